@@ -0,0 +1,312 @@
+/**********************************************************************************************
+*
+*   arc_length - Constant speed motion along polylines from arc length lookup tables
+*
+*   A curve parameter does not move at constant speed, so markers placed by t bunch up where the
+*   curve is slow. The table resamples a polyline (for example a cached spline) at equal arc
+*   length steps, found once per rebuild with a binary search over the cumulative lengths. A
+*   marker at distance s is then a uniform remap, sample s/step and a lerp to the next one, no
+*   search per marker.
+*
+*   EvaluateArcLengthMarkers() places all markers in one pass, 4 per SSE instruction, from SoA
+*   offsets and speeds, writing transforms ready for DrawMeshInstanced().
+*
+*   CONFIGURATION:
+*
+*   #define ARC_LENGTH_IMPLEMENTATION
+*       Generates the implementation of the library into the included file.
+*       If not defined, the library is in header only mode and can be included in other headers
+*       or source files without problems. But only ONE file should hold the implementation.
+*
+**********************************************************************************************/
+
+#ifndef ARC_LENGTH_H
+#define ARC_LENGTH_H
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+
+// Polyline resampled at equal arc length steps, SoA
+typedef struct {
+    float *x;                   // sampleCount + 1 positions, first and last are the polyline ends
+    float *y;
+    float *z;
+    int sampleCount;
+    float length;               // Total arc length
+    float step;                 // length/sampleCount
+
+    float *cumulative;          // Arc length at each polyline point (build scratch)
+    int cumulativeCapacity;
+} ArcLengthTable;
+
+#ifdef __cplusplus
+extern "C" {            // Prevents name mangling of functions
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+ArcLengthTable LoadArcLengthTable(int sampleCount);                                           // Allocate table with sampleCount steps
+void UnloadArcLengthTable(ArcLengthTable *table);                                             // Free table memory
+void UpdateArcLengthTable(ArcLengthTable *table, const Vector3 *points, int pointCount);       // Resample a polyline
+Vector3 GetArcLengthPosition(const ArcLengthTable *table, float distance);                    // Position at distance, wraps around the length
+void EvaluateArcLengthMarkers(const ArcLengthTable *table, const float *offsets, const float *speeds, int count, float time, float scale, Matrix *transforms);  // Markers at offset + speed*time
+
+void BenchmarkArcLengthMarkers(int markerCount, int frames);                                  // Log marker updates per second, remap vs binary search
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ARC_LENGTH_H
+
+
+/***********************************************************************************
+*
+*   ARC_LENGTH IMPLEMENTATION
+*
+************************************************************************************/
+
+#if defined(ARC_LENGTH_IMPLEMENTATION)
+
+#include "raylib.h"
+#include "raymath.h"
+
+#include <math.h>               // Required for: floorf(), sqrtf()
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+    #define ARC_LENGTH_SSE2
+    #include <emmintrin.h>
+#endif
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Declaration
+//----------------------------------------------------------------------------------
+static float WrapArcLength(const ArcLengthTable *table, float distance);
+static Vector3 GetPolylinePosition(const Vector3 *points, const float *cumulative, int pointCount, float distance);
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+
+// Allocate table with sampleCount steps
+ArcLengthTable LoadArcLengthTable(int sampleCount)
+{
+    ArcLengthTable table = { 0 };
+
+    table.sampleCount = (sampleCount > 0)? sampleCount : 256;
+    table.x = (float *)RL_CALLOC(table.sampleCount + 1, sizeof(float));
+    table.y = (float *)RL_CALLOC(table.sampleCount + 1, sizeof(float));
+    table.z = (float *)RL_CALLOC(table.sampleCount + 1, sizeof(float));
+
+    return table;
+}
+
+// Free table memory
+void UnloadArcLengthTable(ArcLengthTable *table)
+{
+    RL_FREE(table->x);
+    RL_FREE(table->y);
+    RL_FREE(table->z);
+    RL_FREE(table->cumulative);
+
+    *table = (ArcLengthTable){ 0 };
+}
+
+// Resample a polyline at sampleCount equal steps
+void UpdateArcLengthTable(ArcLengthTable *table, const Vector3 *points, int pointCount)
+{
+    if (pointCount < 1) return;
+
+    if (pointCount > table->cumulativeCapacity)
+    {
+        table->cumulativeCapacity = pointCount;
+        table->cumulative = (float *)RL_REALLOC(table->cumulative, pointCount*sizeof(float));
+    }
+
+    table->cumulative[0] = 0.0f;
+    for (int i = 1; i < pointCount; i++) table->cumulative[i] = table->cumulative[i - 1] + Vector3Distance(points[i - 1], points[i]);
+
+    table->length = table->cumulative[pointCount - 1];
+    table->step = table->length/table->sampleCount;
+
+    for (int i = 0; i <= table->sampleCount; i++)
+    {
+        Vector3 p = GetPolylinePosition(points, table->cumulative, pointCount, table->step*i);
+
+        table->x[i] = p.x;
+        table->y[i] = p.y;
+        table->z[i] = p.z;
+    }
+}
+
+// Position at distance, wraps around the length
+Vector3 GetArcLengthPosition(const ArcLengthTable *table, float distance)
+{
+    if (table->length <= 0.0f) return (Vector3){ table->x[0], table->y[0], table->z[0] };
+
+    float u = WrapArcLength(table, distance)/table->step;
+    int k = (int)u;
+    if (k >= table->sampleCount) k = table->sampleCount - 1;
+    float f = u - (float)k;
+
+    return (Vector3){ table->x[k] + f*(table->x[k + 1] - table->x[k]),
+                      table->y[k] + f*(table->y[k + 1] - table->y[k]),
+                      table->z[k] + f*(table->z[k + 1] - table->z[k]) };
+}
+
+// Markers at offset + speed*time, wrapped around the length, as scale + translation transforms
+void EvaluateArcLengthMarkers(const ArcLengthTable *table, const float *offsets, const float *speeds, int count, float time, float scale, Matrix *transforms)
+{
+    int i = 0;
+
+    if (table->length > 0.0f)
+    {
+#if defined(ARC_LENGTH_SSE2)
+        const __m128 length = _mm_set1_ps(table->length);
+        const __m128 invLength = _mm_set1_ps(1.0f/table->length);
+        const __m128 invStep = _mm_set1_ps(1.0f/table->step);
+        const __m128 maxIndex = _mm_set1_ps((float)table->sampleCount - 1.0f);
+        const __m128 vtime = _mm_set1_ps(time);
+        const __m128 one = _mm_set1_ps(1.0f);
+
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 s = _mm_add_ps(_mm_loadu_ps(offsets + i), _mm_mul_ps(_mm_loadu_ps(speeds + i), vtime));
+
+            // s - floor(s/length)*length, floor from truncation corrected for negative values
+            __m128 q = _mm_mul_ps(s, invLength);
+            __m128 qt = _mm_cvtepi32_ps(_mm_cvttps_epi32(q));
+            qt = _mm_sub_ps(qt, _mm_and_ps(_mm_cmpgt_ps(qt, q), one));
+            s = _mm_sub_ps(s, _mm_mul_ps(qt, length));
+
+            __m128 u = _mm_min_ps(_mm_max_ps(_mm_mul_ps(s, invStep), _mm_setzero_ps()), _mm_add_ps(maxIndex, _mm_set1_ps(0.99999f)));
+            __m128i k = _mm_cvttps_epi32(u);
+            __m128 f = _mm_sub_ps(u, _mm_cvtepi32_ps(k));
+
+            int idx[4];
+            _mm_storeu_si128((__m128i *)idx, k);
+
+            __m128 x0 = _mm_setr_ps(table->x[idx[0]], table->x[idx[1]], table->x[idx[2]], table->x[idx[3]]);
+            __m128 x1 = _mm_setr_ps(table->x[idx[0] + 1], table->x[idx[1] + 1], table->x[idx[2] + 1], table->x[idx[3] + 1]);
+            __m128 y0 = _mm_setr_ps(table->y[idx[0]], table->y[idx[1]], table->y[idx[2]], table->y[idx[3]]);
+            __m128 y1 = _mm_setr_ps(table->y[idx[0] + 1], table->y[idx[1] + 1], table->y[idx[2] + 1], table->y[idx[3] + 1]);
+            __m128 z0 = _mm_setr_ps(table->z[idx[0]], table->z[idx[1]], table->z[idx[2]], table->z[idx[3]]);
+            __m128 z1 = _mm_setr_ps(table->z[idx[0] + 1], table->z[idx[1] + 1], table->z[idx[2] + 1], table->z[idx[3] + 1]);
+
+            float x[4], y[4], z[4];
+            _mm_storeu_ps(x, _mm_add_ps(x0, _mm_mul_ps(f, _mm_sub_ps(x1, x0))));
+            _mm_storeu_ps(y, _mm_add_ps(y0, _mm_mul_ps(f, _mm_sub_ps(y1, y0))));
+            _mm_storeu_ps(z, _mm_add_ps(z0, _mm_mul_ps(f, _mm_sub_ps(z1, z0))));
+
+            for (int m = 0; m < 4; m++)
+            {
+                transforms[i + m] = (Matrix){ scale, 0.0f, 0.0f, x[m],
+                                              0.0f, scale, 0.0f, y[m],
+                                              0.0f, 0.0f, scale, z[m],
+                                              0.0f, 0.0f, 0.0f, 1.0f };
+            }
+        }
+#endif
+    }
+
+    for (; i < count; i++)
+    {
+        Vector3 p = GetArcLengthPosition(table, offsets[i] + speeds[i]*time);
+
+        transforms[i] = (Matrix){ scale, 0.0f, 0.0f, p.x,
+                                  0.0f, scale, 0.0f, p.y,
+                                  0.0f, 0.0f, scale, p.z,
+                                  0.0f, 0.0f, 0.0f, 1.0f };
+    }
+}
+
+// Log marker updates per second, remap vs binary search
+void BenchmarkArcLengthMarkers(int markerCount, int frames)
+{
+    // Spiral with tight and loose turns, 2049 points
+    const int pointCount = 2049;
+    Vector3 *points = (Vector3 *)RL_MALLOC(pointCount*sizeof(Vector3));
+    for (int i = 0; i < pointCount; i++)
+    {
+        float t = (float)i/(pointCount - 1);
+        points[i] = (Vector3){ 40.0f*t*t*cosf(20.0f*t), 10.0f*t, 40.0f*t*t*sinf(20.0f*t) };
+    }
+
+    ArcLengthTable table = LoadArcLengthTable(4096);
+    float *offsets = (float *)RL_MALLOC(markerCount*sizeof(float));
+    float *speeds = (float *)RL_MALLOC(markerCount*sizeof(float));
+    Matrix *transforms = (Matrix *)RL_MALLOC(markerCount*sizeof(Matrix));
+
+    double start = GetTime();
+    UpdateArcLengthTable(&table, points, pointCount);
+    double buildTime = GetTime() - start;
+
+    for (int i = 0; i < markerCount; i++)
+    {
+        offsets[i] = table.length*i/markerCount;
+        speeds[i] = 5.0f + (float)(i%7);
+    }
+
+    double remapTime = 0.0, searchTime = 0.0;
+
+    for (int f = 0; f < frames; f++)
+    {
+        start = GetTime();
+        EvaluateArcLengthMarkers(&table, offsets, speeds, markerCount, f/60.0f, 0.2f, transforms);
+        remapTime += GetTime() - start;
+
+        start = GetTime();
+        for (int i = 0; i < markerCount; i++)
+        {
+            float s = WrapArcLength(&table, offsets[i] + speeds[i]*f/60.0f);
+            Vector3 p = GetPolylinePosition(points, table.cumulative, pointCount, s);
+            transforms[i].m12 = p.x; transforms[i].m13 = p.y; transforms[i].m14 = p.z;
+        }
+        searchTime += GetTime() - start;
+    }
+
+    TraceLog(LOG_INFO, "ARC LENGTH: %i markers: table build %.3f ms, remap %.1f M updates/s, binary search %.1f M updates/s",
+             markerCount, buildTime*1000.0, markerCount*frames/remapTime/1e6, markerCount*frames/searchTime/1e6);
+
+    RL_FREE(points);
+    RL_FREE(offsets);
+    RL_FREE(speeds);
+    RL_FREE(transforms);
+    UnloadArcLengthTable(&table);
+}
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Definition
+//----------------------------------------------------------------------------------
+
+// Distance wrapped to [0, length)
+static float WrapArcLength(const ArcLengthTable *table, float distance)
+{
+    float s = distance - floorf(distance/table->length)*table->length;
+
+    return (s < table->length)? s : 0.0f;
+}
+
+// Position at distance along the polyline, binary search over the cumulative lengths
+static Vector3 GetPolylinePosition(const Vector3 *points, const float *cumulative, int pointCount, float distance)
+{
+    if (pointCount == 1) return points[0];
+
+    int low = 0, high = pointCount - 1;
+
+    while (high - low > 1)
+    {
+        int mid = (low + high)/2;
+        if (cumulative[mid] <= distance) low = mid;
+        else high = mid;
+    }
+
+    float span = cumulative[high] - cumulative[low];
+    float f = (span > 0.0f)? (distance - cumulative[low])/span : 0.0f;
+
+    return Vector3Lerp(points[low], points[high], Clamp(f, 0.0f, 1.0f));
+}
+
+#endif // ARC_LENGTH_IMPLEMENTATION
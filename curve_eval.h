@@ -0,0 +1,485 @@
+/**********************************************************************************************
+*
+*   curve_eval - Cubic bezier evaluation from precomputed Bernstein basis tables
+*
+*   The cubic Bernstein weights for t = i/n only depend on the segment count, so they are built
+*   once at compile time (constexpr) for every count up to CURVE_MAX_SEGMENTS. Evaluating a
+*   point is then 4 multiply-adds per component, no powf().
+*
+*   Control points are kept SoA (one plane per component), so EvaluateCurveSet() computes 4
+*   curves per SSE instruction (8 with AVX) for each table row. A single curve can also be
+*   evaluated with forward differencing, 3 additions per component and point.
+*
+*   Segment counts can be picked per curve from a pixel tolerance: control points are projected
+*   to the screen and Wang's formula bounds the distance between the curve and its polyline,
+*   n = sqrt(3/4*max|p[i] - 2p[i+1] + p[i+2]|/tolerance). Control points of a perspective
+*   projected curve are only close to the projected control points, fine for picking a count.
+*
+*   NOTE: C++ only, the tables need constexpr (C++14 or later)
+*
+*   CONFIGURATION:
+*
+*   #define CURVE_EVAL_IMPLEMENTATION
+*       Generates the implementation of the library into the included file.
+*       If not defined, the library is in header only mode and can be included in other headers
+*       or source files without problems. But only ONE file should hold the implementation.
+*
+**********************************************************************************************/
+
+#ifndef CURVE_EVAL_H
+#define CURVE_EVAL_H
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define CURVE_MAX_SEGMENTS      64          // Largest segment count with a precomputed table
+#define CURVE_PLANES            12          // p1.xyz, c2.xyz, c3.xyz, p4.xyz
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+
+// Cubic bezier control points, SoA
+typedef struct {
+    float *planes[CURVE_PLANES];    // Component planes, capacity floats each
+    int count;
+    int capacity;                   // Multiple of 8
+} CurveSet;
+
+#ifdef __cplusplus
+extern "C" {            // Prevents name mangling of functions
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+CurveSet LoadCurveSet(int capacity);                                                  // Allocate curve set (grows on demand)
+void UnloadCurveSet(CurveSet *set);                                                   // Free curve set memory
+void ClearCurveSet(CurveSet *set);                                                    // Remove all curves
+int AddCurveBezierCubic(CurveSet *set, Vector3 p1, Vector3 c2, Vector3 c3, Vector3 p4);          // Add a curve, returns its index
+void SetCurveBezierCubic(CurveSet *set, int index, Vector3 p1, Vector3 c2, Vector3 c3, Vector3 p4);  // Replace a curve control points
+void EvaluateCurveSet(const CurveSet *set, int segments, Vector3 *points);           // All curves, segments + 1 points per curve
+void EvaluateCurveRange(const CurveSet *set, int first, int count, int segments, Vector3 *points);  // Curves [first, first + count)
+void EvaluateCurveBezierCubic(Vector3 p1, Vector3 c2, Vector3 c3, Vector3 p4, int segments, Vector3 *points);  // One curve, forward differencing
+const float *GetBernsteinWeights(int segments);                                      // 4 weights per point, NULL above CURVE_MAX_SEGMENTS
+int GetCurveSegmentCount(Vector2 p1, Vector2 c2, Vector2 c3, Vector2 p4, float tolerance);    // Segments keeping a 2d curve within tolerance of its polyline
+int GetCurveSegmentsScreen(Matrix viewProj, int width, int height, Vector3 p1, Vector3 c2, Vector3 c3, Vector3 p4, float tolerance);  // Same, tolerance in pixels
+
+void BenchmarkCurveEvaluation(int curves, int segments, int frames);                 // Log powf() vs table vs forward differencing cost
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CURVE_EVAL_H
+
+
+/***********************************************************************************
+*
+*   CURVE_EVAL IMPLEMENTATION
+*
+************************************************************************************/
+
+#if defined(CURVE_EVAL_IMPLEMENTATION)
+
+#include "raylib.h"
+
+#include <math.h>               // Required for: powf(), sqrtf(), ceilf()
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+    #define CURVE_SSE2
+    #include <emmintrin.h>
+#endif
+#if defined(__AVX__)
+    #define CURVE_AVX
+    #include <immintrin.h>
+#endif
+
+//----------------------------------------------------------------------------------
+// Bernstein tables, built at compile time
+//----------------------------------------------------------------------------------
+#define CURVE_TABLE_ROWS (CURVE_MAX_SEGMENTS*(CURVE_MAX_SEGMENTS + 1)/2 + CURVE_MAX_SEGMENTS)
+
+struct BernsteinTables {
+    float weights[CURVE_TABLE_ROWS][4];         // (1-t)^3, 3(1-t)^2 t, 3(1-t) t^2, t^3
+    int offsets[CURVE_MAX_SEGMENTS + 1];        // First row for each segment count
+};
+
+static constexpr BernsteinTables MakeBernsteinTables()
+{
+    BernsteinTables tables = {};
+    int row = 0;
+
+    for (int n = 1; n <= CURVE_MAX_SEGMENTS; n++)
+    {
+        tables.offsets[n] = row;
+
+        for (int i = 0; i <= n; i++, row++)
+        {
+            float t = (float)i/(float)n;
+            float u = 1.0f - t;
+
+            tables.weights[row][0] = u*u*u;
+            tables.weights[row][1] = 3.0f*u*u*t;
+            tables.weights[row][2] = 3.0f*u*t*t;
+            tables.weights[row][3] = t*t*t;
+        }
+    }
+
+    return tables;
+}
+
+static constexpr BernsteinTables BernsteinTable = MakeBernsteinTables();
+
+static_assert(BernsteinTable.weights[CURVE_TABLE_ROWS - 1][3] == 1.0f, "Bernstein table rows miscounted");
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Declaration
+//----------------------------------------------------------------------------------
+static float *LoadCurvePlane(int capacity);
+#if defined(CURVE_SSE2)
+static void StoreCurvePoints4(__m128 x, __m128 y, __m128 z, Vector3 *out, int stride);
+#endif
+static void EvaluateCurveTable(const CurveSet *set, int curve, const float (*weights)[4], int segments, Vector3 *points);
+static void EvaluateCurvePowf(Vector3 p1, Vector3 c2, Vector3 c3, Vector3 p4, int segments, Vector3 *points);
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+
+// Allocate curve set (grows on demand)
+CurveSet LoadCurveSet(int capacity)
+{
+    CurveSet set = { 0 };
+
+    set.capacity = ((((capacity > 0)? capacity : 64) + 7)/8)*8;
+    for (int p = 0; p < CURVE_PLANES; p++) set.planes[p] = LoadCurvePlane(set.capacity);
+
+    return set;
+}
+
+// Free curve set memory
+void UnloadCurveSet(CurveSet *set)
+{
+    for (int p = 0; p < CURVE_PLANES; p++) RL_FREE(set->planes[p]);
+
+    *set = (CurveSet){ 0 };
+}
+
+// Remove all curves
+void ClearCurveSet(CurveSet *set)
+{
+    set->count = 0;
+}
+
+// Add a curve, returns its index
+int AddCurveBezierCubic(CurveSet *set, Vector3 p1, Vector3 c2, Vector3 c3, Vector3 p4)
+{
+    if (set->count == set->capacity)
+    {
+        int capacity = 2*set->capacity;
+
+        for (int p = 0; p < CURVE_PLANES; p++)
+        {
+            float *plane = LoadCurvePlane(capacity);
+            for (int i = 0; i < set->count; i++) plane[i] = set->planes[p][i];
+            RL_FREE(set->planes[p]);
+            set->planes[p] = plane;
+        }
+
+        set->capacity = capacity;
+    }
+
+    SetCurveBezierCubic(set, set->count, p1, c2, c3, p4);
+
+    return set->count++;
+}
+
+// Replace a curve control points
+void SetCurveBezierCubic(CurveSet *set, int index, Vector3 p1, Vector3 c2, Vector3 c3, Vector3 p4)
+{
+    const Vector3 controls[4] = { p1, c2, c3, p4 };
+
+    for (int k = 0; k < 4; k++)
+    {
+        set->planes[3*k][index] = controls[k].x;
+        set->planes[3*k + 1][index] = controls[k].y;
+        set->planes[3*k + 2][index] = controls[k].z;
+    }
+}
+
+// All curves, segments + 1 points per curve
+void EvaluateCurveSet(const CurveSet *set, int segments, Vector3 *points)
+{
+    EvaluateCurveRange(set, 0, set->count, segments, points);
+}
+
+// Curves [first, first + count), points[(curve - first)*(segments + 1) + i]
+void EvaluateCurveRange(const CurveSet *set, int first, int count, int segments, Vector3 *points)
+{
+    const int stride = segments + 1;
+    int c = first;
+    int end = first + count;
+
+    if (segments > CURVE_MAX_SEGMENTS)
+    {
+        // No table, evaluate one by one
+        for (; c < end; c++)
+        {
+            const float *const *q = set->planes;
+            EvaluateCurveBezierCubic((Vector3){ q[0][c], q[1][c], q[2][c] }, (Vector3){ q[3][c], q[4][c], q[5][c] },
+                                     (Vector3){ q[6][c], q[7][c], q[8][c] }, (Vector3){ q[9][c], q[10][c], q[11][c] }, segments, points + (c - first)*stride);
+        }
+        return;
+    }
+
+    const float (*weights)[4] = BernsteinTable.weights + BernsteinTable.offsets[segments];
+
+#if defined(CURVE_AVX)
+    // 8 curves per instruction, rows computed together then split in 4 lane halves
+    for (; c + 8 <= end; c += 8)
+    {
+        __m256 q[CURVE_PLANES];
+        for (int p = 0; p < CURVE_PLANES; p++) q[p] = _mm256_loadu_ps(set->planes[p] + c);
+
+        for (int i = 0; i <= segments; i++)
+        {
+            __m256 w0 = _mm256_set1_ps(weights[i][0]), w1 = _mm256_set1_ps(weights[i][1]);
+            __m256 w2 = _mm256_set1_ps(weights[i][2]), w3 = _mm256_set1_ps(weights[i][3]);
+            __m256 xyz[3];
+
+            for (int a = 0; a < 3; a++)
+            {
+                xyz[a] = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(w0, q[a]), _mm256_mul_ps(w1, q[3 + a])),
+                                       _mm256_add_ps(_mm256_mul_ps(w2, q[6 + a]), _mm256_mul_ps(w3, q[9 + a])));
+            }
+
+            Vector3 *out = points + (c - first)*stride + i;
+            StoreCurvePoints4(_mm256_castps256_ps128(xyz[0]), _mm256_castps256_ps128(xyz[1]), _mm256_castps256_ps128(xyz[2]), out, stride);
+            StoreCurvePoints4(_mm256_extractf128_ps(xyz[0], 1), _mm256_extractf128_ps(xyz[1], 1), _mm256_extractf128_ps(xyz[2], 1), out + 4*stride, stride);
+        }
+    }
+#endif
+
+#if defined(CURVE_SSE2)
+    // 4 curves per instruction
+    for (; c + 4 <= end; c += 4)
+    {
+        __m128 q[CURVE_PLANES];
+        for (int p = 0; p < CURVE_PLANES; p++) q[p] = _mm_loadu_ps(set->planes[p] + c);
+
+        for (int i = 0; i <= segments; i++)
+        {
+            __m128 w0 = _mm_set1_ps(weights[i][0]), w1 = _mm_set1_ps(weights[i][1]);
+            __m128 w2 = _mm_set1_ps(weights[i][2]), w3 = _mm_set1_ps(weights[i][3]);
+
+            __m128 x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(w0, q[0]), _mm_mul_ps(w1, q[3])), _mm_add_ps(_mm_mul_ps(w2, q[6]), _mm_mul_ps(w3, q[9])));
+            __m128 y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(w0, q[1]), _mm_mul_ps(w1, q[4])), _mm_add_ps(_mm_mul_ps(w2, q[7]), _mm_mul_ps(w3, q[10])));
+            __m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(w0, q[2]), _mm_mul_ps(w1, q[5])), _mm_add_ps(_mm_mul_ps(w2, q[8]), _mm_mul_ps(w3, q[11])));
+
+            StoreCurvePoints4(x, y, z, points + (c - first)*stride + i, stride);
+        }
+    }
+#endif
+
+    for (; c < end; c++) EvaluateCurveTable(set, c, weights, segments, points + (c - first)*stride);
+}
+
+// One curve, forward differencing
+// NOTE: Accumulates rounding over the steps, fine for the segment counts used to draw curves
+void EvaluateCurveBezierCubic(Vector3 p1, Vector3 c2, Vector3 c3, Vector3 p4, int segments, Vector3 *points)
+{
+    const float h = 1.0f/segments;
+    const float controls[4][3] = { { p1.x, p1.y, p1.z }, { c2.x, c2.y, c2.z }, { c3.x, c3.y, c3.z }, { p4.x, p4.y, p4.z } };
+    float value[3], d1[3], d2[3], d3[3];
+
+    for (int a = 0; a < 3; a++)
+    {
+        // Power basis coefficients of B(t) = A t^3 + B t^2 + C t + D
+        float ca = -controls[0][a] + 3.0f*controls[1][a] - 3.0f*controls[2][a] + controls[3][a];
+        float cb = 3.0f*controls[0][a] - 6.0f*controls[1][a] + 3.0f*controls[2][a];
+        float cc = -3.0f*controls[0][a] + 3.0f*controls[1][a];
+
+        value[a] = controls[0][a];
+        d1[a] = ca*h*h*h + cb*h*h + cc*h;
+        d2[a] = 6.0f*ca*h*h*h + 2.0f*cb*h*h;
+        d3[a] = 6.0f*ca*h*h*h;
+    }
+
+    for (int i = 0; i <= segments; i++)
+    {
+        points[i] = (Vector3){ value[0], value[1], value[2] };
+
+        for (int a = 0; a < 3; a++)
+        {
+            value[a] += d1[a];
+            d1[a] += d2[a];
+            d2[a] += d3[a];
+        }
+    }
+
+    points[segments] = p4;
+}
+
+// 4 weights per point, NULL above CURVE_MAX_SEGMENTS
+const float *GetBernsteinWeights(int segments)
+{
+    if ((segments < 1) || (segments > CURVE_MAX_SEGMENTS)) return NULL;
+
+    return BernsteinTable.weights[BernsteinTable.offsets[segments]];
+}
+
+// Segments keeping a 2d curve within tolerance of its polyline (Wang's formula), 1 to CURVE_MAX_SEGMENTS
+int GetCurveSegmentCount(Vector2 p1, Vector2 c2, Vector2 c3, Vector2 p4, float tolerance)
+{
+    float dx0 = p1.x - 2.0f*c2.x + c3.x, dy0 = p1.y - 2.0f*c2.y + c3.y;
+    float dx1 = c2.x - 2.0f*c3.x + p4.x, dy1 = c2.y - 2.0f*c3.y + p4.y;
+    float m = fmaxf(sqrtf(dx0*dx0 + dy0*dy0), sqrtf(dx1*dx1 + dy1*dy1));
+
+    int segments = (int)ceilf(sqrtf(0.75f*m/fmaxf(tolerance, 0.001f)));
+
+    return (segments < 1)? 1 : (segments > CURVE_MAX_SEGMENTS)? CURVE_MAX_SEGMENTS : segments;
+}
+
+// Segments keeping a 3d curve within tolerance pixels on a width x height target
+// NOTE: Curves crossing the camera plane get CURVE_MAX_SEGMENTS, their projection is unbounded
+int GetCurveSegmentsScreen(Matrix viewProj, int width, int height, Vector3 p1, Vector3 c2, Vector3 c3, Vector3 p4, float tolerance)
+{
+    const Vector3 controls[4] = { p1, c2, c3, p4 };
+    Vector2 screen[4] = { 0 };
+    const Matrix m = viewProj;
+
+    for (int i = 0; i < 4; i++)
+    {
+        Vector3 v = controls[i];
+        float x = m.m0*v.x + m.m4*v.y + m.m8*v.z + m.m12;
+        float y = m.m1*v.x + m.m5*v.y + m.m9*v.z + m.m13;
+        float w = m.m3*v.x + m.m7*v.y + m.m11*v.z + m.m15;
+
+        if (w <= 0.0001f) return CURVE_MAX_SEGMENTS;
+
+        screen[i] = (Vector2){ (x/w*0.5f + 0.5f)*width, (0.5f - y/w*0.5f)*height };
+    }
+
+    return GetCurveSegmentCount(screen[0], screen[1], screen[2], screen[3], tolerance);
+}
+
+// Log powf() vs table vs forward differencing cost
+void BenchmarkCurveEvaluation(int curves, int segments, int frames)
+{
+    CurveSet set = LoadCurveSet(curves);
+    Vector3 *points = (Vector3 *)RL_MALLOC(curves*(segments + 1)*sizeof(Vector3));
+    Vector3 *reference = (Vector3 *)RL_MALLOC(curves*(segments + 1)*sizeof(Vector3));
+
+    for (int i = 0; i < curves; i++)
+    {
+        float f = (float)i;
+        AddCurveBezierCubic(&set, (Vector3){ f, 0.0f, 0.0f }, (Vector3){ f, -15.0f, 1.0f }, (Vector3){ 22.0f, -15.0f, f*0.5f }, (Vector3){ 22.0f, 0.0f, f*0.5f });
+    }
+
+    double powfTime = 0.0, tableTime = 0.0, differenceTime = 0.0;
+
+    for (int f = 0; f < frames; f++)
+    {
+        const float *const *q = set.planes;
+
+        double start = GetTime();
+        for (int c = 0; c < curves; c++)
+        {
+            EvaluateCurvePowf((Vector3){ q[0][c], q[1][c], q[2][c] }, (Vector3){ q[3][c], q[4][c], q[5][c] },
+                              (Vector3){ q[6][c], q[7][c], q[8][c] }, (Vector3){ q[9][c], q[10][c], q[11][c] }, segments, reference + c*(segments + 1));
+        }
+        powfTime += GetTime() - start;
+
+        start = GetTime();
+        EvaluateCurveSet(&set, segments, points);
+        tableTime += GetTime() - start;
+
+        start = GetTime();
+        for (int c = 0; c < curves; c++)
+        {
+            EvaluateCurveBezierCubic((Vector3){ q[0][c], q[1][c], q[2][c] }, (Vector3){ q[3][c], q[4][c], q[5][c] },
+                                     (Vector3){ q[6][c], q[7][c], q[8][c] }, (Vector3){ q[9][c], q[10][c], q[11][c] }, segments, points + c*(segments + 1));
+        }
+        differenceTime += GetTime() - start;
+    }
+
+    // Table results against powf()
+    EvaluateCurveSet(&set, segments, points);
+    float maxError = 0.0f;
+    for (int i = 0; i < curves*(segments + 1); i++)
+    {
+        float e = fabsf(points[i].x - reference[i].x) + fabsf(points[i].y - reference[i].y) + fabsf(points[i].z - reference[i].z);
+        if (e > maxError) maxError = e;
+    }
+
+    TraceLog(LOG_INFO, "CURVES: %i curves x %i segments: powf %.3f ms, table %.3f ms, forward differencing %.3f ms, max error %g",
+             curves, segments, powfTime*1000.0/frames, tableTime*1000.0/frames, differenceTime*1000.0/frames, maxError);
+
+    RL_FREE(points);
+    RL_FREE(reference);
+    UnloadCurveSet(&set);
+}
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Definition
+//----------------------------------------------------------------------------------
+
+// Zeroed plane, padded so vector loads past count stay inside the allocation
+static float *LoadCurvePlane(int capacity)
+{
+    return (float *)RL_CALLOC(capacity + 8, sizeof(float));
+}
+
+#if defined(CURVE_SSE2)
+// Point i of 4 consecutive curves, out[k*stride] for curve k
+// NOTE: Rows become (x, y, z, 0) per curve, stored as 8 + 4 bytes so nothing past the point is touched
+static void StoreCurvePoints4(__m128 x, __m128 y, __m128 z, Vector3 *out, int stride)
+{
+    __m128 w = _mm_setzero_ps();
+
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+    _mm_storel_pi((__m64 *)out, x); _mm_store_ss(&out->z, _mm_movehl_ps(x, x)); out += stride;
+    _mm_storel_pi((__m64 *)out, y); _mm_store_ss(&out->z, _mm_movehl_ps(y, y)); out += stride;
+    _mm_storel_pi((__m64 *)out, z); _mm_store_ss(&out->z, _mm_movehl_ps(z, z)); out += stride;
+    _mm_storel_pi((__m64 *)out, w); _mm_store_ss(&out->z, _mm_movehl_ps(w, w));
+}
+#endif
+
+// One curve from the table, scalar
+static void EvaluateCurveTable(const CurveSet *set, int curve, const float (*weights)[4], int segments, Vector3 *points)
+{
+    float q[CURVE_PLANES];
+    for (int p = 0; p < CURVE_PLANES; p++) q[p] = set->planes[p][curve];
+
+    for (int i = 0; i <= segments; i++)
+    {
+        const float *w = weights[i];
+
+        points[i] = (Vector3){ w[0]*q[0] + w[1]*q[3] + w[2]*q[6] + w[3]*q[9],
+                               w[0]*q[1] + w[1]*q[4] + w[2]*q[7] + w[3]*q[10],
+                               w[0]*q[2] + w[1]*q[5] + w[2]*q[8] + w[3]*q[11] };
+    }
+}
+
+// Reference evaluation, same math as DrawSplineSegmentBezierCubic3D()
+static void EvaluateCurvePowf(Vector3 p1, Vector3 c2, Vector3 c3, Vector3 p4, int segments, Vector3 *points)
+{
+    const float step = 1.0f/segments;
+
+    points[0] = p1;
+
+    for (int i = 1; i <= segments; i++)
+    {
+        float t = step*(float)i;
+
+        float a = powf(1.0f - t, 3);
+        float b = 3.0f*powf(1.0f - t, 2)*t;
+        float c = 3.0f*(1.0f - t)*powf(t, 2);
+        float d = powf(t, 3);
+
+        points[i] = (Vector3){ a*p1.x + b*c2.x + c*c3.x + d*p4.x, a*p1.y + b*c2.y + c*c3.y + d*p4.y, a*p1.z + b*c2.z + c*c3.z + d*p4.z };
+    }
+}
+
+#endif // CURVE_EVAL_IMPLEMENTATION
@@ -0,0 +1,352 @@
+/**********************************************************************************************
+*
+*   curve_instancing - Cubic bezier curves evaluated in the vertex shader, one instance per curve
+*
+*   Only the 4 control points, color and width of each curve are uploaded (56 bytes), the segment
+*   geometry is a shared template of (t, side) pairs. The vertex shader evaluates the curve and
+*   its tangent at t and extrudes the point width pixels across the screen space tangent, so
+*   every curve is a strip of thin quads and all curves are drawn with one instanced call.
+*
+*   CPU cost depends on the curve count only, the segment count just changes the template.
+*
+*   Modes: lines are a fixed number of pixels wide. Ribbons are flat strips facing the camera
+*   and tubes are CURVE_TUBE_SIDES sided rings lit from the camera, both sized in world units.
+*   The ends of every segment use the curve tangent at their t, so consecutive segments share
+*   their edge and joins need no miter fix up. Width and color are per curve.
+*
+*   NOTE: Quads instead of GL_LINE_STRIP, rlDrawVertexArrayInstanced() only draws triangles and
+*   core profile line widths above 1 are not portable. Needs GLSL 330 instancing, which Mesa
+*   software rendering (llvmpipe) supports.
+*
+*   CONFIGURATION:
+*
+*   #define CURVE_INSTANCING_IMPLEMENTATION
+*       Generates the implementation of the library into the included file.
+*       If not defined, the library is in header only mode and can be included in other headers
+*       or source files without problems. But only ONE file should hold the implementation.
+*
+**********************************************************************************************/
+
+#ifndef CURVE_INSTANCING_H
+#define CURVE_INSTANCING_H
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define CURVE_TUBE_SIDES        6           // Low poly tube cross section
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+
+// Curve geometry, matches the shader mode uniform
+typedef enum {
+    CURVE_MODE_LINES = 0,       // Screen space quads, width in pixels
+    CURVE_MODE_RIBBONS,         // Camera facing strips, width in world units
+    CURVE_MODE_TUBES            // Low poly tubes, diameter in world units
+} CurveMode;
+
+// Per instance data, matches the shader instance attributes
+typedef struct {
+    Vector3 p1;
+    Vector3 c2;
+    Vector3 c3;
+    Vector3 p4;
+    Color color;
+    float width;
+} CurveInstance;
+
+// Instanced curves sharing one shader and segment count
+typedef struct {
+    Shader shader;              // curve_instanced.vs/fs
+    int attribLocs[7];          // vertexCurve, instanceP1, instanceC2, instanceC3, instanceP4, instanceColor, instanceWidth
+    int viewportLoc;
+    int viewPosLoc;
+    int modeLoc;
+
+    CurveInstance *instances;
+    int count;
+    int capacity;               // CPU array size (grows on demand)
+    int segments;
+    int mode;                   // CurveMode
+
+    unsigned int vaoId;
+    unsigned int vboId[2];      // Segment template, instances
+    int gpuCapacity;            // GPU instance buffer size
+    int gpuSegments;            // Segment count of the uploaded template
+    int gpuMode;                // Mode of the uploaded template
+    int templateVertexCount;
+    bool dirty;                 // Instances changed since last upload
+} InstancedCurves;
+
+#ifdef __cplusplus
+extern "C" {            // Prevents name mangling of functions
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+InstancedCurves LoadInstancedCurves(Shader shader, int capacity, int segments);                // Allocate curves (grows on demand)
+void UnloadInstancedCurves(InstancedCurves *curves);                                          // Free curves memory and GPU buffers
+void ClearInstancedCurves(InstancedCurves *curves);                                           // Remove all curves
+int AddInstancedCurve(InstancedCurves *curves, Vector3 p1, Vector3 c2, Vector3 c3, Vector3 p4, float width, Color color);            // Add a curve, returns its index
+void SetInstancedCurve(InstancedCurves *curves, int index, Vector3 p1, Vector3 c2, Vector3 c3, Vector3 p4, float width, Color color);  // Replace a curve
+void SetInstancedCurvesSegments(InstancedCurves *curves, int segments);                       // Change the segment count of every curve
+void SetInstancedCurvesMode(InstancedCurves *curves, int mode);                               // Change lines/ribbons/tubes for every curve
+void DrawInstancedCurves(InstancedCurves *curves);                                            // Upload if changed and draw all curves
+
+void BenchmarkInstancedCurves(Shader shader, int curves, int frames);                         // Log CPU cost for a low and a high segment count
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CURVE_INSTANCING_H
+
+
+/***********************************************************************************
+*
+*   CURVE_INSTANCING IMPLEMENTATION
+*
+************************************************************************************/
+
+#if defined(CURVE_INSTANCING_IMPLEMENTATION)
+
+#include "raylib.h"
+#include "raymath.h"
+#include "rlgl.h"
+
+#include <stddef.h>             // Required for: offsetof()
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Declaration
+//----------------------------------------------------------------------------------
+static void UploadInstancedCurves(InstancedCurves *curves);
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+
+// Allocate curves (grows on demand)
+InstancedCurves LoadInstancedCurves(Shader shader, int capacity, int segments)
+{
+    InstancedCurves curves = { 0 };
+    const char *attribs[7] = { "vertexCurve", "instanceP1", "instanceC2", "instanceC3", "instanceP4", "instanceColor", "instanceWidth" };
+
+    curves.shader = shader;
+    for (int i = 0; i < 7; i++) curves.attribLocs[i] = GetShaderLocationAttrib(shader, attribs[i]);
+    curves.viewportLoc = GetShaderLocation(shader, "viewport");
+    curves.viewPosLoc = GetShaderLocation(shader, "viewPos");
+    curves.modeLoc = GetShaderLocation(shader, "mode");
+
+    curves.capacity = (capacity > 0)? capacity : 256;
+    curves.instances = (CurveInstance *)RL_MALLOC(curves.capacity*sizeof(CurveInstance));
+    curves.segments = (segments > 0)? segments : 1;
+
+    return curves;
+}
+
+// Free curves memory and GPU buffers
+void UnloadInstancedCurves(InstancedCurves *curves)
+{
+    if (curves->vaoId != 0)
+    {
+        rlUnloadVertexArray(curves->vaoId);
+        rlUnloadVertexBuffer(curves->vboId[0]);
+        rlUnloadVertexBuffer(curves->vboId[1]);
+    }
+
+    RL_FREE(curves->instances);
+
+    *curves = (InstancedCurves){ 0 };
+}
+
+// Remove all curves
+void ClearInstancedCurves(InstancedCurves *curves)
+{
+    curves->count = 0;
+    curves->dirty = true;
+}
+
+// Add a curve, returns its index
+int AddInstancedCurve(InstancedCurves *curves, Vector3 p1, Vector3 c2, Vector3 c3, Vector3 p4, float width, Color color)
+{
+    if (curves->count == curves->capacity)
+    {
+        curves->capacity *= 2;
+        curves->instances = (CurveInstance *)RL_REALLOC(curves->instances, curves->capacity*sizeof(CurveInstance));
+    }
+
+    SetInstancedCurve(curves, curves->count, p1, c2, c3, p4, width, color);
+
+    return curves->count++;
+}
+
+// Replace a curve
+void SetInstancedCurve(InstancedCurves *curves, int index, Vector3 p1, Vector3 c2, Vector3 c3, Vector3 p4, float width, Color color)
+{
+    curves->instances[index] = (CurveInstance){ p1, c2, c3, p4, color, width };
+    curves->dirty = true;
+}
+
+// Change the segment count of every curve, rebuilds the template on next draw
+void SetInstancedCurvesSegments(InstancedCurves *curves, int segments)
+{
+    if (segments < 1) segments = 1;
+
+    if (segments != curves->segments)
+    {
+        curves->segments = segments;
+        curves->dirty = true;
+    }
+}
+
+// Change lines/ribbons/tubes for every curve, rebuilds the template on next draw
+void SetInstancedCurvesMode(InstancedCurves *curves, int mode)
+{
+    if (mode != curves->mode)
+    {
+        curves->mode = mode;
+        curves->dirty = true;
+    }
+}
+
+// Upload if changed and draw all curves
+// NOTE: Like DrawLineBatch(), the rlgl batch is not flushed, the curves are drawn straight away
+void DrawInstancedCurves(InstancedCurves *curves)
+{
+    if ((curves->count == 0) || (curves->shader.id == 0)) return;
+
+    if (curves->dirty) UploadInstancedCurves(curves);
+
+    Matrix mvp = MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection());
+    float white[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    float viewport[2] = { (float)rlGetFramebufferWidth(), (float)rlGetFramebufferHeight() };
+    Matrix view = MatrixInvert(rlGetMatrixModelview());
+    float viewPos[3] = { view.m12, view.m13, view.m14 };
+
+    rlEnableShader(curves->shader.id);
+    rlSetUniformMatrix(curves->shader.locs[SHADER_LOC_MATRIX_MVP], mvp);
+    rlSetUniform(curves->shader.locs[SHADER_LOC_COLOR_DIFFUSE], white, SHADER_UNIFORM_VEC4, 1);
+    rlSetUniform(curves->viewportLoc, viewport, SHADER_UNIFORM_VEC2, 1);
+    rlSetUniform(curves->viewPosLoc, viewPos, SHADER_UNIFORM_VEC3, 1);
+    rlSetUniform(curves->modeLoc, &curves->mode, SHADER_UNIFORM_INT, 1);
+
+    // Quads face the camera either way depending on the curve direction
+    rlDisableBackfaceCulling();
+    rlEnableVertexArray(curves->vaoId);
+
+    rlDrawVertexArrayInstanced(0, curves->templateVertexCount, curves->count);
+
+    rlDisableVertexArray();
+    rlEnableBackfaceCulling();
+    rlDisableShader();
+}
+
+// Log CPU cost for a low and a high segment count
+void BenchmarkInstancedCurves(Shader shader, int curves, int frames)
+{
+    const int segments[2] = { 8, 64 };
+    double time[2] = { 0.0 };
+
+    for (int s = 0; s < 2; s++)
+    {
+        InstancedCurves set = LoadInstancedCurves(shader, curves, segments[s]);
+
+        for (int f = 0; f < frames; f++)
+        {
+            double start = GetTime();
+            ClearInstancedCurves(&set);
+            for (int i = 0; i < curves; i++)
+            {
+                float x = (float)(i%100) - 50.0f;
+                float z = (float)(i/100%100) - 50.0f + 0.01f*f;
+                AddInstancedCurve(&set, (Vector3){ x, 10, z }, (Vector3){ x, -5, z }, (Vector3){ 0, -5, 0 }, (Vector3){ 0, 10, 0 }, 1.0f, LIGHTGRAY);
+            }
+            DrawInstancedCurves(&set);
+            time[s] += GetTime() - start;
+        }
+
+        UnloadInstancedCurves(&set);
+    }
+
+    TraceLog(LOG_INFO, "CURVE INSTANCING: %i curves: %i segments %.3f ms, %i segments %.3f ms (CPU)",
+             curves, segments[0], time[0]*1000.0/frames, segments[1], time[1]*1000.0/frames);
+}
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Definition
+//----------------------------------------------------------------------------------
+
+// Rebuild template and instance buffers when too small, then copy the instances
+static void UploadInstancedCurves(InstancedCurves *curves)
+{
+    if ((curves->count > curves->gpuCapacity) || (curves->segments != curves->gpuSegments) || (curves->mode != curves->gpuMode))
+    {
+        if (curves->vaoId != 0)
+        {
+            rlUnloadVertexArray(curves->vaoId);
+            rlUnloadVertexBuffer(curves->vboId[0]);
+            rlUnloadVertexBuffer(curves->vboId[1]);
+        }
+
+        // Two triangles per segment and side, (t, side) per vertex, side is an angle for tubes
+        int sides = (curves->mode == CURVE_MODE_TUBES)? CURVE_TUBE_SIDES : 1;
+        int vertexCount = 6*sides*curves->segments;
+        float *vertices = (float *)RL_MALLOC(vertexCount*2*sizeof(float));
+        float *v = vertices;
+        const float corners[6][2] = { { 0, -1 }, { 1, -1 }, { 1, 1 }, { 0, -1 }, { 1, 1 }, { 0, 1 } };
+
+        for (int s = 0; s < curves->segments; s++)
+        {
+            for (int k = 0; k < sides; k++)
+            {
+                for (int c = 0; c < 6; c++, v += 2)
+                {
+                    v[0] = (float)(s + corners[c][0])/curves->segments;
+                    v[1] = (sides == 1)? corners[c][1] : 2.0f*PI*((float)k + 0.5f + 0.5f*corners[c][1])/sides;
+                }
+            }
+        }
+
+        curves->gpuCapacity = curves->capacity;
+        curves->gpuSegments = curves->segments;
+        curves->gpuMode = curves->mode;
+        curves->templateVertexCount = vertexCount;
+        curves->vaoId = rlLoadVertexArray();
+        rlEnableVertexArray(curves->vaoId);
+
+        curves->vboId[0] = rlLoadVertexBuffer(vertices, vertexCount*2*sizeof(float), false);
+        if (curves->attribLocs[0] >= 0)
+        {
+            rlSetVertexAttribute(curves->attribLocs[0], 2, RL_FLOAT, false, 0, 0);
+            rlEnableVertexAttribute(curves->attribLocs[0]);
+        }
+
+        curves->vboId[1] = rlLoadVertexBuffer(NULL, curves->gpuCapacity*sizeof(CurveInstance), true);
+
+        const size_t offsets[6] = { offsetof(CurveInstance, p1), offsetof(CurveInstance, c2), offsetof(CurveInstance, c3), offsetof(CurveInstance, p4),
+                                    offsetof(CurveInstance, color), offsetof(CurveInstance, width) };
+
+        for (int i = 0; i < 6; i++)
+        {
+            int loc = curves->attribLocs[i + 1];
+            if (loc < 0) continue;
+
+            if (i < 4) rlSetVertexAttribute(loc, 3, RL_FLOAT, false, sizeof(CurveInstance), (void *)offsets[i]);
+            else if (i == 4) rlSetVertexAttribute(loc, 4, RL_UNSIGNED_BYTE, true, sizeof(CurveInstance), (void *)offsets[i]);
+            else rlSetVertexAttribute(loc, 1, RL_FLOAT, false, sizeof(CurveInstance), (void *)offsets[i]);
+            rlSetVertexAttributeDivisor(loc, 1);
+            rlEnableVertexAttribute(loc);
+        }
+
+        rlDisableVertexArray();
+        RL_FREE(vertices);
+    }
+
+    rlUpdateVertexBuffer(curves->vboId[1], curves->instances, curves->count*sizeof(CurveInstance), 0);
+
+    curves->dirty = false;
+}
+
+#endif // CURVE_INSTANCING_IMPLEMENTATION
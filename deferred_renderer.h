@@ -0,0 +1,438 @@
+/**********************************************************************************************
+*
+*   deferred_renderer - G-buffer and screen space light accumulation for many point lights
+*
+*   The geometry pass draws opaque geometry once into a G-buffer (world position, normal, albedo
+*   and depth) with shaders writing the three color targets (gbuffer.vs/fs). Lighting then runs
+*   in screen space, in the current framebuffer:
+*
+*       - one full screen pass (deferred_shading.fs) for the ambient term and the four rlights.h
+*         lights, read from the shared light buffer (light_buffer.h), it also writes the
+*         G-buffer depth so forward draws after it are depth tested
+*       - one volume per point light (deferred_light.vs/fs), a box around its radius drawn with
+*         additive blending, reading the G-buffer under it
+*
+*   A light only costs the pixels its volume covers, not a pass over every object: hundreds of
+*   small lights cost about as much as the pixels they light.
+*
+*   Volumes are drawn back faces only, with the depth test off, so they still light the scene
+*   with the camera inside them. Light data lives in a float texture, 2 texels per light.
+*
+*   The G-buffer only grows: a smaller viewport (a scene drawn at a reduced render scale) uses
+*   its lower left corner, so a changing render scale does not reallocate it.
+*
+*   CONFIGURATION:
+*
+*   #define DEFERRED_RENDERER_IMPLEMENTATION
+*       Generates the implementation of the library into the included file.
+*       If not defined, the library is in header only mode and can be included in other headers
+*       or source files without problems. But only ONE file should hold the implementation.
+*
+**********************************************************************************************/
+
+#ifndef DEFERRED_RENDERER_H
+#define DEFERRED_RENDERER_H
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define DEFERRED_MAX_LIGHTS     1024        // Light data texture width limit
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+
+// Point light lit by its screen space volume
+typedef struct {
+    Vector3 position;
+    float radius;               // No light past this distance
+    Color color;
+    float intensity;
+} DeferredLight;
+
+// G-buffer, lighting shaders and point lights
+typedef struct {
+    unsigned int framebuffer;
+    Texture2D position;         // RGBA32F world position
+    Texture2D normal;           // RGBA16F world normal, zero where nothing was drawn
+    Texture2D albedo;           // RGBA8 albedo and specular
+    Texture2D depth;
+    int width;
+    int height;
+    int viewWidth;              // Part of the G-buffer drawn by the last geometry pass
+    int viewHeight;
+
+    Shader shadingShader;       // Full screen: ambient, rlights.h lights and depth
+    Shader lightShader;         // Light volumes
+    int shadingLocs[4];         // gPosition, gNormal, gAlbedoSpec, gDepth
+    int lightLocs[4];           // gPosition, gNormal, gAlbedoSpec, lightData
+    int viewportLoc;
+
+    DeferredLight *lights;
+    int lightCount;
+    int lightCapacity;
+    Texture2D lightData;        // RGBA32F, lightCapacity x 2
+    float *lightTexels;
+    bool lightsDirty;
+
+    bool lightBlending;         // Additive blending for the volumes, off leaves the caller's blend state
+    int litVolumes;             // Volumes drawn by the last DrawDeferredLighting()
+
+    int savedFramebuffer;       // Restored by EndDeferredGeometry()
+    int savedViewport[4];
+} DeferredRenderer;
+
+#ifdef __cplusplus
+extern "C" {            // Prevents name mangling of functions
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+DeferredRenderer LoadDeferredRenderer(Shader shadingShader, Shader lightShader, int lightCapacity);  // G-buffer loads when the geometry pass begins
+void UnloadDeferredRenderer(DeferredRenderer *renderer);                                 // Unload G-buffer and light data (not the shaders)
+void ClearDeferredLights(DeferredRenderer *renderer);                                    // Remove all point lights
+int AddDeferredLight(DeferredRenderer *renderer, Vector3 position, float radius, Color color);  // Add a point light, returns its index or -1 when full
+void SetDeferredLight(DeferredRenderer *renderer, int index, Vector3 position, float radius, Color color);  // Move or recolor a point light
+void BeginDeferredGeometry(DeferredRenderer *renderer);                                  // Bind and clear the G-buffer, inside BeginMode3D()
+void EndDeferredGeometry(DeferredRenderer *renderer);                                    // Back to the framebuffer and viewport bound before
+void DrawDeferredLighting(DeferredRenderer *renderer, Vector3 viewPosition);  // Shade the G-buffer into the current framebuffer, inside BeginMode3D()
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DEFERRED_RENDERER_H
+
+
+/***********************************************************************************
+*
+*   DEFERRED_RENDERER IMPLEMENTATION
+*
+************************************************************************************/
+
+#if defined(DEFERRED_RENDERER_IMPLEMENTATION)
+
+#include "raylib.h"
+#include "rlgl.h"
+#include "uniform_cache.h"      // Required for: SetShaderValueCached()
+
+#include "gl_loader.h"      // Required for: glGetIntegerv()
+
+#define DEFERRED_DRAW_FRAMEBUFFER_BINDING   0x8CA6      // GL 3.0, not in gl.h
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Declaration
+//----------------------------------------------------------------------------------
+static void LoadDeferredTargets(DeferredRenderer *renderer, int width, int height);
+static void UnloadDeferredTargets(DeferredRenderer *renderer);
+static void UpdateDeferredLightData(DeferredRenderer *renderer);
+static void DrawDeferredLightVolume(Vector3 position, float radius, int index);
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+
+// G-buffer loads when the geometry pass begins
+DeferredRenderer LoadDeferredRenderer(Shader shadingShader, Shader lightShader, int lightCapacity)
+{
+    DeferredRenderer renderer = { 0 };
+
+    if (lightCapacity > DEFERRED_MAX_LIGHTS) lightCapacity = DEFERRED_MAX_LIGHTS;
+
+    renderer.shadingShader = shadingShader;
+    renderer.lightShader = lightShader;
+    renderer.shadingLocs[0] = GetShaderLocation(shadingShader, "gPosition");
+    renderer.shadingLocs[1] = GetShaderLocation(shadingShader, "gNormal");
+    renderer.shadingLocs[2] = GetShaderLocation(shadingShader, "gAlbedoSpec");
+    renderer.shadingLocs[3] = GetShaderLocation(shadingShader, "gDepth");
+    renderer.lightLocs[0] = GetShaderLocation(lightShader, "gPosition");
+    renderer.lightLocs[1] = GetShaderLocation(lightShader, "gNormal");
+    renderer.lightLocs[2] = GetShaderLocation(lightShader, "gAlbedoSpec");
+    renderer.lightLocs[3] = GetShaderLocation(lightShader, "lightData");
+    renderer.viewportLoc = GetShaderLocation(lightShader, "viewport");
+    renderer.shadingShader.locs[SHADER_LOC_VECTOR_VIEW] = GetShaderLocation(shadingShader, "viewPos");
+    renderer.lightShader.locs[SHADER_LOC_VECTOR_VIEW] = GetShaderLocation(lightShader, "viewPos");
+
+    renderer.lights = (DeferredLight *)RL_CALLOC(lightCapacity, sizeof(DeferredLight));
+    renderer.lightCapacity = lightCapacity;
+    renderer.lightTexels = (float *)RL_CALLOC(lightCapacity*2*4, sizeof(float));
+    renderer.lightData.id = rlLoadTexture(renderer.lightTexels, lightCapacity, 2, RL_PIXELFORMAT_UNCOMPRESSED_R32G32B32A32, 1);
+    renderer.lightData.width = lightCapacity;
+    renderer.lightData.height = 2;
+    renderer.lightData.format = PIXELFORMAT_UNCOMPRESSED_R32G32B32A32;
+    renderer.lightData.mipmaps = 1;
+    renderer.lightBlending = true;
+
+    return renderer;
+}
+
+// Unload G-buffer and light data (not the shaders)
+void UnloadDeferredRenderer(DeferredRenderer *renderer)
+{
+    UnloadDeferredTargets(renderer);
+
+    if (renderer->lightData.id > 0) rlUnloadTexture(renderer->lightData.id);
+    RL_FREE(renderer->lights);
+    RL_FREE(renderer->lightTexels);
+
+    *renderer = (DeferredRenderer){ 0 };
+}
+
+// Remove all point lights
+void ClearDeferredLights(DeferredRenderer *renderer)
+{
+    renderer->lightCount = 0;
+    renderer->lightsDirty = true;
+}
+
+// Add a point light, returns its index or -1 when full
+int AddDeferredLight(DeferredRenderer *renderer, Vector3 position, float radius, Color color)
+{
+    if (renderer->lightCount >= renderer->lightCapacity) return -1;
+
+    int index = renderer->lightCount++;
+    SetDeferredLight(renderer, index, position, radius, color);
+
+    return index;
+}
+
+// Move or recolor a point light
+void SetDeferredLight(DeferredRenderer *renderer, int index, Vector3 position, float radius, Color color)
+{
+    if ((index < 0) || (index >= renderer->lightCount)) return;
+
+    DeferredLight *light = &renderer->lights[index];
+    light->position = position;
+    light->radius = radius;
+    light->color = color;
+    light->intensity = 1.0f;
+
+    renderer->lightsDirty = true;
+}
+
+// Bind and clear the G-buffer, inside BeginMode3D()
+// NOTE: The viewport it replaces is drawn in the lower left corner of the G-buffer, the 3d projection
+// set for it still applies. The G-buffer is reallocated only when that viewport does not fit
+void BeginDeferredGeometry(DeferredRenderer *renderer)
+{
+    rlDrawRenderBatchActive();
+
+    glGetIntegerv(DEFERRED_DRAW_FRAMEBUFFER_BINDING, &renderer->savedFramebuffer);
+    glGetIntegerv(GL_VIEWPORT, renderer->savedViewport);
+
+    int width = renderer->savedViewport[2];
+    int height = renderer->savedViewport[3];
+
+    if ((width > renderer->width) || (height > renderer->height))
+    {
+        int targetWidth = (width > renderer->width)? width : renderer->width;
+        int targetHeight = (height > renderer->height)? height : renderer->height;
+
+        UnloadDeferredTargets(renderer);
+        LoadDeferredTargets(renderer, targetWidth, targetHeight);
+    }
+
+    renderer->viewWidth = width;
+    renderer->viewHeight = height;
+
+    rlEnableFramebuffer(renderer->framebuffer);
+    rlViewport(0, 0, width, height);
+    rlClearColor(0, 0, 0, 0);
+    rlClearScreenBuffers();
+
+    // Position and normal alpha are not coverage, blending would mix them
+    rlDisableColorBlend();
+}
+
+// Back to the framebuffer and viewport bound before
+void EndDeferredGeometry(DeferredRenderer *renderer)
+{
+    rlDrawRenderBatchActive();
+    rlEnableColorBlend();
+
+    rlEnableFramebuffer(renderer->savedFramebuffer);
+    rlViewport(renderer->savedViewport[0], renderer->savedViewport[1], renderer->savedViewport[2], renderer->savedViewport[3]);
+}
+
+// Shade the G-buffer into the current framebuffer, inside BeginMode3D()
+void DrawDeferredLighting(DeferredRenderer *renderer, Vector3 viewPosition)
+{
+    if (renderer->framebuffer == 0) return;
+
+    Shader shading = renderer->shadingShader;
+    Shader light = renderer->lightShader;
+
+    rlDrawRenderBatchActive();
+
+    // Full screen quad in clip space, deferred_shading.vs ignores the matrices
+    float u = (float)renderer->viewWidth/renderer->width;
+    float v = (float)renderer->viewHeight/renderer->height;
+
+    BeginShaderMode(shading);
+        SetShaderValueTexture(shading, renderer->shadingLocs[0], renderer->position);
+        SetShaderValueTexture(shading, renderer->shadingLocs[1], renderer->normal);
+        SetShaderValueTexture(shading, renderer->shadingLocs[2], renderer->albedo);
+        SetShaderValueTexture(shading, renderer->shadingLocs[3], renderer->depth);
+        SetShaderValueCached(shading, shading.locs[SHADER_LOC_VECTOR_VIEW], &viewPosition, SHADER_UNIFORM_VEC3);
+
+        rlBegin(RL_QUADS);
+            rlTexCoord2f(0.0f, 0.0f); rlVertex3f(-1.0f, -1.0f, 0.0f);
+            rlTexCoord2f(u, 0.0f); rlVertex3f(1.0f, -1.0f, 0.0f);
+            rlTexCoord2f(u, v); rlVertex3f(1.0f, 1.0f, 0.0f);
+            rlTexCoord2f(0.0f, v); rlVertex3f(-1.0f, 1.0f, 0.0f);
+        rlEnd();
+    EndShaderMode();
+
+    renderer->litVolumes = 0;
+    if (renderer->lightCount == 0) return;
+
+    if (renderer->lightsDirty) UpdateDeferredLightData(renderer);
+
+    // Back faces only and no depth test: a volume covers its pixels once, camera inside or not
+    rlDisableDepthTest();
+    rlDisableDepthMask();
+    rlSetCullFace(RL_CULL_FACE_FRONT);
+    if (renderer->lightBlending) BeginBlendMode(BLEND_ADDITIVE);
+
+    BeginShaderMode(light);
+        float viewport[2] = { (float)renderer->width, (float)renderer->height };      // Pixel to G-buffer coordinates, same origin
+        SetShaderValueTexture(light, renderer->lightLocs[0], renderer->position);
+        SetShaderValueTexture(light, renderer->lightLocs[1], renderer->normal);
+        SetShaderValueTexture(light, renderer->lightLocs[2], renderer->albedo);
+        SetShaderValueTexture(light, renderer->lightLocs[3], renderer->lightData);
+        SetShaderValueCached(light, renderer->viewportLoc, viewport, SHADER_UNIFORM_VEC2);
+        SetShaderValueCached(light, light.locs[SHADER_LOC_VECTOR_VIEW], &viewPosition, SHADER_UNIFORM_VEC3);
+
+        for (int i = 0; i < renderer->lightCount; i++)
+        {
+            if (renderer->lights[i].radius <= 0.0f) continue;
+
+            DrawDeferredLightVolume(renderer->lights[i].position, renderer->lights[i].radius, i);
+            renderer->litVolumes++;
+        }
+    EndShaderMode();
+
+    if (renderer->lightBlending) EndBlendMode();
+    rlSetCullFace(RL_CULL_FACE_BACK);
+    rlEnableDepthMask();
+    rlEnableDepthTest();
+}
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Definition
+//----------------------------------------------------------------------------------
+
+// Three color targets and a depth texture for the current size
+static void LoadDeferredTargets(DeferredRenderer *renderer, int width, int height)
+{
+    renderer->width = width;
+    renderer->height = height;
+    renderer->framebuffer = rlLoadFramebuffer(width, height);
+    rlEnableFramebuffer(renderer->framebuffer);
+
+    renderer->position = (Texture2D){ rlLoadTexture(NULL, width, height, RL_PIXELFORMAT_UNCOMPRESSED_R32G32B32A32, 1), width, height, 1, PIXELFORMAT_UNCOMPRESSED_R32G32B32A32 };
+    renderer->normal = (Texture2D){ rlLoadTexture(NULL, width, height, RL_PIXELFORMAT_UNCOMPRESSED_R16G16B16A16, 1), width, height, 1, PIXELFORMAT_UNCOMPRESSED_R16G16B16A16 };
+    renderer->albedo = (Texture2D){ rlLoadTexture(NULL, width, height, RL_PIXELFORMAT_UNCOMPRESSED_R8G8B8A8, 1), width, height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+    renderer->depth = (Texture2D){ rlLoadTextureDepth(width, height, false), width, height, 1, 19 };    // DEPTH_COMPONENT_24BIT
+
+    // gbuffer.fs writes locations 0, 1 and 2
+    rlActiveDrawBuffers(3);
+
+    rlFramebufferAttach(renderer->framebuffer, renderer->position.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_TEXTURE2D, 0);
+    rlFramebufferAttach(renderer->framebuffer, renderer->normal.id, RL_ATTACHMENT_COLOR_CHANNEL1, RL_ATTACHMENT_TEXTURE2D, 0);
+    rlFramebufferAttach(renderer->framebuffer, renderer->albedo.id, RL_ATTACHMENT_COLOR_CHANNEL2, RL_ATTACHMENT_TEXTURE2D, 0);
+    rlFramebufferAttach(renderer->framebuffer, renderer->depth.id, RL_ATTACHMENT_DEPTH, RL_ATTACHMENT_TEXTURE2D, 0);
+
+    if (!rlFramebufferComplete(renderer->framebuffer)) TraceLog(LOG_WARNING, "DEFERRED: [ID %i] G-buffer is not complete", renderer->framebuffer);
+    else TraceLog(LOG_INFO, "DEFERRED: [ID %i] G-buffer loaded (%i x %i)", renderer->framebuffer, width, height);
+
+    rlDisableFramebuffer();
+}
+
+static void UnloadDeferredTargets(DeferredRenderer *renderer)
+{
+    if (renderer->framebuffer > 0)
+    {
+        rlUnloadTexture(renderer->position.id);
+        rlUnloadTexture(renderer->normal.id);
+        rlUnloadTexture(renderer->albedo.id);
+        rlUnloadTexture(renderer->depth.id);
+        rlUnloadFramebuffer(renderer->framebuffer);
+    }
+
+    renderer->framebuffer = 0;
+    renderer->position = (Texture2D){ 0 };
+    renderer->normal = (Texture2D){ 0 };
+    renderer->albedo = (Texture2D){ 0 };
+    renderer->depth = (Texture2D){ 0 };
+    renderer->width = 0;
+    renderer->height = 0;
+    renderer->viewWidth = 0;
+    renderer->viewHeight = 0;
+}
+
+// Position and radius in row 0, color times intensity in row 1
+static void UpdateDeferredLightData(DeferredRenderer *renderer)
+{
+    int capacity = renderer->lightCapacity;
+
+    for (int i = 0; i < renderer->lightCount; i++)
+    {
+        DeferredLight *light = &renderer->lights[i];
+        float *position = renderer->lightTexels + i*4;
+        float *color = renderer->lightTexels + (capacity + i)*4;
+
+        position[0] = light->position.x;
+        position[1] = light->position.y;
+        position[2] = light->position.z;
+        position[3] = light->radius;
+        color[0] = light->color.r/255.0f*light->intensity;
+        color[1] = light->color.g/255.0f*light->intensity;
+        color[2] = light->color.b/255.0f*light->intensity;
+        color[3] = 1.0f;
+    }
+
+    rlUpdateTexture(renderer->lightData.id, 0, 0, capacity, 2, RL_PIXELFORMAT_UNCOMPRESSED_R32G32B32A32, renderer->lightTexels);
+    renderer->lightsDirty = false;
+}
+
+// Box around the light radius, 12 triangles wound outwards, the light index in texcoord.x
+static void DrawDeferredLightVolume(Vector3 position, float radius, int index)
+{
+    static const int faces[6][4] = {
+        { 0, 1, 3, 2 },     // -x
+        { 4, 6, 7, 5 },     // +x
+        { 0, 4, 5, 1 },     // -y
+        { 2, 3, 7, 6 },     // +y
+        { 0, 2, 6, 4 },     // -z
+        { 1, 5, 7, 3 }      // +z
+    };
+    Vector3 corners[8] = { 0 };
+
+    // Corner bits: x 4, y 2, z 1
+    for (int i = 0; i < 8; i++)
+    {
+        corners[i].x = position.x + ((i & 4)? radius : -radius);
+        corners[i].y = position.y + ((i & 2)? radius : -radius);
+        corners[i].z = position.z + ((i & 1)? radius : -radius);
+    }
+
+    rlCheckRenderBatchLimit(36);
+
+    rlBegin(RL_TRIANGLES);
+        for (int f = 0; f < 6; f++)
+        {
+            const int *q = faces[f];
+            int triangles[6] = { q[0], q[1], q[2], q[0], q[2], q[3] };
+
+            for (int v = 0; v < 6; v++)
+            {
+                rlTexCoord2f((float)index, 0.0f);
+                rlVertex3f(corners[triangles[v]].x, corners[triangles[v]].y, corners[triangles[v]].z);
+            }
+        }
+    rlEnd();
+}
+
+#endif // DEFERRED_RENDERER_IMPLEMENTATION
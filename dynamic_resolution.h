@@ -0,0 +1,237 @@
+/**********************************************************************************************
+*
+*   dynamic_resolution - Render scale of the 3d scene picked each frame from the frame time
+*
+*   A frame over budget is a dropped frame. Most of the cost of the scene layer grows with its
+*   pixel count (shading, fill rate, post effects at its size), so drawing it at a fraction of
+*   the window resolution and upscaling it (layer_compositor.h) buys the time back, and the
+*   UI and text stay sharp at native resolution.
+*
+*   The controller keeps a smoothed frame time and compares it to the budget:
+*
+*       - down: over upperBound of the budget, the scale drops to where the pixel count fits
+*         the target (time taken as proportional to scale squared), several steps at once
+*       - up: one step, only if the time predicted at the next step stays under the target,
+*         so a fill bound scene does not oscillate between two steps
+*       - hold: otherwise, and for holdFrames frames after every change while the average
+*         catches up with the new scale
+*
+*   Scales are multiples of step so the scale settles instead of drifting. The buffers sized
+*   from the scene (layer targets, MSAA, G-buffer) keep their full size and are drawn in a
+*   sub-viewport, a scale change reallocates nothing.
+*
+*   The frame time fed should be GPU time when the scale is meant to save GPU work, read back
+*   with timer queries a frame or two late (gpu_timer.h), not waited for with glFinish().
+*
+*   CONFIGURATION:
+*
+*   #define DYNAMIC_RESOLUTION_IMPLEMENTATION
+*       Generates the implementation of the library into the included file.
+*       If not defined, the library is in header only mode and can be included in other headers
+*       or source files without problems. But only ONE file should hold the implementation.
+*
+**********************************************************************************************/
+
+#ifndef DYNAMIC_RESOLUTION_H
+#define DYNAMIC_RESOLUTION_H
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+
+// Controller decisions
+typedef enum {
+    RESOLUTION_HOLD = 0,
+    RESOLUTION_DOWN,
+    RESOLUTION_UP,
+} ResolutionDecision;
+
+// Frame time controller of a render scale
+typedef struct {
+    float scale;                // Current render scale, minScale..maxScale
+    float minScale;
+    float maxScale;
+    float step;                 // Scales are multiples of it
+    float budget;               // Seconds per frame
+    float target;               // Fraction of the budget aimed at, headroom for spikes
+    float upperBound;           // Fraction of the budget over which the scale goes down
+    float smoothing;            // Weight of a new frame time in the average
+    int holdFrames;             // Frames without decision after a change
+    float average;              // Smoothed frame time (seconds)
+    int hold;                   // Frames left before the next decision
+    int decision;               // Last decision (ResolutionDecision)
+    float decisionTime;         // Average the last change was decided on
+    int changeCount;
+    int frameCount;
+} ResolutionController;
+
+#ifdef __cplusplus
+extern "C" {            // Prevents name mangling of functions
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+ResolutionController LoadResolutionController(float budget);                             // Full scale controller for a frame budget (seconds)
+void SetResolutionBudget(ResolutionController *controller, float budget);               // New budget, decisions restart from the current average
+float UpdateResolutionController(ResolutionController *controller, float frameTime);    // Add a frame time, returns the scale of the next frame
+const char *GetResolutionDecisionName(int decision);                                    // "hold", "down" or "up"
+
+void BenchmarkResolutionController(int frames);                                         // Log settling and over budget frames on a simulated load
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DYNAMIC_RESOLUTION_H
+
+
+/***********************************************************************************
+*
+*   DYNAMIC_RESOLUTION IMPLEMENTATION
+*
+************************************************************************************/
+
+#if defined(DYNAMIC_RESOLUTION_IMPLEMENTATION)
+
+#include "raylib.h"
+
+#include <math.h>               // Required for: sqrtf(), floorf()
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Declaration
+//----------------------------------------------------------------------------------
+static float ClampResolutionScale(const ResolutionController *controller, float scale);
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+
+// Full scale controller for a frame budget (seconds)
+ResolutionController LoadResolutionController(float budget)
+{
+    ResolutionController controller = { 0 };
+
+    controller.scale = 1.0f;
+    controller.minScale = 0.5f;
+    controller.maxScale = 1.0f;
+    controller.step = 0.05f;
+    controller.budget = budget;
+    controller.target = 0.85f;
+    controller.upperBound = 0.95f;
+    controller.smoothing = 0.2f;
+    controller.holdFrames = 10;
+
+    return controller;
+}
+
+// New budget, decisions restart from the current average
+void SetResolutionBudget(ResolutionController *controller, float budget)
+{
+    if (budget == controller->budget) return;
+
+    controller->budget = budget;
+    controller->hold = 0;
+}
+
+// Add a frame time, returns the scale of the next frame
+float UpdateResolutionController(ResolutionController *controller, float frameTime)
+{
+    controller->average = (controller->frameCount == 0)? frameTime : controller->average + (frameTime - controller->average)*controller->smoothing;
+    controller->frameCount++;
+
+    if (controller->hold > 0)
+    {
+        controller->hold--;
+        return controller->scale;
+    }
+
+    float scale = controller->scale;
+    float target = controller->budget*controller->target;
+
+    if (controller->average > controller->budget*controller->upperBound)
+    {
+        // Pixels cut to fit the target, at least one step
+        float fit = ClampResolutionScale(controller, scale*sqrtf(target/controller->average));
+        scale = (fit < scale)? fit : ClampResolutionScale(controller, scale - controller->step);
+    }
+    else
+    {
+        float next = ClampResolutionScale(controller, scale + controller->step);
+        float predicted = controller->average*(next*next)/(scale*scale);
+        if (predicted < target) scale = next;
+    }
+
+    if (scale == controller->scale)
+    {
+        controller->decision = RESOLUTION_HOLD;
+        return scale;
+    }
+
+    controller->decision = (scale < controller->scale)? RESOLUTION_DOWN : RESOLUTION_UP;
+    controller->decisionTime = controller->average;
+    controller->scale = scale;
+    controller->hold = controller->holdFrames;
+    controller->changeCount++;
+
+    return scale;
+}
+
+// "hold", "down" or "up"
+const char *GetResolutionDecisionName(int decision)
+{
+    if (decision == RESOLUTION_DOWN) return "down";
+    else if (decision == RESOLUTION_UP) return "up";
+    else return "hold";
+}
+
+// Log settling and over budget frames on a simulated load
+// NOTE: Frame time is 2 ms plus a pixel cost times scale squared, the pixel cost triples halfway
+void BenchmarkResolutionController(int frames)
+{
+    const float budget = 1.0f/60.0f;
+    ResolutionController controller = LoadResolutionController(budget);
+    int overBudget[2] = { 0 };
+    int settled[2] = { -1, -1 };
+    int changes = 0;
+
+    for (int f = 0; f < frames; f++)
+    {
+        int half = (f < frames/2)? 0 : 1;
+        float pixelTime = (half == 0)? 0.010f : 0.030f;
+        float frameTime = 0.002f + pixelTime*controller.scale*controller.scale;
+
+        if (frameTime > budget) overBudget[half]++;
+
+        int before = controller.changeCount;
+        UpdateResolutionController(&controller, frameTime);
+        if (controller.changeCount != before) settled[half] = f - half*(frames/2);
+
+        if (f == frames/2 - 1)
+        {
+            TraceLog(LOG_INFO, "RESOLUTION: light load: scale %.2f, settled after %i frames, %i over budget",
+                     controller.scale, settled[0] + 1, overBudget[0]);
+            changes = controller.changeCount;
+        }
+    }
+
+    TraceLog(LOG_INFO, "RESOLUTION: 3x load: scale %.2f, settled after %i frames, %i over budget, %i changes",
+             controller.scale, settled[1] + 1, overBudget[1], controller.changeCount - changes);
+}
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Definition
+//----------------------------------------------------------------------------------
+
+// Nearest lower multiple of the step, within the scale range
+static float ClampResolutionScale(const ResolutionController *controller, float scale)
+{
+    scale = floorf(scale/controller->step + 0.001f)*controller->step;
+
+    if (scale < controller->minScale) scale = controller->minScale;
+    if (scale > controller->maxScale) scale = controller->maxScale;
+
+    return scale;
+}
+
+#endif // DYNAMIC_RESOLUTION_IMPLEMENTATION
@@ -0,0 +1,77 @@
+/**********************************************************************************************
+*
+*   gl_loader - GL header and the GL entry points rlgl does not expose
+*
+*   The modules drawing through rlgl still need a few GL calls of their own (glFinish(),
+*   glGetIntegerv()...) and some GL 3.x functions rlgl has no wrapper for (renderbuffers,
+*   uniform buffer bindings, program binaries, queries). This header includes gl.h the same way
+*   for all of them and declares the function types those modules load.
+*
+*   GL 3.x functions are not exported by the system GL library on every platform, modules load
+*   them at runtime with glfwGetProcAddress() from raylib's desktop platform, once, and keep
+*   working without the feature when the driver does not have it (NULL pointer).
+*
+*   NOTE: Declarations only, there is no implementation part to define.
+*
+**********************************************************************************************/
+
+#ifndef GL_LOADER_H
+#define GL_LOADER_H
+
+#if defined(_WIN32)
+    #ifndef APIENTRY
+        #define APIENTRY __stdcall          // Lets gl.h build without windows.h, whose names clash with raylib
+    #endif
+    #ifndef WINGDIAPI
+        #define WINGDIAPI __declspec(dllimport)
+    #endif
+#endif
+#if defined(__APPLE__)
+    #include <OpenGL/gl.h>
+#else
+    #include <GL/gl.h>
+#endif
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef void (*GLLoaderProc)(void);
+
+// Renderbuffers (GL 3.0)
+typedef void (APIENTRY *GLGenRenderbuffersProc)(int n, unsigned int *renderbuffers);
+typedef void (APIENTRY *GLDeleteRenderbuffersProc)(int n, const unsigned int *renderbuffers);
+typedef void (APIENTRY *GLBindRenderbufferProc)(unsigned int target, unsigned int renderbuffer);
+typedef void (APIENTRY *GLRenderbufferStorageMultisampleProc)(unsigned int target, int samples, unsigned int format, int width, int height);
+
+// Uniform buffer bindings (GL 3.1)
+typedef void (APIENTRY *GLBindBufferBaseProc)(unsigned int target, unsigned int index, unsigned int buffer);
+
+// Programs and program binaries (GL 4.1)
+typedef unsigned int (APIENTRY *GLCreateProgramProc)(void);
+typedef void (APIENTRY *GLGetProgramivProc)(unsigned int program, unsigned int pname, int *params);
+typedef void (APIENTRY *GLGetProgramBinaryProc)(unsigned int program, int bufSize, int *length, unsigned int *binaryFormat, void *binary);
+typedef void (APIENTRY *GLProgramBinaryProc)(unsigned int program, unsigned int binaryFormat, const void *binary, int length);
+
+// Queries (GL 1.5, 64 bit results GL 3.3)
+typedef void (APIENTRY *GLGenQueriesProc)(int n, unsigned int *ids);
+typedef void (APIENTRY *GLDeleteQueriesProc)(int n, const unsigned int *ids);
+typedef void (APIENTRY *GLBeginQueryProc)(unsigned int target, unsigned int id);
+typedef void (APIENTRY *GLEndQueryProc)(unsigned int target);
+typedef void (APIENTRY *GLGetQueryObjectivProc)(unsigned int id, unsigned int pname, int *params);
+typedef void (APIENTRY *GLGetQueryObjectui64vProc)(unsigned int id, unsigned int pname, unsigned long long *params);
+typedef void (APIENTRY *GLQueryCounterProc)(unsigned int id, unsigned int target);
+
+#ifdef __cplusplus
+extern "C" {            // Prevents name mangling of functions
+#endif
+
+//----------------------------------------------------------------------------------
+// Functions Declaration
+//----------------------------------------------------------------------------------
+GLLoaderProc glfwGetProcAddress(const char *procname);     // Provided by raylib (GLFW), NULL when not available
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GL_LOADER_H
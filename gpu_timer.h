@@ -0,0 +1,205 @@
+/**********************************************************************************************
+*
+*   gpu_timer - GPU time of whole frames, read back a few frames late so it never stalls
+*
+*   Waiting for the GPU to finish a frame (glFinish()) to time it serializes CPU and GPU: the
+*   CPU cannot build the next frame while the GPU draws this one. The timer instead writes a
+*   GL_TIMESTAMP at the start and at the end of the frame and reads the pair back once the GPU
+*   got there, usually one or two frames later.
+*
+*   Frames in flight each hold their own pair, GPU_TIMER_FRAMES of them. A frame finding its
+*   slot still in flight is not timed rather than waited for.
+*
+*   Timestamps (glQueryCounter()) are used instead of a GL_TIME_ELAPSED query: elapsed queries
+*   of the same target cannot nest and the post chain (post_chain.h) times its passes with them
+*   inside the frame. The time between the two stamps includes gaps where the GPU waited for
+*   commands, a CPU bound frame reads close to its submission time.
+*
+*   NOTE: Query functions are not part of rlgl, they are loaded through glfwGetProcAddress()
+*   from raylib's desktop platform. Without them the timer gives no result.
+*
+*   CONFIGURATION:
+*
+*   #define GPU_TIMER_IMPLEMENTATION
+*       Generates the implementation of the library into the included file.
+*       If not defined, the library is in header only mode and can be included in other headers
+*       or source files without problems. But only ONE file should hold the implementation.
+*
+**********************************************************************************************/
+
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define GPU_TIMER_FRAMES        4       // Frames timed in flight
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+
+// Timestamp pairs of the frames in flight and the last result read back
+typedef struct {
+    unsigned int queries[GPU_TIMER_FRAMES][2];  // Start and end timestamps, 0 without queries
+    bool pending[GPU_TIMER_FRAMES];             // Issued, result not read yet
+    bool keep[GPU_TIMER_FRAMES];                // Result wanted, others are read and dropped
+    int next;                                   // Slot of the next frame, the oldest one in flight
+    bool timing;                                // Current frame is timed
+    float time;                                 // Seconds, last result kept
+    int resultCount;                            // Results kept, changes when time is new
+    int skippedCount;                           // Frames not timed, their slot still in flight
+} GpuTimer;
+
+#ifdef __cplusplus
+extern "C" {            // Prevents name mangling of functions
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+GpuTimer LoadGpuTimer(void);                                // Queries of every slot, none issued yet
+void UnloadGpuTimer(GpuTimer *timer);                       // Delete the queries
+void BeginGpuTimer(GpuTimer *timer);                        // Read back finished frames, then stamp the start of this one
+void EndGpuTimer(GpuTimer *timer, bool keep);               // Stamp the end of the frame, after its last batch is flushed
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GPU_TIMER_H
+
+
+/***********************************************************************************
+*
+*   GPU_TIMER IMPLEMENTATION
+*
+************************************************************************************/
+
+#if defined(GPU_TIMER_IMPLEMENTATION)
+
+#include "raylib.h"
+
+#include "gl_loader.h"      // Required for: glfwGetProcAddress(), GL function types
+
+#define GPU_TIMER_GL_TIMESTAMP                  0x8E28      // GL 3.3, not in gl.h
+#define GPU_TIMER_GL_QUERY_RESULT               0x8866
+#define GPU_TIMER_GL_QUERY_RESULT_AVAILABLE     0x8867
+
+//----------------------------------------------------------------------------------
+// Global Variables Definition
+//----------------------------------------------------------------------------------
+static GLGenQueriesProc gpuTimerGenQueries = NULL;
+static GLDeleteQueriesProc gpuTimerDeleteQueries = NULL;
+static GLQueryCounterProc gpuTimerQueryCounter = NULL;
+static GLGetQueryObjectivProc gpuTimerGetQueryObjectiv = NULL;
+static GLGetQueryObjectui64vProc gpuTimerGetQueryObjectui64v = NULL;
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Declaration
+//----------------------------------------------------------------------------------
+static bool ReadGpuTimerSlot(GpuTimer *timer, int slot);
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+
+// Queries of every slot, none issued yet
+GpuTimer LoadGpuTimer(void)
+{
+    GpuTimer timer = { 0 };
+
+    if (gpuTimerGenQueries == NULL)
+    {
+        gpuTimerGenQueries = (GLGenQueriesProc)glfwGetProcAddress("glGenQueries");
+        gpuTimerDeleteQueries = (GLDeleteQueriesProc)glfwGetProcAddress("glDeleteQueries");
+        gpuTimerQueryCounter = (GLQueryCounterProc)glfwGetProcAddress("glQueryCounter");
+        gpuTimerGetQueryObjectiv = (GLGetQueryObjectivProc)glfwGetProcAddress("glGetQueryObjectiv");
+        gpuTimerGetQueryObjectui64v = (GLGetQueryObjectui64vProc)glfwGetProcAddress("glGetQueryObjectui64v");
+    }
+
+    if ((gpuTimerGenQueries != NULL) && (gpuTimerQueryCounter != NULL) && (gpuTimerGetQueryObjectui64v != NULL))
+    {
+        for (int i = 0; i < GPU_TIMER_FRAMES; i++) gpuTimerGenQueries(2, timer.queries[i]);
+    }
+    else TraceLog(LOG_WARNING, "GPU TIMER: Timestamp queries not available, frames are not timed");
+
+    return timer;
+}
+
+// Delete the queries
+void UnloadGpuTimer(GpuTimer *timer)
+{
+    for (int i = 0; i < GPU_TIMER_FRAMES; i++)
+    {
+        if (timer->queries[i][0] != 0) gpuTimerDeleteQueries(2, timer->queries[i]);
+    }
+
+    *timer = (GpuTimer){ 0 };
+}
+
+// Read back finished frames, then stamp the start of this one
+void BeginGpuTimer(GpuTimer *timer)
+{
+    timer->timing = false;
+
+    if (timer->queries[0][0] == 0) return;
+
+    // Oldest first, frames finish in order
+    for (int i = 0; i < GPU_TIMER_FRAMES; i++)
+    {
+        int slot = (timer->next + i)%GPU_TIMER_FRAMES;
+        if (timer->pending[slot] && !ReadGpuTimerSlot(timer, slot)) break;
+    }
+
+    if (timer->pending[timer->next])
+    {
+        timer->skippedCount++;
+        return;
+    }
+
+    gpuTimerQueryCounter(timer->queries[timer->next][0], GPU_TIMER_GL_TIMESTAMP);
+    timer->timing = true;
+}
+
+// Stamp the end of the frame, after its last batch is flushed
+// NOTE: keep false reads the result back and drops it (frames not worth measuring)
+void EndGpuTimer(GpuTimer *timer, bool keep)
+{
+    if (!timer->timing) return;
+
+    gpuTimerQueryCounter(timer->queries[timer->next][1], GPU_TIMER_GL_TIMESTAMP);
+    timer->pending[timer->next] = true;
+    timer->keep[timer->next] = keep;
+    timer->next = (timer->next + 1)%GPU_TIMER_FRAMES;
+    timer->timing = false;
+}
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Definition
+//----------------------------------------------------------------------------------
+
+// Result of a slot if the GPU got past its end stamp, false while it is still in flight
+static bool ReadGpuTimerSlot(GpuTimer *timer, int slot)
+{
+    int available = 0;
+    gpuTimerGetQueryObjectiv(timer->queries[slot][1], GPU_TIMER_GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) return false;
+
+    if (timer->keep[slot])
+    {
+        unsigned long long start = 0;
+        unsigned long long end = 0;
+        gpuTimerGetQueryObjectui64v(timer->queries[slot][0], GPU_TIMER_GL_QUERY_RESULT, &start);
+        gpuTimerGetQueryObjectui64v(timer->queries[slot][1], GPU_TIMER_GL_QUERY_RESULT, &end);
+
+        timer->time = (float)((end - start)/1.0e9);
+        timer->resultCount++;
+    }
+
+    timer->pending[slot] = false;
+
+    return true;
+}
+
+#endif // GPU_TIMER_IMPLEMENTATION
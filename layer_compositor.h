@@ -0,0 +1,631 @@
+/**********************************************************************************************
+*
+*   layer_compositor - screen layers drawn into their own render targets, redrawn only when their
+*   inputs change and composited every frame
+*
+*   A frame is split in layers that change at different rates (3d scene, text overlays, UI). Each
+*   layer keeps its last image in a render target together with a hash of the inputs it was drawn
+*   with. A layer is redrawn when the hash changes, when it is invalidated, or when its refresh
+*   interval elapses (for content like an FPS readout that changes every frame but does not need
+*   to be redrawn every frame). Presenting a frame is one textured quad per visible layer.
+*
+*   The bottom layer can be drawn multisampled, in a framebuffer of the compositor with the
+*   sample count set at runtime, and resolved into its target with a framebuffer blit (render
+*   textures have no MSAA). The window framebuffer itself does not need MSAA. With 0 samples
+*   the layer is drawn straight into its target.
+*
+*   Transparent layers are drawn with the alpha blend factors split so the target ends up with
+*   premultiplied alpha (color*alpha, alpha), composited with BLEND_ALPHA_PREMULTIPLY.
+*
+*   A layer can be drawn at a fraction of its target size (dynamic resolution): the viewport
+*   covers scale*size in the corner of the target and the same 2d projection, so draw code does
+*   not change. After a redraw the compositor upscales that corner into a full size image, with
+*   the sharpening upscale shader when set (upscale_sharpen.fs). Post and compositing only see
+*   the full size image, the layers over it stay at native resolution.
+*
+*   A layer can have a post function (post_chain.h), run over its image after a redraw or when
+*   its own key changes. The texture it returns is composited instead of the target, and a
+*   cached layer keeps its processed image: post effects cost nothing while the layer is unchanged.
+*
+*   NOTE: Multisampled renderbuffers are not part of rlgl, their functions are loaded through
+*   glfwGetProcAddress() from raylib's desktop platform. Without them MSAA layers get no MSAA.
+*
+*   CONFIGURATION:
+*
+*   #define LAYER_COMPOSITOR_IMPLEMENTATION
+*       Generates the implementation of the library into the included file.
+*       If not defined, the library is in header only mode and can be included in other headers
+*       or source files without problems. But only ONE file should hold the implementation.
+*
+**********************************************************************************************/
+
+#ifndef LAYER_COMPOSITOR_H
+#define LAYER_COMPOSITOR_H
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define COMPOSITOR_MAX_LAYERS       8
+
+#define COMPOSITOR_LAYER_OPAQUE     1       // Covers the whole window, composited without blending
+#define COMPOSITOR_LAYER_MSAA       2       // Drawn multisampled and resolved (implies opaque)
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef void (*CompositorDrawFunc)(void);
+typedef Texture2D (*CompositorPostFunc)(Texture2D image);      // Returns the image to composite
+
+// One layer and its cached image
+typedef struct {
+    RenderTexture2D target;
+    CompositorDrawFunc draw;
+    int flags;
+    Color clear;                // Target cleared to this before drawing (BLANK for overlays)
+    float refresh;              // Seconds between redraws of an unchanged layer, 0 for never
+    double drawTime;            // GetTime() of the last redraw
+    unsigned int key;           // Hash of the inputs the image was drawn with
+    bool dirty;
+    bool visible;
+    bool redrawn;               // Redrawn in the last update
+    int redrawCount;
+    CompositorPostFunc post;    // Optional, run over the target after a redraw
+    Texture2D image;            // Result of the post function
+    unsigned int postKey;       // Hash of the post function inputs
+    bool postDirty;
+    float scale;                // Drawn at this fraction of the target size, 1 for native
+    int viewportWidth;          // Size it was last drawn at
+    int viewportHeight;
+    RenderTexture2D upscaled;   // Target size image of a scaled layer
+} CompositorLayer;
+
+// Layers, composited in the order they were added
+typedef struct {
+    CompositorLayer layers[COMPOSITOR_MAX_LAYERS];
+    int layerCount;
+    int width;                  // Screen size the targets were loaded for
+    int height;
+    int frameCount;
+    int samples;                // Of the MSAA layers, 0 draws them straight into their target
+    unsigned int msaaFramebuffer;   // Multisampled color and depth, shared by the MSAA layers
+    unsigned int msaaColor;
+    unsigned int msaaDepth;
+    int msaaWidth;
+    int msaaHeight;
+    int msaaSamples;
+    Shader upscaleShader;       // Upscale of the scaled layers, bilinear when not set
+    int sourceTexelLoc;
+    int sourceExtentLoc;
+    int sharpnessLoc;
+    float sharpness;
+} LayerCompositor;
+
+#ifdef __cplusplus
+extern "C" {            // Prevents name mangling of functions
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+LayerCompositor LoadLayerCompositor(void);                                                     // Empty compositor, targets load on the first update
+void UnloadLayerCompositor(LayerCompositor *compositor);                                       // Unload all layer targets
+int AddCompositorLayer(LayerCompositor *compositor, CompositorDrawFunc draw, int flags, Color clear, float refresh);  // Add a layer on top, returns its index
+void SetCompositorLayerKey(LayerCompositor *compositor, int layer, const void *key, int size);  // Layer inputs, redrawn when they differ from the last image
+void SetCompositorLayerVisible(LayerCompositor *compositor, int layer, bool visible);          // Hidden layers are neither redrawn nor composited
+void InvalidateCompositorLayer(LayerCompositor *compositor, int layer);                        // Redraw on the next update
+void SetCompositorLayerPost(LayerCompositor *compositor, int layer, CompositorPostFunc post);   // Process the layer image after each redraw, NULL for none
+void SetCompositorPostKey(LayerCompositor *compositor, int layer, const void *key, int size);   // Post inputs, run again (without a redraw) when they differ
+void UpdateLayerCompositor(LayerCompositor *compositor);                                       // Redraw the layers that need it (call first in the frame)
+void DrawLayerCompositor(LayerCompositor *compositor);                                         // Composite all visible layers over the window
+void SetCompositorSamples(LayerCompositor *compositor, int samples);                           // MSAA samples of the MSAA layers, 0 for none
+void SetCompositorLayerScale(LayerCompositor *compositor, int layer, float scale);             // Draw the layer at a fraction of its size and upscale it
+void SetCompositorUpscaleShader(LayerCompositor *compositor, Shader shader, float sharpness);  // Sharpening upscale (upscale_sharpen.fs) of the scaled layers
+
+void BenchmarkLayerCompositor(int texts, int frames);                                          // Log cost of redrawing an overlay vs compositing its image
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LAYER_COMPOSITOR_H
+
+
+/***********************************************************************************
+*
+*   LAYER_COMPOSITOR IMPLEMENTATION
+*
+************************************************************************************/
+
+#if defined(LAYER_COMPOSITOR_IMPLEMENTATION)
+
+#include "raylib.h"
+#include "rlgl.h"
+
+#include "gl_loader.h"      // Required for: glFinish(), glfwGetProcAddress()
+
+#define COMPOSITOR_COLOR_BUFFER_BIT 0x00004000      // GL_COLOR_BUFFER_BIT, for rlBlitFramebuffer()
+#define COMPOSITOR_GL_RENDERBUFFER  0x8D41          // GL 3.0, not in gl.h
+#define COMPOSITOR_GL_RGBA8         0x8058
+#define COMPOSITOR_GL_DEPTH24       0x81A6          // GL_DEPTH_COMPONENT24
+#define COMPOSITOR_GL_MAX_SAMPLES   0x8D57
+
+//----------------------------------------------------------------------------------
+// Global Variables Definition
+//----------------------------------------------------------------------------------
+static GLGenRenderbuffersProc compositorGenRenderbuffers = NULL;
+static GLDeleteRenderbuffersProc compositorDeleteRenderbuffers = NULL;
+static GLBindRenderbufferProc compositorBindRenderbuffer = NULL;
+static GLRenderbufferStorageMultisampleProc compositorRenderbufferStorageMultisample = NULL;
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Declaration
+//----------------------------------------------------------------------------------
+static void LoadCompositorTargets(LayerCompositor *compositor);
+static bool LoadCompositorMsaa(LayerCompositor *compositor, int width, int height);
+static void UnloadCompositorMsaa(LayerCompositor *compositor);
+static void DrawCompositorLayer(LayerCompositor *compositor, CompositorLayer *layer);
+static void UpscaleCompositorLayer(LayerCompositor *compositor, CompositorLayer *layer);
+static Texture2D GetCompositorLayerImage(const CompositorLayer *layer);
+static unsigned int HashCompositorKey(const void *key, int size);
+static void DrawBenchmarkTexts(void);
+
+static int benchmarkTexts = 0;
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+
+// Empty compositor, targets load on the first update
+LayerCompositor LoadLayerCompositor(void)
+{
+    LayerCompositor compositor = { 0 };
+
+    compositor.samples = 4;
+
+    if (compositorGenRenderbuffers == NULL)
+    {
+        compositorGenRenderbuffers = (GLGenRenderbuffersProc)glfwGetProcAddress("glGenRenderbuffers");
+        compositorDeleteRenderbuffers = (GLDeleteRenderbuffersProc)glfwGetProcAddress("glDeleteRenderbuffers");
+        compositorBindRenderbuffer = (GLBindRenderbufferProc)glfwGetProcAddress("glBindRenderbuffer");
+        compositorRenderbufferStorageMultisample = (GLRenderbufferStorageMultisampleProc)glfwGetProcAddress("glRenderbufferStorageMultisample");
+    }
+
+    return compositor;
+}
+
+// Unload all layer targets
+void UnloadLayerCompositor(LayerCompositor *compositor)
+{
+    for (int i = 0; i < compositor->layerCount; i++)
+    {
+        if (compositor->layers[i].target.id > 0) UnloadRenderTexture(compositor->layers[i].target);
+        if (compositor->layers[i].upscaled.id > 0) UnloadRenderTexture(compositor->layers[i].upscaled);
+    }
+
+    UnloadCompositorMsaa(compositor);
+
+    *compositor = (LayerCompositor){ 0 };
+}
+
+// Add a layer on top, returns its index
+int AddCompositorLayer(LayerCompositor *compositor, CompositorDrawFunc draw, int flags, Color clear, float refresh)
+{
+    if (compositor->layerCount >= COMPOSITOR_MAX_LAYERS)
+    {
+        TraceLog(LOG_WARNING, "COMPOSITOR: Layer limit (%i) reached", COMPOSITOR_MAX_LAYERS);
+        return -1;
+    }
+
+    CompositorLayer *layer = &compositor->layers[compositor->layerCount];
+    *layer = (CompositorLayer){ 0 };
+    layer->draw = draw;
+    layer->flags = (flags & COMPOSITOR_LAYER_MSAA)? (flags | COMPOSITOR_LAYER_OPAQUE) : flags;
+    layer->clear = clear;
+    layer->refresh = refresh;
+    layer->dirty = true;
+    layer->visible = true;
+    layer->scale = 1.0f;
+
+    compositor->width = 0;      // Loads the new target on the next update
+
+    return compositor->layerCount++;
+}
+
+// Layer inputs, redrawn when they differ from the last image
+void SetCompositorLayerKey(LayerCompositor *compositor, int layer, const void *key, int size)
+{
+    unsigned int hash = HashCompositorKey(key, size);
+
+    if (hash != compositor->layers[layer].key)
+    {
+        compositor->layers[layer].key = hash;
+        compositor->layers[layer].dirty = true;
+    }
+}
+
+// Hidden layers are neither redrawn nor composited
+void SetCompositorLayerVisible(LayerCompositor *compositor, int layer, bool visible)
+{
+    // Whatever changed while hidden was not drawn
+    if (visible && !compositor->layers[layer].visible) compositor->layers[layer].dirty = true;
+
+    compositor->layers[layer].visible = visible;
+}
+
+// Redraw on the next update
+void InvalidateCompositorLayer(LayerCompositor *compositor, int layer)
+{
+    compositor->layers[layer].dirty = true;
+}
+
+// Process the layer image after each redraw, NULL for none
+void SetCompositorLayerPost(LayerCompositor *compositor, int layer, CompositorPostFunc post)
+{
+    compositor->layers[layer].post = post;
+    compositor->layers[layer].postDirty = true;
+}
+
+// Post inputs, run again (without a redraw) when they differ
+void SetCompositorPostKey(LayerCompositor *compositor, int layer, const void *key, int size)
+{
+    unsigned int hash = HashCompositorKey(key, size);
+
+    if (hash != compositor->layers[layer].postKey)
+    {
+        compositor->layers[layer].postKey = hash;
+        compositor->layers[layer].postDirty = true;
+    }
+}
+
+// Redraw the layers that need it (call first in the frame)
+void UpdateLayerCompositor(LayerCompositor *compositor)
+{
+    if ((compositor->width != GetScreenWidth()) || (compositor->height != GetScreenHeight())) LoadCompositorTargets(compositor);
+
+    double time = GetTime();
+
+    for (int i = 0; i < compositor->layerCount; i++)
+    {
+        CompositorLayer *layer = &compositor->layers[i];
+        bool expired = (layer->refresh > 0.0f) && ((time - layer->drawTime) >= layer->refresh);
+
+        layer->redrawn = layer->visible && (layer->dirty || expired);
+        if (layer->redrawn)
+        {
+            DrawCompositorLayer(compositor, layer);
+            if (layer->scale < 1.0f) UpscaleCompositorLayer(compositor, layer);
+
+            layer->dirty = false;
+            layer->drawTime = time;
+            layer->redrawCount++;
+        }
+
+        if ((layer->post != NULL) && layer->visible && (layer->redrawn || layer->postDirty))
+        {
+            layer->image = layer->post(GetCompositorLayerImage(layer));
+            layer->postDirty = false;
+        }
+    }
+
+    compositor->frameCount++;
+}
+
+// Composite all visible layers over the window
+void DrawLayerCompositor(LayerCompositor *compositor)
+{
+    Rectangle dest = { 0.0f, 0.0f, (float)GetScreenWidth(), (float)GetScreenHeight() };
+
+    for (int i = 0; i < compositor->layerCount; i++)
+    {
+        CompositorLayer *layer = &compositor->layers[i];
+        if (!layer->visible) continue;
+
+        // Render textures are bottom up
+        Texture2D image = (layer->post != NULL)? layer->image : GetCompositorLayerImage(layer);
+        Rectangle source = { 0.0f, 0.0f, (float)image.width, -(float)image.height };
+
+        if (layer->flags & COMPOSITOR_LAYER_OPAQUE)
+        {
+            DrawTexturePro(image, source, dest, (Vector2){ 0.0f, 0.0f }, 0.0f, WHITE);
+        }
+        else
+        {
+            BeginBlendMode(BLEND_ALPHA_PREMULTIPLY);
+                DrawTexturePro(image, source, dest, (Vector2){ 0.0f, 0.0f }, 0.0f, WHITE);
+            EndBlendMode();
+        }
+    }
+}
+
+// MSAA samples of the MSAA layers, 0 for none
+// NOTE: Clamped to the driver maximum when the multisampled buffers load
+void SetCompositorSamples(LayerCompositor *compositor, int samples)
+{
+    if (samples == compositor->samples) return;
+
+    compositor->samples = samples;
+
+    for (int i = 0; i < compositor->layerCount; i++)
+    {
+        if (compositor->layers[i].flags & COMPOSITOR_LAYER_MSAA) compositor->layers[i].dirty = true;
+    }
+}
+
+// Draw the layer at a fraction of its size and upscale it
+// NOTE: Clamped to 0.25..1, a different scale redraws the layer
+void SetCompositorLayerScale(LayerCompositor *compositor, int layer, float scale)
+{
+    scale = (scale < 0.25f)? 0.25f : (scale > 1.0f)? 1.0f : scale;
+
+    if (scale == compositor->layers[layer].scale) return;
+
+    compositor->layers[layer].scale = scale;
+    compositor->layers[layer].dirty = true;
+}
+
+// Sharpening upscale (upscale_sharpen.fs) of the scaled layers
+// NOTE: The shader gets sourceTexel (texel size of the layer target), sourceExtent (texture coordinates
+// of the drawn corner, taps past it must be clamped) and sharpness, 0..1
+void SetCompositorUpscaleShader(LayerCompositor *compositor, Shader shader, float sharpness)
+{
+    compositor->upscaleShader = shader;
+    compositor->sourceTexelLoc = GetShaderLocation(shader, "sourceTexel");
+    compositor->sourceExtentLoc = GetShaderLocation(shader, "sourceExtent");
+    compositor->sharpnessLoc = GetShaderLocation(shader, "sharpness");
+    compositor->sharpness = sharpness;
+
+    for (int i = 0; i < compositor->layerCount; i++)
+    {
+        if (compositor->layers[i].scale < 1.0f) compositor->layers[i].dirty = true;
+    }
+}
+
+// Log cost of redrawing an overlay vs compositing its image
+void BenchmarkLayerCompositor(int texts, int frames)
+{
+    LayerCompositor compositor = LoadLayerCompositor();
+    int layer = AddCompositorLayer(&compositor, DrawBenchmarkTexts, 0, BLANK, 0.0f);
+    double redrawTime = 0.0, compositeTime = 0.0;
+
+    benchmarkTexts = texts;
+
+    for (int f = 0; f < frames; f++)
+    {
+        double start = GetTime();
+        BeginDrawing();
+            ClearBackground(RAYWHITE);
+            DrawBenchmarkTexts();
+            rlDrawRenderBatchActive();
+            glFinish();
+            redrawTime += GetTime() - start;
+        EndDrawing();
+
+        // First frame draws the layer, every following one only composites it
+        start = GetTime();
+        BeginDrawing();
+            ClearBackground(RAYWHITE);
+            SetCompositorLayerKey(&compositor, layer, &texts, sizeof(texts));
+            UpdateLayerCompositor(&compositor);
+            DrawLayerCompositor(&compositor);
+            rlDrawRenderBatchActive();
+            glFinish();
+            compositeTime += GetTime() - start;
+        EndDrawing();
+    }
+
+    TraceLog(LOG_INFO, "COMPOSITOR: %i texts: redraw %.3f ms, cached layer %.3f ms (%i redraws in %i frames)",
+             texts, redrawTime*1000.0/frames, compositeTime*1000.0/frames, compositor.layers[layer].redrawCount, frames);
+
+    UnloadLayerCompositor(&compositor);
+}
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Definition
+//----------------------------------------------------------------------------------
+
+// (Re)load every target for the current screen size, all layers need a redraw
+static void LoadCompositorTargets(LayerCompositor *compositor)
+{
+    compositor->width = GetScreenWidth();
+    compositor->height = GetScreenHeight();
+
+    for (int i = 0; i < compositor->layerCount; i++)
+    {
+        CompositorLayer *layer = &compositor->layers[i];
+
+        // Resolved layers are at render resolution, which differs from screen units on high DPI
+        int width = (layer->flags & COMPOSITOR_LAYER_MSAA)? GetRenderWidth() : compositor->width;
+        int height = (layer->flags & COMPOSITOR_LAYER_MSAA)? GetRenderHeight() : compositor->height;
+
+        if ((layer->target.id > 0) && (layer->target.texture.width == width) && (layer->target.texture.height == height)) continue;
+
+        if (layer->target.id > 0) UnloadRenderTexture(layer->target);
+        layer->target = LoadRenderTexture(width, height);
+        SetTextureFilter(layer->target.texture, TEXTURE_FILTER_BILINEAR);   // Upscaled from when the layer is scaled
+        layer->dirty = true;
+    }
+}
+
+// Multisampled color and depth renderbuffers for the size and sample count, false without MSAA
+static bool LoadCompositorMsaa(LayerCompositor *compositor, int width, int height)
+{
+    if ((compositor->samples <= 1) || (compositorRenderbufferStorageMultisample == NULL)) return false;
+
+    int maxSamples = 0;
+    glGetIntegerv(COMPOSITOR_GL_MAX_SAMPLES, &maxSamples);
+    int samples = (compositor->samples < maxSamples)? compositor->samples : maxSamples;
+    if (samples <= 1) return false;
+
+    if ((compositor->msaaFramebuffer > 0) && (compositor->msaaWidth == width) &&
+        (compositor->msaaHeight == height) && (compositor->msaaSamples == samples)) return true;
+
+    UnloadCompositorMsaa(compositor);
+
+    compositor->msaaFramebuffer = rlLoadFramebuffer(width, height);
+    compositorGenRenderbuffers(1, &compositor->msaaColor);
+    compositorGenRenderbuffers(1, &compositor->msaaDepth);
+
+    compositorBindRenderbuffer(COMPOSITOR_GL_RENDERBUFFER, compositor->msaaColor);
+    compositorRenderbufferStorageMultisample(COMPOSITOR_GL_RENDERBUFFER, samples, COMPOSITOR_GL_RGBA8, width, height);
+    compositorBindRenderbuffer(COMPOSITOR_GL_RENDERBUFFER, compositor->msaaDepth);
+    compositorRenderbufferStorageMultisample(COMPOSITOR_GL_RENDERBUFFER, samples, COMPOSITOR_GL_DEPTH24, width, height);
+    compositorBindRenderbuffer(COMPOSITOR_GL_RENDERBUFFER, 0);
+
+    rlFramebufferAttach(compositor->msaaFramebuffer, compositor->msaaColor, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_RENDERBUFFER, 0);
+    rlFramebufferAttach(compositor->msaaFramebuffer, compositor->msaaDepth, RL_ATTACHMENT_DEPTH, RL_ATTACHMENT_RENDERBUFFER, 0);
+
+    if (!rlFramebufferComplete(compositor->msaaFramebuffer))
+    {
+        TraceLog(LOG_WARNING, "COMPOSITOR: [ID %i] %ix MSAA framebuffer is not complete, drawing without MSAA", compositor->msaaFramebuffer, samples);
+        UnloadCompositorMsaa(compositor);
+        compositor->samples = 0;
+        return false;
+    }
+
+    compositor->msaaWidth = width;
+    compositor->msaaHeight = height;
+    compositor->msaaSamples = samples;
+
+    TraceLog(LOG_INFO, "COMPOSITOR: [ID %i] %ix MSAA framebuffer loaded (%i x %i)", compositor->msaaFramebuffer, samples, width, height);
+
+    return true;
+}
+
+// Unload the multisampled framebuffer and its renderbuffers
+static void UnloadCompositorMsaa(LayerCompositor *compositor)
+{
+    if (compositor->msaaFramebuffer > 0)
+    {
+        // rlUnloadFramebuffer() deletes the depth attachment, not the color one
+        compositorDeleteRenderbuffers(1, &compositor->msaaColor);
+        rlUnloadFramebuffer(compositor->msaaFramebuffer);
+    }
+
+    compositor->msaaFramebuffer = 0;
+    compositor->msaaColor = 0;
+    compositor->msaaDepth = 0;
+    compositor->msaaWidth = 0;
+    compositor->msaaHeight = 0;
+    compositor->msaaSamples = 0;
+}
+
+// Draw one layer into its target
+static void DrawCompositorLayer(LayerCompositor *compositor, CompositorLayer *layer)
+{
+    int width = layer->target.texture.width;
+    int height = layer->target.texture.height;
+
+    // Scaled layers draw into the corner of their target, same projection over a smaller viewport
+    int drawWidth = (layer->scale < 1.0f)? (int)(width*layer->scale) : width;
+    int drawHeight = (layer->scale < 1.0f)? (int)(height*layer->scale) : height;
+    layer->viewportWidth = (drawWidth > 0)? drawWidth : 1;
+    layer->viewportHeight = (drawHeight > 0)? drawHeight : 1;
+
+    if ((layer->flags & COMPOSITOR_LAYER_MSAA) && LoadCompositorMsaa(compositor, width, height))
+    {
+        // Drawn as a render texture of the same size, then resolved into the target
+        RenderTexture2D msaa = { compositor->msaaFramebuffer, { 0, width, height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 }, { 0 } };
+
+        BeginTextureMode(msaa);
+            rlViewport(0, 0, layer->viewportWidth, layer->viewportHeight);
+            ClearBackground(layer->clear);
+            layer->draw();
+        EndTextureMode();
+
+        rlBindFramebuffer(RL_READ_FRAMEBUFFER, compositor->msaaFramebuffer);
+        rlBindFramebuffer(RL_DRAW_FRAMEBUFFER, layer->target.id);
+        rlBlitFramebuffer(0, 0, layer->viewportWidth, layer->viewportHeight, 0, 0, layer->viewportWidth, layer->viewportHeight, COMPOSITOR_COLOR_BUFFER_BIT);
+        rlDisableFramebuffer();
+    }
+    else if (layer->flags & COMPOSITOR_LAYER_OPAQUE)
+    {
+        BeginTextureMode(layer->target);
+            rlViewport(0, 0, layer->viewportWidth, layer->viewportHeight);
+            ClearBackground(layer->clear);
+            layer->draw();
+        EndTextureMode();
+    }
+    else
+    {
+        // Color blends as usual (ending up multiplied by alpha over BLANK), alpha accumulates once
+        rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE, RL_ONE_MINUS_SRC_ALPHA, RL_FUNC_ADD, RL_FUNC_ADD);
+
+        BeginTextureMode(layer->target);
+            rlViewport(0, 0, layer->viewportWidth, layer->viewportHeight);
+            ClearBackground(layer->clear);
+            BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+                layer->draw();
+            EndBlendMode();
+        EndTextureMode();
+    }
+}
+
+// Drawn corner of a scaled layer stretched over its upscaled image
+static void UpscaleCompositorLayer(LayerCompositor *compositor, CompositorLayer *layer)
+{
+    int width = layer->target.texture.width;
+    int height = layer->target.texture.height;
+
+    if ((layer->upscaled.id == 0) || (layer->upscaled.texture.width != width) || (layer->upscaled.texture.height != height))
+    {
+        if (layer->upscaled.id > 0) UnloadRenderTexture(layer->upscaled);
+        layer->upscaled = LoadRenderTexture(width, height);
+    }
+
+    // Bottom up like the target: the drawn corner starts at texture row 0. Past it is the clear color
+    // or an older frame (the MSAA blit only covers the corner), no tap may reach it: the shader clamps
+    // its taps, the plain bilinear copy samples an area inset by half a texel
+    bool shaded = (compositor->upscaleShader.id > 0);
+    float inset = shaded? 0.0f : 0.5f;
+    Rectangle source = { inset, inset, layer->viewportWidth - 2.0f*inset, -(layer->viewportHeight - 2.0f*inset) };
+    Rectangle dest = { 0.0f, 0.0f, (float)width, (float)height };
+
+    BeginTextureMode(layer->upscaled);
+        rlDisableColorBlend();      // Copied as is, alpha of transparent layers included
+        if (shaded)
+        {
+            float texel[2] = { 1.0f/width, 1.0f/height };
+            float extent[2] = { (float)layer->viewportWidth/width, (float)layer->viewportHeight/height };
+            BeginShaderMode(compositor->upscaleShader);
+            SetShaderValue(compositor->upscaleShader, compositor->sourceTexelLoc, texel, SHADER_UNIFORM_VEC2);
+            SetShaderValue(compositor->upscaleShader, compositor->sourceExtentLoc, extent, SHADER_UNIFORM_VEC2);
+            SetShaderValue(compositor->upscaleShader, compositor->sharpnessLoc, &compositor->sharpness, SHADER_UNIFORM_FLOAT);
+        }
+        DrawTexturePro(layer->target.texture, source, dest, (Vector2){ 0.0f, 0.0f }, 0.0f, WHITE);
+        if (shaded) EndShaderMode();
+        rlDrawRenderBatchActive();
+        rlEnableColorBlend();
+    EndTextureMode();
+}
+
+// Full size image of a layer: its target, or the upscaled one when drawn scaled
+static Texture2D GetCompositorLayerImage(const CompositorLayer *layer)
+{
+    return ((layer->scale < 1.0f) && (layer->upscaled.id > 0))? layer->upscaled.texture : layer->target.texture;
+}
+
+// FNV-1a over the key bytes
+static unsigned int HashCompositorKey(const void *key, int size)
+{
+    const unsigned char *bytes = (const unsigned char *)key;
+    unsigned int hash = 2166136261u;
+
+    for (int i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+// Overlay of benchmarkTexts lines for the benchmark
+static void DrawBenchmarkTexts(void)
+{
+    for (int i = 0; i < benchmarkTexts; i++)
+    {
+        DrawText("Layer compositor benchmark", 10 + (i % 8)*70, 10 + (i/8 % 40)*11, 10, DARKGRAY);
+    }
+}
+
+#endif // LAYER_COMPOSITOR_IMPLEMENTATION
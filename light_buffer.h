@@ -0,0 +1,287 @@
+/**********************************************************************************************
+*
+*   light_buffer - rlights.h lights and the ambient level in one std140 uniform buffer
+*
+*   Lit shaders declare the block instead of plain uniforms:
+*
+*       layout(std140) uniform LightBlock {
+*           Light lights[MAX_LIGHTS];
+*           vec4 ambient;
+*       };
+*
+*   The buffer sits on uniform block binding 0, where every program's blocks start after
+*   linking, so a shader declaring LightBlock is lit without any location lookup or per shader
+*   upload. Lights are compared with the buffer copy when set, and the buffer is only uploaded
+*   when something changed.
+*
+*   NOTE: Uniform buffer binding is not part of rlgl, glBindBufferBase() is loaded through
+*   glfwGetProcAddress() from raylib's desktop platform. The buffer itself is a plain rlgl
+*   vertex buffer, buffer objects do not care about the target they were created with.
+*
+*   CONFIGURATION:
+*
+*   #define LIGHT_BUFFER_IMPLEMENTATION
+*       Generates the implementation of the library into the included file.
+*       If not defined, the library is in header only mode and can be included in other headers
+*       or source files without problems. But only ONE file should hold the implementation.
+*
+**********************************************************************************************/
+
+#ifndef LIGHT_BUFFER_H
+#define LIGHT_BUFFER_H
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define LIGHT_BUFFER_MAX_LIGHTS     4       // MAX_LIGHTS of the lit shaders
+#define LIGHT_BUFFER_BINDING        0       // Uniform block binding, the default of every block
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+
+// One Light of the block, std140 layout (64 bytes)
+typedef struct {
+    int enabled;
+    int type;
+    float padding[2];
+    float position[4];          // vec3, 16 byte aligned
+    float target[4];
+    float color[4];
+} LightBufferLight;
+
+// The whole block, std140 layout
+typedef struct {
+    LightBufferLight lights[LIGHT_BUFFER_MAX_LIGHTS];
+    float ambient[4];
+} LightBufferData;
+
+// Uniform buffer and the copy it was last uploaded from
+typedef struct {
+    unsigned int id;
+    LightBufferData data;
+    int lightCount;             // Lights created so far
+    bool dirty;                 // Data changed since the last upload
+    int uploadCount;            // Uploads since loading
+} LightBuffer;
+
+#ifdef __cplusplus
+extern "C" {            // Prevents name mangling of functions
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+LightBuffer LoadLightBuffer(void);                                                       // Uniform buffer with every light disabled, bound to LIGHT_BUFFER_BINDING
+void UnloadLightBuffer(LightBuffer *buffer);                                             // Unload the uniform buffer
+Light CreateBufferLight(LightBuffer *buffer, int type, Vector3 position, Vector3 target, Color color);  // Create a light in the next slot, as CreateLight() without a shader
+void SetBufferLight(LightBuffer *buffer, int index, Light light);                        // Copy a light into its slot, marks the buffer changed if it differs
+void SetBufferAmbient(LightBuffer *buffer, Vector4 ambient);                             // Ambient level, marks the buffer changed if it differs
+void UpdateLightBuffer(LightBuffer *buffer);                                             // Bind the buffer, upload it if it changed
+
+void BenchmarkLightBuffer(int shaders, int frames);                                      // Per shader uniforms vs the shared buffer, CPU time per frame
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LIGHT_BUFFER_H
+
+
+/***********************************************************************************
+*
+*   LIGHT_BUFFER IMPLEMENTATION
+*
+************************************************************************************/
+
+#if defined(LIGHT_BUFFER_IMPLEMENTATION)
+
+#include "raylib.h"
+#include "rlgl.h"
+
+#include <string.h>             // Required for: memcmp(), memcpy()
+
+#include "gl_loader.h"      // Required for: glfwGetProcAddress(), GL function types
+
+#define LIGHT_BUFFER_GL_UNIFORM_BUFFER  0x8A11      // GL 3.1, not in gl.h
+
+//----------------------------------------------------------------------------------
+// Global Variables Definition
+//----------------------------------------------------------------------------------
+static GLBindBufferBaseProc lightBufferBindBase = NULL;
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Declaration
+//----------------------------------------------------------------------------------
+static LightBufferLight GetLightBufferLight(Light light);
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+
+// Uniform buffer with every light disabled, bound to LIGHT_BUFFER_BINDING
+LightBuffer LoadLightBuffer(void)
+{
+    LightBuffer buffer = { 0 };
+
+    if (lightBufferBindBase == NULL) lightBufferBindBase = (GLBindBufferBaseProc)glfwGetProcAddress("glBindBufferBase");
+    if (lightBufferBindBase == NULL) TraceLog(LOG_WARNING, "LIGHTS: glBindBufferBase() not available, lit shaders get no lights");
+
+    buffer.id = rlLoadVertexBuffer(&buffer.data, sizeof(LightBufferData), true);
+    buffer.dirty = false;
+
+    if (lightBufferBindBase != NULL) lightBufferBindBase(LIGHT_BUFFER_GL_UNIFORM_BUFFER, LIGHT_BUFFER_BINDING, buffer.id);
+
+    TraceLog(LOG_INFO, "LIGHTS: [ID %i] Light buffer loaded (%i bytes, binding %i)", buffer.id, (int)sizeof(LightBufferData), LIGHT_BUFFER_BINDING);
+
+    return buffer;
+}
+
+// Unload the uniform buffer
+void UnloadLightBuffer(LightBuffer *buffer)
+{
+    if (buffer->id > 0) rlUnloadVertexBuffer(buffer->id);
+
+    *buffer = (LightBuffer){ 0 };
+}
+
+// Create a light in the next slot, as CreateLight() without a shader
+Light CreateBufferLight(LightBuffer *buffer, int type, Vector3 position, Vector3 target, Color color)
+{
+    Light light = { 0 };
+
+    if (buffer->lightCount < LIGHT_BUFFER_MAX_LIGHTS)
+    {
+        light.enabled = true;
+        light.type = type;
+        light.position = position;
+        light.target = target;
+        light.color = color;
+
+        // No shader locations, the block is found by its binding
+        light.enabledLoc = -1;
+        light.typeLoc = -1;
+        light.positionLoc = -1;
+        light.targetLoc = -1;
+        light.colorLoc = -1;
+        light.attenuationLoc = -1;
+
+        SetBufferLight(buffer, buffer->lightCount, light);
+        buffer->lightCount++;
+    }
+
+    return light;
+}
+
+// Copy a light into its slot, marks the buffer changed if it differs
+void SetBufferLight(LightBuffer *buffer, int index, Light light)
+{
+    if ((index < 0) || (index >= LIGHT_BUFFER_MAX_LIGHTS)) return;
+
+    LightBufferLight data = GetLightBufferLight(light);
+
+    if (memcmp(&data, &buffer->data.lights[index], sizeof(LightBufferLight)) != 0)
+    {
+        buffer->data.lights[index] = data;
+        buffer->dirty = true;
+    }
+}
+
+// Ambient level, marks the buffer changed if it differs
+void SetBufferAmbient(LightBuffer *buffer, Vector4 ambient)
+{
+    float value[4] = { ambient.x, ambient.y, ambient.z, ambient.w };
+
+    if (memcmp(value, buffer->data.ambient, sizeof(value)) != 0)
+    {
+        memcpy(buffer->data.ambient, value, sizeof(value));
+        buffer->dirty = true;
+    }
+}
+
+// Bind the buffer, upload it if it changed
+// NOTE: Binding every time lets several buffers (benchmarks) take turns on the binding point
+void UpdateLightBuffer(LightBuffer *buffer)
+{
+    if (buffer->dirty)
+    {
+        rlDrawRenderBatchActive();      // Batched draws still use the previous values
+        rlUpdateVertexBuffer(buffer->id, &buffer->data, sizeof(LightBufferData), 0);
+        buffer->dirty = false;
+        buffer->uploadCount++;
+    }
+
+    if (lightBufferBindBase != NULL) lightBufferBindBase(LIGHT_BUFFER_GL_UNIFORM_BUFFER, LIGHT_BUFFER_BINDING, buffer->id);
+}
+
+// Per shader uniforms vs the shared buffer, CPU time per frame
+// NOTE: The per shader path makes the 5 SetShaderValue() calls per light rlights.h makes, on shaders without those uniforms
+void BenchmarkLightBuffer(int shaders, int frames)
+{
+    Shader *list = (Shader *)RL_MALLOC(shaders*sizeof(Shader));
+    Light lights[LIGHT_BUFFER_MAX_LIGHTS] = { 0 };
+    LightBuffer buffer = LoadLightBuffer();
+    double time[3] = { 0 };
+
+    for (int s = 0; s < shaders; s++) list[s] = LoadShader(0, 0);
+    for (int i = 0; i < LIGHT_BUFFER_MAX_LIGHTS; i++) lights[i] = CreateBufferLight(&buffer, 1, (Vector3){ 10.0f*i, 10.0f, 0.0f }, (Vector3){ 0 }, WHITE);
+
+    for (int f = 0; f < frames; f++)
+    {
+        // Every frame, every light on every shader
+        double start = GetTime();
+        for (int s = 0; s < shaders; s++)
+        {
+            for (int i = 0; i < LIGHT_BUFFER_MAX_LIGHTS; i++) UpdateLightValues(list[s], lights[i]);
+        }
+        time[0] += GetTime() - start;
+
+        // Shared buffer, lights unchanged
+        start = GetTime();
+        for (int i = 0; i < LIGHT_BUFFER_MAX_LIGHTS; i++) SetBufferLight(&buffer, i, lights[i]);
+        UpdateLightBuffer(&buffer);
+        time[1] += GetTime() - start;
+
+        // Shared buffer, one light moving
+        lights[0].position.y = 10.0f + f;
+        start = GetTime();
+        for (int i = 0; i < LIGHT_BUFFER_MAX_LIGHTS; i++) SetBufferLight(&buffer, i, lights[i]);
+        UpdateLightBuffer(&buffer);
+        time[2] += GetTime() - start;
+    }
+
+    TraceLog(LOG_INFO, "LIGHTS: %i lit shaders, %i lights: per shader uniforms %.4f ms, light buffer unchanged %.4f ms, changed %.4f ms (%i uploads)",
+             shaders, LIGHT_BUFFER_MAX_LIGHTS, time[0]*1000.0/frames, time[1]*1000.0/frames, time[2]*1000.0/frames, buffer.uploadCount);
+
+    for (int s = 0; s < shaders; s++) UnloadShader(list[s]);
+    RL_FREE(list);
+    UnloadLightBuffer(&buffer);
+}
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Definition
+//----------------------------------------------------------------------------------
+
+// std140 copy of a light, zero padded so copies compare with memcmp()
+static LightBufferLight GetLightBufferLight(Light light)
+{
+    LightBufferLight data;
+    memset(&data, 0, sizeof(data));
+
+    data.enabled = light.enabled? 1 : 0;
+    data.type = light.type;
+    data.position[0] = light.position.x;
+    data.position[1] = light.position.y;
+    data.position[2] = light.position.z;
+    data.target[0] = light.target.x;
+    data.target[1] = light.target.y;
+    data.target[2] = light.target.z;
+    data.color[0] = light.color.r/255.0f;
+    data.color[1] = light.color.g/255.0f;
+    data.color[2] = light.color.b/255.0f;
+    data.color[3] = light.color.a/255.0f;
+
+    return data;
+}
+
+#endif // LIGHT_BUFFER_IMPLEMENTATION
@@ -0,0 +1,492 @@
+/**********************************************************************************************
+*
+*   light_clusters - clustered forward lighting, point lights binned on the CPU every frame
+*
+*   The camera frustum is cut into LIGHT_CLUSTERS_X x LIGHT_CLUSTERS_Y screen tiles and
+*   LIGHT_CLUSTERS_Z depth slices, exponentially spaced between the near and far planes given
+*   to LoadLightClusters() (the first slice reaches the camera, the last one goes on forever).
+*
+*   Each frame the lights are moved to view space and tested against the view space bounds of
+*   the clusters their sphere can touch, 4 clusters of a row per SSE instruction. Lists are
+*   then compacted and uploaded to three float textures bound on fixed texture units:
+*
+*       - clusters: per cluster offset and count into the index list
+*       - indices:  light indices, LIGHT_CLUSTERS_INDEX_WIDTH per row
+*       - lights:   per light position and radius (row 0), color (row 1)
+*
+*   The CLUSTERED variant of lighting.fs finds the cluster of a fragment from gl_FragCoord and
+*   its view depth, then only loops over the lights listed there, so forward shading (MSAA,
+*   blended geometry) takes hundreds of lights at a cost of a few per fragment.
+*
+*   Cluster bounds only depend on the projection (fovy and aspect), they are rebuilt when it
+*   changes. Perspective cameras only.
+*
+*   CONFIGURATION:
+*
+*   #define LIGHT_CLUSTERS_IMPLEMENTATION
+*       Generates the implementation of the library into the included file.
+*       If not defined, the library is in header only mode and can be included in other headers
+*       or source files without problems. But only ONE file should hold the implementation.
+*
+**********************************************************************************************/
+
+#ifndef LIGHT_CLUSTERS_H
+#define LIGHT_CLUSTERS_H
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define LIGHT_CLUSTERS_X                16
+#define LIGHT_CLUSTERS_Y                9
+#define LIGHT_CLUSTERS_Z                24
+#define LIGHT_CLUSTERS_COUNT            (LIGHT_CLUSTERS_X*LIGHT_CLUSTERS_Y*LIGHT_CLUSTERS_Z)
+#define LIGHT_CLUSTER_MAX_LIGHTS        64      // Per cluster, further lights are dropped
+#define LIGHT_CLUSTERS_INDEX_WIDTH      1024    // Index texture row length
+#define LIGHT_CLUSTERS_TEXTURE_UNIT     13      // Clusters, indices and lights on 13, 14 and 15, above the material maps
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+
+// Point light, no light past the radius
+typedef struct {
+    Vector3 position;
+    float radius;
+    Color color;
+} ClusterLight;
+
+// Cluster bounds, light lists and their textures
+typedef struct {
+    float nearPlane;            // First slice ends here
+    float farPlane;             // Last slice starts here
+    float fovy;                 // Projection the bounds were built for
+    float aspect;
+    int width;                  // Viewport the clusters cover
+    int height;
+
+    float *boundsMin[3];        // View space cluster bounds, x, y and depth (positive), one array per axis
+    float *boundsMax[3];
+    unsigned short *counts;     // Lights per cluster
+    unsigned short *lists;      // LIGHT_CLUSTER_MAX_LIGHTS slots per cluster
+
+    int maxLights;
+    int lightCount;
+    float *clusterTexels;       // RGBA32F, offset and count
+    float *indexTexels;         // R32F
+    float *lightTexels;         // RGBA32F, maxLights x 2
+    Texture2D clusterTexture;
+    Texture2D indexTexture;
+    Texture2D lightTexture;
+
+    bool simd;                  // SSE sphere tests when available
+    int indexCount;             // Light references over all clusters, last update
+    int occupiedClusters;
+    int maxClusterLights;
+    int droppedCount;           // References past LIGHT_CLUSTER_MAX_LIGHTS
+    double binTime;             // Seconds binning, last update
+    double uploadTime;          // Seconds compacting and uploading, last update
+} LightClusters;
+
+#ifdef __cplusplus
+extern "C" {            // Prevents name mangling of functions
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+LightClusters LoadLightClusters(int maxLights, float nearPlane, float farPlane);        // Cluster grid and textures for up to maxLights lights
+void UnloadLightClusters(LightClusters *clusters);                                       // Unload bounds, lists and textures
+void UpdateLightClusters(LightClusters *clusters, Camera camera, int width, int height, const ClusterLight *lights, int lightCount);  // Bin lights for the camera and upload the lists
+void SetLightClustersShader(LightClusters *clusters, Shader shader);                     // Grid uniforms and texture units of a CLUSTERED lighting.fs variant
+void BindLightClusters(LightClusters *clusters);                                         // Bind the textures to their units, before drawing
+float GetLightClustersAverage(LightClusters *clusters);                                  // Average lights per cluster
+
+void BenchmarkLightClusters(int lights, int frames);                                     // Binning time with and without SSE
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LIGHT_CLUSTERS_H
+
+
+/***********************************************************************************
+*
+*   LIGHT_CLUSTERS IMPLEMENTATION
+*
+************************************************************************************/
+
+#if defined(LIGHT_CLUSTERS_IMPLEMENTATION)
+
+#include "raylib.h"
+#include "raymath.h"
+#include "rlgl.h"
+#include "uniform_cache.h"      // Required for: SetShaderValueCached()
+
+#include <math.h>               // Required for: tanf(), logf(), powf(), floorf()
+#include <string.h>             // Required for: memset()
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+    #define LIGHT_CLUSTERS_SSE2
+    #include <emmintrin.h>
+#endif
+
+#define LIGHT_CLUSTERS_FAR_DEPTH    1.0e30f     // Last slice has no far end
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Declaration
+//----------------------------------------------------------------------------------
+static void UpdateLightClusterBounds(LightClusters *clusters, float fovy, float aspect);
+static int GetLightClusterSlice(LightClusters *clusters, float depth);
+static void BinClusterLight(LightClusters *clusters, Vector3 center, float radius, int light);
+static void AddClusterLight(LightClusters *clusters, int cluster, int light);
+static void UploadLightClusters(LightClusters *clusters);
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+
+// Cluster grid and textures for up to maxLights lights
+LightClusters LoadLightClusters(int maxLights, float nearPlane, float farPlane)
+{
+    LightClusters clusters = { 0 };
+    int indexRows = (LIGHT_CLUSTERS_COUNT*LIGHT_CLUSTER_MAX_LIGHTS + LIGHT_CLUSTERS_INDEX_WIDTH - 1)/LIGHT_CLUSTERS_INDEX_WIDTH;
+
+    clusters.nearPlane = nearPlane;
+    clusters.farPlane = farPlane;
+    clusters.maxLights = maxLights;
+    clusters.simd = true;
+
+    for (int a = 0; a < 3; a++)
+    {
+        clusters.boundsMin[a] = (float *)RL_CALLOC(LIGHT_CLUSTERS_COUNT, sizeof(float));
+        clusters.boundsMax[a] = (float *)RL_CALLOC(LIGHT_CLUSTERS_COUNT, sizeof(float));
+    }
+    clusters.counts = (unsigned short *)RL_CALLOC(LIGHT_CLUSTERS_COUNT, sizeof(unsigned short));
+    clusters.lists = (unsigned short *)RL_CALLOC(LIGHT_CLUSTERS_COUNT*LIGHT_CLUSTER_MAX_LIGHTS, sizeof(unsigned short));
+
+    clusters.clusterTexels = (float *)RL_CALLOC(LIGHT_CLUSTERS_COUNT*4, sizeof(float));
+    clusters.indexTexels = (float *)RL_CALLOC(indexRows*LIGHT_CLUSTERS_INDEX_WIDTH, sizeof(float));
+    clusters.lightTexels = (float *)RL_CALLOC(maxLights*2*4, sizeof(float));
+
+    clusters.clusterTexture = (Texture2D){ rlLoadTexture(clusters.clusterTexels, LIGHT_CLUSTERS_X*LIGHT_CLUSTERS_Y, LIGHT_CLUSTERS_Z, RL_PIXELFORMAT_UNCOMPRESSED_R32G32B32A32, 1),
+                                           LIGHT_CLUSTERS_X*LIGHT_CLUSTERS_Y, LIGHT_CLUSTERS_Z, 1, PIXELFORMAT_UNCOMPRESSED_R32G32B32A32 };
+    clusters.indexTexture = (Texture2D){ rlLoadTexture(clusters.indexTexels, LIGHT_CLUSTERS_INDEX_WIDTH, indexRows, RL_PIXELFORMAT_UNCOMPRESSED_R32, 1),
+                                         LIGHT_CLUSTERS_INDEX_WIDTH, indexRows, 1, PIXELFORMAT_UNCOMPRESSED_R32 };
+    clusters.lightTexture = (Texture2D){ rlLoadTexture(clusters.lightTexels, maxLights, 2, RL_PIXELFORMAT_UNCOMPRESSED_R32G32B32A32, 1),
+                                         maxLights, 2, 1, PIXELFORMAT_UNCOMPRESSED_R32G32B32A32 };
+
+    return clusters;
+}
+
+// Unload bounds, lists and textures
+void UnloadLightClusters(LightClusters *clusters)
+{
+    for (int a = 0; a < 3; a++)
+    {
+        RL_FREE(clusters->boundsMin[a]);
+        RL_FREE(clusters->boundsMax[a]);
+    }
+    RL_FREE(clusters->counts);
+    RL_FREE(clusters->lists);
+    RL_FREE(clusters->clusterTexels);
+    RL_FREE(clusters->indexTexels);
+    RL_FREE(clusters->lightTexels);
+
+    if (clusters->clusterTexture.id > 0) rlUnloadTexture(clusters->clusterTexture.id);
+    if (clusters->indexTexture.id > 0) rlUnloadTexture(clusters->indexTexture.id);
+    if (clusters->lightTexture.id > 0) rlUnloadTexture(clusters->lightTexture.id);
+
+    *clusters = (LightClusters){ 0 };
+}
+
+// Bin lights for the camera and upload the lists
+void UpdateLightClusters(LightClusters *clusters, Camera camera, int width, int height, const ClusterLight *lights, int lightCount)
+{
+    double start = GetTime();
+    float aspect = (float)width/(float)height;
+
+    if ((camera.fovy != clusters->fovy) || (aspect != clusters->aspect)) UpdateLightClusterBounds(clusters, camera.fovy, aspect);
+
+    clusters->width = width;
+    clusters->height = height;
+    clusters->lightCount = (lightCount < clusters->maxLights)? lightCount : clusters->maxLights;
+    clusters->droppedCount = 0;
+    memset(clusters->counts, 0, LIGHT_CLUSTERS_COUNT*sizeof(unsigned short));
+
+    Matrix view = GetCameraMatrix(camera);
+    float *positions = clusters->lightTexels;
+    float *colors = clusters->lightTexels + clusters->maxLights*4;
+
+    for (int i = 0; i < clusters->lightCount; i++)
+    {
+        const ClusterLight *light = &lights[i];
+        Vector3 center = Vector3Transform(light->position, view);
+
+        // View space looks down -z, bounds use positive depth
+        BinClusterLight(clusters, (Vector3){ center.x, center.y, -center.z }, light->radius, i);
+
+        positions[i*4 + 0] = light->position.x;
+        positions[i*4 + 1] = light->position.y;
+        positions[i*4 + 2] = light->position.z;
+        positions[i*4 + 3] = light->radius;
+        colors[i*4 + 0] = light->color.r/255.0f;
+        colors[i*4 + 1] = light->color.g/255.0f;
+        colors[i*4 + 2] = light->color.b/255.0f;
+        colors[i*4 + 3] = 1.0f;
+    }
+
+    clusters->binTime = GetTime() - start;
+
+    start = GetTime();
+    UploadLightClusters(clusters);
+    clusters->uploadTime = GetTime() - start;
+}
+
+// Grid uniforms and texture units of a CLUSTERED lighting.fs variant
+void SetLightClustersShader(LightClusters *clusters, Shader shader)
+{
+    // Slice of a view depth d: log(d)*scale + bias
+    float scale = LIGHT_CLUSTERS_Z/logf(clusters->farPlane/clusters->nearPlane);
+    float depth[2] = { scale, -logf(clusters->nearPlane)*scale };
+    int grid[3] = { LIGHT_CLUSTERS_X, LIGHT_CLUSTERS_Y, LIGHT_CLUSTERS_Z };
+    float viewport[2] = { (float)clusters->width, (float)clusters->height };
+    int units[3] = { LIGHT_CLUSTERS_TEXTURE_UNIT, LIGHT_CLUSTERS_TEXTURE_UNIT + 1, LIGHT_CLUSTERS_TEXTURE_UNIT + 2 };
+
+    SetShaderValueCached(shader, GetShaderLocation(shader, "clusterGrid"), grid, SHADER_UNIFORM_IVEC3);
+    SetShaderValueCached(shader, GetShaderLocation(shader, "clusterDepth"), depth, SHADER_UNIFORM_VEC2);
+    SetShaderValueCached(shader, GetShaderLocation(shader, "clusterViewport"), viewport, SHADER_UNIFORM_VEC2);
+    SetShaderValueCached(shader, GetShaderLocation(shader, "clusterData"), &units[0], SHADER_UNIFORM_INT);
+    SetShaderValueCached(shader, GetShaderLocation(shader, "clusterIndices"), &units[1], SHADER_UNIFORM_INT);
+    SetShaderValueCached(shader, GetShaderLocation(shader, "clusterLights"), &units[2], SHADER_UNIFORM_INT);
+}
+
+// Bind the textures to their units, before drawing
+// NOTE: Draws bind material maps from unit 0 and the batch its textures from unit 1, these units stay untouched
+void BindLightClusters(LightClusters *clusters)
+{
+    rlActiveTextureSlot(LIGHT_CLUSTERS_TEXTURE_UNIT);
+    rlEnableTexture(clusters->clusterTexture.id);
+    rlActiveTextureSlot(LIGHT_CLUSTERS_TEXTURE_UNIT + 1);
+    rlEnableTexture(clusters->indexTexture.id);
+    rlActiveTextureSlot(LIGHT_CLUSTERS_TEXTURE_UNIT + 2);
+    rlEnableTexture(clusters->lightTexture.id);
+    rlActiveTextureSlot(0);
+}
+
+// Average lights per cluster
+float GetLightClustersAverage(LightClusters *clusters)
+{
+    return (float)clusters->indexCount/LIGHT_CLUSTERS_COUNT;
+}
+
+// Binning time with and without SSE
+void BenchmarkLightClusters(int lights, int frames)
+{
+    Camera camera = { { 0.0f, 20.0f, 60.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, 45.0f, CAMERA_PERSPECTIVE };
+    LightClusters clusters = LoadLightClusters(lights, 1.0f, 200.0f);
+    ClusterLight *list = (ClusterLight *)RL_CALLOC(lights, sizeof(ClusterLight));
+    double time[2] = { 0 };
+    double upload = 0.0;
+
+    for (int i = 0; i < lights; i++)
+    {
+        list[i].position = (Vector3){ (float)GetRandomValue(-40, 40), (float)GetRandomValue(0, 10), (float)GetRandomValue(-40, 40) };
+        list[i].radius = 6.0f;
+        list[i].color = WHITE;
+    }
+
+    for (int mode = 0; mode < 2; mode++)
+    {
+        clusters.simd = (mode == 1);
+
+        for (int f = 0; f < frames; f++)
+        {
+            camera.position = Vector3RotateByAxisAngle(camera.position, camera.up, 0.01f);
+            UpdateLightClusters(&clusters, camera, 1280, 720, list, lights);
+            time[mode] += clusters.binTime;
+            upload += clusters.uploadTime;
+        }
+    }
+
+    TraceLog(LOG_INFO, "LIGHT CLUSTERS: %i lights in %i clusters: binning %.3f ms scalar, %.3f ms SSE, upload %.3f ms, %.2f lights per cluster (max %i, %i occupied, %i dropped)",
+             lights, LIGHT_CLUSTERS_COUNT, time[0]*1000.0/frames, time[1]*1000.0/frames, upload*1000.0/(2*frames),
+             GetLightClustersAverage(&clusters), clusters.maxClusterLights, clusters.occupiedClusters, clusters.droppedCount);
+
+    RL_FREE(list);
+    UnloadLightClusters(&clusters);
+}
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Definition
+//----------------------------------------------------------------------------------
+
+// View space bounds of every cluster for a projection
+static void UpdateLightClusterBounds(LightClusters *clusters, float fovy, float aspect)
+{
+    float tanY = tanf(fovy*0.5f*DEG2RAD);
+    float tanX = tanY*aspect;
+    float ratio = clusters->farPlane/clusters->nearPlane;
+
+    for (int z = 0; z < LIGHT_CLUSTERS_Z; z++)
+    {
+        float nearDepth = (z == 0)? 0.0f : clusters->nearPlane*powf(ratio, (float)z/LIGHT_CLUSTERS_Z);
+        float farDepth = (z == LIGHT_CLUSTERS_Z - 1)? LIGHT_CLUSTERS_FAR_DEPTH : clusters->nearPlane*powf(ratio, (float)(z + 1)/LIGHT_CLUSTERS_Z);
+
+        for (int y = 0; y < LIGHT_CLUSTERS_Y; y++)
+        {
+            float y0 = (-1.0f + 2.0f*y/LIGHT_CLUSTERS_Y)*tanY;
+            float y1 = (-1.0f + 2.0f*(y + 1)/LIGHT_CLUSTERS_Y)*tanY;
+
+            for (int x = 0; x < LIGHT_CLUSTERS_X; x++)
+            {
+                int c = (z*LIGHT_CLUSTERS_Y + y)*LIGHT_CLUSTERS_X + x;
+                float x0 = (-1.0f + 2.0f*x/LIGHT_CLUSTERS_X)*tanX;
+                float x1 = (-1.0f + 2.0f*(x + 1)/LIGHT_CLUSTERS_X)*tanX;
+
+                // The tile widens with depth, the bounds take the wider end on each side
+                clusters->boundsMin[0][c] = fminf(x0*nearDepth, x0*farDepth);
+                clusters->boundsMax[0][c] = fmaxf(x1*nearDepth, x1*farDepth);
+                clusters->boundsMin[1][c] = fminf(y0*nearDepth, y0*farDepth);
+                clusters->boundsMax[1][c] = fmaxf(y1*nearDepth, y1*farDepth);
+                clusters->boundsMin[2][c] = nearDepth;
+                clusters->boundsMax[2][c] = farDepth;
+            }
+        }
+    }
+
+    clusters->fovy = fovy;
+    clusters->aspect = aspect;
+}
+
+// Depth slice of a positive view depth, clamped to the grid
+static int GetLightClusterSlice(LightClusters *clusters, float depth)
+{
+    if (depth <= clusters->nearPlane) return 0;
+
+    int slice = (int)floorf(logf(depth/clusters->nearPlane)/logf(clusters->farPlane/clusters->nearPlane)*LIGHT_CLUSTERS_Z);
+
+    return (slice < LIGHT_CLUSTERS_Z)? slice : LIGHT_CLUSTERS_Z - 1;
+}
+
+// Add a light to every cluster its view space sphere touches
+static void BinClusterLight(LightClusters *clusters, Vector3 center, float radius, int light)
+{
+    float nearDepth = center.z - radius;
+    float farDepth = center.z + radius;
+    if (farDepth <= 0.0f) return;       // Behind the camera
+
+    int z0 = GetLightClusterSlice(clusters, nearDepth);
+    int z1 = GetLightClusterSlice(clusters, farDepth);
+    int x0 = 0, x1 = LIGHT_CLUSTERS_X - 1;
+    int y0 = 0, y1 = LIGHT_CLUSTERS_Y - 1;
+
+    // Tile range from the sphere's box at its near and far depth, all tiles when it reaches the camera plane
+    if (nearDepth > 0.0f)
+    {
+        float tanY = tanf(clusters->fovy*0.5f*DEG2RAD);
+        float tanX = tanY*clusters->aspect;
+        float left = fminf((center.x - radius)/nearDepth, (center.x - radius)/farDepth)/tanX;
+        float right = fmaxf((center.x + radius)/nearDepth, (center.x + radius)/farDepth)/tanX;
+        float bottom = fminf((center.y - radius)/nearDepth, (center.y - radius)/farDepth)/tanY;
+        float top = fmaxf((center.y + radius)/nearDepth, (center.y + radius)/farDepth)/tanY;
+
+        if ((left > 1.0f) || (right < -1.0f) || (bottom > 1.0f) || (top < -1.0f)) return;
+
+        x0 = (int)Clamp(floorf((left + 1.0f)*0.5f*LIGHT_CLUSTERS_X), 0.0f, LIGHT_CLUSTERS_X - 1.0f);
+        x1 = (int)Clamp(floorf((right + 1.0f)*0.5f*LIGHT_CLUSTERS_X), 0.0f, LIGHT_CLUSTERS_X - 1.0f);
+        y0 = (int)Clamp(floorf((bottom + 1.0f)*0.5f*LIGHT_CLUSTERS_Y), 0.0f, LIGHT_CLUSTERS_Y - 1.0f);
+        y1 = (int)Clamp(floorf((top + 1.0f)*0.5f*LIGHT_CLUSTERS_Y), 0.0f, LIGHT_CLUSTERS_Y - 1.0f);
+    }
+
+    float radius2 = radius*radius;
+
+    for (int z = z0; z <= z1; z++)
+    {
+        for (int y = y0; y <= y1; y++)
+        {
+            int row = (z*LIGHT_CLUSTERS_Y + y)*LIGHT_CLUSTERS_X;
+            int x = x0;
+
+#if defined(LIGHT_CLUSTERS_SSE2)
+            // Sphere against 4 cluster boxes of the row at once
+            if (clusters->simd)
+            {
+                __m128 zero = _mm_setzero_ps();
+                __m128 cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y), cz = _mm_set1_ps(center.z);
+                __m128 r2 = _mm_set1_ps(radius2);
+
+                for (; x + 4 <= x1 + 1; x += 4)
+                {
+                    int c = row + x;
+                    __m128 dx = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(clusters->boundsMin[0] + c), cx), zero), _mm_max_ps(_mm_sub_ps(cx, _mm_loadu_ps(clusters->boundsMax[0] + c)), zero));
+                    __m128 dy = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(clusters->boundsMin[1] + c), cy), zero), _mm_max_ps(_mm_sub_ps(cy, _mm_loadu_ps(clusters->boundsMax[1] + c)), zero));
+                    __m128 dz = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(clusters->boundsMin[2] + c), cz), zero), _mm_max_ps(_mm_sub_ps(cz, _mm_loadu_ps(clusters->boundsMax[2] + c)), zero));
+                    __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+                    int mask = _mm_movemask_ps(_mm_cmple_ps(d2, r2));
+
+                    for (int k = 0; k < 4; k++)
+                    {
+                        if (mask & (1 << k)) AddClusterLight(clusters, c + k, light);
+                    }
+                }
+            }
+#endif
+            for (; x <= x1; x++)
+            {
+                int c = row + x;
+                float dx = fmaxf(clusters->boundsMin[0][c] - center.x, 0.0f) + fmaxf(center.x - clusters->boundsMax[0][c], 0.0f);
+                float dy = fmaxf(clusters->boundsMin[1][c] - center.y, 0.0f) + fmaxf(center.y - clusters->boundsMax[1][c], 0.0f);
+                float dz = fmaxf(clusters->boundsMin[2][c] - center.z, 0.0f) + fmaxf(center.z - clusters->boundsMax[2][c], 0.0f);
+
+                if (dx*dx + dy*dy + dz*dz <= radius2) AddClusterLight(clusters, c, light);
+            }
+        }
+    }
+}
+
+static void AddClusterLight(LightClusters *clusters, int cluster, int light)
+{
+    if (clusters->counts[cluster] < LIGHT_CLUSTER_MAX_LIGHTS)
+    {
+        clusters->lists[cluster*LIGHT_CLUSTER_MAX_LIGHTS + clusters->counts[cluster]] = (unsigned short)light;
+        clusters->counts[cluster]++;
+    }
+    else clusters->droppedCount++;
+}
+
+// Compact the per cluster lists into one index list, upload the rows used
+static void UploadLightClusters(LightClusters *clusters)
+{
+    int offset = 0;
+
+    clusters->occupiedClusters = 0;
+    clusters->maxClusterLights = 0;
+
+    for (int c = 0; c < LIGHT_CLUSTERS_COUNT; c++)
+    {
+        int count = clusters->counts[c];
+        const unsigned short *list = clusters->lists + c*LIGHT_CLUSTER_MAX_LIGHTS;
+
+        // Floats hold these integers exactly
+        clusters->clusterTexels[c*4 + 0] = (float)offset;
+        clusters->clusterTexels[c*4 + 1] = (float)count;
+
+        for (int i = 0; i < count; i++) clusters->indexTexels[offset + i] = (float)list[i];
+
+        offset += count;
+        if (count > 0) clusters->occupiedClusters++;
+        if (count > clusters->maxClusterLights) clusters->maxClusterLights = count;
+    }
+
+    clusters->indexCount = offset;
+
+    rlUpdateTexture(clusters->clusterTexture.id, 0, 0, LIGHT_CLUSTERS_X*LIGHT_CLUSTERS_Y, LIGHT_CLUSTERS_Z, RL_PIXELFORMAT_UNCOMPRESSED_R32G32B32A32, clusters->clusterTexels);
+
+    int rows = (offset + LIGHT_CLUSTERS_INDEX_WIDTH - 1)/LIGHT_CLUSTERS_INDEX_WIDTH;
+    if (rows > 0) rlUpdateTexture(clusters->indexTexture.id, 0, 0, LIGHT_CLUSTERS_INDEX_WIDTH, rows, RL_PIXELFORMAT_UNCOMPRESSED_R32, clusters->indexTexels);
+
+    if (clusters->lightCount > 0) rlUpdateTexture(clusters->lightTexture.id, 0, 0, clusters->maxLights, 2, RL_PIXELFORMAT_UNCOMPRESSED_R32G32B32A32, clusters->lightTexels);
+}
+
+#endif // LIGHT_CLUSTERS_IMPLEMENTATION
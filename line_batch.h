@@ -0,0 +1,316 @@
+/**********************************************************************************************
+*
+*   line_batch - 3d line segments collected in one growable vertex buffer, drawn with one call
+*
+*   DrawLine3D() goes through rlBegin()/rlEnd() for every segment and the rlgl batch splits into
+*   a new draw whenever the mode changes. A line batch keeps positions and per-vertex colors in
+*   plain arrays, uploads them once per frame (only when changed) and draws them all with a single
+*   GL_LINES call using the default shader.
+*
+*   CONFIGURATION:
+*
+*   #define LINE_BATCH_IMPLEMENTATION
+*       Generates the implementation of the library into the included file.
+*       If not defined, the library is in header only mode and can be included in other headers
+*       or source files without problems. But only ONE file should hold the implementation.
+*
+**********************************************************************************************/
+
+#ifndef LINE_BATCH_H
+#define LINE_BATCH_H
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+
+// Line batch, two vertices per segment
+typedef struct {
+    float *vertices;            // 3 floats per vertex
+    unsigned char *colors;      // 4 bytes per vertex
+    int vertexCount;
+    int vertexCapacity;         // CPU arrays size (grows on demand)
+
+    unsigned int vaoId;
+    unsigned int vboId[2];      // Positions, colors
+    int gpuCapacity;            // GPU buffers size in vertices
+    bool dirty;                 // Changed since last upload
+} LineBatch;
+
+#ifdef __cplusplus
+extern "C" {            // Prevents name mangling of functions
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+LineBatch LoadLineBatch(int segmentCapacity);                                                 // Allocate batch (grows on demand)
+void UnloadLineBatch(LineBatch *batch);                                                       // Free batch memory and GPU buffers
+void ClearLineBatch(LineBatch *batch);                                                        // Remove all segments
+void AddLineBatch3D(LineBatch *batch, Vector3 start, Vector3 end, Color color);               // Add a segment
+void AddLineBatchGradient3D(LineBatch *batch, Vector3 start, Vector3 end, Color startColor, Color endColor);  // Add a segment, color per vertex
+void AddLineBatchStrip(LineBatch *batch, const Vector3 *points, int pointCount, Color color);   // Add a polyline, pointCount - 1 segments
+void AddLineBatchBox(LineBatch *batch, BoundingBox box, Color color);                         // Add the 12 edges of a box
+void AddLineBatchGrid(LineBatch *batch, int slices, float spacing);                           // Add a grid centered at (0, 0, 0), same as DrawGrid()
+void DrawLineBatch(LineBatch *batch);                                                         // Upload if changed and draw all segments
+
+void BenchmarkLineBatch(int segments, int frames);                                            // Log CPU cost of DrawLine3D() vs a line batch
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LINE_BATCH_H
+
+
+/***********************************************************************************
+*
+*   LINE_BATCH IMPLEMENTATION
+*
+************************************************************************************/
+
+#if defined(LINE_BATCH_IMPLEMENTATION)
+
+#include "raylib.h"
+#include "raymath.h"
+#include "rlgl.h"
+
+#include <math.h>               // Required for: sinf(), cosf()
+
+#include "gl_loader.h"      // Required for: glDrawArrays(), glFinish()
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Declaration
+//----------------------------------------------------------------------------------
+static void ReserveLineBatch(LineBatch *batch, int vertexCount);
+static void UploadLineBatch(LineBatch *batch);
+static Vector3 GetBenchmarkPoint(int index);
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+
+// Allocate batch (grows on demand)
+LineBatch LoadLineBatch(int segmentCapacity)
+{
+    LineBatch batch = { 0 };
+
+    batch.vertexCapacity = 2*((segmentCapacity > 0)? segmentCapacity : 256);
+    batch.vertices = (float *)RL_MALLOC(batch.vertexCapacity*3*sizeof(float));
+    batch.colors = (unsigned char *)RL_MALLOC(batch.vertexCapacity*4*sizeof(unsigned char));
+
+    return batch;
+}
+
+// Free batch memory and GPU buffers
+void UnloadLineBatch(LineBatch *batch)
+{
+    if (batch->vaoId != 0)
+    {
+        rlUnloadVertexArray(batch->vaoId);
+        rlUnloadVertexBuffer(batch->vboId[0]);
+        rlUnloadVertexBuffer(batch->vboId[1]);
+    }
+
+    RL_FREE(batch->vertices);
+    RL_FREE(batch->colors);
+
+    *batch = (LineBatch){ 0 };
+}
+
+// Remove all segments
+void ClearLineBatch(LineBatch *batch)
+{
+    batch->vertexCount = 0;
+    batch->dirty = true;
+}
+
+// Add a segment
+void AddLineBatch3D(LineBatch *batch, Vector3 start, Vector3 end, Color color)
+{
+    AddLineBatchGradient3D(batch, start, end, color, color);
+}
+
+// Add a segment, color per vertex
+void AddLineBatchGradient3D(LineBatch *batch, Vector3 start, Vector3 end, Color startColor, Color endColor)
+{
+    if (batch->vertexCount + 2 > batch->vertexCapacity) ReserveLineBatch(batch, batch->vertexCount + 2);
+
+    float *v = batch->vertices + 3*batch->vertexCount;
+    unsigned char *c = batch->colors + 4*batch->vertexCount;
+
+    v[0] = start.x; v[1] = start.y; v[2] = start.z;
+    v[3] = end.x; v[4] = end.y; v[5] = end.z;
+    c[0] = startColor.r; c[1] = startColor.g; c[2] = startColor.b; c[3] = startColor.a;
+    c[4] = endColor.r; c[5] = endColor.g; c[6] = endColor.b; c[7] = endColor.a;
+
+    batch->vertexCount += 2;
+    batch->dirty = true;
+}
+
+// Add a polyline, pointCount - 1 segments
+void AddLineBatchStrip(LineBatch *batch, const Vector3 *points, int pointCount, Color color)
+{
+    if (pointCount < 2) return;
+
+    int segments = pointCount - 1;
+    if (batch->vertexCount + 2*segments > batch->vertexCapacity) ReserveLineBatch(batch, batch->vertexCount + 2*segments);
+
+    float *v = batch->vertices + 3*batch->vertexCount;
+    unsigned char *c = batch->colors + 4*batch->vertexCount;
+
+    for (int i = 0; i < segments; i++, v += 6, c += 8)
+    {
+        v[0] = points[i].x; v[1] = points[i].y; v[2] = points[i].z;
+        v[3] = points[i + 1].x; v[4] = points[i + 1].y; v[5] = points[i + 1].z;
+        c[0] = color.r; c[1] = color.g; c[2] = color.b; c[3] = color.a;
+        c[4] = color.r; c[5] = color.g; c[6] = color.b; c[7] = color.a;
+    }
+
+    batch->vertexCount += 2*segments;
+    batch->dirty = true;
+}
+
+// Add the 12 edges of a box
+void AddLineBatchBox(LineBatch *batch, BoundingBox box, Color color)
+{
+    Vector3 corners[8];
+    for (int i = 0; i < 8; i++)
+    {
+        corners[i] = (Vector3){ (i & 4)? box.max.x : box.min.x, (i & 2)? box.max.y : box.min.y, (i & 1)? box.max.z : box.min.z };
+    }
+
+    // Corner pairs differing in one axis bit
+    for (int i = 0; i < 8; i++)
+    {
+        for (int axis = 1; axis < 8; axis <<= 1)
+        {
+            if ((i & axis) == 0) AddLineBatch3D(batch, corners[i], corners[i | axis], color);
+        }
+    }
+}
+
+// Add a grid centered at (0, 0, 0), same as DrawGrid()
+void AddLineBatchGrid(LineBatch *batch, int slices, float spacing)
+{
+    int halfSlices = slices/2;
+
+    for (int i = -halfSlices; i <= halfSlices; i++)
+    {
+        Color color = (i == 0)? (Color){ 128, 128, 128, 255 } : (Color){ 191, 191, 191, 255 };
+
+        AddLineBatch3D(batch, (Vector3){ (float)i*spacing, 0.0f, (float)-halfSlices*spacing }, (Vector3){ (float)i*spacing, 0.0f, (float)halfSlices*spacing }, color);
+        AddLineBatch3D(batch, (Vector3){ (float)-halfSlices*spacing, 0.0f, (float)i*spacing }, (Vector3){ (float)halfSlices*spacing, 0.0f, (float)i*spacing }, color);
+    }
+}
+
+// Upload if changed and draw all segments
+// NOTE: Draws immediately, ahead of geometry still pending in the rlgl batch (lines are depth tested)
+void DrawLineBatch(LineBatch *batch)
+{
+    if (batch->vertexCount == 0) return;
+
+    if (batch->dirty) UploadLineBatch(batch);
+
+    Matrix mvp = MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection());
+    float white[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    int slot = 0;
+    int *locs = rlGetShaderLocsDefault();
+
+    rlEnableShader(rlGetShaderIdDefault());
+    rlSetUniformMatrix(locs[SHADER_LOC_MATRIX_MVP], mvp);
+    rlSetUniform(locs[SHADER_LOC_COLOR_DIFFUSE], white, SHADER_UNIFORM_VEC4, 1);
+    rlSetUniform(locs[SHADER_LOC_MAP_DIFFUSE], &slot, SHADER_UNIFORM_INT, 1);
+    rlActiveTextureSlot(0);
+    rlEnableTexture(rlGetTextureIdDefault());
+    rlEnableVertexArray(batch->vaoId);
+
+    glDrawArrays(GL_LINES, 0, batch->vertexCount);
+
+    rlDisableVertexArray();
+    rlDisableTexture();
+    rlDisableShader();
+}
+
+// Log CPU cost of DrawLine3D() vs a line batch
+void BenchmarkLineBatch(int segments, int frames)
+{
+    LineBatch batch = LoadLineBatch(segments);
+    double immediateTime = 0.0, batchTime = 0.0;
+
+    for (int f = 0; f < frames; f++)
+    {
+        double start = GetTime();
+        for (int i = 0; i < segments; i++) DrawLine3D(GetBenchmarkPoint(i), GetBenchmarkPoint(i + 1), LIGHTGRAY);
+        rlDrawRenderBatchActive();
+        glFinish();
+        immediateTime += GetTime() - start;
+
+        start = GetTime();
+        ClearLineBatch(&batch);
+        for (int i = 0; i < segments; i++) AddLineBatch3D(&batch, GetBenchmarkPoint(i), GetBenchmarkPoint(i + 1), LIGHTGRAY);
+        DrawLineBatch(&batch);
+        glFinish();
+        batchTime += GetTime() - start;
+    }
+
+    TraceLog(LOG_INFO, "LINE BATCH: %i segments: DrawLine3D %.3f ms, line batch %.3f ms",
+             segments, immediateTime*1000.0/frames, batchTime*1000.0/frames);
+
+    UnloadLineBatch(&batch);
+}
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Definition
+//----------------------------------------------------------------------------------
+
+// Grow CPU arrays to hold at least vertexCount vertices
+static void ReserveLineBatch(LineBatch *batch, int vertexCount)
+{
+    while (batch->vertexCapacity < vertexCount) batch->vertexCapacity *= 2;
+
+    batch->vertices = (float *)RL_REALLOC(batch->vertices, batch->vertexCapacity*3*sizeof(float));
+    batch->colors = (unsigned char *)RL_REALLOC(batch->colors, batch->vertexCapacity*4*sizeof(unsigned char));
+}
+
+// Copy vertices to the GPU, reallocating buffers when they are too small
+static void UploadLineBatch(LineBatch *batch)
+{
+    if (batch->vertexCount > batch->gpuCapacity)
+    {
+        if (batch->vaoId != 0)
+        {
+            rlUnloadVertexArray(batch->vaoId);
+            rlUnloadVertexBuffer(batch->vboId[0]);
+            rlUnloadVertexBuffer(batch->vboId[1]);
+        }
+
+        batch->gpuCapacity = batch->vertexCapacity;
+        batch->vaoId = rlLoadVertexArray();
+        rlEnableVertexArray(batch->vaoId);
+
+        batch->vboId[0] = rlLoadVertexBuffer(NULL, batch->gpuCapacity*3*sizeof(float), true);
+        rlSetVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION, 3, RL_FLOAT, false, 0, 0);
+        rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION);
+
+        batch->vboId[1] = rlLoadVertexBuffer(NULL, batch->gpuCapacity*4*sizeof(unsigned char), true);
+        rlSetVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_COLOR, 4, RL_UNSIGNED_BYTE, true, 0, 0);
+        rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_COLOR);
+
+        rlDisableVertexArray();
+    }
+
+    rlUpdateVertexBuffer(batch->vboId[0], batch->vertices, batch->vertexCount*3*sizeof(float), 0);
+    rlUpdateVertexBuffer(batch->vboId[1], batch->colors, batch->vertexCount*4*sizeof(unsigned char), 0);
+
+    batch->dirty = false;
+}
+
+// Deterministic polyline for the benchmark, same points for both paths
+static Vector3 GetBenchmarkPoint(int index)
+{
+    float t = index*0.001f;
+
+    return (Vector3){ 10.0f*cosf(t), 0.01f*index, 10.0f*sinf(t) };
+}
+
+#endif // LINE_BATCH_IMPLEMENTATION
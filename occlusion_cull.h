@@ -0,0 +1,518 @@
+/**********************************************************************************************
+*
+*   occlusion_cull - CPU occlusion culling against a low resolution software depth buffer
+*
+*   A few large occluders are rasterized every frame into a small depth buffer holding 1/w per
+*   pixel (larger is nearer, 0 is empty), four pixels at a time with SSE2. A tile hierarchy
+*   keeps the farthest depth of every 8x8 tile so most bound tests finish at tile level, only
+*   tiles straddling an occluder edge fall back to per pixel compares.
+*
+*   Compared to masked occlusion culling, which stores a coverage mask and two depth layers per
+*   tile, this keeps a plain depth buffer: at the low resolution used here it is small enough to
+*   stay in cache, and it needs no layer merge heuristics.
+*
+*   CONFIGURATION:
+*
+*   #define OCCLUSION_CULL_IMPLEMENTATION
+*       Generates the implementation of the library into the included file.
+*       If not defined, the library is in header only mode and can be included in other headers
+*       or source files without problems. But only ONE file should hold the implementation.
+*
+**********************************************************************************************/
+
+#ifndef OCCLUSION_CULL_H
+#define OCCLUSION_CULL_H
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define OCCLUSION_TILE_SIZE          8        // Tile hierarchy granularity (pixels)
+#define OCCLUSION_NEAR_PLANE     0.01f        // Clip distance for occluders, bounds crossing it are visible
+#define OCCLUSION_DEPTH_BIAS    0.001f        // Relative bias so an occluder never hides itself
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+
+// Software depth buffer and per frame statistics
+typedef struct {
+    float *depth;               // 1/w per pixel, 0 when empty
+    float *tileMin;             // Farthest (smallest) 1/w per tile
+    int width;                  // Multiple of OCCLUSION_TILE_SIZE
+    int height;                 // Multiple of OCCLUSION_TILE_SIZE
+    int tilesX;
+    int tilesY;
+    Matrix viewProjection;
+
+    int occluderCount;          // Occluders rasterized this frame
+    int triangleCount;          // Occluder triangles rasterized this frame
+    int testedCount;            // Bounds tested this frame
+    int occludedCount;          // Bounds found hidden this frame
+    double rasterTime;          // Seconds spent rasterizing this frame
+    double testTime;            // Seconds spent testing this frame
+} OcclusionBuffer;
+
+#ifdef __cplusplus
+extern "C" {            // Prevents name mangling of functions
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+OcclusionBuffer LoadOcclusionBuffer(int width, int height);                   // Allocate buffer (size rounded up to tiles)
+void UnloadOcclusionBuffer(OcclusionBuffer *buffer);                          // Free buffer memory
+void BeginOcclusionFrame(OcclusionBuffer *buffer, Matrix viewProjection);     // Clear buffer and statistics
+void RasterizeOccluderTriangles(OcclusionBuffer *buffer, const Vector3 *vertices, int triangleCount);  // World space triangle list
+void RasterizeOccluderBox(OcclusionBuffer *buffer, BoundingBox box);          // Solid box (front faces only)
+void EndOcclusionFrame(OcclusionBuffer *buffer);                              // Build tile hierarchy, call before testing
+bool TestOcclusionBox(OcclusionBuffer *buffer, BoundingBox box);              // Returns false when box is hidden by occluders
+
+void BenchmarkOcclusionCulling(int gridSize, int occluders);                  // Log raster and test cost for a dense grid seen edge-on
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OCCLUSION_CULL_H
+
+
+/***********************************************************************************
+*
+*   OCCLUSION_CULL IMPLEMENTATION
+*
+************************************************************************************/
+
+#if defined(OCCLUSION_CULL_IMPLEMENTATION)
+
+#include "raylib.h"
+#include "raymath.h"
+
+#include <math.h>               // Required for: floorf(), ceilf(), fabsf()
+#include <string.h>             // Required for: memset()
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+    #define OCCLUSION_SSE2
+    #include <emmintrin.h>
+#endif
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Declaration
+//----------------------------------------------------------------------------------
+static void RasterizeClipTriangle(OcclusionBuffer *buffer, Vector4 c0, Vector4 c1, Vector4 c2, bool cullBackface);
+static void RasterizeScreenTriangle(OcclusionBuffer *buffer, Vector3 v0, Vector3 v1, Vector3 v2, bool cullBackface);
+
+// Transform a world position to clip space
+static inline Vector4 TransformClip(Matrix m, Vector3 v)
+{
+    return (Vector4){ m.m0*v.x + m.m4*v.y + m.m8*v.z + m.m12,
+                      m.m1*v.x + m.m5*v.y + m.m9*v.z + m.m13,
+                      m.m2*v.x + m.m6*v.y + m.m10*v.z + m.m14,
+                      m.m3*v.x + m.m7*v.y + m.m11*v.z + m.m15 };
+}
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+
+// Allocate buffer (size rounded up to tiles)
+OcclusionBuffer LoadOcclusionBuffer(int width, int height)
+{
+    OcclusionBuffer buffer = { 0 };
+
+    buffer.tilesX = (width + OCCLUSION_TILE_SIZE - 1)/OCCLUSION_TILE_SIZE;
+    buffer.tilesY = (height + OCCLUSION_TILE_SIZE - 1)/OCCLUSION_TILE_SIZE;
+    buffer.width = buffer.tilesX*OCCLUSION_TILE_SIZE;
+    buffer.height = buffer.tilesY*OCCLUSION_TILE_SIZE;
+    buffer.depth = (float *)RL_CALLOC(buffer.width*buffer.height, sizeof(float));
+    buffer.tileMin = (float *)RL_CALLOC(buffer.tilesX*buffer.tilesY, sizeof(float));
+    buffer.viewProjection = MatrixIdentity();
+
+    return buffer;
+}
+
+// Free buffer memory
+void UnloadOcclusionBuffer(OcclusionBuffer *buffer)
+{
+    RL_FREE(buffer->depth);
+    RL_FREE(buffer->tileMin);
+
+    *buffer = (OcclusionBuffer){ 0 };
+}
+
+// Clear buffer and statistics
+void BeginOcclusionFrame(OcclusionBuffer *buffer, Matrix viewProjection)
+{
+    memset(buffer->depth, 0, buffer->width*buffer->height*sizeof(float));
+    memset(buffer->tileMin, 0, buffer->tilesX*buffer->tilesY*sizeof(float));
+
+    buffer->viewProjection = viewProjection;
+    buffer->occluderCount = 0;
+    buffer->triangleCount = 0;
+    buffer->testedCount = 0;
+    buffer->occludedCount = 0;
+    buffer->rasterTime = 0.0;
+    buffer->testTime = 0.0;
+}
+
+// World space triangle list, both faces rasterized
+void RasterizeOccluderTriangles(OcclusionBuffer *buffer, const Vector3 *vertices, int triangleCount)
+{
+    double start = GetTime();
+
+    for (int i = 0; i < triangleCount; i++)
+    {
+        RasterizeClipTriangle(buffer, TransformClip(buffer->viewProjection, vertices[3*i]),
+                                      TransformClip(buffer->viewProjection, vertices[3*i + 1]),
+                                      TransformClip(buffer->viewProjection, vertices[3*i + 2]), false);
+    }
+
+    buffer->occluderCount++;
+    buffer->rasterTime += GetTime() - start;
+}
+
+// Solid box (front faces only)
+void RasterizeOccluderBox(OcclusionBuffer *buffer, BoundingBox box)
+{
+    // Outward facing triangles, clockwise seen from outside
+    static const unsigned char indices[36] = {
+        0, 2, 1, 1, 2, 3,       // -x
+        4, 5, 6, 5, 7, 6,       // +x
+        0, 1, 4, 1, 5, 4,       // -y
+        2, 6, 3, 3, 6, 7,       // +y
+        0, 4, 2, 2, 4, 6,       // -z
+        1, 3, 5, 3, 7, 5        // +z
+    };
+
+    double start = GetTime();
+
+    Vector4 corners[8];
+    for (int i = 0; i < 8; i++)
+    {
+        Vector3 v = { (i & 4)? box.max.x : box.min.x, (i & 2)? box.max.y : box.min.y, (i & 1)? box.max.z : box.min.z };
+        corners[i] = TransformClip(buffer->viewProjection, v);
+    }
+
+    for (int i = 0; i < 36; i += 3)
+    {
+        RasterizeClipTriangle(buffer, corners[indices[i]], corners[indices[i + 1]], corners[indices[i + 2]], true);
+    }
+
+    buffer->occluderCount++;
+    buffer->rasterTime += GetTime() - start;
+}
+
+// Build tile hierarchy, call before testing
+void EndOcclusionFrame(OcclusionBuffer *buffer)
+{
+    double start = GetTime();
+
+    for (int ty = 0; ty < buffer->tilesY; ty++)
+    {
+        for (int tx = 0; tx < buffer->tilesX; tx++)
+        {
+            const float *row = buffer->depth + ty*OCCLUSION_TILE_SIZE*buffer->width + tx*OCCLUSION_TILE_SIZE;
+
+#if defined(OCCLUSION_SSE2)
+            __m128 minimum = _mm_loadu_ps(row);
+            for (int y = 0; y < OCCLUSION_TILE_SIZE; y++, row += buffer->width)
+            {
+                for (int x = 0; x < OCCLUSION_TILE_SIZE; x += 4) minimum = _mm_min_ps(minimum, _mm_loadu_ps(row + x));
+            }
+            minimum = _mm_min_ps(minimum, _mm_shuffle_ps(minimum, minimum, _MM_SHUFFLE(1, 0, 3, 2)));
+            minimum = _mm_min_ps(minimum, _mm_shuffle_ps(minimum, minimum, _MM_SHUFFLE(2, 3, 0, 1)));
+            buffer->tileMin[ty*buffer->tilesX + tx] = _mm_cvtss_f32(minimum);
+#else
+            float minimum = row[0];
+            for (int y = 0; y < OCCLUSION_TILE_SIZE; y++, row += buffer->width)
+            {
+                for (int x = 0; x < OCCLUSION_TILE_SIZE; x++) if (row[x] < minimum) minimum = row[x];
+            }
+            buffer->tileMin[ty*buffer->tilesX + tx] = minimum;
+#endif
+        }
+    }
+
+    buffer->rasterTime += GetTime() - start;
+}
+
+// Returns false when box is hidden by occluders
+// NOTE: The nearest point of a box is one of its corners, so the largest corner 1/w is a
+// conservative depth for the whole projected rectangle
+bool TestOcclusionBox(OcclusionBuffer *buffer, BoundingBox box)
+{
+    double start = GetTime();
+    bool visible = false;
+
+    float xmin = 1e30f, ymin = 1e30f, xmax = -1e30f, ymax = -1e30f;
+    float nearest = 0.0f;
+
+    buffer->testedCount++;
+
+    for (int i = 0; i < 8; i++)
+    {
+        Vector3 v = { (i & 4)? box.max.x : box.min.x, (i & 2)? box.max.y : box.min.y, (i & 1)? box.max.z : box.min.z };
+        Vector4 c = TransformClip(buffer->viewProjection, v);
+
+        if (c.w <= OCCLUSION_NEAR_PLANE)
+        {
+            // Crosses the camera plane, can not be bounded on screen
+            buffer->testTime += GetTime() - start;
+            return true;
+        }
+
+        float invW = 1.0f/c.w;
+        float sx = (c.x*invW*0.5f + 0.5f)*buffer->width;
+        float sy = (0.5f - c.y*invW*0.5f)*buffer->height;
+
+        if (sx < xmin) xmin = sx;
+        if (sx > xmax) xmax = sx;
+        if (sy < ymin) ymin = sy;
+        if (sy > ymax) ymax = sy;
+        if (invW > nearest) nearest = invW;
+    }
+
+    int x0 = (int)floorf(xmin), y0 = (int)floorf(ymin);
+    int x1 = (int)ceilf(xmax), y1 = (int)ceilf(ymax);
+
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > buffer->width) x1 = buffer->width;
+    if (y1 > buffer->height) y1 = buffer->height;
+
+    // Outside the buffer is frustum culling business
+    if ((x0 >= x1) || (y0 >= y1))
+    {
+        buffer->testTime += GetTime() - start;
+        return true;
+    }
+
+    float threshold = nearest*(1.0f + OCCLUSION_DEPTH_BIAS);
+
+    for (int ty = y0/OCCLUSION_TILE_SIZE; (ty <= (y1 - 1)/OCCLUSION_TILE_SIZE) && !visible; ty++)
+    {
+        for (int tx = x0/OCCLUSION_TILE_SIZE; (tx <= (x1 - 1)/OCCLUSION_TILE_SIZE) && !visible; tx++)
+        {
+            // Whole tile nearer than the box
+            if (buffer->tileMin[ty*buffer->tilesX + tx] > threshold) continue;
+
+            int px0 = tx*OCCLUSION_TILE_SIZE, py0 = ty*OCCLUSION_TILE_SIZE;
+            int px1 = px0 + OCCLUSION_TILE_SIZE, py1 = py0 + OCCLUSION_TILE_SIZE;
+            if (px0 < x0) px0 = x0;
+            if (py0 < y0) py0 = y0;
+            if (px1 > x1) px1 = x1;
+            if (py1 > y1) py1 = y1;
+
+            for (int y = py0; (y < py1) && !visible; y++)
+            {
+                const float *row = buffer->depth + y*buffer->width;
+                int x = px0;
+
+#if defined(OCCLUSION_SSE2)
+                __m128 limit = _mm_set1_ps(threshold);
+                for (; x + 4 <= px1; x += 4)
+                {
+                    if (_mm_movemask_ps(_mm_cmple_ps(_mm_loadu_ps(row + x), limit)) != 0)
+                    {
+                        visible = true;
+                        break;
+                    }
+                }
+#endif
+                for (; (x < px1) && !visible; x++)
+                {
+                    if (row[x] <= threshold) visible = true;
+                }
+            }
+        }
+    }
+
+    if (!visible) buffer->occludedCount++;
+    buffer->testTime += GetTime() - start;
+
+    return visible;
+}
+
+// Log raster and test cost for a dense grid seen edge-on
+void BenchmarkOcclusionCulling(int gridSize, int occluders)
+{
+    OcclusionBuffer buffer = LoadOcclusionBuffer(256, 192);
+
+    Camera camera = { 0 };
+    camera.position = (Vector3){ 0.0f, 2.0f, -4.0f*gridSize };
+    camera.target = (Vector3){ 0.0f, 0.0f, 0.0f };
+    camera.up = (Vector3){ 0.0f, 1.0f, 0.0f };
+    camera.fovy = 45.0f;
+
+    Matrix view = MatrixLookAt(camera.position, camera.target, camera.up);
+    Matrix projection = MatrixPerspective(camera.fovy*DEG2RAD, 640.0/480.0, 0.01, 1000.0);
+    Matrix viewProjection = MatrixMultiply(view, projection);
+
+    int frames = 100;
+    int occluded = 0;
+    double rasterTime = 0.0, testTime = 0.0;
+
+    for (int f = 0; f < frames; f++)
+    {
+        BeginOcclusionFrame(&buffer, viewProjection);
+
+        // Front row blocks make a wall, taller than the camera line of sight over the grid
+        for (int i = 0; (i < occluders) && (i < gridSize); i++)
+        {
+            Vector3 p = { (i - gridSize/2.0f)*4.0f, 0.0f, -gridSize*2.0f };
+            RasterizeOccluderBox(&buffer, (BoundingBox){ (Vector3){ p.x - 2.0f, -1.0f, p.z - 1.0f }, (Vector3){ p.x + 2.0f, 3.0f, p.z + 1.0f } });
+        }
+
+        EndOcclusionFrame(&buffer);
+
+        for (int z = 1; z < gridSize; z++)
+        {
+            for (int x = 0; x < gridSize; x++)
+            {
+                Vector3 p = { (x - gridSize/2.0f)*4.0f, 0.0f, (z - gridSize/2.0f)*4.0f };
+                TestOcclusionBox(&buffer, (BoundingBox){ Vector3SubtractValue(p, 1.0f), Vector3AddValue(p, 1.0f) });
+            }
+        }
+
+        occluded += buffer.occludedCount;
+        rasterTime += buffer.rasterTime;
+        testTime += buffer.testTime;
+    }
+
+    TraceLog(LOG_INFO, "OCCLUSION: %ix%i grid, %i occluders: raster %.3f ms, %i tests %.3f ms, %i occluded",
+             gridSize, gridSize, buffer.occluderCount, rasterTime*1000.0/frames, buffer.testedCount, testTime*1000.0/frames, occluded/frames);
+
+    UnloadOcclusionBuffer(&buffer);
+}
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Definition
+//----------------------------------------------------------------------------------
+
+// Clip a triangle against the near plane and rasterize the resulting fan
+static void RasterizeClipTriangle(OcclusionBuffer *buffer, Vector4 c0, Vector4 c1, Vector4 c2, bool cullBackface)
+{
+    Vector4 input[3] = { c0, c1, c2 };
+    Vector4 output[4];
+    int count = 0;
+
+    for (int i = 0; i < 3; i++)
+    {
+        Vector4 a = input[i];
+        Vector4 b = input[(i + 1)%3];
+        bool aInside = (a.w >= OCCLUSION_NEAR_PLANE);
+        bool bInside = (b.w >= OCCLUSION_NEAR_PLANE);
+
+        if (aInside) output[count++] = a;
+
+        if (aInside != bInside)
+        {
+            float t = (OCCLUSION_NEAR_PLANE - a.w)/(b.w - a.w);
+            output[count++] = (Vector4){ a.x + t*(b.x - a.x), a.y + t*(b.y - a.y), a.z + t*(b.z - a.z), OCCLUSION_NEAR_PLANE };
+        }
+    }
+
+    if (count < 3) return;
+
+    Vector3 screen[4];
+    for (int i = 0; i < count; i++)
+    {
+        float invW = 1.0f/output[i].w;
+        screen[i] = (Vector3){ (output[i].x*invW*0.5f + 0.5f)*buffer->width, (0.5f - output[i].y*invW*0.5f)*buffer->height, invW };
+    }
+
+    RasterizeScreenTriangle(buffer, screen[0], screen[1], screen[2], cullBackface);
+    if (count == 4) RasterizeScreenTriangle(buffer, screen[0], screen[2], screen[3], cullBackface);
+}
+
+// Rasterize a screen space triangle (z holds 1/w), keeping the nearest depth per pixel
+static void RasterizeScreenTriangle(OcclusionBuffer *buffer, Vector3 v0, Vector3 v1, Vector3 v2, bool cullBackface)
+{
+    float area = (v1.x - v0.x)*(v2.y - v0.y) - (v1.y - v0.y)*(v2.x - v0.x);
+
+    // Clockwise front faces turn counter-clockwise with y pointing down, non positive area is a back face
+    if (cullBackface && (area <= 0.0f)) return;
+    if (fabsf(area) < 1e-6f) return;
+
+    if (area < 0.0f)
+    {
+        Vector3 t = v1; v1 = v2; v2 = t;
+        area = -area;
+    }
+
+    buffer->triangleCount++;
+
+    // Edge functions E(x, y) = A*x + B*y + C, non negative inside
+    float a0 = v0.y - v1.y, b0 = v1.x - v0.x, e0 = -(a0*v0.x + b0*v0.y);
+    float a1 = v1.y - v2.y, b1 = v2.x - v1.x, e1 = -(a1*v1.x + b1*v1.y);
+    float a2 = v2.y - v0.y, b2 = v0.x - v2.x, e2 = -(a2*v2.x + b2*v2.y);
+
+    // Depth plane from barycentric weights (E12, E20, E01)
+    float invArea = 1.0f/area;
+    float za = (a1*v0.z + a2*v1.z + a0*v2.z)*invArea;
+    float zb = (b1*v0.z + b2*v1.z + b0*v2.z)*invArea;
+    float zc = (e1*v0.z + e2*v1.z + e0*v2.z)*invArea;
+
+    int xmin = (int)floorf(fminf(v0.x, fminf(v1.x, v2.x)));
+    int xmax = (int)ceilf(fmaxf(v0.x, fmaxf(v1.x, v2.x)));
+    int ymin = (int)floorf(fminf(v0.y, fminf(v1.y, v2.y)));
+    int ymax = (int)ceilf(fmaxf(v0.y, fmaxf(v1.y, v2.y)));
+
+    if (xmin < 0) xmin = 0;
+    if (ymin < 0) ymin = 0;
+    if (xmax > buffer->width - 1) xmax = buffer->width - 1;
+    if (ymax > buffer->height - 1) ymax = buffer->height - 1;
+    if ((xmin > xmax) || (ymin > ymax)) return;
+
+    xmin &= ~3;         // Blocks of four pixels, width is a multiple of four
+
+#if defined(OCCLUSION_SSE2)
+    __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    __m128 va0 = _mm_set1_ps(a0), va1 = _mm_set1_ps(a1), va2 = _mm_set1_ps(a2), vza = _mm_set1_ps(za);
+    __m128 zero = _mm_setzero_ps();
+
+    for (int y = ymin; y <= ymax; y++)
+    {
+        float py = y + 0.5f;
+        __m128 r0 = _mm_set1_ps(b0*py + e0);
+        __m128 r1 = _mm_set1_ps(b1*py + e1);
+        __m128 r2 = _mm_set1_ps(b2*py + e2);
+        __m128 rz = _mm_set1_ps(zb*py + zc);
+        float *row = buffer->depth + y*buffer->width;
+
+        for (int x = xmin; x <= xmax; x += 4)
+        {
+            __m128 px = _mm_add_ps(_mm_set1_ps((float)x), offsets);
+            __m128 w0 = _mm_add_ps(_mm_mul_ps(va0, px), r0);
+            __m128 w1 = _mm_add_ps(_mm_mul_ps(va1, px), r1);
+            __m128 w2 = _mm_add_ps(_mm_mul_ps(va2, px), r2);
+            __m128 mask = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(w0, zero), _mm_cmpge_ps(w1, zero)), _mm_cmpge_ps(w2, zero));
+
+            if (_mm_movemask_ps(mask) == 0) continue;
+
+            __m128 z = _mm_add_ps(_mm_mul_ps(vza, px), rz);
+            __m128 stored = _mm_loadu_ps(row + x);
+            __m128 nearer = _mm_max_ps(stored, z);
+            _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(mask, nearer), _mm_andnot_ps(mask, stored)));
+        }
+    }
+#else
+    for (int y = ymin; y <= ymax; y++)
+    {
+        float py = y + 0.5f;
+        float *row = buffer->depth + y*buffer->width;
+
+        for (int x = xmin; x <= xmax; x++)
+        {
+            float px = x + 0.5f;
+
+            if ((a0*px + b0*py + e0 >= 0.0f) && (a1*px + b1*py + e1 >= 0.0f) && (a2*px + b2*py + e2 >= 0.0f))
+            {
+                float z = za*px + zb*py + zc;
+                if (z > row[x]) row[x] = z;
+            }
+        }
+    }
+#endif
+}
+
+#endif // OCCLUSION_CULL_IMPLEMENTATION
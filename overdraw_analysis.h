@@ -0,0 +1,371 @@
+/**********************************************************************************************
+*
+*   overdraw_analysis - fragments per pixel of a drawing, counted on the GPU and read back
+*
+*   Draws are counted with the blend state alone, so models, instanced meshes and batch geometry
+*   count the same whatever shader they bind. The counting target is a float texture cleared to
+*   x0 = 128/255 and every fragment written blends with factors (ZERO, ONE_MINUS_DST_COLOR):
+*
+*       x(n + 1) = x(n)*(1 - x(n))
+*
+*   The sequence only depends on the number of fragments, so the count is found by looking the
+*   read back value up in the same sequence computed on the CPU. Fragments discarded by their
+*   shader or failing the depth test are not counted. Draws changing the blend mode themselves
+*   (BeginBlendMode()) break the counting.
+*
+*   Each counted drawing (a layer) gets its min, mean and max fragments per pixel, the sum over
+*   all layers of the frame is shown as a heatmap.
+*
+*   CONFIGURATION:
+*
+*   #define OVERDRAW_ANALYSIS_IMPLEMENTATION
+*       Generates the implementation of the library into the included file.
+*       If not defined, the library is in header only mode and can be included in other headers
+*       or source files without problems. But only ONE file should hold the implementation.
+*
+**********************************************************************************************/
+
+#ifndef OVERDRAW_ANALYSIS_H
+#define OVERDRAW_ANALYSIS_H
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define OVERDRAW_MAX_COUNT      255     // Higher counts read back as this
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef void (*OverdrawDrawFunc)(void);
+
+// Fragments per pixel over the screen
+typedef struct {
+    int minimum;
+    float mean;
+    int maximum;
+} OverdrawStats;
+
+// Counting target, read back counts and heatmap
+typedef struct {
+    RenderTexture2D target;     // R32 float color and depth
+    Texture2D heatmap;          // RGBA, top down
+    Color *heatmapPixels;
+    unsigned short *counts;     // Per pixel over the layers counted since BeginOverdrawAnalysis(), top down
+    float sequence[OVERDRAW_MAX_COUNT + 1];    // Target value after n fragments
+    int width;
+    int height;
+    OverdrawStats total;        // Over all layers, set by EndOverdrawAnalysis()
+    double time;                // Seconds spent counting and reading back this frame
+} OverdrawAnalysis;
+
+#ifdef __cplusplus
+extern "C" {            // Prevents name mangling of functions
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+OverdrawAnalysis LoadOverdrawAnalysis(void);                                             // Empty analysis, targets load for the screen size when begun
+void UnloadOverdrawAnalysis(OverdrawAnalysis *analysis);                                 // Unload targets and counts
+void BeginOverdrawAnalysis(OverdrawAnalysis *analysis);                                  // Start a frame of counting, zero the per pixel sums
+OverdrawStats CountOverdraw(OverdrawAnalysis *analysis, OverdrawDrawFunc draw);          // Count the fragments of one drawing (a layer)
+void EndOverdrawAnalysis(OverdrawAnalysis *analysis);                                    // Total stats and heatmap of the layers counted
+void DrawOverdrawHeatmap(OverdrawAnalysis *analysis);                                    // Draw the heatmap over the screen
+Color GetOverdrawColor(int count);                                                       // Heatmap color of a fragment count
+
+void BenchmarkOverdrawAnalysis(int rectangles, int frames);                              // Check counts for stacked rectangles and log the analysis cost
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OVERDRAW_ANALYSIS_H
+
+
+/***********************************************************************************
+*
+*   OVERDRAW_ANALYSIS IMPLEMENTATION
+*
+************************************************************************************/
+
+#if defined(OVERDRAW_ANALYSIS_IMPLEMENTATION)
+
+#include "raylib.h"
+#include "rlgl.h"
+
+#include <string.h>             // Required for: memset()
+
+#include "gl_loader.h"      // Required for: glFinish()
+
+#define OVERDRAW_CLEAR_VALUE    128     // x0 = 128/255, what rlClearColor() turns 128 into
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Declaration
+//----------------------------------------------------------------------------------
+static void LoadOverdrawTargets(OverdrawAnalysis *analysis);
+static void UnloadOverdrawTargets(OverdrawAnalysis *analysis);
+static int DecodeOverdrawCount(const float *sequence, float value);
+static OverdrawStats GetOverdrawStats(const unsigned short *counts, int pixelCount);
+static void DrawBenchmarkRectangles(void);
+
+static int benchmarkRectangles = 0;
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+
+// Empty analysis, targets load for the screen size when begun
+OverdrawAnalysis LoadOverdrawAnalysis(void)
+{
+    OverdrawAnalysis analysis = { 0 };
+
+    analysis.sequence[0] = (float)OVERDRAW_CLEAR_VALUE/255.0f;
+    for (int i = 1; i <= OVERDRAW_MAX_COUNT; i++) analysis.sequence[i] = analysis.sequence[i - 1]*(1.0f - analysis.sequence[i - 1]);
+
+    return analysis;
+}
+
+// Unload targets and counts
+void UnloadOverdrawAnalysis(OverdrawAnalysis *analysis)
+{
+    UnloadOverdrawTargets(analysis);
+
+    *analysis = (OverdrawAnalysis){ 0 };
+}
+
+// Start a frame of counting, zero the per pixel sums
+void BeginOverdrawAnalysis(OverdrawAnalysis *analysis)
+{
+    if ((analysis->width != GetScreenWidth()) || (analysis->height != GetScreenHeight()))
+    {
+        UnloadOverdrawTargets(analysis);
+        analysis->width = GetScreenWidth();
+        analysis->height = GetScreenHeight();
+        LoadOverdrawTargets(analysis);
+    }
+
+    memset(analysis->counts, 0, analysis->width*analysis->height*sizeof(unsigned short));
+    analysis->time = 0.0;
+}
+
+// Count the fragments of one drawing (a layer)
+OverdrawStats CountOverdraw(OverdrawAnalysis *analysis, OverdrawDrawFunc draw)
+{
+    double start = GetTime();
+    int width = analysis->width;
+    int height = analysis->height;
+
+    BeginTextureMode(analysis->target);
+        ClearBackground((Color){ OVERDRAW_CLEAR_VALUE, OVERDRAW_CLEAR_VALUE, OVERDRAW_CLEAR_VALUE, OVERDRAW_CLEAR_VALUE });
+
+        rlSetBlendFactors(RL_ZERO, RL_ONE_MINUS_DST_COLOR, RL_FUNC_ADD);
+        BeginBlendMode(BLEND_CUSTOM);
+            draw();
+        EndBlendMode();
+    EndTextureMode();
+
+    float *values = (float *)rlReadTexturePixels(analysis->target.texture.id, width, height, RL_PIXELFORMAT_UNCOMPRESSED_R32);
+    unsigned short *layerCounts = (unsigned short *)RL_MALLOC(width*height*sizeof(unsigned short));
+
+    // Texture rows are bottom up, counts top down like the screen
+    for (int y = 0; y < height; y++)
+    {
+        const float *row = values + (height - 1 - y)*width;
+        unsigned short *counts = layerCounts + y*width;
+        float previous = -1.0f;
+        int count = 0;
+
+        for (int x = 0; x < width; x++)
+        {
+            // Runs of equal values are common, skip the lookup for them
+            if (row[x] != previous)
+            {
+                previous = row[x];
+                count = DecodeOverdrawCount(analysis->sequence, previous);
+            }
+
+            counts[x] = (unsigned short)count;
+            analysis->counts[y*width + x] += (unsigned short)count;
+        }
+    }
+
+    OverdrawStats stats = GetOverdrawStats(layerCounts, width*height);
+
+    RL_FREE(layerCounts);
+    RL_FREE(values);
+
+    analysis->time += GetTime() - start;
+
+    return stats;
+}
+
+// Total stats and heatmap of the layers counted
+void EndOverdrawAnalysis(OverdrawAnalysis *analysis)
+{
+    int pixelCount = analysis->width*analysis->height;
+
+    analysis->total = GetOverdrawStats(analysis->counts, pixelCount);
+
+    for (int i = 0; i < pixelCount; i++) analysis->heatmapPixels[i] = GetOverdrawColor(analysis->counts[i]);
+
+    UpdateTexture(analysis->heatmap, analysis->heatmapPixels);
+}
+
+// Draw the heatmap over the screen
+void DrawOverdrawHeatmap(OverdrawAnalysis *analysis)
+{
+    if (analysis->heatmap.id == 0) return;
+
+    DrawTexture(analysis->heatmap, 0, 0, WHITE);
+}
+
+// Heatmap color of a fragment count
+Color GetOverdrawColor(int count)
+{
+    static const Color ramp[8] = {
+        { 0, 0, 0, 255 },           // 0
+        { 0, 0, 160, 255 },         // 1
+        { 0, 160, 220, 255 },       // 2
+        { 0, 200, 0, 255 },         // 3
+        { 230, 230, 0, 255 },       // 4
+        { 255, 140, 0, 255 },       // 5
+        { 230, 0, 0, 255 },         // 6, 7
+        { 255, 255, 255, 255 }      // 8 and more
+    };
+
+    if (count >= 8) return ramp[7];
+    if (count == 7) return ramp[6];
+
+    return ramp[count];
+}
+
+// Check counts for stacked rectangles and log the analysis cost
+void BenchmarkOverdrawAnalysis(int rectangles, int frames)
+{
+    OverdrawAnalysis analysis = LoadOverdrawAnalysis();
+    OverdrawStats stats = { 0 };
+
+    benchmarkRectangles = rectangles;
+
+    for (int f = 0; f < frames; f++)
+    {
+        BeginOverdrawAnalysis(&analysis);
+        stats = CountOverdraw(&analysis, DrawBenchmarkRectangles);
+        EndOverdrawAnalysis(&analysis);
+        glFinish();
+    }
+
+    // Rectangle i covers the left (i + 1)/rectangles of the screen: max is rectangles, min 1
+    TraceLog(LOG_INFO, "OVERDRAW: %i stacked rectangles: min %i mean %.2f max %i (expected 1, %.2f, %i), count and read back %.3f ms",
+             rectangles, stats.minimum, stats.mean, stats.maximum, (rectangles + 1)/2.0f, rectangles, analysis.time*1000.0);
+
+    UnloadOverdrawAnalysis(&analysis);
+}
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Definition
+//----------------------------------------------------------------------------------
+
+// Float color target with a depth renderbuffer, counts and heatmap for the current size
+static void LoadOverdrawTargets(OverdrawAnalysis *analysis)
+{
+    int width = analysis->width;
+    int height = analysis->height;
+    RenderTexture2D target = { 0 };
+
+    target.id = rlLoadFramebuffer(width, height);
+    rlEnableFramebuffer(target.id);
+
+    target.texture.id = rlLoadTexture(NULL, width, height, RL_PIXELFORMAT_UNCOMPRESSED_R32, 1);
+    target.texture.width = width;
+    target.texture.height = height;
+    target.texture.format = PIXELFORMAT_UNCOMPRESSED_R32;
+    target.texture.mipmaps = 1;
+
+    target.depth.id = rlLoadTextureDepth(width, height, true);
+    target.depth.width = width;
+    target.depth.height = height;
+    target.depth.format = 19;       // DEPTH_COMPONENT_24BIT, as LoadRenderTexture()
+    target.depth.mipmaps = 1;
+
+    rlFramebufferAttach(target.id, target.texture.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_TEXTURE2D, 0);
+    rlFramebufferAttach(target.id, target.depth.id, RL_ATTACHMENT_DEPTH, RL_ATTACHMENT_RENDERBUFFER, 0);
+
+    if (!rlFramebufferComplete(target.id)) TraceLog(LOG_WARNING, "OVERDRAW: [ID %i] Counting framebuffer is not complete", target.id);
+
+    rlDisableFramebuffer();
+
+    analysis->target = target;
+    analysis->counts = (unsigned short *)RL_CALLOC(width*height, sizeof(unsigned short));
+    analysis->heatmapPixels = (Color *)RL_CALLOC(width*height, sizeof(Color));
+
+    Image image = { analysis->heatmapPixels, width, height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+    analysis->heatmap = LoadTextureFromImage(image);
+}
+
+static void UnloadOverdrawTargets(OverdrawAnalysis *analysis)
+{
+    if (analysis->target.id > 0) UnloadRenderTexture(analysis->target);
+    if (analysis->heatmap.id > 0) UnloadTexture(analysis->heatmap);
+
+    RL_FREE(analysis->counts);
+    RL_FREE(analysis->heatmapPixels);
+
+    analysis->target = (RenderTexture2D){ 0 };
+    analysis->heatmap = (Texture2D){ 0 };
+    analysis->counts = NULL;
+    analysis->heatmapPixels = NULL;
+}
+
+// Index of the sequence value nearest to a read back value (the sequence decreases)
+static int DecodeOverdrawCount(const float *sequence, float value)
+{
+    int low = 0;
+    int high = OVERDRAW_MAX_COUNT;
+
+    if (value >= sequence[0]) return 0;
+    if (value <= sequence[OVERDRAW_MAX_COUNT]) return OVERDRAW_MAX_COUNT;
+
+    // sequence[low] > value >= sequence[high]
+    while (high - low > 1)
+    {
+        int middle = (low + high)/2;
+
+        if (sequence[middle] > value) low = middle;
+        else high = middle;
+    }
+
+    return ((sequence[low] - value) < (value - sequence[high]))? low : high;
+}
+
+// Min, mean and max of per pixel counts
+static OverdrawStats GetOverdrawStats(const unsigned short *counts, int pixelCount)
+{
+    OverdrawStats stats = { 0 };
+    if (pixelCount == 0) return stats;
+
+    long long sum = 0;
+    stats.minimum = counts[0];
+
+    for (int i = 0; i < pixelCount; i++)
+    {
+        if (counts[i] < stats.minimum) stats.minimum = counts[i];
+        if (counts[i] > stats.maximum) stats.maximum = counts[i];
+        sum += counts[i];
+    }
+
+    stats.mean = (float)((double)sum/pixelCount);
+
+    return stats;
+}
+
+// Stacked rectangles for the benchmark, each one wider than the previous
+static void DrawBenchmarkRectangles(void)
+{
+    for (int i = 0; i < benchmarkRectangles; i++)
+    {
+        DrawRectangle(0, 0, GetScreenWidth()*(i + 1)/benchmarkRectangles, GetScreenHeight(), WHITE);
+    }
+}
+
+#endif // OVERDRAW_ANALYSIS_IMPLEMENTATION
@@ -0,0 +1,468 @@
+/**********************************************************************************************
+*
+*   post_chain - Post-processing over a rendered image, blurs at reduced resolution and every
+*   per pixel effect fused in one full resolution pass
+*
+*   Post effects cost fill rate: a pass per effect reads and writes every pixel of the screen.
+*   The chain keeps full resolution work to a single pass (post_compose.fs) with the enabled
+*   effects compiled in as shader variants (shader_variants.h), and runs the wide filters at a
+*   half or a quarter of the image size:
+*
+*       - bloom: the bright part of the image downsampled (post_blur.fs, DOWNSAMPLE THRESHOLD),
+*         then blurred horizontally and vertically between two targets, bloomIterations times
+*       - blur: the same without the threshold, mixed over the image by blurAmount
+*       - compose: the image (FXAA antialiased if enabled), edges, both blurs (bilinear
+*         upsampling), grayscale, posterize and vignette, one draw at full resolution
+*
+*   A quarter resolution blur touches 1/16 of the pixels of a full resolution one and its 9 taps
+*   cover 4 times the width. With no effect enabled the chain returns its input, no pass runs.
+*
+*   Each pass is timed on the GPU with a GL_TIME_ELAPSED query, read back once the result is
+*   available (a frame or more later) so it never stalls the pipeline.
+*
+*   NOTE: Timer queries are not part of rlgl, they are loaded through glfwGetProcAddress() from
+*   raylib's desktop platform. Without them the passes run untimed.
+*
+*   CONFIGURATION:
+*
+*   #define POST_CHAIN_IMPLEMENTATION
+*       Generates the implementation of the library into the included file.
+*       If not defined, the library is in header only mode and can be included in other headers
+*       or source files without problems. But only ONE file should hold the implementation.
+*
+**********************************************************************************************/
+
+#ifndef POST_CHAIN_H
+#define POST_CHAIN_H
+
+#include "shader_variants.h"    // Required for: ShaderVariants
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define POST_CHAIN_PASSES       3       // Timed passes: bloom, blur and compose
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+
+// Effects, the bits of the post_compose.fs variant mask
+typedef enum {
+    POST_EFFECT_EDGES = 1,
+    POST_EFFECT_BLUR = 2,
+    POST_EFFECT_BLOOM = 4,
+    POST_EFFECT_GRAYSCALE = 8,
+    POST_EFFECT_POSTERIZE = 16,
+    POST_EFFECT_VIGNETTE = 32,
+    POST_EFFECT_FXAA = 64,
+} PostEffect;
+
+// Timed passes
+typedef enum {
+    POST_PASS_BLOOM = 0,
+    POST_PASS_BLUR,
+    POST_PASS_COMPOSE,
+} PostPassIndex;
+
+// One pass and its last GPU time
+typedef struct {
+    unsigned int query;         // GL_TIME_ELAPSED query, 0 without timer queries
+    bool pending;               // Query issued, result not read yet
+    bool ran;                   // Ran in the last ApplyPostChain()
+    double time;                // Seconds, last result read
+    int width;                  // Resolution it last ran at
+    int height;
+    int draws;
+} PostPass;
+
+// Effects, their settings and the targets they run in
+typedef struct {
+    ShaderVariants blurShaders;         // post_blur.fs
+    ShaderVariants composeShaders;      // post_compose.fs
+
+    unsigned int effects;               // PostEffect flags
+    bool fused;                         // Off runs every compose effect as its own pass (reference)
+    int bloomScale;                     // Image size divided by this, 1, 2 or 4
+    int bloomIterations;                // Horizontal and vertical blur pairs
+    float bloomThreshold;
+    float bloomIntensity;
+    int blurScale;
+    int blurIterations;
+    float blurAmount;
+    float colorLevels;                  // Posterize levels per channel
+
+    RenderTexture2D bloomTargets[2];    // Ping-pong at the bloom scale
+    RenderTexture2D blurTargets[2];     // Ping-pong at the blur scale
+    RenderTexture2D outputs[2];         // Full resolution, the second one only used unfused
+    int width;                          // Image size the targets were loaded for
+    int height;
+
+    PostPass passes[POST_CHAIN_PASSES];
+    double cpuTime;                     // Submission time of the last ApplyPostChain()
+} PostChain;
+
+#ifdef __cplusplus
+extern "C" {            // Prevents name mangling of functions
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+PostChain LoadPostChain(ShaderCache *cache, int glslVersion, const char *blurFileName, const char *composeFileName);  // No effect enabled, targets load on the first apply
+void UnloadPostChain(PostChain *chain);                                                  // Unload targets, shader variants and queries
+Texture2D ApplyPostChain(PostChain *chain, Texture2D image);                             // Run the enabled effects over a render texture image, returns the result
+int GetPostChainPixels(PostChain *chain);                                                // Pixels written by the passes of the last apply
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // POST_CHAIN_H
+
+
+/***********************************************************************************
+*
+*   POST_CHAIN IMPLEMENTATION
+*
+************************************************************************************/
+
+#if defined(POST_CHAIN_IMPLEMENTATION)
+
+#include "raylib.h"
+#include "rlgl.h"
+#include "uniform_cache.h"      // Required for: SetShaderValueCached()
+
+#include "gl_loader.h"      // Required for: glfwGetProcAddress(), GL function types
+
+#define POST_CHAIN_GL_TIME_ELAPSED              0x88BF      // GL 3.3, not in gl.h
+#define POST_CHAIN_GL_QUERY_RESULT              0x8866
+#define POST_CHAIN_GL_QUERY_RESULT_AVAILABLE    0x8867
+
+//----------------------------------------------------------------------------------
+// Global Variables Definition
+//----------------------------------------------------------------------------------
+static GLGenQueriesProc postChainGenQueries = NULL;
+static GLDeleteQueriesProc postChainDeleteQueries = NULL;
+static GLBeginQueryProc postChainBeginQuery = NULL;
+static GLEndQueryProc postChainEndQuery = NULL;
+static GLGetQueryObjectivProc postChainGetQueryObjectiv = NULL;
+static GLGetQueryObjectui64vProc postChainGetQueryObjectui64v = NULL;
+
+static const char *postBlurFeatures[] = { "DOWNSAMPLE", "THRESHOLD" };
+static const char *postComposeFeatures[] = { "EDGES", "BLUR", "BLOOM", "GRAYSCALE", "POSTERIZE", "VIGNETTE", "FXAA" };
+
+#define POST_BLUR_DOWNSAMPLE    1       // post_blur.fs variant bits
+#define POST_BLUR_THRESHOLD     2
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Declaration
+//----------------------------------------------------------------------------------
+static void LoadPostChainTargets(PostChain *chain, int width, int height);
+static void LoadPostChainPair(RenderTexture2D *targets, int width, int height, int scale);
+static void UnloadPostChainPair(RenderTexture2D *targets);
+static bool BeginPostPass(PostChain *chain, PostPass *pass);
+static void EndPostPass(PostChain *chain, PostPass *pass, bool timed);
+static void DrawPostQuad(PostPass *pass, RenderTexture2D target, Texture2D source);
+static Texture2D BlurPostImage(PostChain *chain, PostPass *pass, Texture2D image, RenderTexture2D *targets, int iterations, bool threshold);
+static void SetPostComposeValues(PostChain *chain, Shader shader, unsigned int effects, Texture2D image);
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+
+// No effect enabled, targets load on the first apply
+PostChain LoadPostChain(ShaderCache *cache, int glslVersion, const char *blurFileName, const char *composeFileName)
+{
+    PostChain chain = { 0 };
+
+    // Default vertex shader, the variants only differ in their fragment stage
+    chain.blurShaders = LoadShaderVariants(cache, glslVersion, NULL, blurFileName, postBlurFeatures, 2);
+    chain.composeShaders = LoadShaderVariants(cache, glslVersion, NULL, composeFileName, postComposeFeatures, 7);
+
+    chain.fused = true;
+    chain.bloomScale = 4;
+    chain.bloomIterations = 2;
+    chain.bloomThreshold = 0.8f;
+    chain.bloomIntensity = 0.8f;
+    chain.blurScale = 2;
+    chain.blurIterations = 1;
+    chain.blurAmount = 0.5f;
+    chain.colorLevels = 8.0f;
+
+    if (postChainGenQueries == NULL)
+    {
+        postChainGenQueries = (GLGenQueriesProc)glfwGetProcAddress("glGenQueries");
+        postChainDeleteQueries = (GLDeleteQueriesProc)glfwGetProcAddress("glDeleteQueries");
+        postChainBeginQuery = (GLBeginQueryProc)glfwGetProcAddress("glBeginQuery");
+        postChainEndQuery = (GLEndQueryProc)glfwGetProcAddress("glEndQuery");
+        postChainGetQueryObjectiv = (GLGetQueryObjectivProc)glfwGetProcAddress("glGetQueryObjectiv");
+        postChainGetQueryObjectui64v = (GLGetQueryObjectui64vProc)glfwGetProcAddress("glGetQueryObjectui64v");
+    }
+
+    if ((postChainGenQueries != NULL) && (postChainGetQueryObjectui64v != NULL))
+    {
+        for (int i = 0; i < POST_CHAIN_PASSES; i++) postChainGenQueries(1, &chain.passes[i].query);
+    }
+    else TraceLog(LOG_WARNING, "POST: Timer queries not available, passes are not timed");
+
+    return chain;
+}
+
+// Unload targets, shader variants and queries
+void UnloadPostChain(PostChain *chain)
+{
+    UnloadPostChainPair(chain->bloomTargets);
+    UnloadPostChainPair(chain->blurTargets);
+    UnloadPostChainPair(chain->outputs);
+
+    for (int i = 0; i < chain->blurShaders.count; i++) ClearShaderValueCache(chain->blurShaders.shaders[i]);
+    for (int i = 0; i < chain->composeShaders.count; i++) ClearShaderValueCache(chain->composeShaders.shaders[i]);
+    UnloadShaderVariants(&chain->blurShaders);
+    UnloadShaderVariants(&chain->composeShaders);
+
+    for (int i = 0; i < POST_CHAIN_PASSES; i++)
+    {
+        if (chain->passes[i].query > 0) postChainDeleteQueries(1, &chain->passes[i].query);
+    }
+
+    *chain = (PostChain){ 0 };
+}
+
+// Run the enabled effects over a render texture image, returns the result
+// NOTE: The result is a render texture too (bottom up), it stays valid until the next apply
+Texture2D ApplyPostChain(PostChain *chain, Texture2D image)
+{
+    for (int i = 0; i < POST_CHAIN_PASSES; i++) chain->passes[i].ran = false;
+    chain->cpuTime = 0.0;
+
+    if (chain->effects == 0) return image;
+
+    double start = GetTime();
+
+    if ((chain->width != image.width) || (chain->height != image.height) ||
+        (chain->bloomTargets[0].texture.width != image.width/chain->bloomScale) ||
+        (chain->blurTargets[0].texture.width != image.width/chain->blurScale)) LoadPostChainTargets(chain, image.width, image.height);
+
+    // Downsampling averages bilinear taps
+    SetTextureFilter(image, TEXTURE_FILTER_BILINEAR);
+
+    Texture2D bloom = { 0 };
+    Texture2D blur = { 0 };
+
+    if (chain->effects & POST_EFFECT_BLOOM)
+    {
+        bloom = BlurPostImage(chain, &chain->passes[POST_PASS_BLOOM], image, chain->bloomTargets, chain->bloomIterations, true);
+    }
+
+    if (chain->effects & POST_EFFECT_BLUR)
+    {
+        blur = BlurPostImage(chain, &chain->passes[POST_PASS_BLUR], image, chain->blurTargets, chain->blurIterations, false);
+    }
+
+    // One full resolution pass for every effect, or one per effect for reference
+    PostPass *pass = &chain->passes[POST_PASS_COMPOSE];
+    bool timed = BeginPostPass(chain, pass);
+
+    Texture2D result = image;
+    unsigned int remaining = chain->effects;
+    int output = 0;
+
+    while (remaining != 0)
+    {
+        unsigned int effects = remaining;
+        if (!chain->fused)
+        {
+            // FXAA first as in the fused pass, it antialiases the scene edges, then lowest effect bit alone
+            effects = (remaining & POST_EFFECT_FXAA)? POST_EFFECT_FXAA : (remaining & (~remaining + 1));
+        }
+        remaining &= ~effects;
+
+        Shader shader = GetShaderVariant(&chain->composeShaders, effects);
+        SetPostComposeValues(chain, shader, effects, result);
+
+        // Samplers are bound with the batch, after anything that flushes it
+        BeginTextureMode(chain->outputs[output]);
+            BeginShaderMode(shader);
+                if (effects & POST_EFFECT_BLOOM) SetShaderValueTexture(shader, GetShaderLocation(shader, "bloomTexture"), bloom);
+                if (effects & POST_EFFECT_BLUR) SetShaderValueTexture(shader, GetShaderLocation(shader, "blurTexture"), blur);
+                DrawPostQuad(pass, chain->outputs[output], result);
+            EndShaderMode();
+        EndTextureMode();
+
+        result = chain->outputs[output].texture;
+        output = 1 - output;
+    }
+
+    EndPostPass(chain, pass, timed);
+
+    chain->cpuTime = GetTime() - start;
+
+    return result;
+}
+
+// Pixels written by the passes of the last apply
+int GetPostChainPixels(PostChain *chain)
+{
+    int pixels = 0;
+
+    for (int i = 0; i < POST_CHAIN_PASSES; i++)
+    {
+        if (chain->passes[i].ran) pixels += chain->passes[i].width*chain->passes[i].height*chain->passes[i].draws;
+    }
+
+    return pixels;
+}
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Definition
+//----------------------------------------------------------------------------------
+
+// (Re)load every target for the image size and the current scales
+static void LoadPostChainTargets(PostChain *chain, int width, int height)
+{
+    chain->width = width;
+    chain->height = height;
+
+    LoadPostChainPair(chain->bloomTargets, width, height, chain->bloomScale);
+    LoadPostChainPair(chain->blurTargets, width, height, chain->blurScale);
+    LoadPostChainPair(chain->outputs, width, height, 1);
+
+    TraceLog(LOG_INFO, "POST: Targets loaded for %ix%i, bloom 1/%i, blur 1/%i", width, height, chain->bloomScale, chain->blurScale);
+}
+
+// Two targets at a fraction of the image size, filtered so a smaller one upsamples smoothly
+static void LoadPostChainPair(RenderTexture2D *targets, int width, int height, int scale)
+{
+    UnloadPostChainPair(targets);
+
+    for (int i = 0; i < 2; i++)
+    {
+        targets[i] = LoadRenderTexture((width/scale > 0)? width/scale : 1, (height/scale > 0)? height/scale : 1);
+        SetTextureFilter(targets[i].texture, TEXTURE_FILTER_BILINEAR);
+        SetTextureWrap(targets[i].texture, TEXTURE_WRAP_CLAMP);
+    }
+}
+
+// Unload both targets of a pair
+static void UnloadPostChainPair(RenderTexture2D *targets)
+{
+    for (int i = 0; i < 2; i++)
+    {
+        if (targets[i].id > 0) UnloadRenderTexture(targets[i]);
+        targets[i] = (RenderTexture2D){ 0 };
+    }
+}
+
+// Start the timer query of a pass, unless its last result is still in flight
+static bool BeginPostPass(PostChain *chain, PostPass *pass)
+{
+    pass->ran = true;
+    pass->draws = 0;
+
+    if (pass->query == 0) return false;
+
+    if (pass->pending)
+    {
+        int available = 0;
+        postChainGetQueryObjectiv(pass->query, POST_CHAIN_GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) return false;
+
+        unsigned long long nanoseconds = 0;
+        postChainGetQueryObjectui64v(pass->query, POST_CHAIN_GL_QUERY_RESULT, &nanoseconds);
+        pass->time = nanoseconds/1.0e9;
+        pass->pending = false;
+    }
+
+    rlDrawRenderBatchActive();      // Draws submitted before the pass are not part of it
+    postChainBeginQuery(POST_CHAIN_GL_TIME_ELAPSED, pass->query);
+
+    return true;
+}
+
+// End the timer query of a pass, its result is read on a later run
+static void EndPostPass(PostChain *chain, PostPass *pass, bool timed)
+{
+    if (!timed) return;
+
+    postChainEndQuery(POST_CHAIN_GL_TIME_ELAPSED);
+    pass->pending = true;
+}
+
+// Draw an image over the whole target being drawn to, orientation kept (both bottom up)
+static void DrawPostQuad(PostPass *pass, RenderTexture2D target, Texture2D source)
+{
+    Rectangle sourceRec = { 0.0f, 0.0f, (float)source.width, -(float)source.height };
+    Rectangle destRec = { 0.0f, 0.0f, (float)target.texture.width, (float)target.texture.height };
+
+    // Every pixel is overwritten, no clear and no blending
+    rlDisableColorBlend();
+    DrawTexturePro(source, sourceRec, destRec, (Vector2){ 0.0f, 0.0f }, 0.0f, WHITE);
+    rlDrawRenderBatchActive();
+    rlEnableColorBlend();
+
+    pass->width = target.texture.width;
+    pass->height = target.texture.height;
+    pass->draws++;
+}
+
+// Downsample an image into a pair of targets and blur it there, returns the blurred image
+static Texture2D BlurPostImage(PostChain *chain, PostPass *pass, Texture2D image, RenderTexture2D *targets, int iterations, bool threshold)
+{
+    bool timed = BeginPostPass(chain, pass);
+
+    Shader downsample = GetShaderVariant(&chain->blurShaders, POST_BLUR_DOWNSAMPLE | (threshold? POST_BLUR_THRESHOLD : 0));
+    Shader blur = GetShaderVariant(&chain->blurShaders, 0);
+
+    float texelSize[2] = { 1.0f/image.width, 1.0f/image.height };
+    SetShaderValueCached(downsample, GetShaderLocation(downsample, "texelSize"), texelSize, SHADER_UNIFORM_VEC2);
+    if (threshold) SetShaderValueCached(downsample, GetShaderLocation(downsample, "threshold"), &chain->bloomThreshold, SHADER_UNIFORM_FLOAT);
+
+    BeginTextureMode(targets[0]);
+        BeginShaderMode(downsample);
+            DrawPostQuad(pass, targets[0], image);
+        EndShaderMode();
+    EndTextureMode();
+
+    // Back and forth between the two targets, the result ends in the first one
+    float pairTexelSize[2] = { 1.0f/targets[0].texture.width, 1.0f/targets[0].texture.height };
+    int texelSizeLoc = GetShaderLocation(blur, "texelSize");
+    int directionLoc = GetShaderLocation(blur, "blurDirection");
+    const float horizontal[2] = { 1.0f, 0.0f };
+    const float vertical[2] = { 0.0f, 1.0f };
+
+    SetShaderValueCached(blur, texelSizeLoc, pairTexelSize, SHADER_UNIFORM_VEC2);
+
+    for (int i = 0; i < iterations; i++)
+    {
+        SetShaderValue(blur, directionLoc, horizontal, SHADER_UNIFORM_VEC2);
+        BeginTextureMode(targets[1]);
+            BeginShaderMode(blur);
+                DrawPostQuad(pass, targets[1], targets[0].texture);
+            EndShaderMode();
+        EndTextureMode();
+
+        SetShaderValue(blur, directionLoc, vertical, SHADER_UNIFORM_VEC2);
+        BeginTextureMode(targets[0]);
+            BeginShaderMode(blur);
+                DrawPostQuad(pass, targets[0], targets[1].texture);
+            EndShaderMode();
+        EndTextureMode();
+    }
+
+    EndPostPass(chain, pass, timed);
+
+    return targets[0].texture;
+}
+
+// Uniforms of a compose variant, only the ones of its effects
+static void SetPostComposeValues(PostChain *chain, Shader shader, unsigned int effects, Texture2D image)
+{
+    float texelSize[2] = { 1.0f/image.width, 1.0f/image.height };
+    SetShaderValueCached(shader, GetShaderLocation(shader, "texelSize"), texelSize, SHADER_UNIFORM_VEC2);
+
+    if (effects & POST_EFFECT_BLUR) SetShaderValueCached(shader, GetShaderLocation(shader, "blurAmount"), &chain->blurAmount, SHADER_UNIFORM_FLOAT);
+    if (effects & POST_EFFECT_BLOOM) SetShaderValueCached(shader, GetShaderLocation(shader, "bloomIntensity"), &chain->bloomIntensity, SHADER_UNIFORM_FLOAT);
+    if (effects & POST_EFFECT_POSTERIZE) SetShaderValueCached(shader, GetShaderLocation(shader, "colorLevels"), &chain->colorLevels, SHADER_UNIFORM_FLOAT);
+}
+
+#endif // POST_CHAIN_IMPLEMENTATION
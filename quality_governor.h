@@ -0,0 +1,303 @@
+/**********************************************************************************************
+*
+*   quality_governor - Quality knobs stepped down a ladder until the frame time percentiles
+*   fit the frame budget, and back up when there is headroom
+*
+*   A frame rate target is missed by the slow frames, not the average one. The governor keeps
+*   the last GOVERNOR_WINDOW frame times and every evaluateFrames frames looks at percentiles:
+*
+*       - down: the p95 frame is over budget, the next rung of the ladder is applied
+*       - up: the p95 frame is under upFraction of the budget and the p99 one fits, the last
+*         rung applied is undone
+*       - hold: otherwise
+*
+*   The ladder is the tuning: a list of knobs (curve tolerance, LOD bias...), each rung lowers
+*   one of them by a level, cheapest visual loss first. A knob can appear on several rungs, its
+*   level is the number of rungs applied that name it. Frame times of the previous rung are
+*   dropped after a change, the next decision only sees frames drawn with the new knobs.
+*
+*   Every decision is logged with the percentiles it was taken on, the rung and the knob level
+*   it changed ("GOVERNOR:" lines).
+*
+*   Another controller reacting to the same frame times (a render scale) must not adjust at the
+*   same time, or each undoes the other. While it adjusts the governor is paused: frames are not
+*   added and the times restart, the next decision only sees frames after the pause.
+*
+*   CONFIGURATION:
+*
+*   #define QUALITY_GOVERNOR_IMPLEMENTATION
+*       Generates the implementation of the library into the included file.
+*       If not defined, the library is in header only mode and can be included in other headers
+*       or source files without problems. But only ONE file should hold the implementation.
+*
+**********************************************************************************************/
+
+#ifndef QUALITY_GOVERNOR_H
+#define QUALITY_GOVERNOR_H
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define GOVERNOR_WINDOW         120     // Frame times kept for the percentiles
+#define GOVERNOR_MAX_KNOBS      8
+#define GOVERNOR_MAX_RUNGS      32
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+
+// Governor decisions
+typedef enum {
+    GOVERNOR_HOLD = 0,
+    GOVERNOR_DOWN,
+    GOVERNOR_UP,
+} GovernorDecision;
+
+// Frame time percentiles and the ladder of quality knobs they move along
+typedef struct {
+    const char *knobNames[GOVERNOR_MAX_KNOBS];
+    int knobCount;
+    int ladder[GOVERNOR_MAX_RUNGS];     // Knob lowered by each rung, in order
+    int rungCount;
+    int rung;                           // Rungs applied, 0 is full quality
+    int knobLevels[GOVERNOR_MAX_KNOBS]; // Level of each knob at the current rung
+    float budget;                       // Seconds per frame
+    float upFraction;                   // Of the budget, p95 under it is headroom
+    int evaluateFrames;                 // Frames between decisions (and before the first one)
+    float times[GOVERNOR_WINDOW];       // Ring of frame times
+    int timeCount;
+    int timeNext;
+    int sinceDecision;                  // Frames added since the last evaluation
+    float p50;                          // Percentiles of the last evaluation (seconds)
+    float p95;
+    float p99;
+    int decision;                       // Last decision (GovernorDecision)
+    int changeCount;
+} QualityGovernor;
+
+#ifdef __cplusplus
+extern "C" {            // Prevents name mangling of functions
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+QualityGovernor LoadQualityGovernor(float budget, const char **knobNames, int knobCount, const int *ladder, int rungCount);  // Full quality, ladder of knob indices
+void SetGovernorBudget(QualityGovernor *governor, float budget);                         // New budget (seconds), frame times restart
+void ResetQualityGovernor(QualityGovernor *governor);                                    // Back to full quality, frame times restart
+void PauseQualityGovernor(QualityGovernor *governor);                                    // Knobs kept, frame times restart, call instead of an update
+bool UpdateQualityGovernor(QualityGovernor *governor, float frameTime);                  // Add a frame time, true when the rung changed
+int GetGovernorKnob(const QualityGovernor *governor, int knob);                          // Level of a knob, 0 is full quality
+const char *GetGovernorDecisionName(int decision);                                       // "hold", "down" or "up"
+
+void BenchmarkQualityGovernor(int frames);                                               // Log rungs and over budget frames on a simulated load
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // QUALITY_GOVERNOR_H
+
+
+/***********************************************************************************
+*
+*   QUALITY_GOVERNOR IMPLEMENTATION
+*
+************************************************************************************/
+
+#if defined(QUALITY_GOVERNOR_IMPLEMENTATION)
+
+#include "raylib.h"
+
+#include <stdlib.h>             // Required for: qsort()
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Declaration
+//----------------------------------------------------------------------------------
+static void EvaluateGovernorPercentiles(QualityGovernor *governor);
+static int CompareGovernorTimes(const void *a, const void *b);
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+
+// Full quality, ladder of knob indices
+// NOTE: Names are not copied, rungs naming a knob past knobCount are dropped
+QualityGovernor LoadQualityGovernor(float budget, const char **knobNames, int knobCount, const int *ladder, int rungCount)
+{
+    QualityGovernor governor = { 0 };
+
+    governor.knobCount = (knobCount < GOVERNOR_MAX_KNOBS)? knobCount : GOVERNOR_MAX_KNOBS;
+    for (int i = 0; i < governor.knobCount; i++) governor.knobNames[i] = knobNames[i];
+
+    for (int i = 0; (i < rungCount) && (governor.rungCount < GOVERNOR_MAX_RUNGS); i++)
+    {
+        if ((ladder[i] >= 0) && (ladder[i] < governor.knobCount)) governor.ladder[governor.rungCount++] = ladder[i];
+    }
+
+    governor.budget = budget;
+    governor.upFraction = 0.7f;
+    governor.evaluateFrames = 30;
+
+    return governor;
+}
+
+// New budget (seconds), frame times restart
+void SetGovernorBudget(QualityGovernor *governor, float budget)
+{
+    if (budget == governor->budget) return;
+
+    governor->budget = budget;
+    governor->timeCount = 0;
+    governor->sinceDecision = 0;
+}
+
+// Back to full quality, frame times restart
+void ResetQualityGovernor(QualityGovernor *governor)
+{
+    governor->rung = 0;
+    for (int i = 0; i < GOVERNOR_MAX_KNOBS; i++) governor->knobLevels[i] = 0;
+    governor->timeCount = 0;
+    governor->sinceDecision = 0;
+    governor->decision = GOVERNOR_HOLD;
+}
+
+// Knobs kept, frame times restart, call instead of an update
+void PauseQualityGovernor(QualityGovernor *governor)
+{
+    governor->timeCount = 0;
+    governor->sinceDecision = 0;
+    governor->decision = GOVERNOR_HOLD;
+}
+
+// Add a frame time, true when the rung changed
+bool UpdateQualityGovernor(QualityGovernor *governor, float frameTime)
+{
+    governor->times[governor->timeNext] = frameTime;
+    governor->timeNext = (governor->timeNext + 1)%GOVERNOR_WINDOW;
+    if (governor->timeCount < GOVERNOR_WINDOW) governor->timeCount++;
+    governor->sinceDecision++;
+
+    if ((governor->sinceDecision < governor->evaluateFrames) || (governor->timeCount < governor->evaluateFrames)) return false;
+
+    governor->sinceDecision = 0;
+    EvaluateGovernorPercentiles(governor);
+
+    int knob = -1;
+
+    if ((governor->p95 > governor->budget) && (governor->rung < governor->rungCount))
+    {
+        knob = governor->ladder[governor->rung];
+        governor->knobLevels[knob]++;
+        governor->rung++;
+        governor->decision = GOVERNOR_DOWN;
+    }
+    else if ((governor->p95 < governor->budget*governor->upFraction) && (governor->p99 <= governor->budget) && (governor->rung > 0))
+    {
+        governor->rung--;
+        knob = governor->ladder[governor->rung];
+        governor->knobLevels[knob]--;
+        governor->decision = GOVERNOR_UP;
+    }
+    else
+    {
+        governor->decision = GOVERNOR_HOLD;
+        return false;
+    }
+
+    TraceLog(LOG_INFO, "GOVERNOR: p50 %.2f p95 %.2f p99 %.2f ms, budget %.2f ms: %s to rung %i/%i, %s level %i",
+             governor->p50*1000.0f, governor->p95*1000.0f, governor->p99*1000.0f, governor->budget*1000.0f,
+             GetGovernorDecisionName(governor->decision), governor->rung, governor->rungCount,
+             governor->knobNames[knob], governor->knobLevels[knob]);
+
+    // The next decision only sees frames drawn at the new rung
+    governor->timeCount = 0;
+    governor->changeCount++;
+
+    return true;
+}
+
+// Level of a knob, 0 is full quality
+int GetGovernorKnob(const QualityGovernor *governor, int knob)
+{
+    return ((knob >= 0) && (knob < governor->knobCount))? governor->knobLevels[knob] : 0;
+}
+
+// "hold", "down" or "up"
+const char *GetGovernorDecisionName(int decision)
+{
+    if (decision == GOVERNOR_DOWN) return "down";
+    else if (decision == GOVERNOR_UP) return "up";
+    else return "hold";
+}
+
+// Log rungs and over budget frames on a simulated load
+// NOTE: Frame time is 4 ms of fixed cost plus 3 knobs each saving a third of its share per level,
+// with one frame in 33 a 30% spike; the load triples for the middle third of the frames
+void BenchmarkQualityGovernor(int frames)
+{
+    const char *names[3] = { "a", "b", "c" };
+    const int ladder[6] = { 0, 1, 2, 0, 1, 2 };
+    const float budget = 1.0f/60.0f;
+    QualityGovernor governor = LoadQualityGovernor(budget, names, 3, ladder, 6);
+    int overBudget[3] = { 0 };
+    int rungs[3] = { 0 };
+    double evaluateTime = 0.0;
+    int evaluations = 0;
+
+    for (int f = 0; f < frames; f++)
+    {
+        int third = (3*f)/frames;
+        float load = (third == 1)? 3.0f : 1.0f;
+        float work = 0.0f;
+        for (int k = 0; k < 3; k++) work += 0.003f*load*(1.0f - GetGovernorKnob(&governor, k)/3.0f);
+        float frameTime = (0.004f + work)*((f%33 == 0)? 1.3f : 1.0f);
+
+        if (frameTime > budget) overBudget[third]++;
+
+        double start = GetTime();
+        bool evaluated = (governor.sinceDecision + 1 >= governor.evaluateFrames);
+        UpdateQualityGovernor(&governor, frameTime);
+        if (evaluated)
+        {
+            evaluateTime += GetTime() - start;
+            evaluations++;
+        }
+
+        rungs[third] = governor.rung;
+    }
+
+    TraceLog(LOG_INFO, "GOVERNOR: %i frames: rung %i, %i, %i at the end of each third (load x1, x3, x1), %i, %i, %i frames over budget, %i changes, %.4f ms per evaluation",
+             frames, rungs[0], rungs[1], rungs[2], overBudget[0], overBudget[1], overBudget[2], governor.changeCount,
+             (evaluations > 0)? evaluateTime*1000.0/evaluations : 0.0);
+}
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Definition
+//----------------------------------------------------------------------------------
+
+// p50, p95 and p99 of the frame times in the window (nearest rank)
+static void EvaluateGovernorPercentiles(QualityGovernor *governor)
+{
+    float sorted[GOVERNOR_WINDOW];
+    int count = governor->timeCount;
+
+    // The ring holds the last timeCount entries before timeNext
+    for (int i = 0; i < count; i++) sorted[i] = governor->times[(governor->timeNext - count + i + GOVERNOR_WINDOW)%GOVERNOR_WINDOW];
+    qsort(sorted, count, sizeof(float), CompareGovernorTimes);
+
+    governor->p50 = sorted[(count*50)/100];
+    governor->p95 = sorted[(count*95)/100];
+    governor->p99 = sorted[(count*99)/100];
+}
+
+// Ascending order for qsort()
+static int CompareGovernorTimes(const void *a, const void *b)
+{
+    float x = *(const float *)a;
+    float y = *(const float *)b;
+
+    return (x > y) - (x < y);
+}
+
+#endif // QUALITY_GOVERNOR_IMPLEMENTATION
@@ -42,6 +42,66 @@
 
 #include "load_stl.h"
 
+#define SCENE_BVH_IMPLEMENTATION
+#include "scene_bvh.h"
+
+#define OCCLUSION_CULL_IMPLEMENTATION
+#include "occlusion_cull.h"
+
+#define RENDER_QUEUE_IMPLEMENTATION
+#include "render_queue.h"
+
+#define LINE_BATCH_IMPLEMENTATION
+#include "line_batch.h"
+
+#define CURVE_EVAL_IMPLEMENTATION
+#include "curve_eval.h"
+
+#define CURVE_INSTANCING_IMPLEMENTATION
+#include "curve_instancing.h"
+
+#define SPLINE_CACHE_IMPLEMENTATION
+#include "spline_cache.h"
+
+#define ARC_LENGTH_IMPLEMENTATION
+#include "arc_length.h"
+
+#define LAYER_COMPOSITOR_IMPLEMENTATION
+#include "layer_compositor.h"
+
+#define OVERDRAW_ANALYSIS_IMPLEMENTATION
+#include "overdraw_analysis.h"
+
+#define UNIFORM_CACHE_IMPLEMENTATION
+#include "uniform_cache.h"
+
+#define SHADER_CACHE_IMPLEMENTATION
+#include "shader_cache.h"
+
+#define SHADER_VARIANTS_IMPLEMENTATION
+#include "shader_variants.h"
+
+#define DEFERRED_RENDERER_IMPLEMENTATION
+#include "deferred_renderer.h"
+
+#define LIGHT_CLUSTERS_IMPLEMENTATION
+#include "light_clusters.h"
+
+#define LIGHT_BUFFER_IMPLEMENTATION
+#include "light_buffer.h"
+
+#define POST_CHAIN_IMPLEMENTATION
+#include "post_chain.h"
+
+#define DYNAMIC_RESOLUTION_IMPLEMENTATION
+#include "dynamic_resolution.h"
+
+#define GPU_TIMER_IMPLEMENTATION
+#include "gpu_timer.h"
+
+#define QUALITY_GOVERNOR_IMPLEMENTATION
+#include "quality_governor.h"
+
 // raygui embedded styles
 // #include "styles/style_cyber.h"       // raygui style: cyber
 // #include "styles/style_jungle.h"      // raygui style: jungle
@@ -86,6 +146,7 @@ static Vector3 MeasureText3D(Font font, const char *text, float fontSize, float
 
 void DrawSplineBasis3D(Vector3 *points, int pointCount, Color color);
 void DrawSplineSegmentBezierCubic3D(Vector3 p1, Vector3 c2, Vector3 c3, Vector3 p4, int segments, Color color, bool d );
+int GetSplineSegments3D(Vector3 p1, Vector3 c2, Vector3 c3, Vector3 p4);
 
 int CubeInstanceCount;
 Matrix *CubeInstances = 0;
@@ -98,14 +159,58 @@ Model GameTorus;
 Model GameCylinder;
 Model GameCone;
 
+// Coarser spheres picked by screen size, levels 1 to 3 (level 0 is GameSphere)
+#define SPHERE_LODS 4
+const int SphereLodRings[SPHERE_LODS] = { 32, 16, 10, 6 };
+Model GameSphereLods[SPHERE_LODS - 1];
+int SphereLodBias = 0;              // Levels added to the one picked by screen size
+int SphereTessellation = 0;         // Finest level allowed
+
+// Program binaries of the shaders loaded at startup, compiled once per driver
+ShaderCache SceneShaderCache = { 0 };
+
+// Lighting shader features (resources/shaders/variants), a bit of the variant mask each
+typedef enum {
+    LIGHTING_LIGHT_0 = 1,           // Bits 0 to 3, one per enabled rlights.h light
+    LIGHTING_INSTANCING = 16,
+    LIGHTING_CLUSTERED = 32,
+} LightingFeature;
+
+const char *LightingFeatures[] = { "LIGHT_0", "LIGHT_1", "LIGHT_2", "LIGHT_3", "INSTANCING", "CLUSTERED" };
+const int LightingFeatureCount = sizeof( LightingFeatures )/sizeof( LightingFeatures[0] );
+
+// GameShader and InstancingShader are the variants of the current mask
+ShaderVariants LightingVariants = { 0 };
+unsigned int LightingMask = 0;
+
 Shader GameShader;
-int    ShaderAmbientLoc;
 
 Shader FontShader;
 
 Material MatInstances;
 Shader InstancingShader;
-int InstancingAmbientLoc;
+
+// Depth only versions of the lighting shaders, for the depth pre-pass
+ShaderVariants DepthVariants = { 0 };
+Shader DepthShader;
+Shader DepthInstancingShader;
+Material MatDepthInstances;
+
+// Point lights drifting over the layout, lit by the deferred path or by clustered forward lighting
+#define SCENE_POINT_LIGHTS 256
+ClusterLight ScenePointLights[SCENE_POINT_LIGHTS] = { 0 };
+int ScenePointLightCount = SCENE_POINT_LIGHTS;     // Lit, the first ones of the array
+LightClusters SceneClusters = { 0 };
+bool ClusteredLighting = false;
+
+// Deferred path: models fill a G-buffer, the lights are then added in screen space
+Shader GBufferShader;
+Shader GBufferInstancingShader;
+Material MatGBufferInstances;
+Shader DeferredShadingShader;
+Shader DeferredLightShader;
+DeferredRenderer Deferred = { 0 };
+bool DeferredShading = false;
 
 Model GameModel;
 BoundingBox GameModelBounds;
@@ -116,8 +221,9 @@ Mesh GameStlMesh;
 
 Model GameStl;
 
+// The four lights and the ambient level, one uniform buffer read by every lit shader
+LightBuffer SceneLights = { 0 };
 Light Lights[4] = { 0 };
-Light InstancingLights[4] = { 0 };
 
 bool ElementErase = true;
 bool ElementLines = true;
@@ -125,6 +231,7 @@ bool ElementObjects = true;
 bool ElementModels = true;
 bool ElementUi = true;
 bool ElementText = true;
+bool ElementStats = false;
 
 Font FontDefault = { 0 };
 Font FontSDF = { 0 };
@@ -155,6 +262,213 @@ int FrameRateIndexSet = 2;
 int FrameRate = 60;
 bool AmbientLight = true;
 
+// Scene objects, one per drawn model instance, indexed by SceneIndex for culling and picking
+#define SCENE_LAYOUT_CUBES      0       // 36 cubes moving between LayoutA and LayoutB
+#define SCENE_ORBIT_SPHERE      36      // Sphere orbiting the origin
+#define SCENE_TETHER_SPHERES    37      // 40 spline start points
+#define SCENE_TETHER_CUBES      77      // 40 markers below the spline start points
+#define SCENE_ROBOT             117
+#define SCENE_ESP32             118
+#define SCENE_STL               119
+#define SCENE_OBJECT_COUNT      120
+
+typedef struct SceneObject {
+    Model *model;
+    Vector3 position;
+    float scale;
+    Color tint;
+    BoundingBox bounds;         // Model space bounds
+    Model *lods;                // Coarser versions of model, NULL for none
+    int lodCount;
+    int lod;                    // Level drawn this frame, 0 is model
+    int proxy;                  // Leaf in SceneIndex
+    bool visible;               // Passed frustum culling this frame
+    bool selected;
+} SceneObject;
+
+SceneObject SceneObjects[SCENE_OBJECT_COUNT] = { 0 };
+SceneBvh SceneIndex = { 0 };
+int SceneQueryResults[SCENE_OBJECT_COUNT];
+int SceneVisibleCount = 0;
+
+bool Selecting = false;
+Vector2 SelectionStart = { 0 };
+
+// Occlusion culling, the largest solid objects on screen hide what is behind them
+#define OCCLUDER_MAX            8
+
+OcclusionBuffer SceneOcclusion = { 0 };
+bool OcclusionCulling = true;
+int SceneOccludedCount = 0;
+
+// 3d draws of a frame, executed sorted by state and depth
+RenderQueue SceneQueue = { 0 };
+
+// Splines, grid and selection boxes, drawn with one call
+LineBatch SceneLines = { 0 };
+
+// Tether beziers, evaluated together from the Bernstein tables
+#define TETHER_CURVE_COUNT 40
+CurveSet TetherCurves = { 0 };
+Vector3 TetherCurvePoints[CURVE_MAX_SEGMENTS + 1];
+
+// Same beziers evaluated in the vertex shader, one instance per curve
+Shader CurveShader;
+InstancedCurves TetherInstances = { 0 };
+bool GpuCurves = true;
+int TetherCurveMode = CURVE_MODE_RIBBONS;
+const char *CurveModeNames[3] = { "lines", "ribbons", "tubes" };
+
+// Spline segment counts from a pixel tolerance instead of a fixed 24
+#define SPLINE_FIXED_SEGMENTS 24
+bool AdaptiveCurves = true;
+float CurveTolerance = 0.5f;        // Pixels between a curve and its polyline
+Matrix SceneViewProj = { 0 };       // GameCamera on the screen, for the segment counts
+int SplineSegmentsDrawn = 0;        // This frame
+int SplineSegmentsFixed = 0;        // Same curves at SPLINE_FIXED_SEGMENTS
+
+// Catmull-Rom path through the layout cubes, only moving spans are evaluated again
+#define LAYOUT_PATH_POINTS 38           // 36 cubes, first and last repeated so the path reaches them
+SplineCache LayoutPath = { 0 };
+
+// Markers flowing along the path at constant speed, drawn instanced
+#define FLOW_MARKER_COUNT 240
+ArcLengthTable LayoutPathLength = { 0 };
+float FlowOffsets[FLOW_MARKER_COUNT];
+float FlowSpeeds[FLOW_MARKER_COUNT];
+Matrix FlowMarkers[FLOW_MARKER_COUNT];
+int FlowMarkerCount = FLOW_MARKER_COUNT;    // Drawn, spread evenly over the path
+int FlowMarkersSpread = 0;                  // Count the offsets were spread for
+
+// Everything the 3d scene depends on, compared between frames to detect a static scene
+typedef struct SceneReplayKey {
+    Camera camera;
+    float cycle;
+    float layoutFraction;
+    int screenWidth;
+    int screenHeight;
+    int selectionVersion;
+    bool models;
+    bool lines;
+    bool text;
+    bool occlusion;
+    bool sorted;
+    bool prepass;
+    bool deferred;
+    bool clustered;
+    bool gpuCurves;
+    bool adaptiveCurves;
+    int curveMode;
+    bool lights[4];
+    bool ambient;
+    bool erase;
+    int quality;                // Governor rung, its knobs change the draws
+    float resolutionScale;      // Scene layer scale, the cluster grid and G-buffer follow its size
+} SceneReplayKey;
+
+// Redraws of an unchanged scene replay the recorded queue instead of rebuilding it
+// NOTE: With the frame cache on (F) a static scene is not redrawn at all, the cached layer image owns
+// static frames. Replay then only serves redraws with an unchanged key (MSAA samples, invalidation),
+// recorded on the first one and replayed from the second; with the cache off it serves every static frame
+RenderRecording SceneRecording = { 0 };
+SceneReplayKey SceneRecordingKey = { 0 };
+SceneReplayKey ScenePreviousKey = { 0 };
+bool SceneReplay = true;
+bool SceneReplaying = false;
+bool SceneRecorded = false;         // Last scene draw recorded the queue
+int SelectionVersion = 0;
+double SceneCpuTime = 0.0;
+
+// Scene, text and UI each keep their last image and are redrawn only when their inputs change
+typedef struct TextLayerKey {
+    int screenWidth;
+    int screenHeight;
+    bool text;
+    bool selecting;
+    Vector2 selectionStart;
+    Vector2 mouse;
+} TextLayerKey;
+
+typedef struct UiLayerKey {
+    int screenWidth;
+    int screenHeight;
+    Vector2 mouse;
+    bool mouseDown;
+    int layout;
+    int dynamic;
+    int frameRateIndex;
+    int antialias;
+    bool lights[4];
+    bool ambient;
+    bool lines;
+    bool models;
+    bool text;
+    bool ui;
+    bool erase;
+} UiLayerKey;
+
+LayerCompositor Layers = { 0 };
+int LayerScene = 0;
+int LayerText = 0;
+int LayerUi = 0;
+bool FrameCache = true;             // Off redraws the scene layer every frame
+
+// Fragments per pixel of each layer, counted again every frame while the heatmap is shown
+#define OVERDRAW_LAYERS 4
+
+OverdrawAnalysis Overdraw = { 0 };
+OverdrawStats OverdrawLayers[OVERDRAW_LAYERS] = { 0 };
+const char *OverdrawLayerNames[OVERDRAW_LAYERS] = { "scene", "text", "ui", "stats" };
+bool OverdrawMode = false;
+bool OverdrawCounting = false;      // Layers are being drawn for counting
+int OverdrawFrames = 0;
+
+// Post effects over the scene layer, run when the scene image or the settings change
+typedef struct PostLayerKey {
+    unsigned int effects;
+    bool fused;
+    int bloomScale;
+    int blurScale;
+} PostLayerKey;
+
+PostChain ScenePost = { 0 };
+const char *PostEffectLetters = "EBLGPV";    // Edges, blur, bloom, grayscale, posterize, vignette
+
+// Scene antialiasing: MSAA in the compositor's scene framebuffer, or FXAA in the post chain
+typedef enum {
+    ANTIALIAS_NONE = 0,
+    ANTIALIAS_MSAA_2X,
+    ANTIALIAS_MSAA_4X,
+    ANTIALIAS_FXAA,
+} AntialiasMode;
+
+const char *AntialiasNames[] = { "None", "MSAA 2x", "MSAA 4x", "FXAA" };
+const char *AntialiasOptions[] = { "none", "msaa2", "msaa4", "fxaa" };       // --aa values
+int Antialias = ANTIALIAS_MSAA_4X;
+
+// Dynamic resolution: the scene layer scale follows the frame time against the FPS combo budget
+bool DynamicResolution = false;
+ResolutionController SceneResolution;
+Shader UpscaleShader;
+double FrameWorkTime = 0.0;         // CPU time of the last frame, without the wait for the target FPS
+GpuTimer FrameGpuTimer;             // GPU time of frames that redrew the scene, read back late
+int FrameGpuResults = 0;            // Results of FrameGpuTimer already used
+
+// Quality governor: knobs stepped down a ladder while the p95 frame misses the FPS combo budget
+typedef enum {
+    QUALITY_CURVES = 0,         // Curve tolerance, doubled per level
+    QUALITY_LOD_BIAS,           // Sphere LOD levels added
+    QUALITY_TESSELLATION,       // Finest sphere LOD allowed
+    QUALITY_INSTANCES,          // Flow markers, halved per level
+    QUALITY_LIGHTS,             // Point lights, halved per level
+} QualityKnob;
+
+const char *QualityKnobNames[] = { "curves", "lod bias", "tessellation", "instances", "lights" };
+const int QualityLadder[] = { QUALITY_CURVES, QUALITY_LOD_BIAS, QUALITY_INSTANCES, QUALITY_LIGHTS, QUALITY_CURVES, QUALITY_LOD_BIAS,
+                              QUALITY_TESSELLATION, QUALITY_LIGHTS, QUALITY_INSTANCES, QUALITY_CURVES, QUALITY_TESSELLATION, QUALITY_LIGHTS };
+bool Governor = false;
+QualityGovernor SceneGovernor;
+
 //----------------------------------------------------------------------------------
 const int ScreenWidth = 640;
 const int ScreenHeight = 480;
@@ -165,15 +479,86 @@ void UnloadGameplayScreen();
 void DrawGameplayScreen();
 void UpdateGameplayScreen();
 
+void InitSceneObject(int index, Model *model, float scale, Color tint);
+void UpdateSceneObjects();
+void CullSceneObjects();
+void RasterizeSceneOccluders();
+void DrawSceneObject(int index);
+void DrawSceneObjectDepth(int index);
+void DrawModelShader(Model model, Shader shader, Vector3 position, float scale, Color tint);
+void SetupLightingVariant(Shader *shader, unsigned int mask);
+void SelectLightingVariants();
+void QueueSceneDraws();
+void UpdateScenePointLights();
+void DrawDeferredGeometry();
+SceneReplayKey GetSceneReplayKey();
+void DrawSceneLayer();
+void DrawTextLayer();
+void DrawUiLayer();
+void AnalyzeOverdraw();
+void DrawOverdrawOverlay();
+Texture2D ApplyScenePost(Texture2D image);
+void SetAntialiasMode(int mode);
+void ApplyQualityKnobs();
+bool IsResolutionAdjusting();
+void SelectSceneLods();
+Model *GetSceneObjectModel(SceneObject *object);
+void DrawSceneLines(int data);
+void DrawTetherCurves(int data);
+void DrawFlowMarkers(int data);
+void DrawFlowMarkersDepth(int data);
+void DrawSphereLabel(int data);
+void DrawSphereBillboard(int data);
+void SelectSceneObjects(Vector2 start, Vector2 end);
+void DrawStatsOverlay();
+void RunBenchmarks();
+void BenchmarkSplineDrawing(Shader curveShader, int curves, int segments, int frames);
+void BenchmarkCurveModes(Shader curveShader, int curves, int frames);
+void BenchmarkDepthPrepass(int cubes, int frames);
+void BenchmarkDeferredShading(int cubes, int frames);
+void BenchmarkUniformCache(int shaders, int frames);
+void BenchmarkShaderCache(int loads);
+void BenchmarkLightingVariants(int cubes, int frames);
+void BenchmarkPostChain(int width, int height, int frames);
+void BenchmarkAntialiasing(int cubes, int frames);
+
 //----------------------------------------------------------------------------------
 // Main entry point
 //----------------------------------------------------------------------------------
-int main(void)
+int main(int argc, char *argv[])
 {
     // Initialization
     //---------------------------------------------------------
-    SetConfigFlags(FLAG_MSAA_4X_HINT);
+    bool benchmark = false;
+    for ( int i = 1; i < argc; i++ ) {
+        if ( TextIsEqual( argv[i], "--bench" ) )
+            benchmark = true;
+        if ( TextIsEqual( argv[i], "--overdraw" ) )
+            OverdrawMode = true;
+        if ( TextIsEqual( argv[i], "--aa" ) && ( i + 1 < argc ) ) {
+            i++;
+            bool known = false;
+            for ( int mode = 0; mode < 4; mode++ ) {
+                if ( TextIsEqual( argv[i], AntialiasOptions[mode] ) ) {
+                    Antialias = mode;
+                    known = true;
+                }
+            }
+            if ( !known )
+                TraceLog( LOG_WARNING, "--aa %s: unknown mode, expected none|msaa2|msaa4|fxaa, using %s", argv[i], AntialiasNames[Antialias] );
+        }
+    }
 
+    if ( benchmark ) {
+        // Benchmarks need a GL context and the timer, not a visible window
+        SetConfigFlags(FLAG_WINDOW_HIDDEN);
+        InitWindow(ScreenWidth, ScreenHeight, "raylib game template");
+        RunBenchmarks();
+        CloseWindow();
+        return 0;
+    }
+
+    // No MSAA window framebuffer, the scene layer is multisampled offscreen (--aa and X pick the mode)
     InitWindow(ScreenWidth, ScreenHeight, "raylib game template");
 
     SetWindowState(FLAG_WINDOW_RESIZABLE);
@@ -227,10 +612,14 @@ int main(void)
 // Gameplay Screen Initialization logic
 void InitGameplayScreen(void)
 {
+    double initStart = GetTime();
+
     // TODO: Initialize GAMEPLAY screen variables here!
     framesCounter = 0;
     finishScreen = 0;
 
+    SceneShaderCache = LoadShaderCache( "shader_cache" );
+
     // Define the GameCamera to look into our 3d world
     GameCamera.position = (Vector3){ 0.0f, 20.0f, 60.0f };
     GameCamera.target = (Vector3){ 0.0f, 0.0f, 0.0f };
@@ -247,51 +636,21 @@ void InitGameplayScreen(void)
     GameCubeMesh = GenMeshCube( 2.0f, 2.0f, 2.0f );
     GameCube = LoadModelFromMesh(GenMeshCube( 2.0f, 2.0f, 2.0f ));
     GameSphere = LoadModelFromMesh( GenMeshSphere( 2.0, 32, 32 ));
+    for ( int i = 1; i < SPHERE_LODS; i++ )
+        GameSphereLods[i - 1] = LoadModelFromMesh( GenMeshSphere( 2.0, SphereLodRings[i], SphereLodRings[i] ));
     GameTorus = LoadModelFromMesh( GenMeshTorus( 0.5, 2.0, 32, 32 ));
     GameCone = LoadModelFromMesh( GenMeshCone( 0.5f, 2.0f, 32 ) );
     GameCylinder = LoadModelFromMesh( GenMeshCylinder( 1.0f, 2.0f, 32 ) );
 
-    GameShader = LoadShader(TextFormat("resources/shaders/glsl%i/lighting.vs", GLSL_VERSION),
-                            TextFormat("resources/shaders/glsl%i/lighting.fs", GLSL_VERSION));
-    
-    // Get some required shader locations
-    GameShader.locs[SHADER_LOC_VECTOR_VIEW] = GetShaderLocation(GameShader, "viewPos");
-    // NOTE: "matModel" location name is automatically assigned on shader loading, 
-    // no need to get the location again if using that uniform name
-    // GameShader.locs[SHADER_LOC_MATRIX_MODEL] = GetShaderLocation(GameShader, "matModel");
+    // Lighting shaders, variants are generated for the GLSL version as light masks come up
+    LightingVariants = LoadShaderVariants(&SceneShaderCache, GLSL_VERSION, "resources/shaders/variants/lighting.vs",
+                                          "resources/shaders/variants/lighting.fs", LightingFeatures, LightingFeatureCount);
+    LightingVariants.setup = SetupLightingVariant;
 
-    // Ambient light level (some basic lighting)
-    ShaderAmbientLoc = GetShaderLocation(GameShader, "ambient");
-    float ambient[4] = { 2.0f, 2.0f, 2.0f, 1.0f };
-    SetShaderValue(GameShader, ShaderAmbientLoc, ambient, SHADER_UNIFORM_VEC4);
-
-    // Load lighting shader
-    InstancingShader = LoadShader(TextFormat("resources/shaders/glsl%i/lighting_instancing.vs", GLSL_VERSION),
-                                  TextFormat("resources/shaders/glsl%i/lighting.fs", GLSL_VERSION));
-    // Get shader locations
-    InstancingShader.locs[SHADER_LOC_MATRIX_MVP] = GetShaderLocation(InstancingShader, "mvp");
-    InstancingShader.locs[SHADER_LOC_VECTOR_VIEW] = GetShaderLocation(InstancingShader, "viewPos");
-    InstancingShader.locs[SHADER_LOC_MATRIX_MODEL] = GetShaderLocationAttrib(InstancingShader, "instanceTransform");
-
-    // Set shader value: ambient light level
-    InstancingAmbientLoc = GetShaderLocation(InstancingShader, "ambient");
-    float instancingAmbient[4] = { 2.0f, 2.0f, 2.0f, 2.0f };
-    SetShaderValue(InstancingShader, InstancingAmbientLoc, instancingAmbient, SHADER_UNIFORM_VEC4);
-
-    // Create one light
-    // CreateLight(LIGHT_DIRECTIONAL, (Vector3){ 50.0f, 50.0f, 0.0f }, Vector3Zero(), WHITE, InstancingShader);
-
-    // Create Lights
-    ClearLightIndex();
-    InstancingLights[0] = CreateLight(LIGHT_POINT, (Vector3){ 0, 8, 20 }, Vector3Zero(), WHITE,    InstancingShader);
-    InstancingLights[1] = CreateLight(LIGHT_POINT, (Vector3){ 32, 32, 32 }, Vector3Zero(), RED,    InstancingShader);
-    InstancingLights[2] = CreateLight(LIGHT_POINT, (Vector3){ -32, 32, 32 }, Vector3Zero(), GREEN, InstancingShader);
-    InstancingLights[3] = CreateLight(LIGHT_POINT, (Vector3){ 32, 32, -32 }, Vector3Zero(), BLUE,  InstancingShader);
-
-    InstancingLights[0].enabled = true;
-    InstancingLights[1].enabled = false;
-    InstancingLights[2].enabled = false;
-    InstancingLights[3].enabled = false;
+    // Light 0 is the only one on at start
+    LightingMask = LIGHTING_LIGHT_0;
+    GameShader = GetShaderVariant(&LightingVariants, LightingMask);
+    InstancingShader = GetShaderVariant(&LightingVariants, LightingMask | LIGHTING_INSTANCING);
 
     CubeInstanceCount = pow(2,8);
     CubeInstances = (Matrix *)RL_CALLOC(CubeInstanceCount, sizeof(Matrix));  
@@ -300,12 +659,45 @@ void InitGameplayScreen(void)
     MatInstances.shader = InstancingShader;
     MatInstances.maps[MATERIAL_MAP_DIFFUSE].color = WHITE;
 
-    // Create Lights
-    ClearLightIndex();
-    Lights[0] = CreateLight(LIGHT_POINT, (Vector3){ 0, 8, 20 }, Vector3Zero(), WHITE, GameShader);
-    Lights[1] = CreateLight(LIGHT_POINT, (Vector3){ 32, 32, 32 }, Vector3Zero(), RED, GameShader);
-    Lights[2] = CreateLight(LIGHT_POINT, (Vector3){ -32, 32, 32 }, Vector3Zero(), GREEN, GameShader);
-    Lights[3] = CreateLight(LIGHT_POINT, (Vector3){ 32, 32, -32 }, Vector3Zero(), BLUE, GameShader);
+    // Same vertex shaders as the lighting ones, so pre-pass depth matches the shaded depth exactly
+    DepthVariants = LoadShaderVariants(&SceneShaderCache, GLSL_VERSION, "resources/shaders/variants/lighting.vs",
+                                       "resources/shaders/variants/depth_prepass.fs", LightingFeatures, LightingFeatureCount);
+    DepthVariants.setup = SetupLightingVariant;
+    DepthShader = GetShaderVariant(&DepthVariants, 0);
+    DepthInstancingShader = GetShaderVariant(&DepthVariants, LIGHTING_INSTANCING);
+    MatDepthInstances = LoadMaterialDefault();
+    MatDepthInstances.shader = DepthInstancingShader;
+
+    // G-buffer shaders take the same material inputs as the lighting ones
+    GBufferShader = LoadShaderCached(&SceneShaderCache, TextFormat("resources/shaders/glsl%i/gbuffer.vs", GLSL_VERSION),
+                                                        TextFormat("resources/shaders/glsl%i/gbuffer.fs", GLSL_VERSION));
+    GBufferInstancingShader = LoadShaderCached(&SceneShaderCache, TextFormat("resources/shaders/glsl%i/gbuffer_instancing.vs", GLSL_VERSION),
+                                                                  TextFormat("resources/shaders/glsl%i/gbuffer.fs", GLSL_VERSION));
+    GBufferInstancingShader.locs[SHADER_LOC_MATRIX_MVP] = GetShaderLocation(GBufferInstancingShader, "mvp");
+    GBufferInstancingShader.locs[SHADER_LOC_MATRIX_MODEL] = GetShaderLocationAttrib(GBufferInstancingShader, "instanceTransform");
+    MatGBufferInstances = LoadMaterialDefault();
+    MatGBufferInstances.shader = GBufferInstancingShader;
+
+    DeferredShadingShader = LoadShaderCached(&SceneShaderCache, TextFormat("resources/shaders/glsl%i/deferred_shading.vs", GLSL_VERSION),
+                                                                TextFormat("resources/shaders/glsl%i/deferred_shading.fs", GLSL_VERSION));
+    DeferredLightShader = LoadShaderCached(&SceneShaderCache, TextFormat("resources/shaders/glsl%i/deferred_light.vs", GLSL_VERSION),
+                                                              TextFormat("resources/shaders/glsl%i/deferred_light.fs", GLSL_VERSION));
+    Deferred = LoadDeferredRenderer(DeferredShadingShader, DeferredLightShader, SCENE_POINT_LIGHTS);
+    for (int i = 0; i < SCENE_POINT_LIGHTS; i++) {
+        ScenePointLights[i].radius = 6.0f;
+        ScenePointLights[i].color = ColorFromHSV(360.0f*i/SCENE_POINT_LIGHTS, 0.7f, 1.0f);
+        AddDeferredLight(&Deferred, Vector3Zero(), ScenePointLights[i].radius, ScenePointLights[i].color);
+    }
+
+    // Same lights for the forward shaders, binned into view clusters from 1 to 200 units
+    SceneClusters = LoadLightClusters(SCENE_POINT_LIGHTS, 1.0f, 200.0f);
+
+    // Create Lights, shared by the lighting, instancing and deferred shading shaders
+    SceneLights = LoadLightBuffer();
+    Lights[0] = CreateBufferLight(&SceneLights, LIGHT_POINT, (Vector3){ 0, 8, 20 }, Vector3Zero(), WHITE);
+    Lights[1] = CreateBufferLight(&SceneLights, LIGHT_POINT, (Vector3){ 32, 32, 32 }, Vector3Zero(), RED);
+    Lights[2] = CreateBufferLight(&SceneLights, LIGHT_POINT, (Vector3){ -32, 32, 32 }, Vector3Zero(), GREEN);
+    Lights[3] = CreateBufferLight(&SceneLights, LIGHT_POINT, (Vector3){ 32, 32, -32 }, Vector3Zero(), BLUE);
 
     Lights[0].enabled = true;
     Lights[1].enabled = false;
@@ -315,6 +707,8 @@ void InitGameplayScreen(void)
     // Assign out lighting shader to model
     GameCube.materials[0].shader = GameShader;
     GameSphere.materials[0].shader = GameShader;
+    for ( int i = 0; i < SPHERE_LODS - 1; i++ )
+        GameSphereLods[i].materials[0].shader = GameShader;
     GameTorus.materials[0].shader = GameShader;
     GameCylinder.materials[0].shader = GameShader;
     GameCone.materials[0].shader = GameShader;
@@ -348,7 +742,7 @@ void InitGameplayScreen(void)
     UnloadFileData(fileData);      // Free memory from loaded file
 
     // Load SDF required shader (we use default vertex shader)
-    FontShader = LoadShader(0, TextFormat("resources/shaders/glsl%i/sdf.fs", GLSL_VERSION));
+    FontShader = LoadShaderCached(&SceneShaderCache, 0, TextFormat("resources/shaders/glsl%i/sdf.fs", GLSL_VERSION));
     SetTextureFilter(FontSDF.texture, TEXTURE_FILTER_BILINEAR);    // Required for SDF font
 
     InformationImage = GenImageColor( 100, 60, WHITE );
@@ -384,6 +778,58 @@ void InitGameplayScreen(void)
     GameStl.materials[0].shader = GameShader;
     // GameStl.materials[0].maps[0].color = ORANGE;
 
+    // Register every model instance in the scene index
+    SceneIndex = CreateSceneBvh( SCENE_OBJECT_COUNT, SCENE_BVH_MARGIN );
+    for ( int i = 0; i < 36; i++ )
+        InitSceneObject( SCENE_LAYOUT_CUBES + i, &GameCube, 1.0f, LIGHTGRAY );
+    InitSceneObject( SCENE_ORBIT_SPHERE, &GameSphere, 1.0f, LIGHTGRAY );
+    for ( int i = 0; i < 40; i++ ) {
+        InitSceneObject( SCENE_TETHER_SPHERES + i, &GameSphere, 0.2f, LIGHTGRAY );
+        InitSceneObject( SCENE_TETHER_CUBES + i, &GameCube, 0.2f, LIGHTGRAY );
+    }
+    InitSceneObject( SCENE_ROBOT, &GameModel, 1.5f, WHITE );
+    InitSceneObject( SCENE_ESP32, &GameEsp32, 0.1f, WHITE );
+    InitSceneObject( SCENE_STL, &GameStl, 0.1f, RED );
+    for ( int i = SCENE_ORBIT_SPHERE; i < SCENE_TETHER_SPHERES + 40; i++ ) {
+        SceneObjects[i].lods = GameSphereLods;
+        SceneObjects[i].lodCount = SPHERE_LODS - 1;
+    }
+    UpdateSceneObjects();
+    RebuildSceneBvh( &SceneIndex );
+
+    SceneOcclusion = LoadOcclusionBuffer( ScreenWidth/4, ScreenHeight/4 );
+    SceneQueue = LoadRenderQueue( 256 );
+    SceneLines = LoadLineBatch( 2048 );
+    TetherCurves = LoadCurveSet( TETHER_CURVE_COUNT );
+    CurveShader = LoadShaderCached( &SceneShaderCache, TextFormat( "resources/shaders/glsl%i/curve_instanced.vs", GLSL_VERSION ),
+                                                       TextFormat( "resources/shaders/glsl%i/curve_instanced.fs", GLSL_VERSION ) );
+    TetherInstances = LoadInstancedCurves( CurveShader, TETHER_CURVE_COUNT, SPLINE_FIXED_SEGMENTS );
+
+    Vector3 pathPoints[LAYOUT_PATH_POINTS] = { 0 };
+    LayoutPath = LoadSplineCache( SPLINE_CACHE_CATMULL_ROM, pathPoints, LAYOUT_PATH_POINTS, 12 );
+    LayoutPathLength = LoadArcLengthTable( 1024 );
+    for ( int i = 0; i < FLOW_MARKER_COUNT; i++ )
+        FlowSpeeds[i] = 40.0f + 10.0f*( i % 3 );
+    SceneRecording = LoadRenderRecording( 8192 );
+
+    // The FPS readout is the only UI content changing on its own, twice a second is enough
+    Layers = LoadLayerCompositor();
+    Overdraw = LoadOverdrawAnalysis();
+    LayerScene = AddCompositorLayer( &Layers, DrawSceneLayer, COMPOSITOR_LAYER_MSAA, RAYWHITE, 0.0f );
+    LayerText = AddCompositorLayer( &Layers, DrawTextLayer, 0, BLANK, 0.0f );
+    LayerUi = AddCompositorLayer( &Layers, DrawUiLayer, 0, BLANK, 0.5f );
+
+    ScenePost = LoadPostChain( &SceneShaderCache, GLSL_VERSION, "resources/shaders/variants/post_blur.fs",
+                               "resources/shaders/variants/post_compose.fs" );
+    SetCompositorLayerPost( &Layers, LayerScene, ApplyScenePost );
+    SetAntialiasMode( Antialias );
+
+    UpscaleShader = LoadShaderCached( &SceneShaderCache, 0, TextFormat( "resources/shaders/glsl%i/upscale_sharpen.fs", GLSL_VERSION ) );
+    SetCompositorUpscaleShader( &Layers, UpscaleShader, 0.5f );
+    SceneResolution = LoadResolutionController( 1.0f/60.0f );
+    FrameGpuTimer = LoadGpuTimer();
+    SceneGovernor = LoadQualityGovernor( 1.0f/60.0f, QualityKnobNames, 5, QualityLadder, sizeof( QualityLadder )/sizeof( QualityLadder[0] ) );
+
     // Load default style
     GuiLoadStyleDefault();
 
@@ -428,6 +874,10 @@ void InitGameplayScreen(void)
 
     GuiSetStyle( BUTTON, TEXT_ALIGNMENT, TEXT_ALIGN_CENTER );
 
+    // Startup profile
+    TraceLog( LOG_INFO, "STARTUP: init %.1f ms, shaders %i compiled %.1f ms, %i from cache %.1f ms, %i binaries rejected",
+              ( GetTime() - initStart )*1000.0, SceneShaderCache.compiledCount, SceneShaderCache.compileTime*1000.0,
+              SceneShaderCache.cachedCount, SceneShaderCache.cacheTime*1000.0, SceneShaderCache.rejectedCount );
 }
 
 // Update and draw game frame
@@ -437,6 +887,9 @@ void UpdateDrawFrame(void)
     //----------------------------------------------------------------------------------
     // UpdateMusicStream(music);       // NOTE: Music keeps playing between screens
 
+    double frameStart = GetTime();
+    BeginGpuTimer( &FrameGpuTimer );
+
     UpdateGameplayScreen();
 
 
@@ -447,8 +900,15 @@ void UpdateDrawFrame(void)
         ClearBackground(RAYWHITE);
 
         DrawGameplayScreen();
+
+        // GPU time is read back a few frames later, waiting for it here would stall the CPU
+        rlDrawRenderBatchActive();
+        EndGpuTimer( &FrameGpuTimer, Layers.layers[LayerScene].redrawn );
+        FrameWorkTime = GetTime() - frameStart;
         
     EndDrawing();
+
+    EndUniformCacheFrame();
     //----------------------------------------------------------------------------------
 }
 
@@ -482,19 +942,15 @@ void UpdateGameplayScreen(void)
 
     if (IsKeyPressed(KEY_W)) { 
         Lights[0].enabled = !Lights[0].enabled; 
-        InstancingLights[0].enabled = !InstancingLights[0].enabled; 
     }
     if (IsKeyPressed(KEY_R)) { 
         Lights[1].enabled = !Lights[1].enabled; 
-        InstancingLights[1].enabled = !InstancingLights[1].enabled; 
     }
     if (IsKeyPressed(KEY_G)) { 
         Lights[2].enabled = !Lights[2].enabled; 
-        InstancingLights[2].enabled = !InstancingLights[2].enabled; 
     }
     if (IsKeyPressed(KEY_B)) { 
         Lights[3].enabled = !Lights[3].enabled; 
-        InstancingLights[3].enabled = !InstancingLights[3].enabled; 
     }
     if (IsKeyPressed(KEY_E)) { 
         ElementErase = !ElementErase; 
@@ -511,12 +967,113 @@ void UpdateGameplayScreen(void)
     if (IsKeyPressed(KEY_T)) { 
         ElementText = !ElementText; 
     }
+    if (IsKeyPressed(KEY_S)) { 
+        ElementStats = !ElementStats; 
+    }
+    if (IsKeyPressed(KEY_O)) { 
+        OcclusionCulling = !OcclusionCulling; 
+    }
+    if (IsKeyPressed(KEY_Q)) { 
+        SceneQueue.sorted = !SceneQueue.sorted; 
+    }
+    if (IsKeyPressed(KEY_P)) { 
+        SceneReplay = !SceneReplay; 
+    }
+    if (IsKeyPressed(KEY_C)) { 
+        GpuCurves = !GpuCurves; 
+    }
+    if (IsKeyPressed(KEY_A)) { 
+        AdaptiveCurves = !AdaptiveCurves; 
+    }
+    if (IsKeyPressed(KEY_V)) { 
+        TetherCurveMode = ( TetherCurveMode + 1 ) % 3; 
+    }
+    if (IsKeyPressed(KEY_F)) { 
+        FrameCache = !FrameCache; 
+    }
+    if (IsKeyPressed(KEY_Z)) { 
+        SceneQueue.depthPrepass = !SceneQueue.depthPrepass; 
+    }
+    if (IsKeyPressed(KEY_H)) { 
+        OverdrawMode = !OverdrawMode; 
+    }
+    if (IsKeyPressed(KEY_D)) { 
+        DeferredShading = !DeferredShading; 
+    }
+    if (IsKeyPressed(KEY_K)) { 
+        ClusteredLighting = !ClusteredLighting; 
+    }
+
+    // 1 to 6 toggle the post effects, 7 fuses them, 8 cycles the blur resolution
+    for ( int i = 0; i < 6; i++ ) {
+        if ( IsKeyPressed( KEY_ONE + i ) )
+            ScenePost.effects ^= 1u << i;
+    }
+    if (IsKeyPressed(KEY_SEVEN)) { 
+        ScenePost.fused = !ScenePost.fused; 
+    }
+    if (IsKeyPressed(KEY_EIGHT)) { 
+        ScenePost.bloomScale = ( ScenePost.bloomScale >= 4 ) ? 1 : ScenePost.bloomScale*2;
+        ScenePost.blurScale = ScenePost.bloomScale;
+    }
+    if (IsKeyPressed(KEY_X)) { 
+        Antialias = ( Antialias + 1 ) % 4; 
+    }
+    if (IsKeyPressed(KEY_J)) { 
+        DynamicResolution = !DynamicResolution; 
+    }
+    if (IsKeyPressed(KEY_N)) { 
+        Governor = !Governor; 
+        ResetQualityGovernor( &SceneGovernor );
+    }
+
+    // Click picks one object, dragging selects everything inside the rectangle
+    Vector2 mouse = GetMousePosition();
+    bool overUi = ElementUi && CheckCollisionPointRec( mouse, (Rectangle){ 20, 70, 340, 410 } );
+    if ( IsMouseButtonPressed( MOUSE_BUTTON_LEFT ) && !overUi ) {
+        Selecting = true;
+        SelectionStart = mouse;
+    }
+    if ( Selecting && IsMouseButtonReleased( MOUSE_BUTTON_LEFT ) ) {
+        Selecting = false;
+        SelectSceneObjects( SelectionStart, mouse );
+    }
+
+    // The UI button and X change it
+    SetAntialiasMode( Antialias );
+
+    // Only frames that redrew the scene say something about its cost, cached ones are cheap. The
+    // timer keeps only those, each new result is used once; without timer queries the CPU time stands in
+    bool sceneTimed = ( FrameGpuTimer.resultCount != FrameGpuResults );
+    float gpuTime = FrameGpuTimer.time;
+    if ( FrameGpuTimer.queries[0][0] == 0 ) {
+        sceneTimed = Layers.layers[LayerScene].redrawn;
+        gpuTime = (float)FrameWorkTime;
+    }
+    FrameGpuResults = FrameGpuTimer.resultCount;
+
+    // Resolution only saves GPU time. Going down it acts first, going up it waits until the governor
+    // restored full quality: it may lower the scale but not raise it while a knob is lowered
+    if ( DynamicResolution && sceneTimed ) {
+        SceneResolution.maxScale = ( Governor && ( SceneGovernor.rung > 0 ) ) ? SceneResolution.scale : 1.0f;
+        UpdateResolutionController( &SceneResolution, gpuTime );
+    }
+    SetCompositorLayerScale( &Layers, LayerScene, DynamicResolution ? SceneResolution.scale : 1.0f );
+
+    // The knobs save both, the slower side is the frame time; decisions are logged
+    if ( Governor && sceneTimed ) {
+        if ( IsResolutionAdjusting() )
+            PauseQualityGovernor( &SceneGovernor );
+        else
+            UpdateQualityGovernor( &SceneGovernor, fmaxf( gpuTime, (float)FrameWorkTime ) );
+    }
+    ApplyQualityKnobs();
 
     // Update light values (actually, only enable/disable them)
     for (int i = 0; i < 4; i++) {
-        UpdateLightValues(GameShader, Lights[i]);
-        UpdateLightValues(InstancingShader, InstancingLights[i] );
+        SetBufferLight(&SceneLights, i, Lights[i]);
     }
+    SelectLightingVariants();
 
     // Press enter or tap to change to ENDING screen
     if (IsKeyPressed(KEY_ENTER) )
@@ -558,65 +1115,150 @@ void UpdateGameplayScreen(void)
                 break;
         }
         SetTargetFPS( fps );
+        SetResolutionBudget( &SceneResolution, 1.0f/fps );
+        SetGovernorBudget( &SceneGovernor, 1.0f/fps );
         FrameRateIndexSet = FrameRateIndex;
     }
 
     // Ambient light level (some basic lighting)
-    float f[4];
-    if ( AmbientLight ) {
-        f[0] = 1.0f;
-        f[1] = 1.0f;
-        f[2] = 1.0f;
-        f[3] = 1.0f;
-    } else {
-        f[0] = 0.0f;
-        f[1] = 0.0f;
-        f[2] = 0.0f;
-        f[3] = 0.0f;
-    } 
-    SetShaderValue(GameShader, ShaderAmbientLoc, f, SHADER_UNIFORM_VEC4);
-    SetShaderValue(InstancingShader, InstancingAmbientLoc, f, SHADER_UNIFORM_VEC4);
+    float level = AmbientLight ? 1.0f : 0.0f;
+    SetBufferAmbient(&SceneLights, (Vector4){ level, level, level, level });
+
+    // Uploaded only when a light or the ambient level changed
+    UpdateLightBuffer(&SceneLights);
 }
 
 // Gameplay Screen Draw logic
 void DrawGameplayScreen(void)
 {
-    if ( ElementErase ) {
-        DrawRectangle(0, 0, GetScreenWidth(), GetScreenHeight(), WHITE);
-    }
-    
     float cameraPos[3] = { GameCamera.position.x, GameCamera.position.y, GameCamera.position.z };
-    SetShaderValue(GameShader, GameShader.locs[SHADER_LOC_VECTOR_VIEW], cameraPos, SHADER_UNIFORM_VEC3);
-    SetShaderValue(InstancingShader, InstancingShader.locs[SHADER_LOC_VECTOR_VIEW], cameraPos, SHADER_UNIFORM_VEC3);
+    SetShaderValueCached(GameShader, GameShader.locs[SHADER_LOC_VECTOR_VIEW], cameraPos, SHADER_UNIFORM_VEC3);
+    SetShaderValueCached(InstancingShader, InstancingShader.locs[SHADER_LOC_VECTOR_VIEW], cameraPos, SHADER_UNIFORM_VEC3);
+
+    if ( (float)Layout != LayoutFraction ) {
+        if ( Layout > LayoutFraction ) {
+            LayoutFraction += 0.01;
+            if ( LayoutFraction > Layout )
+                LayoutFraction = Layout;
+        } else {
+            LayoutFraction -= 0.01;
+            if ( LayoutFraction < Layout )
+                LayoutFraction = Layout;
+        } 
+    }
 
-    Vector2 pos = { 20, 10 };
+    if ( Dynamic ) {
+        cycle += 0.01;
+    }
 
-    BeginMode3D(GameCamera);
+    // Each layer is redrawn when its inputs change, then all of them are composited
+    SceneReplayKey sceneKey = GetSceneReplayKey();
+    SetCompositorLayerKey( &Layers, LayerScene, &sceneKey, sizeof( sceneKey ) );
+    if ( !FrameCache ) {
+        InvalidateCompositorLayer( &Layers, LayerScene );
+    }
 
-        if ( (float)Layout != LayoutFraction ) {
-            if ( Layout > LayoutFraction ) {
-                LayoutFraction += 0.01;
-                if ( LayoutFraction > Layout )
-                    LayoutFraction = Layout;
-            } else {
-                LayoutFraction -= 0.01;
-                if ( LayoutFraction < Layout )
-                    LayoutFraction = Layout;
-            } 
-        }
+    TextLayerKey textKey;
+    memset( &textKey, 0, sizeof( textKey ) );
+    textKey.screenWidth = GetScreenWidth();
+    textKey.screenHeight = GetScreenHeight();
+    textKey.text = ElementText;
+    textKey.selecting = Selecting;
+    if ( Selecting ) {
+        textKey.selectionStart = SelectionStart;
+        textKey.mouse = GetMousePosition();
+    }
+    SetCompositorLayerKey( &Layers, LayerText, &textKey, sizeof( textKey ) );
+    SetCompositorLayerVisible( &Layers, LayerText, ElementText || Selecting );
+
+    UiLayerKey uiKey;
+    memset( &uiKey, 0, sizeof( uiKey ) );
+    uiKey.screenWidth = GetScreenWidth();
+    uiKey.screenHeight = GetScreenHeight();
+    uiKey.mouseDown = IsMouseButtonDown( MOUSE_BUTTON_LEFT );
+    if ( CheckCollisionPointRec( GetMousePosition(), (Rectangle){ 20, 70, 340, 410 } ) || uiKey.mouseDown ) {
+        uiKey.mouse = GetMousePosition();       // Elsewhere the mouse leaves the panel unchanged
+    }
+    uiKey.layout = Layout;
+    uiKey.dynamic = Dynamic;
+    uiKey.frameRateIndex = FrameRateIndex;
+    uiKey.antialias = Antialias;
+    for ( int i = 0; i < 4; i++ )
+        uiKey.lights[i] = Lights[i].enabled;
+    uiKey.ambient = AmbientLight;
+    uiKey.lines = ElementLines;
+    uiKey.models = ElementModels;
+    uiKey.text = ElementText;
+    uiKey.ui = ElementUi;
+    uiKey.erase = ElementErase;
+    SetCompositorLayerKey( &Layers, LayerUi, &uiKey, sizeof( uiKey ) );
+    SetCompositorLayerVisible( &Layers, LayerUi, ElementUi );
+
+    // Post settings only rerun the chain over the cached scene image
+    PostLayerKey postKey;
+    memset( &postKey, 0, sizeof( postKey ) );
+    postKey.effects = ScenePost.effects;
+    postKey.fused = ScenePost.fused;
+    postKey.bloomScale = ScenePost.bloomScale;
+    postKey.blurScale = ScenePost.blurScale;
+    SetCompositorPostKey( &Layers, LayerScene, &postKey, sizeof( postKey ) );
+
+    UpdateLayerCompositor( &Layers );
+    DrawLayerCompositor( &Layers );
+
+    if ( OverdrawMode ) {
+        AnalyzeOverdraw();
+        DrawOverdrawHeatmap( &Overdraw );
+        DrawOverdrawOverlay();
+    }
 
-        if ( ElementModels ) {
-            for ( int i = 0; i <= 35; i++ ) {
-                Vector3 a = (Vector3){ (i-13.5f)*4.0f, 0, 0 };
-                Vector3 b = (Vector3){ ((i)/6-2.5f)*4.0f, 0, ((i)%6-2.5f)*4.0f };
+    if ( ElementStats ) {
+        DrawStatsOverlay();
+    }
+}
 
-                Vector3 p = Vector3Lerp( a, b, LayoutFraction );
-                DrawModel( GameCube, p, 1.0f, LIGHTGRAY );
-            }
+// 3d scene layer, drawn multisampled (or not, see --aa) and resolved by the compositor
+void DrawSceneLayer(void)
+{
+    if ( ElementErase ) {
+        DrawRectangle(0, 0, GetScreenWidth(), GetScreenHeight(), WHITE);
+    }
+
+    // A scene unchanged since its last draw is recorded once, then replayed until something changes
+    double sceneStart = GetTime();
+    SceneReplayKey key = GetSceneReplayKey();
+    bool unchanged = ( memcmp( &key, &ScenePreviousKey, sizeof( key ) ) == 0 );
+    bool replay = SceneReplay && !OverdrawCounting;     // Replay sets its recorded blend state, which breaks counting
+    SceneReplaying = replay && unchanged && SceneRecording.valid && ( memcmp( &key, &SceneRecordingKey, sizeof( key ) ) == 0 );
+    ScenePreviousKey = key;
+    SceneRecorded = false;
+
+    if ( !SceneReplaying ) {
+        UpdateSceneObjects();
+        CullSceneObjects();
+        SelectSceneLods();
+        QueueSceneDraws();
+        if ( DeferredShading || ClusteredLighting ) {
+            UpdateScenePointLights();
         }
+    }
+
+    // Clustered variants loop over their cluster's lights, the deferred path lights the models itself
+    if ( LightingMask & LIGHTING_CLUSTERED ) {
+        SetLightClustersShader( &SceneClusters, GameShader );
+        SetLightClustersShader( &SceneClusters, InstancingShader );
+        BindLightClusters( &SceneClusters );
+    }
+
+    BeginMode3D(GameCamera);
 
-        if ( Dynamic ) {
-            cycle += 0.01;
+        // Deferred models and markers are not queued, a replayed frame reuses the last G-buffer
+        if ( DeferredShading ) {
+            if ( !SceneReplaying ) {
+                DrawDeferredGeometry();
+            }
+            Deferred.lightBlending = !OverdrawCounting;     // Counting keeps its own blend state
+            DrawDeferredLighting( &Deferred, GameCamera.position );
         }
 
         // // Old busted joint
@@ -645,126 +1287,1304 @@ void DrawGameplayScreen(void)
 
         #endif 
 
-        if ( ElementText ) {
-            BeginShaderMode( FontShader);    // Activate SDF font shader
-                Vector3 mt = MeasureText3D(FontSDF, "SPHERE", 32,0, 0 );
+        if ( SceneReplaying ) {
+            ReplayRenderRecording( &SceneRecording );
+        } else if ( replay && unchanged ) {
+            RecordRenderQueue( &SceneQueue, &SceneRecording );
+            SceneRecordingKey = key;
+            SceneRecorded = true;
+        } else {
+            ExecuteRenderQueue( &SceneQueue );
+        }
+
+        SceneCpuTime = GetTime() - sceneStart;
+
+    EndMode3D();
+}
+
+// Title and selection rectangle
+void DrawTextLayer(void)
+{
+    Vector2 pos = { 20, 10 };
+
+    if ( Selecting ) {
+        Vector2 mouse = GetMousePosition();
+        Rectangle rect = { fminf( SelectionStart.x, mouse.x ), fminf( SelectionStart.y, mouse.y ),
+                           fabsf( mouse.x - SelectionStart.x ), fabsf( mouse.y - SelectionStart.y ) };
+        DrawRectangleLinesEx( rect, 1.0f, ORANGE );
+    }
+                
+    if ( ElementText) {
+        BeginShaderMode( FontShader);    // Activate SDF font shader
+            DrawTextEx(FontSDF, "VISUALIZATION DEMO", pos, font.baseSize*3.0f, 4, MAROON);
+        EndShaderMode();
+    }
+}
+
+// raygui panel, its controls only see input while the layer is redrawn (the key holds the mouse state)
+void DrawUiLayer(void)
+{
+    BeginShaderMode( FontShader);    // Activate SDF font shader
+
+        // GuiDrawRectangle( (Rectangle){ 5, 115, 410, 290 }, 1, WHITE, WHITE );
+        GuiPanel( (Rectangle){ 20, 70, 340, 410 }, 0 );
+        // GuiGroupBox( (Rectangle){ 10, 120, 400, 200 }, "Viz Control" );
+
+        GuiSetStyle( DEFAULT, TEXT_ALIGNMENT, TEXT_ALIGN_RIGHT );
+        GuiLabel((Rectangle){ 35, 80, 90, 32 }, "Layout");
+        GuiLabel((Rectangle){ 35, 120, 90, 32 }, "Run");
+        GuiLabel((Rectangle){ 35, 160, 90, 32 }, "FPS" );
+        GuiLabel((Rectangle){ 35, 240, 90, 32 }, "Lights" );
+        GuiLabel((Rectangle){ 35, 280, 90, 32 }, "Element" );
+        GuiSetStyle( DEFAULT, TEXT_ALIGNMENT, TEXT_ALIGN_CENTER );
+
+        GuiComboBox((Rectangle){ 130, 80, 200, 32 }, "LayoutA;LayoutB", &Layout);
+
+        GuiSetIconScale(1);
+
+        GuiToggleSlider( (Rectangle){ 130, 120, 200, 32 }, "Static;Dynamic", &Dynamic );
+
+        int fps = GetFPS();
+        GuiValueBox((Rectangle){ 130, 160, 90, 32 }, 0, &fps, 0, 1000, false );
+
+        if ( GuiButton( (Rectangle){ 230, 160, 100, 32 }, AntialiasNames[Antialias] ) )
+            Antialias = ( Antialias + 1 ) % 4;
+
+        GuiComboBox((Rectangle){ 130, 200, 200, 32 }, "10;30;60;120;160;220", &FrameRateIndex );
+
+        GuiToggle( (Rectangle){ 130, 240, 30, 32 }, "W", &Lights[0].enabled );
+        GuiToggle( (Rectangle){ 170, 240, 30, 32 }, "R", &Lights[1].enabled );
+        GuiToggle( (Rectangle){ 210, 240, 30, 32 }, "G", &Lights[2].enabled );
+        GuiToggle( (Rectangle){ 250, 240, 30, 32 }, "B", &Lights[3].enabled );
+        GuiToggle( (Rectangle){ 290, 240, 30, 32 }, "A", &AmbientLight );
+
+        GuiToggle( (Rectangle){ 130, 280, 200, 32 }, "Lines", &ElementLines );
+        GuiToggle( (Rectangle){ 130, 320, 200, 32 }, "Models", &ElementModels );
+        GuiToggle( (Rectangle){ 130, 360, 200, 32 }, "Text", &ElementText );
+        GuiToggle( (Rectangle){ 130, 400, 200, 32 }, "UI", &ElementUi );
+        GuiToggle( (Rectangle){ 130, 440, 200, 32 }, "Erase", &ElementErase );
+
+    EndShaderMode();
+}
+
+// Count every layer on its own, the UI locked so its controls do not see the input twice
+void AnalyzeOverdraw(void)
+{
+    OverdrawStats none = { 0 };
+
+    OverdrawCounting = true;
+    BeginOverdrawAnalysis( &Overdraw );
+
+    OverdrawLayers[0] = CountOverdraw( &Overdraw, DrawSceneLayer );
+    OverdrawLayers[1] = ( ElementText || Selecting ) ? CountOverdraw( &Overdraw, DrawTextLayer ) : none;
+    GuiLock();
+    OverdrawLayers[2] = ElementUi ? CountOverdraw( &Overdraw, DrawUiLayer ) : none;
+    GuiUnlock();
+    OverdrawLayers[3] = ElementStats ? CountOverdraw( &Overdraw, DrawStatsOverlay ) : none;
+
+    EndOverdrawAnalysis( &Overdraw );
+    OverdrawCounting = false;
+
+    // Once a second in the log, for regression runs
+    if ( OverdrawFrames++ % 60 == 0 ) {
+        TraceLog( LOG_INFO, "OVERDRAW: scene %i/%.2f/%i text %i/%.2f/%i ui %i/%.2f/%i stats %i/%.2f/%i total %i/%.2f/%i (min/mean/max)",
+                  OverdrawLayers[0].minimum, OverdrawLayers[0].mean, OverdrawLayers[0].maximum,
+                  OverdrawLayers[1].minimum, OverdrawLayers[1].mean, OverdrawLayers[1].maximum,
+                  OverdrawLayers[2].minimum, OverdrawLayers[2].mean, OverdrawLayers[2].maximum,
+                  OverdrawLayers[3].minimum, OverdrawLayers[3].mean, OverdrawLayers[3].maximum,
+                  Overdraw.total.minimum, Overdraw.total.mean, Overdraw.total.maximum );
+    }
+}
+
+// Per layer fragments and the heatmap legend, bottom left
+void DrawOverdrawOverlay(void)
+{
+    int x = 20;
+    int y = GetScreenHeight() - 125;
+    int presented = 0;
+
+    for ( int i = 0; i < Layers.layerCount; i++ )
+        presented += Layers.layers[i].visible ? 1 : 0;
+
+    DrawRectangle( x - 10, y - 5, 250, 130, Fade( RAYWHITE, 0.8f ) );
+    DrawText( TextFormat( "Overdraw [H]  %.2f ms", Overdraw.time*1000.0 ), x, y, 10, DARKGRAY );
+    y += 14;
+    for ( int i = 0; i < OVERDRAW_LAYERS; i++ ) {
+        DrawText( TextFormat( "%s  min %i  mean %.2f  max %i", OverdrawLayerNames[i], OverdrawLayers[i].minimum, OverdrawLayers[i].mean, OverdrawLayers[i].maximum ), x, y, 10, DARKGRAY );
+        y += 14;
+    }
+    DrawText( TextFormat( "total  min %i  mean %.2f  max %i", Overdraw.total.minimum, Overdraw.total.mean, Overdraw.total.maximum ), x, y, 10, DARKGRAY );
+    y += 14;
+    DrawText( TextFormat( "present  %i full screen layers", presented ), x, y, 10, DARKGRAY );
+    y += 14;
+    for ( int i = 0; i <= 8; i++ ) {
+        DrawRectangle( x + i*24, y, 20, 10, GetOverdrawColor( i ) );
+        DrawText( TextFormat( ( i == 8 ) ? "8+" : "%i", i ), x + i*24 + 4, y + 12, 10, DARKGRAY );
+    }
+}
 
-                DrawText3D( FontSDF, "SPHERE", (Vector3){ 22.0f*sin(cycle)-mt.x/2, -5.0f, 22.0f*cos(cycle)}, 32, 5, 0.0, true, GRAY );
-            EndShaderMode();
+// Dynamic resolution is lowering the scale or measuring its last change, the governor waits
+// NOTE: Once the scale is at its floor, or the GPU time fits and the frame is CPU bound, it is the governor's turn
+bool IsResolutionAdjusting(void)
+{
+    if ( !DynamicResolution )
+        return false;
+    if ( SceneResolution.hold > 0 )
+        return true;
+
+    return ( SceneResolution.scale > SceneResolution.minScale ) &&
+           ( SceneResolution.average > SceneResolution.budget*SceneResolution.upperBound );
+}
+
+// Knob values of the governor's rung, full quality while it is off
+void ApplyQualityKnobs(void)
+{
+    CurveTolerance = 0.5f*( 1 << GetGovernorKnob( &SceneGovernor, QUALITY_CURVES ) );
+    SphereLodBias = GetGovernorKnob( &SceneGovernor, QUALITY_LOD_BIAS );
+    SphereTessellation = GetGovernorKnob( &SceneGovernor, QUALITY_TESSELLATION );
+    FlowMarkerCount = FLOW_MARKER_COUNT >> GetGovernorKnob( &SceneGovernor, QUALITY_INSTANCES );
+
+    // The deferred path lights every light it holds
+    int lights = SCENE_POINT_LIGHTS >> GetGovernorKnob( &SceneGovernor, QUALITY_LIGHTS );
+    if ( lights != ScenePointLightCount ) {
+        ScenePointLightCount = lights;
+        ClearDeferredLights( &Deferred );
+        for ( int i = 0; i < lights; i++ )
+            AddDeferredLight( &Deferred, ScenePointLights[i].position, ScenePointLights[i].radius, ScenePointLights[i].color );
+    }
+}
+
+// Scene layer image through the post chain, called by the compositor
+Texture2D ApplyScenePost(Texture2D image)
+{
+    return ApplyPostChain( &ScenePost, image );
+}
+
+// MSAA samples of the scene layer, or the FXAA post effect
+void SetAntialiasMode(int mode)
+{
+    SetCompositorSamples( &Layers, ( mode == ANTIALIAS_MSAA_2X ) ? 2 : ( mode == ANTIALIAS_MSAA_4X ) ? 4 : 0 );
+
+    if ( mode == ANTIALIAS_FXAA )
+        ScenePost.effects |= POST_EFFECT_FXAA;
+    else
+        ScenePost.effects &= ~POST_EFFECT_FXAA;
+}
+
+// Gameplay Screen Unload logic
+void UnloadGameplayScreen(void)
+{
+    // TODO: Unload GAMEPLAY screen variables here!
+    UnloadSceneBvh( &SceneIndex );
+    UnloadOcclusionBuffer( &SceneOcclusion );
+    UnloadRenderQueue( &SceneQueue );
+    UnloadLineBatch( &SceneLines );
+    UnloadCurveSet( &TetherCurves );
+    UnloadInstancedCurves( &TetherInstances );
+    UnloadSplineCache( &LayoutPath );
+    UnloadArcLengthTable( &LayoutPathLength );
+    UnloadShader( CurveShader );
+    UnloadShaderVariants( &LightingVariants );
+    UnloadShaderVariants( &DepthVariants );
+    UnloadShader( GBufferShader );
+    UnloadShader( GBufferInstancingShader );
+    UnloadShader( DeferredShadingShader );
+    UnloadShader( DeferredLightShader );
+    UnloadDeferredRenderer( &Deferred );
+    UnloadLightClusters( &SceneClusters );
+    UnloadRenderRecording( &SceneRecording );
+    UnloadLayerCompositor( &Layers );
+    UnloadPostChain( &ScenePost );
+    UnloadShader( UpscaleShader );
+    UnloadGpuTimer( &FrameGpuTimer );
+    UnloadOverdrawAnalysis( &Overdraw );
+}
+
+// Register a model instance in the scene index
+void InitSceneObject(int index, Model *model, float scale, Color tint)
+{
+    SceneObject *object = &SceneObjects[index];
+
+    object->model = model;
+    object->scale = scale;
+    object->tint = tint;
+    object->bounds = GetModelBoundingBox( *model );
+    object->proxy = InsertSceneBvh( &SceneIndex, object->bounds, index );
+}
+
+// Move scene objects for the current cycle and layout, then refit the scene index
+void UpdateSceneObjects(void)
+{
+    for ( int i = 0; i <= 35; i++ ) {
+        Vector3 a = (Vector3){ (i-13.5f)*4.0f, 0, 0 };
+        Vector3 b = (Vector3){ ((i)/6-2.5f)*4.0f, 0, ((i)%6-2.5f)*4.0f };
+
+        SceneObjects[SCENE_LAYOUT_CUBES + i].position = Vector3Lerp( a, b, LayoutFraction );
+    }
+
+    SceneObjects[SCENE_ORBIT_SPHERE].position = (Vector3){ 22.0f*sin(cycle), 0.0f, 22.0f*cos(cycle) };
+
+    for ( int i = -20; i < 20; i++ ) {
+        SceneObjects[SCENE_TETHER_SPHERES + i + 20].position = (Vector3){ 2.0f * i, 4.0f*sin(3*cycle)+4.0f, -16.0f * sin(cycle)};
+        SceneObjects[SCENE_TETHER_CUBES + i + 20].position = (Vector3){ 2.0f * i, -4.0f*sin(4*cycle)+4.0f, 16.0f * sin( cycle)};
+    }
+
+    Vector3 modelPosition = (Vector3){ 20.0f*sin(cycle), 0.0f, -20.0f*cos(cycle) };
+    SceneObjects[SCENE_ROBOT].position = modelPosition;
+    modelPosition.y += 8;
+    SceneObjects[SCENE_ESP32].position = modelPosition;
+    modelPosition.y += 10;
+    SceneObjects[SCENE_STL].position = modelPosition;
+
+    for ( int i = 0; i < SCENE_OBJECT_COUNT; i++ ) {
+        SceneObject *object = &SceneObjects[i];
+        BoundingBox box = { Vector3Add( Vector3Scale( object->bounds.min, object->scale ), object->position ),
+                            Vector3Add( Vector3Scale( object->bounds.max, object->scale ), object->position ) };
+        MoveSceneBvh( &SceneIndex, object->proxy, box );
+    }
+
+    UpdateSceneBvh( &SceneIndex );
+}
+
+// Flag the objects inside the camera frustum and not hidden behind occluders
+void CullSceneObjects(void)
+{
+    for ( int i = 0; i < SCENE_OBJECT_COUNT; i++ )
+        SceneObjects[i].visible = false;
+
+    Frustum frustum = GetCameraFrustum( GameCamera, GetScreenWidth(), GetScreenHeight() );
+    SceneVisibleCount = QuerySceneBvhFrustum( &SceneIndex, frustum, SceneQueryResults, SCENE_OBJECT_COUNT );
+
+    for ( int i = 0; i < SceneVisibleCount; i++ )
+        SceneObjects[SceneQueryResults[i]].visible = true;
+
+    SceneOccludedCount = 0;
+
+    if ( !OcclusionCulling || !ElementModels )
+        return;
+
+    BeginOcclusionFrame( &SceneOcclusion, GetCameraViewProjection( GameCamera, GetScreenWidth(), GetScreenHeight() ) );
+    RasterizeSceneOccluders();
+    EndOcclusionFrame( &SceneOcclusion );
+
+    for ( int i = 0; i < SceneVisibleCount; i++ ) {
+        SceneObject *object = &SceneObjects[SceneQueryResults[i]];
+        if ( !TestOcclusionBox( &SceneOcclusion, SceneIndex.nodes[object->proxy].bounds ) )
+            object->visible = false;
+    }
+
+    SceneOccludedCount = SceneOcclusion.occludedCount;
+}
+
+// Level of the visible objects with LODs: from their size on screen, plus the bias, no finer than the tessellation knob
+void SelectSceneLods(void)
+{
+    float pixelsPerUnit = GetScreenHeight()/( 2.0f*tanf( GameCamera.fovy*0.5f*DEG2RAD ) );
+
+    for ( int i = 0; i < SCENE_OBJECT_COUNT; i++ ) {
+        SceneObject *object = &SceneObjects[i];
+        if ( object->lods == NULL || !object->visible )
+            continue;
+
+        float radius = 0.5f*Vector3Distance( object->bounds.min, object->bounds.max )*object->scale;
+        float distance = Vector3Distance( object->position, GameCamera.position );
+        float pixels = radius*pixelsPerUnit/fmaxf( distance, 0.001f );
+
+        int lod = ( pixels >= 48.0f ) ? 0 : ( pixels >= 16.0f ) ? 1 : ( pixels >= 6.0f ) ? 2 : 3;
+        lod += SphereLodBias;
+        if ( lod < SphereTessellation )
+            lod = SphereTessellation;
+        object->lod = ( lod < object->lodCount ) ? lod : object->lodCount;
+    }
+}
+
+// Model of the object's current LOD
+Model *GetSceneObjectModel(SceneObject *object)
+{
+    return ( object->lod > 0 ) ? &object->lods[object->lod - 1] : object->model;
+}
+
+// Rasterize the visible solid objects with the largest projected size
+// NOTE: Only cubes and the orbit sphere are solid enough, the sphere contributes its inscribed box
+void RasterizeSceneOccluders(void)
+{
+    BoundingBox boxes[OCCLUDER_MAX];
+    float scores[OCCLUDER_MAX];
+    int count = 0;
+
+    for ( int i = SCENE_LAYOUT_CUBES; i <= SCENE_ORBIT_SPHERE; i++ ) {
+        SceneObject *object = &SceneObjects[i];
+        if ( !object->visible )
+            continue;
+
+        Vector3 extent = Vector3Scale( Vector3Subtract( object->bounds.max, object->bounds.min ), 0.5f*object->scale );
+        if ( i == SCENE_ORBIT_SPHERE )
+            extent = Vector3Scale( extent, 1.0f/sqrtf( 3.0f ) );
+
+        float score = Vector3LengthSqr( extent )/( Vector3DistanceSqr( object->position, GameCamera.position ) + 1.0f );
+
+        // Keep the best scores sorted, largest first
+        int slot = count;
+        while ( slot > 0 && scores[slot - 1] < score ) {
+            if ( slot < OCCLUDER_MAX ) {
+                scores[slot] = scores[slot - 1];
+                boxes[slot] = boxes[slot - 1];
+            }
+            slot--;
+        }
+        if ( slot < OCCLUDER_MAX ) {
+            scores[slot] = score;
+            boxes[slot] = (BoundingBox){ Vector3Subtract( object->position, extent ), Vector3Add( object->position, extent ) };
+            if ( count < OCCLUDER_MAX )
+                count++;
+        }
+    }
+
+    for ( int i = 0; i < count; i++ )
+        RasterizeOccluderBox( &SceneOcclusion, boxes[i] );
+}
+
+// Draw a scene object if it survived culling
+void DrawSceneObject(int index)
+{
+    SceneObject *object = &SceneObjects[index];
+
+    if ( object->visible )
+        DrawModel( *GetSceneObjectModel( object ), object->position, object->scale, object->tint );
+}
+
+// Scene object depth for the pre-pass
+void DrawSceneObjectDepth(int index)
+{
+    SceneObject *object = &SceneObjects[index];
+
+    if ( object->visible )
+        DrawModelShader( *GetSceneObjectModel( object ), DepthShader, object->position, object->scale, WHITE );
+}
+
+// Locations of a new lighting or depth variant
+void SetupLightingVariant(Shader *shader, unsigned int mask)
+{
+    shader->locs[SHADER_LOC_VECTOR_VIEW] = GetShaderLocation( *shader, "viewPos" );
+    if ( mask & LIGHTING_INSTANCING )
+        shader->locs[SHADER_LOC_MATRIX_MODEL] = GetShaderLocationAttrib( *shader, "instanceTransform" );
+}
+
+// Lighting variants of the enabled lights and the clustered path, models switch when the mask changes
+void SelectLightingVariants(void)
+{
+    unsigned int mask = 0;
+    for ( int i = 0; i < 4; i++ ) {
+        if ( Lights[i].enabled )
+            mask |= LIGHTING_LIGHT_0 << i;
+    }
+    if ( ClusteredLighting && !DeferredShading )
+        mask |= LIGHTING_CLUSTERED;
+
+    if ( mask == LightingMask )
+        return;
+
+    LightingMask = mask;
+    GameShader = GetShaderVariant( &LightingVariants, mask );
+    InstancingShader = GetShaderVariant( &LightingVariants, mask | LIGHTING_INSTANCING );
+    MatInstances.shader = InstancingShader;
+
+    Model *models[] = { &GameCube, &GameSphere, &GameTorus, &GameCylinder, &GameCone, &GameModel, &GameEsp32, &GameStl,
+                        &GameSphereLods[0], &GameSphereLods[1], &GameSphereLods[2] };
+    for ( int m = 0; m < 11; m++ ) {
+        for ( int i = 0; i < models[m]->materialCount; i++ )
+            models[m]->materials[i].shader = GameShader;
+    }
+}
+
+// Draw a model with its materials switched to another shader (depth only, G-buffer)
+// NOTE: Scene models use one shader for all their materials, the first one is restored everywhere
+void DrawModelShader(Model model, Shader shader, Vector3 position, float scale, Color tint)
+{
+    Shader materialShader = model.materials[0].shader;
+
+    for ( int i = 0; i < model.materialCount; i++ )
+        model.materials[i].shader = shader;
+
+    DrawModel( model, position, scale, tint );
+
+    for ( int i = 0; i < model.materialCount; i++ )
+        model.materials[i].shader = materialShader;
+}
+
+// Record the frame's 3d draws, opaque models and lines, then blended text
+void QueueSceneDraws(void)
+{
+    Shader none = { 0 };
+    Vector3 spherePosition = SceneObjects[SCENE_ORBIT_SPHERE].position;
+
+    BeginRenderQueue( &SceneQueue, GameCamera.position, RL_CULL_DISTANCE_FAR );
+
+    for ( int i = 0; i < SCENE_OBJECT_COUNT; i++ ) {
+        SceneObject *object = &SceneObjects[i];
+        if ( !ElementModels || !object->visible || DeferredShading )
+            continue;
+
+        Material *material = &object->model->materials[0];
+        unsigned int materialKey = ( material->shader.id << 8 ) ^ material->maps[MATERIAL_MAP_DIFFUSE].texture.id;
+        PushRenderItem( &SceneQueue, RENDER_LAYER_OPAQUE, BLEND_ALPHA, none, materialKey, object->position, DrawSceneObject, i );
+        SetRenderItemDepthDraw( &SceneQueue, DrawSceneObjectDepth );
+    }
+
+    // Beziers from each tether sphere to the orbit sphere, the grid and selection boxes
+    ClearLineBatch( &SceneLines );
+    SceneViewProj = GetCameraViewProjection( GameCamera, GetScreenWidth(), GetScreenHeight() );
+    SplineSegmentsDrawn = 0;
+    SplineSegmentsFixed = 0;
+
+    if ( ElementLines ) {
+        ClearCurveSet( &TetherCurves );
+        ClearInstancedCurves( &TetherInstances );
+        SetInstancedCurvesMode( &TetherInstances, TetherCurveMode );
+        int instanceSegments = 1;
+        for ( int i = 0; i < TETHER_CURVE_COUNT; i++ ) {
+            Vector3 start = SceneObjects[SCENE_TETHER_SPHERES + i].position;
+            Vector3 c2 = { start.x, start.y - 15, start.z };
+            Vector3 c3 = { spherePosition.x, spherePosition.y - 15, spherePosition.z };
+            int segments = GetSplineSegments3D( start, c2, c3, spherePosition );
+            if ( GpuCurves ) {
+                // Width encodes the tether index: 1 to 4 pixels, or 0.1 to 0.4 world units
+                float width = ( TetherCurveMode == CURVE_MODE_LINES ) ? 1.0f + ( i % 4 ) : 0.1f + 0.1f*( i % 4 );
+                AddInstancedCurve( &TetherInstances, start, c2, c3, spherePosition, width, LIGHTGRAY );
+                instanceSegments = ( segments > instanceSegments ) ? segments : instanceSegments;
+            } else {
+                // One curve at a time, each with its own count
+                AddCurveBezierCubic( &TetherCurves, start, c2, c3, spherePosition );
+                EvaluateCurveRange( &TetherCurves, i, 1, segments, TetherCurvePoints );
+                AddLineBatchStrip( &SceneLines, TetherCurvePoints, segments + 1, LIGHTGRAY );
+                SplineSegmentsDrawn += segments;
+            }
+            SplineSegmentsFixed += SPLINE_FIXED_SEGMENTS;
+        }
+        if ( GpuCurves ) {
+            // Instances share the template, sized for the most demanding curve
+            SetInstancedCurvesSegments( &TetherInstances, instanceSegments );
+            SplineSegmentsDrawn += TETHER_CURVE_COUNT*instanceSegments;
+        }
+        AddLineBatchGrid( &SceneLines, 20, 10.0f );
+
+        // Path above the layout cubes, unchanged points leave their spans cached
+        for ( int i = 0; i < LAYOUT_PATH_POINTS; i++ ) {
+            int cube = ( i == 0 ) ? 0 : ( i > 36 ) ? 35 : i - 1;
+            Vector3 position = SceneObjects[SCENE_LAYOUT_CUBES + cube].position;
+            SetSplineCachePoint( &LayoutPath, i, (Vector3){ position.x, position.y + 3.0f, position.z } );
+        }
+        if ( GpuCurves )
+            AddInstancedCurvesSplineCache( &TetherInstances, &LayoutPath, ( TetherCurveMode == CURVE_MODE_LINES ) ? 2.0f : 0.3f, SKYBLUE );
+        else
+            AddLineBatchSplineCache( &SceneLines, &LayoutPath, SKYBLUE );
+
+        // Arc length table follows the path, markers spread evenly over its new length
+        if ( LayoutPath.evaluatedSpans > 0 )
+            UpdateArcLengthTable( &LayoutPathLength, LayoutPath.curve, LayoutPath.spanCount*LayoutPath.segments + 1 );
+        if ( LayoutPath.evaluatedSpans > 0 || FlowMarkersSpread != FlowMarkerCount ) {
+            for ( int i = 0; i < FlowMarkerCount; i++ )
+                FlowOffsets[i] = LayoutPathLength.length*i/FlowMarkerCount;
+            FlowMarkersSpread = FlowMarkerCount;
+        }
+        EvaluateArcLengthMarkers( &LayoutPathLength, FlowOffsets, FlowSpeeds, FlowMarkerCount, cycle, 0.3f, FlowMarkers );
+        if ( ElementModels && !DeferredShading ) {
+            PushRenderItem( &SceneQueue, RENDER_LAYER_OPAQUE, BLEND_ALPHA, MatInstances.shader, 0, spherePosition, DrawFlowMarkers, 0 );
+            SetRenderItemDepthDraw( &SceneQueue, DrawFlowMarkersDepth );
         }
+    }
+
+    for ( int i = 0; i < SCENE_OBJECT_COUNT; i++ ) {
+        if ( SceneObjects[i].selected )
+            AddLineBatchBox( &SceneLines, SceneIndex.nodes[SceneObjects[i].proxy].bounds, ORANGE );
+    }
 
-        Vector3 spherePosition = (Vector3){ 22.0f*sin(cycle), 0.0f, 22.0f*cos(cycle) };
+    if ( SceneLines.vertexCount > 0 )
+        PushRenderItem( &SceneQueue, RENDER_LAYER_OPAQUE, BLEND_ALPHA, none, 0, Vector3Zero(), DrawSceneLines, 0 );
 
-        if ( ElementModels ) {
-            DrawModel( GameSphere, spherePosition, 1.0f, LIGHTGRAY );
+    if ( ElementLines && GpuCurves )
+        PushRenderItem( &SceneQueue, RENDER_LAYER_OPAQUE, BLEND_ALPHA, CurveShader, 0, spherePosition, DrawTetherCurves, 0 );
+
+    if ( ElementText ) {
+        Vector3 labelPosition = { spherePosition.x, -5.0f, spherePosition.z };
+        Vector3 billboardPosition = { spherePosition.x, 4.0f, spherePosition.z };
+        PushRenderItem( &SceneQueue, RENDER_LAYER_TRANSPARENT, BLEND_ALPHA, FontShader, FontSDF.texture.id, labelPosition, DrawSphereLabel, 0 );
+        PushRenderItem( &SceneQueue, RENDER_LAYER_TRANSPARENT, BLEND_ALPHA, none, InformationTexture.texture.id, billboardPosition, DrawSphereBillboard, 0 );
+    }
+}
+
+// Snapshot of the scene inputs, zero filled so keys compare with memcmp()
+SceneReplayKey GetSceneReplayKey(void)
+{
+    SceneReplayKey key;
+    memset( &key, 0, sizeof( key ) );
+
+    key.camera = GameCamera;
+    key.cycle = cycle;
+    key.layoutFraction = LayoutFraction;
+    key.screenWidth = GetScreenWidth();
+    key.screenHeight = GetScreenHeight();
+    key.selectionVersion = SelectionVersion;
+    key.models = ElementModels;
+    key.lines = ElementLines;
+    key.text = ElementText;
+    key.occlusion = OcclusionCulling;
+    key.sorted = SceneQueue.sorted;
+    key.prepass = SceneQueue.depthPrepass;
+    key.deferred = DeferredShading;
+    key.clustered = ClusteredLighting;
+    key.gpuCurves = GpuCurves;
+    key.adaptiveCurves = AdaptiveCurves;
+    key.curveMode = TetherCurveMode;
+    for ( int i = 0; i < 4; i++ )
+        key.lights[i] = Lights[i].enabled;
+    key.ambient = AmbientLight;
+    key.erase = ElementErase;
+    key.quality = SceneGovernor.rung;
+    key.resolutionScale = Layers.layers[LayerScene].scale;
+
+    return key;
+}
+
+// All scene lines in one draw
+void DrawSceneLines(int data)
+{
+    DrawLineBatch( &SceneLines );
+}
+
+// Tether curves, evaluated on the GPU
+void DrawTetherCurves(int data)
+{
+    DrawInstancedCurves( &TetherInstances );
+}
+
+// Markers on the layout path, one instanced draw
+void DrawFlowMarkers(int data)
+{
+    DrawMeshInstanced( GameCubeMesh, MatInstances, FlowMarkers, FlowMarkerCount );
+}
+
+// Point lights drifting over the layout in rings, one turn every few seconds while dynamic
+void UpdateScenePointLights(void)
+{
+    for ( int i = 0; i < ScenePointLightCount; i++ ) {
+        ClusterLight *light = &ScenePointLights[i];
+        float ring = 4.0f + 2.0f*( i % 12 );
+        float angle = 2.0f*PI*i/SCENE_POINT_LIGHTS*7.0f + cycle*( 0.5f + 0.1f*( i % 5 ) );
+        light->position = (Vector3){ ring*cosf( angle ), 1.0f + 0.5f*( i % 6 ), ring*sinf( angle ) };
+        if ( DeferredShading )
+            SetDeferredLight( &Deferred, i, light->position, light->radius, light->color );
+    }
+
+    if ( ClusteredLighting && !DeferredShading )
+        UpdateLightClusters( &SceneClusters, GameCamera, Layers.layers[LayerScene].viewportWidth, Layers.layers[LayerScene].viewportHeight,
+                             ScenePointLights, ScenePointLightCount );
+}
+
+// Opaque models and markers into the G-buffer, lit afterwards by DrawDeferredLighting()
+void DrawDeferredGeometry(void)
+{
+    BeginDeferredGeometry( &Deferred );
+
+        for ( int i = 0; i < SCENE_OBJECT_COUNT; i++ ) {
+            SceneObject *object = &SceneObjects[i];
+            if ( ElementModels && object->visible )
+                DrawModelShader( *GetSceneObjectModel( object ), GBufferShader, object->position, object->scale, object->tint );
         }
 
-        if ( ElementText ) {
-            Vector2 size = { 1.0f, 1.0f };
-            Rectangle source = { 0.0f, 0.0f, (float)InformationTexture.texture.width, -(float)InformationTexture.texture.height };
-            DrawBillboardRec( GameCamera, InformationTexture.texture, source, (Vector3){ 22.0f*sin(cycle), 4.0f, 22.0f*cos(cycle)}, size, WHITE );
+        if ( ElementModels && ElementLines ) {
+            DrawMeshInstanced( GameCubeMesh, MatGBufferInstances, FlowMarkers, FlowMarkerCount );
         }
 
-        Vector3 points[4];
+    EndDeferredGeometry( &Deferred );
+}
+
+// Markers depth for the pre-pass
+void DrawFlowMarkersDepth(int data)
+{
+    DrawMeshInstanced( GameCubeMesh, MatDepthInstances, FlowMarkers, FlowMarkerCount );
+}
 
-        for ( int i = -20; i < 20; i++ ) {
-            if ( ElementModels || ElementLines ) {
-                points[ 0 ] = (Vector3){ 2.0f * i, 4.0f*sin(3*cycle)+4.0f, -16.0f * sin(cycle)};
-                points[ 3 ] = (Vector3){ 2.0f * i, -4.0f*sin(4*cycle)+4.0f, 16.0f * sin( cycle)};
+// SDF label under the orbit sphere, FontShader is bound by the queue
+void DrawSphereLabel(int data)
+{
+    Vector3 mt = MeasureText3D( FontSDF, "SPHERE", 32, 0, 0 );
+    Vector3 spherePosition = SceneObjects[SCENE_ORBIT_SPHERE].position;
 
-                points[ 1 ] = points[ 0 ];
-                points[ 1 ].y -= 15;
-                points[ 2 ] = points[ 3 ];
-                points[ 2 ].y += 10;
-            }
+    DrawText3D( FontSDF, "SPHERE", (Vector3){ spherePosition.x - mt.x/2, -5.0f, spherePosition.z }, 32, 5, 0.0, true, GRAY );
+}
+
+// Information texture above the orbit sphere
+void DrawSphereBillboard(int data)
+{
+    Vector2 size = { 1.0f, 1.0f };
+    Rectangle source = { 0.0f, 0.0f, (float)InformationTexture.texture.width, -(float)InformationTexture.texture.height };
+    Vector3 spherePosition = SceneObjects[SCENE_ORBIT_SPHERE].position;
+
+    DrawBillboardRec( GameCamera, InformationTexture.texture, source, (Vector3){ spherePosition.x, 4.0f, spherePosition.z }, size, WHITE );
+}
+
+// Select the object under a click, or every object inside a dragged rectangle
+void SelectSceneObjects(Vector2 start, Vector2 end)
+{
+    SelectionVersion++;
+
+    for ( int i = 0; i < SCENE_OBJECT_COUNT; i++ )
+        SceneObjects[i].selected = false;
+
+    if ( Vector2Distance( start, end ) < 4.0f ) {
+        int picked = RaycastSceneBvh( &SceneIndex, GetMouseRay( end, GameCamera ), 0 );
+        if ( picked >= 0 )
+            SceneObjects[picked].selected = true;
+    } else {
+        Rectangle rect = { fminf( start.x, end.x ), fminf( start.y, end.y ), fabsf( end.x - start.x ), fabsf( end.y - start.y ) };
+        Frustum frustum = GetCameraFrustumRect( GameCamera, rect, GetScreenWidth(), GetScreenHeight() );
+        int count = QuerySceneBvhFrustum( &SceneIndex, frustum, SceneQueryResults, SCENE_OBJECT_COUNT );
+        for ( int i = 0; i < count; i++ )
+            SceneObjects[SceneQueryResults[i]].selected = true;
+    }
+}
+
+// Frame statistics in the top right corner
+void DrawStatsOverlay(void)
+{
+    int x = GetScreenWidth() - 210;
+    int y = 10;
+
+    DrawRectangle( x - 10, y - 5, 210, 412, Fade( RAYWHITE, 0.8f ) );
+    DrawText( TextFormat( "FPS %i  frame %.2f ms", GetFPS(), GetFrameTime()*1000.0f ), x, y, 10, DARKGRAY );
+    y += 14;
+    DrawText( TextFormat( "Objects %i  in frustum %i", SCENE_OBJECT_COUNT, SceneVisibleCount ), x, y, 10, DARKGRAY );
+    y += 14;
+    DrawText( TextFormat( "Occlusion [O] %s", OcclusionCulling ? "on" : "off" ), x, y, 10, DARKGRAY );
+    y += 14;
+    DrawText( TextFormat( "Occluders %i  triangles %i", SceneOcclusion.occluderCount, SceneOcclusion.triangleCount ), x, y, 10, DARKGRAY );
+    y += 14;
+    DrawText( TextFormat( "Occluded %i of %i", SceneOccludedCount, SceneOcclusion.testedCount ), x, y, 10, DARKGRAY );
+    y += 14;
+    DrawText( TextFormat( "Raster %.3f ms  test %.3f ms", SceneOcclusion.rasterTime*1000.0, SceneOcclusion.testTime*1000.0 ), x, y, 10, DARKGRAY );
+    y += 14;
+    DrawText( TextFormat( "Queue [Q] %s  %i items", SceneQueue.sorted ? "sorted" : "unsorted", SceneQueue.count ), x, y, 10, DARKGRAY );
+    y += 14;
+    DrawText( TextFormat( "State changes %i (code order %i)", SceneQueue.stateChanges, SceneQueue.unsortedStateChanges ), x, y, 10, DARKGRAY );
+    y += 14;
+    DrawText( TextFormat( "Depth prepass [Z] %s  %i items", SceneQueue.depthPrepass ? "on" : "off", SceneQueue.prepassCount ), x, y, 10, DARKGRAY );
+    y += 14;
+    DrawText( TextFormat( "Deferred [D] %s  %i point lights", DeferredShading ? "on" : "off", DeferredShading ? Deferred.litVolumes : 0 ), x, y, 10, DARKGRAY );
+    y += 14;
+    DrawText( TextFormat( "Clusters [K] %s  bin %.3f ms  %.2f lights/cluster", ClusteredLighting ? "on" : "off", SceneClusters.binTime*1000.0, GetLightClustersAverage( &SceneClusters ) ), x, y, 10, DARKGRAY );
+    y += 14;
+    UniformCacheStats uniforms = GetUniformCacheStats();
+    DrawText( TextFormat( "Uniforms %i sent  %i skipped", uniforms.issued, uniforms.skipped ), x, y, 10, DARKGRAY );
+    y += 14;
+    const char *sceneState = !Layers.layers[LayerScene].redrawn ? "cached" : SceneReplaying ? "replaying" : SceneRecorded ? "recording" : "live";
+    DrawText( TextFormat( "Replay [P] %s  %s", SceneReplay ? "on" : "off", sceneState ), x, y, 10, DARKGRAY );
+    y += 14;
+    DrawText( TextFormat( "Scene cpu %.3f ms  %i commands", SceneCpuTime*1000.0, SceneRecording.commandCount ), x, y, 10, DARKGRAY );
+    y += 14;
+    DrawText( TextFormat( "Lines %i segments, 1 draw", SceneLines.vertexCount/2 ), x, y, 10, DARKGRAY );
+    y += 14;
+    DrawText( TextFormat( "Curves [C] %s  [V] %s", GpuCurves ? "gpu" : "cpu", GpuCurves ? CurveModeNames[TetherCurveMode] : "lines" ), x, y, 10, DARKGRAY );
+    y += 14;
+    DrawText( TextFormat( "Adaptive [A] %s  %i/%i segments", AdaptiveCurves ? "on" : "off", SplineSegmentsDrawn, SplineSegmentsFixed ), x, y, 10, DARKGRAY );
+    y += 14;
+    DrawText( TextFormat( "Path %i/%i spans evaluated", LayoutPath.evaluatedSpans, LayoutPath.spanCount ), x, y, 10, DARKGRAY );
+    y += 14;
+    int frames = Layers.frameCount;
+    int sceneRedraws = Layers.layers[LayerScene].redrawCount;
+    DrawText( TextFormat( "Frame cache [F] %s  %.1f%% cached", FrameCache ? "on" : "off", ( frames > 0 )? 100.0f*( frames - sceneRedraws )/frames : 0.0f ), x, y, 10, DARKGRAY );
+    y += 14;
+    DrawText( TextFormat( "Redraws scene %i  text %i  ui %i", sceneRedraws, Layers.layers[LayerText].redrawCount, Layers.layers[LayerUi].redrawCount ), x, y, 10, DARKGRAY );
+    y += 14;
+    char effects[7] = { 0 };
+    for ( int i = 0; i < 6; i++ )
+        effects[i] = ( ScenePost.effects & ( 1u << i ) ) ? PostEffectLetters[i] : '-';
+    DrawText( TextFormat( "Post [1-6] %s  [7] %s  [8] 1/%i", effects, ScenePost.fused ? "fused" : "passes", ScenePost.bloomScale ), x, y, 10, DARKGRAY );
+    y += 14;
+    DrawText( TextFormat( "Post gpu bloom %.2f blur %.2f fx %.2f ms", ScenePost.passes[POST_PASS_BLOOM].time*1000.0,
+                          ScenePost.passes[POST_PASS_BLUR].time*1000.0, ScenePost.passes[POST_PASS_COMPOSE].time*1000.0 ), x, y, 10, DARKGRAY );
+    y += 14;
+    DrawText( TextFormat( "Post %.2f Mpixels  cpu %.3f ms", GetPostChainPixels( &ScenePost )/1.0e6, ScenePost.cpuTime*1000.0 ), x, y, 10, DARKGRAY );
+    y += 14;
+    DrawText( TextFormat( "Antialiasing [X] %s", AntialiasNames[Antialias] ), x, y, 10, DARKGRAY );
+    y += 14;
+    CompositorLayer *scene = &Layers.layers[LayerScene];
+    DrawText( TextFormat( "Resolution [J] %s  %.2f  %ix%i", DynamicResolution ? "dynamic" : "native", scene->scale,
+                          scene->viewportWidth, scene->viewportHeight ), x, y, 10, DARKGRAY );
+    y += 14;
+    DrawText( TextFormat( "Gpu %.2f/%.2f ms  %s  %i changes", SceneResolution.average*1000.0f, SceneResolution.budget*1000.0f,
+                          GetResolutionDecisionName( SceneResolution.decision ), SceneResolution.changeCount ), x, y, 10, DARKGRAY );
+    y += 14;
+    DrawText( TextFormat( "Governor [N] %s  rung %i/%i  %s", Governor ? "on" : "off", SceneGovernor.rung, SceneGovernor.rungCount,
+                          GetGovernorDecisionName( SceneGovernor.decision ) ), x, y, 10, DARKGRAY );
+    y += 14;
+    DrawText( TextFormat( "p50 %.2f  p95 %.2f  p99 %.2f ms", SceneGovernor.p50*1000.0f, SceneGovernor.p95*1000.0f, SceneGovernor.p99*1000.0f ), x, y, 10, DARKGRAY );
+    y += 14;
+    DrawText( TextFormat( "Curves %.1f px  lod +%i/%i  %i marks  %i lights", CurveTolerance, SphereLodBias, SphereTessellation,
+                          FlowMarkerCount, ScenePointLightCount ), x, y, 10, DARKGRAY );
+}
+
+// Module benchmarks, run with --bench (results go to the log)
+void RunBenchmarks(void)
+{
+    BenchmarkSceneBvh( 10000, 60 );
+    BenchmarkSceneBvh( 100000, 30 );
+    BenchmarkOcclusionCulling( 50, 50 );
+    BenchmarkOcclusionCulling( 100, 100 );
+    BenchmarkRenderQueue( 1000, 100 );
+    BenchmarkRenderQueue( 10000, 10 );
+    BenchmarkLineBatch( 100000, 30 );
+    BenchmarkCurveEvaluation( 10000, 24, 30 );
+    BenchmarkCurveEvaluation( 100000, 24, 10 );
+    BenchmarkSplineCache( 10000, 30 );
+    BenchmarkArcLengthMarkers( 100000, 60 );
+    BenchmarkLayerCompositor( 2000, 60 );
+    BenchmarkDepthPrepass( 4000, 30 );
+    BenchmarkDeferredShading( 1600, 30 );
+    BenchmarkLightClusters( 256, 60 );
+    BenchmarkLightClusters( 1024, 60 );
+    BenchmarkLightBuffer( 3, 600 );
+    BenchmarkUniformCache( 8, 600 );
+    BenchmarkShaderCache( 10 );
+    BenchmarkLightingVariants( 1600, 30 );
+    BenchmarkPostChain( 1920, 1080, 30 );
+    BenchmarkAntialiasing( 400, 30 );
+    BenchmarkResolutionController( 600 );
+    BenchmarkQualityGovernor( 1800 );
+    BenchmarkOverdrawAnalysis( 8, 30 );
+
+    Shader curveShader = LoadShader( TextFormat( "resources/shaders/glsl%i/curve_instanced.vs", GLSL_VERSION ),
+                                     TextFormat( "resources/shaders/glsl%i/curve_instanced.fs", GLSL_VERSION ) );
+    BenchmarkSplineDrawing( curveShader, 10000, 24, 10 );
+    BenchmarkSplineDrawing( curveShader, 100000, 24, 3 );
+    BenchmarkInstancedCurves( curveShader, 100000, 10 );
+    BenchmarkCurveModes( curveShader, 20000, 30 );
+    UnloadShader( curveShader );
+}
+
+// DrawSplineSegmentBezierCubic3D() per curve vs table evaluation into a line batch vs instanced curves
+void BenchmarkSplineDrawing(Shader curveShader, int curves, int segments, int frames)
+{
+    CurveSet set = LoadCurveSet( curves );
+    LineBatch batch = LoadLineBatch( curves*segments );
+    InstancedCurves instanced = LoadInstancedCurves( curveShader, curves, segments );
+    Vector3 *points = (Vector3 *)RL_MALLOC( curves*( segments + 1 )*sizeof( Vector3 ) );
+
+    for ( int i = 0; i < curves; i++ ) {
+        float x = (float)( i % 100 ) - 50.0f;
+        float z = (float)( i/100 % 100 ) - 50.0f;
+        AddCurveBezierCubic( &set, (Vector3){ x, 10, z }, (Vector3){ x, -5, z }, (Vector3){ 0, -5, 0 }, (Vector3){ 0, 10, 0 } );
+    }
+
+    double drawTime = 0.0, curveTime = 0.0, instancedTime = 0.0;
+
+    for ( int f = 0; f < frames; f++ ) {
+        double start = GetTime();
+        for ( int i = 0; i < curves; i++ ) {
+            const float *const *q = set.planes;
+            DrawSplineSegmentBezierCubic3D( (Vector3){ q[0][i], q[1][i], q[2][i] }, (Vector3){ q[3][i], q[4][i], q[5][i] },
+                                            (Vector3){ q[6][i], q[7][i], q[8][i] }, (Vector3){ q[9][i], q[10][i], q[11][i] }, segments, LIGHTGRAY, false );
+        }
+        rlDrawRenderBatchActive();
+        glFinish();
+        drawTime += GetTime() - start;
+
+        start = GetTime();
+        ClearLineBatch( &batch );
+        EvaluateCurveSet( &set, segments, points );
+        for ( int i = 0; i < curves; i++ )
+            AddLineBatchStrip( &batch, points + i*( segments + 1 ), segments + 1, LIGHTGRAY );
+        DrawLineBatch( &batch );
+        glFinish();
+        curveTime += GetTime() - start;
+
+        start = GetTime();
+        ClearInstancedCurves( &instanced );
+        for ( int i = 0; i < curves; i++ ) {
+            const float *const *q = set.planes;
+            AddInstancedCurve( &instanced, (Vector3){ q[0][i], q[1][i], q[2][i] }, (Vector3){ q[3][i], q[4][i], q[5][i] },
+                               (Vector3){ q[6][i], q[7][i], q[8][i] }, (Vector3){ q[9][i], q[10][i], q[11][i] }, 1.0f, LIGHTGRAY );
+        }
+        DrawInstancedCurves( &instanced );
+        glFinish();
+        instancedTime += GetTime() - start;
+    }
 
-            if ( ElementModels ) {
-                DrawModel( GameSphere, points[ 0 ], 0.2f, LIGHTGRAY );
-                DrawModel( GameCube, points[ 3 ], 0.2f, LIGHTGRAY );
+    TraceLog( LOG_INFO, "SPLINES: %i curves x %i segments: DrawSplineSegmentBezierCubic3D %.3f ms, curve set + line batch %.3f ms, instanced %.3f ms",
+              curves, segments, drawTime*1000.0/frames, curveTime*1000.0/frames, instancedTime*1000.0/frames );
+
+    RL_FREE( points );
+    UnloadInstancedCurves( &instanced );
+    UnloadLineBatch( &batch );
+    UnloadCurveSet( &set );
+}
+
+// Frame time of lines, ribbons and tubes for a dashboard sized edge set, GPU included
+void BenchmarkCurveModes(Shader curveShader, int curves, int frames)
+{
+    Camera camera = { { 0.0f, 60.0f, 120.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, 45.0f, CAMERA_PERSPECTIVE };
+    InstancedCurves instanced = LoadInstancedCurves( curveShader, curves, SPLINE_FIXED_SEGMENTS );
+    double time[3] = { 0 };
+
+    for ( int mode = 0; mode < 3; mode++ ) {
+        SetInstancedCurvesMode( &instanced, mode );
+
+        for ( int f = 0; f < frames; f++ ) {
+            double start = GetTime();
+            ClearInstancedCurves( &instanced );
+            for ( int i = 0; i < curves; i++ ) {
+                float angle = 2.0f*PI*i/curves;
+                Vector3 a = { 50.0f*cosf( angle ), 0.0f, 50.0f*sinf( angle ) };
+                Vector3 b = { 50.0f*cosf( 7.0f*angle + 0.01f*f ), 0.0f, 50.0f*sinf( 7.0f*angle + 0.01f*f ) };
+                float width = ( mode == CURVE_MODE_LINES ) ? 1.0f + ( i % 4 ) : 0.05f + 0.05f*( i % 4 );
+                AddInstancedCurve( &instanced, a, (Vector3){ a.x, 20.0f, a.z }, (Vector3){ b.x, 20.0f, b.z }, b, width, LIGHTGRAY );
             }
+            BeginMode3D( camera );
+            DrawInstancedCurves( &instanced );
+            EndMode3D();
+            glFinish();
+            time[mode] += GetTime() - start;
+        }
+    }
 
-            // DrawSplineSegmentBezierCubic3D( points[0], points[1], points[2], points[3], 24, LIGHTGRAY, false );
+    TraceLog( LOG_INFO, "CURVE MODES: %i curves x %i segments: lines %.3f ms, ribbons %.3f ms, tubes %.3f ms (60 FPS budget 16.7 ms)",
+              curves, SPLINE_FIXED_SEGMENTS, time[0]*1000.0/frames, time[1]*1000.0/frames, time[2]*1000.0/frames );
+
+    UnloadInstancedCurves( &instanced );
+}
+
+// Depth pre-pass benchmark scene, read by its draw callbacks
+Model PrepassBenchCube;
+Shader PrepassBenchDepth;
+Vector3 *PrepassBenchPositions;
+
+void DrawPrepassBenchCube(int data)
+{
+    DrawModel( PrepassBenchCube, PrepassBenchPositions[data], 1.0f, WHITE );
+}
 
-            if ( ElementLines ) {
-                points[ 2 ] = spherePosition;
-                points[ 2 ].y -= 15;
-                points[ 3 ] = spherePosition;
-                DrawSplineSegmentBezierCubic3D( points[0], points[1], points[2], points[3], 24, LIGHTGRAY, false );
+void DrawPrepassBenchCubeDepth(int data)
+{
+    DrawModelShader( PrepassBenchCube, PrepassBenchDepth, PrepassBenchPositions[data], 1.0f, WHITE );
+}
+
+// Overlapping layers of lit cubes, submitted back to front, with and without the depth pre-pass
+void BenchmarkDepthPrepass(int cubes, int frames)
+{
+    Camera camera = { { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 1.0f, 0.0f }, 60.0f, CAMERA_PERSPECTIVE };
+    ShaderVariants lightingVariants = LoadShaderVariants( NULL, GLSL_VERSION, "resources/shaders/variants/lighting.vs",
+                                                          "resources/shaders/variants/lighting.fs", LightingFeatures, LightingFeatureCount );
+    ShaderVariants depthVariants = LoadShaderVariants( NULL, GLSL_VERSION, "resources/shaders/variants/lighting.vs",
+                                                       "resources/shaders/variants/depth_prepass.fs", LightingFeatures, LightingFeatureCount );
+    lightingVariants.setup = SetupLightingVariant;
+    Shader lighting = GetShaderVariant( &lightingVariants, 0xF );       // All four lights
+    PrepassBenchDepth = GetShaderVariant( &depthVariants, 0 );
+
+    LightBuffer lights = LoadLightBuffer();
+    CreateBufferLight( &lights, LIGHT_POINT, (Vector3){ 0, 8, 20 }, Vector3Zero(), WHITE );
+    CreateBufferLight( &lights, LIGHT_POINT, (Vector3){ 32, 32, 32 }, Vector3Zero(), RED );
+    CreateBufferLight( &lights, LIGHT_POINT, (Vector3){ -32, 32, 32 }, Vector3Zero(), GREEN );
+    CreateBufferLight( &lights, LIGHT_POINT, (Vector3){ 32, 32, -32 }, Vector3Zero(), BLUE );
+    UpdateLightBuffer( &lights );
+
+    PrepassBenchCube = LoadModelFromMesh( GenMeshCube( 2.0f, 2.0f, 2.0f ) );
+    PrepassBenchCube.materials[0].shader = lighting;
+
+    // 20 x 20 cubes per layer, far layers first
+    int layers = cubes/400;
+    PrepassBenchPositions = (Vector3 *)RL_MALLOC( layers*400*sizeof( Vector3 ) );
+    for ( int i = 0; i < layers*400; i++ ) {
+        int layer = layers - 1 - i/400;
+        PrepassBenchPositions[i] = (Vector3){ -19.0f + 2.0f*( i % 20 ), -19.0f + 2.0f*( i/20 % 20 ), 30.0f + 3.0f*layer };
+    }
+
+    RenderQueue queue = LoadRenderQueue( layers*400 );
+    double time[4] = { 0 };
+    Shader none = { 0 };
+
+    for ( int mode = 0; mode < 4; mode++ ) {
+        queue.sorted = ( mode >= 2 );
+        queue.depthPrepass = ( mode % 2 == 1 );
+
+        for ( int f = 0; f < frames; f++ ) {
+            double start = GetTime();
+            ClearBackground( RAYWHITE );
+            BeginMode3D( camera );
+            BeginRenderQueue( &queue, camera.position, 100.0f );
+            for ( int i = 0; i < layers*400; i++ ) {
+                PushRenderItem( &queue, RENDER_LAYER_OPAQUE, BLEND_ALPHA, none, 0, PrepassBenchPositions[i], DrawPrepassBenchCube, i );
+                SetRenderItemDepthDraw( &queue, DrawPrepassBenchCubeDepth );
             }
+            ExecuteRenderQueue( &queue );
+            EndMode3D();
+            glFinish();
+            time[mode] += GetTime() - start;
         }
+    }
 
-        if ( ElementModels ) {
+    TraceLog( LOG_INFO, "DEPTH PREPASS: %i cubes in %i layers, 4 lights: submission order %.3f ms, with pre-pass %.3f ms, front to back %.3f ms, with pre-pass %.3f ms",
+              layers*400, layers, time[0]*1000.0/frames, time[1]*1000.0/frames, time[2]*1000.0/frames, time[3]*1000.0/frames );
 
-            Vector3 modelPosition = (Vector3){ 20.0f*sin(cycle), 0.0f, -20.0f*cos(cycle) };
-            DrawModel( GameModel, modelPosition, 1.5f, WHITE);        // Draw 3d model with texture
+    UnloadRenderQueue( &queue );
+    RL_FREE( PrepassBenchPositions );
+    UnloadModel( PrepassBenchCube );
+    UnloadLightBuffer( &lights );
+    UnloadShaderVariants( &lightingVariants );
+    UnloadShaderVariants( &depthVariants );
+}
 
-            modelPosition.y += 8;
-            DrawModel( GameEsp32, modelPosition, 0.1f, WHITE);        // Draw 3d model with texture
+// Lit cube grid under 4, 64 and 256 point lights, forward with one pass per 4 lights vs deferred
+void BenchmarkDeferredShading(int cubes, int frames)
+{
+    Camera camera = { { 0.0f, 45.0f, 35.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, 60.0f, CAMERA_PERSPECTIVE };
+    ShaderVariants lightingVariants = LoadShaderVariants( NULL, GLSL_VERSION, "resources/shaders/variants/lighting.vs",
+                                                          "resources/shaders/variants/lighting.fs", LightingFeatures, LightingFeatureCount );
+    lightingVariants.setup = SetupLightingVariant;
+    Shader lighting = GetShaderVariant( &lightingVariants, 0xF );       // All four light slots
+    Shader gbuffer = LoadShader( TextFormat( "resources/shaders/glsl%i/gbuffer.vs", GLSL_VERSION ),
+                                 TextFormat( "resources/shaders/glsl%i/gbuffer.fs", GLSL_VERSION ) );
+    Shader shading = LoadShader( TextFormat( "resources/shaders/glsl%i/deferred_shading.vs", GLSL_VERSION ),
+                                 TextFormat( "resources/shaders/glsl%i/deferred_shading.fs", GLSL_VERSION ) );
+    Shader volumes = LoadShader( TextFormat( "resources/shaders/glsl%i/deferred_light.vs", GLSL_VERSION ),
+                                 TextFormat( "resources/shaders/glsl%i/deferred_light.fs", GLSL_VERSION ) );
+    DeferredRenderer renderer = LoadDeferredRenderer( shading, volumes, 256 );
+
+    // A forward pass takes 4 lights, the slots are refilled for each pass
+    LightBuffer buffer = LoadLightBuffer();
+    Light lights[4];
+    for ( int i = 0; i < 4; i++ )
+        lights[i] = CreateBufferLight( &buffer, LIGHT_POINT, Vector3Zero(), Vector3Zero(), WHITE );
+    SetBufferAmbient( &buffer, (Vector4){ 1.0f, 1.0f, 1.0f, 1.0f } );
+
+    Model cube = LoadModelFromMesh( GenMeshCube( 1.6f, 1.6f, 1.6f ) );
+    int side = (int)sqrtf( (float)cubes );
+    const int lightCounts[3] = { 4, 64, 256 };
+    double forward[3] = { 0 };
+    double deferred[3] = { 0 };
+
+    for ( int c = 0; c < 3; c++ ) {
+        int count = lightCounts[c];
+        ClearDeferredLights( &renderer );
+        for ( int i = 0; i < count; i++ ) {
+            Vector3 position = { (float)GetRandomValue( -side, side ), 1.5f, (float)GetRandomValue( -side, side ) };
+            AddDeferredLight( &renderer, position, 6.0f, ColorFromHSV( 360.0f*i/count, 0.7f, 1.0f ) );
+        }
 
-            modelPosition.y += 10;
-            DrawModel( GameStl, modelPosition, 0.1f, RED);        // Draw 3d model with texture
+        cube.materials[0].shader = lighting;
+        for ( int f = 0; f < frames; f++ ) {
+            double start = GetTime();
+            ClearBackground( RAYWHITE );
+            BeginMode3D( camera );
+            for ( int pass = 0; pass < count/4; pass++ ) {
+                for ( int i = 0; i < 4; i++ ) {
+                    lights[i].position = renderer.lights[pass*4 + i].position;
+                    lights[i].color = renderer.lights[pass*4 + i].color;
+                    SetBufferLight( &buffer, i, lights[i] );
+                }
+                UpdateLightBuffer( &buffer );
+                if ( pass == 1 ) BeginBlendMode( BLEND_ADDITIVE );      // Later passes add over the same depth
+                for ( int i = 0; i < side*side; i++ )
+                    DrawModel( cube, (Vector3){ -side + 2.0f*( i % side ), 0.0f, -side + 2.0f*( i/side ) }, 1.0f, WHITE );
+            }
+            if ( count > 4 ) EndBlendMode();
+            EndMode3D();
+            glFinish();
+            forward[c] += GetTime() - start;
         }
 
-        if ( ElementLines ) {
-            DrawGrid( 20, 10.0f );        // Draw a grid
+        cube.materials[0].shader = gbuffer;
+        for ( int f = 0; f < frames; f++ ) {
+            double start = GetTime();
+            ClearBackground( RAYWHITE );
+            BeginMode3D( camera );
+            BeginDeferredGeometry( &renderer );
+            for ( int i = 0; i < side*side; i++ )
+                DrawModel( cube, (Vector3){ -side + 2.0f*( i % side ), 0.0f, -side + 2.0f*( i/side ) }, 1.0f, WHITE );
+            EndDeferredGeometry( &renderer );
+            DrawDeferredLighting( &renderer, camera.position );
+            EndMode3D();
+            glFinish();
+            deferred[c] += GetTime() - start;
         }
+    }
 
-    EndMode3D();
-                
-    if ( ElementText) {
-        BeginShaderMode( FontShader);    // Activate SDF font shader
-            DrawTextEx(FontSDF, "VISUALIZATION DEMO", pos, font.baseSize*3.0f, 4, MAROON);
-        EndShaderMode();
+    TraceLog( LOG_INFO, "DEFERRED: %i cubes, 4/64/256 point lights: forward %.3f/%.3f/%.3f ms (a pass per 4 lights), deferred %.3f/%.3f/%.3f ms",
+              side*side, forward[0]*1000.0/frames, forward[1]*1000.0/frames, forward[2]*1000.0/frames,
+              deferred[0]*1000.0/frames, deferred[1]*1000.0/frames, deferred[2]*1000.0/frames );
+
+    cube.materials[0].shader = lighting;
+    UnloadModel( cube );
+    UnloadDeferredRenderer( &renderer );
+    UnloadLightBuffer( &buffer );
+    ClearShaderValueCache( shading );
+    ClearShaderValueCache( volumes );
+    UnloadShaderVariants( &lightingVariants );
+    UnloadShader( gbuffer );
+    UnloadShader( shading );
+    UnloadShader( volumes );
+}
+
+// viewPos and colDiffuse of lighting shaders set every frame, through SetShaderValue() and the uniform cache
+void BenchmarkUniformCache(int shaders, int frames)
+{
+    // Separate programs of the same variant, each has its own cached values
+    char *vsSource = LoadFileText( "resources/shaders/variants/lighting.vs" );
+    char *fsSource = LoadFileText( "resources/shaders/variants/lighting.fs" );
+    char *vsCode = GenShaderVariantCode( vsSource, GLSL_VERSION, false, LightingFeatures, LightingFeatureCount, 0xF );
+    char *fsCode = GenShaderVariantCode( fsSource, GLSL_VERSION, true, LightingFeatures, LightingFeatureCount, 0xF );
+    Shader *list = (Shader *)RL_MALLOC( shaders*sizeof( Shader ) );
+    for ( int s = 0; s < shaders; s++ ) {
+        list[s] = LoadShaderFromMemory( vsCode, fsCode );
+        SetupLightingVariant( &list[s], 0xF );
+    }
+    RL_FREE( vsCode );
+    RL_FREE( fsCode );
+    UnloadFileText( vsSource );
+    UnloadFileText( fsSource );
+
+    // Unchanged values, then a camera moving every frame
+    double time[4] = { 0 };
+    EndUniformCacheFrame();     // Count this benchmark alone
+    for ( int mode = 0; mode < 4; mode++ ) {
+        bool cached = ( mode % 2 == 1 );
+        bool moving = ( mode >= 2 );
+
+        for ( int f = 0; f < frames; f++ ) {
+            Vector3 view = { 10.0f, 20.0f, moving ? (float)f : 30.0f };
+            Vector4 color = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+            double start = GetTime();
+            for ( int s = 0; s < shaders; s++ ) {
+                if ( cached ) {
+                    SetShaderValueCached( list[s], list[s].locs[SHADER_LOC_VECTOR_VIEW], &view, SHADER_UNIFORM_VEC3 );
+                    SetShaderValueCached( list[s], list[s].locs[SHADER_LOC_COLOR_DIFFUSE], &color, SHADER_UNIFORM_VEC4 );
+                } else {
+                    SetShaderValue( list[s], list[s].locs[SHADER_LOC_VECTOR_VIEW], &view, SHADER_UNIFORM_VEC3 );
+                    SetShaderValue( list[s], list[s].locs[SHADER_LOC_COLOR_DIFFUSE], &color, SHADER_UNIFORM_VEC4 );
+                }
+            }
+            time[mode] += GetTime() - start;
+        }
     }
+    EndUniformCacheFrame();
+    UniformCacheStats counts = GetUniformCacheStats();
 
-    if ( ElementUi ) {
-        BeginShaderMode( FontShader);    // Activate SDF font shader
+    TraceLog( LOG_INFO, "UNIFORMS: %i shaders, 2 uniforms: unchanged %.4f ms, cached %.4f ms; moving %.4f ms, cached %.4f ms (%i sent, %i skipped)",
+              shaders, time[0]*1000.0/frames, time[1]*1000.0/frames, time[2]*1000.0/frames, time[3]*1000.0/frames, counts.issued, counts.skipped );
 
-            // GuiDrawRectangle( (Rectangle){ 5, 115, 410, 290 }, 1, WHITE, WHITE );
-            GuiPanel( (Rectangle){ 20, 70, 340, 410 }, 0 );
-            // GuiGroupBox( (Rectangle){ 10, 120, 400, 200 }, "Viz Control" );
+    for ( int s = 0; s < shaders; s++ ) {
+        ClearShaderValueCache( list[s] );
+        UnloadShader( list[s] );
+    }
+    RL_FREE( list );
+}
 
-            GuiSetStyle( DEFAULT, TEXT_ALIGNMENT, TEXT_ALIGN_RIGHT );
-            GuiLabel((Rectangle){ 35, 80, 90, 32 }, "Layout");
-            GuiLabel((Rectangle){ 35, 120, 90, 32 }, "Run");
-            GuiLabel((Rectangle){ 35, 160, 90, 32 }, "FPS" );
-            GuiLabel((Rectangle){ 35, 240, 90, 32 }, "Lights" );
-            GuiLabel((Rectangle){ 35, 280, 90, 32 }, "Element" );
-            GuiSetStyle( DEFAULT, TEXT_ALIGNMENT, TEXT_ALIGN_CENTER );
+// Lighting shader loaded from source vs from its program binary, the first cached load may compile and store it
+void BenchmarkShaderCache(int loads)
+{
+    // Variant with all four lights
+    char *vsSource = LoadFileText( "resources/shaders/variants/lighting.vs" );
+    char *fsSource = LoadFileText( "resources/shaders/variants/lighting.fs" );
+    char *vsCode = GenShaderVariantCode( vsSource, GLSL_VERSION, false, LightingFeatures, LightingFeatureCount, 0xF );
+    char *fsCode = GenShaderVariantCode( fsSource, GLSL_VERSION, true, LightingFeatures, LightingFeatureCount, 0xF );
+    ShaderCache cache = LoadShaderCache( "shader_cache" );
+
+    Shader first = LoadShaderCodeCached( &cache, vsCode, fsCode );
+    UnloadShader( first );
+    double firstTime = cache.compileTime + cache.cacheTime;
+
+    double compile = 0.0;
+    for ( int i = 0; i < loads; i++ ) {
+        double start = GetTime();
+        Shader shader = LoadShaderFromMemory( vsCode, fsCode );
+        compile += GetTime() - start;
+        UnloadShader( shader );
+    }
 
-            GuiComboBox((Rectangle){ 130, 80, 200, 32 }, "LayoutA;LayoutB", &Layout);
+    cache.cacheTime = 0.0;
+    cache.cachedCount = 0;
+    for ( int i = 0; i < loads; i++ ) {
+        Shader shader = LoadShaderCodeCached( &cache, vsCode, fsCode );
+        UnloadShader( shader );
+    }
+    RL_FREE( vsCode );
+    RL_FREE( fsCode );
+    UnloadFileText( vsSource );
+    UnloadFileText( fsSource );
+
+    TraceLog( LOG_INFO, "SHADER CACHE: lighting shader, first load %.2f ms (%s), compiled %.2f ms, from binary %.2f ms (%i of %i cached)",
+              firstTime*1000.0, ( cache.compiledCount > 0 )? "compiled" : "cached", compile*1000.0/loads,
+              ( cache.cachedCount > 0 )? cache.cacheTime*1000.0/cache.cachedCount : 0.0, cache.cachedCount, loads );
+}
 
-            GuiSetIconScale(1);
+// Lit cube grid with one and with four lights on, shaded by the variant of the enabled lights vs
+// the branching baseline (every light behind a branch on its enabled uniform, as before variants)
+void BenchmarkLightingVariants(int cubes, int frames)
+{
+    Camera camera = { { 0.0f, 45.0f, 35.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, 60.0f, CAMERA_PERSPECTIVE };
+    ShaderVariants variants = LoadShaderVariants( NULL, GLSL_VERSION, "resources/shaders/variants/lighting.vs",
+                                                  "resources/shaders/variants/lighting.fs", LightingFeatures, LightingFeatureCount );
+    variants.setup = SetupLightingVariant;
+
+    // Baseline from the same source, LIGHT_BRANCHES is not a feature of the app's masks
+    const char *branchFeatures[] = { "LIGHT_BRANCHES" };
+    char *vsCode = GenShaderVariantCode( variants.vsCode, GLSL_VERSION, false, branchFeatures, 1, 0 );
+    char *fsCode = GenShaderVariantCode( variants.fsCode, GLSL_VERSION, true, branchFeatures, 1, 1 );
+    Shader branching = LoadShaderFromMemory( vsCode, fsCode );
+    SetupLightingVariant( &branching, 0 );
+    RL_FREE( vsCode );
+    RL_FREE( fsCode );
+
+    // Variants of one and of four lights, first use of a mask generates and compiles it
+    const unsigned int masks[2] = { LIGHTING_LIGHT_0, 0xF };
+    Shader shaders[2];
+    for ( int v = 0; v < 2; v++ )
+        shaders[v] = GetShaderVariant( &variants, masks[v] );
+
+    LightBuffer buffer = LoadLightBuffer();
+    const Vector3 positions[4] = { { 0.0f, 8.0f, 20.0f }, { 20.0f, 8.0f, 0.0f }, { -20.0f, 8.0f, 0.0f }, { 0.0f, 8.0f, -20.0f } };
+    Light lights[4];
+    for ( int i = 0; i < 4; i++ )
+        lights[i] = CreateBufferLight( &buffer, LIGHT_POINT, positions[i], Vector3Zero(), WHITE );
+    SetBufferAmbient( &buffer, (Vector4){ 1.0f, 1.0f, 1.0f, 1.0f } );
+
+    Model cube = LoadModelFromMesh( GenMeshCube( 1.6f, 1.6f, 1.6f ) );
+    int side = (int)sqrtf( (float)cubes );
+    double time[2][2] = { 0 };      // [lights 1/4][branching/variant]
+
+    for ( int l = 0; l < 2; l++ ) {
+        for ( int i = 1; i < 4; i++ ) {
+            lights[i].enabled = ( l == 1 );
+            SetBufferLight( &buffer, i, lights[i] );
+        }
+        UpdateLightBuffer( &buffer );
+
+        for ( int v = 0; v < 2; v++ ) {
+            cube.materials[0].shader = ( v == 0 )? branching : shaders[l];
+            for ( int f = 0; f < frames; f++ ) {
+                double start = GetTime();
+                ClearBackground( RAYWHITE );
+                BeginMode3D( camera );
+                for ( int i = 0; i < side*side; i++ )
+                    DrawModel( cube, (Vector3){ -side + 2.0f*( i % side ), 0.0f, -side + 2.0f*( i/side ) }, 1.0f, WHITE );
+                EndMode3D();
+                glFinish();
+                time[l][v] += GetTime() - start;
+            }
+        }
+    }
+
+    TraceLog( LOG_INFO, "LIGHTING VARIANTS: %i cubes, branching vs variant: 1 light on %.3f vs %.3f ms, 4 lights on %.3f vs %.3f ms",
+              side*side, time[0][0]*1000.0/frames, time[0][1]*1000.0/frames, time[1][0]*1000.0/frames, time[1][1]*1000.0/frames );
+
+    UnloadModel( cube );
+    UnloadShader( branching );
+    UnloadLightBuffer( &buffer );
+    UnloadShaderVariants( &variants );
+}
 
-            GuiToggleSlider( (Rectangle){ 130, 120, 200, 32 }, "Static;Dynamic", &Dynamic );
+// Bloom, blur and four per pixel effects over a 1080p image: blurs at full, half and quarter resolution
+// with an effect per pass, then quarter resolution with the effects fused
+void BenchmarkPostChain(int width, int height, int frames)
+{
+    PostChain chain = LoadPostChain( NULL, GLSL_VERSION, "resources/shaders/variants/post_blur.fs",
+                                     "resources/shaders/variants/post_compose.fs" );
+    chain.effects = POST_EFFECT_EDGES | POST_EFFECT_BLUR | POST_EFFECT_BLOOM | POST_EFFECT_GRAYSCALE | POST_EFFECT_POSTERIZE | POST_EFFECT_VIGNETTE;
+
+    // Bright squares over a gray background, something to bloom and edges to find
+    RenderTexture2D image = LoadRenderTexture( width, height );
+    BeginTextureMode( image );
+        ClearBackground( GRAY );
+        for ( int i = 0; i < 64; i++ )
+            DrawRectangle( ( i % 8 )*width/8 + 20, ( i/8 )*height/8 + 20, width/16, height/16, ColorFromHSV( 45.0f*( i % 8 ), 0.5f, 1.0f ) );
+    EndTextureMode();
 
-            int fps = GetFPS();
-            GuiValueBox((Rectangle){ 130, 160, 200, 32 }, 0, &fps, 0, 1000, false );
+    const int scales[4] = { 1, 2, 4, 4 };
+    double time[4] = { 0 };
+    int pixels[4] = { 0 };
+
+    for ( int mode = 0; mode < 4; mode++ ) {
+        chain.bloomScale = scales[mode];
+        chain.blurScale = scales[mode];
+        chain.fused = ( mode == 3 );
+        ApplyPostChain( &chain, image.texture );      // Targets and variants load outside the timing
+        glFinish();
+
+        for ( int f = 0; f < frames; f++ ) {
+            double start = GetTime();
+            ApplyPostChain( &chain, image.texture );
+            glFinish();
+            time[mode] += GetTime() - start;
+        }
+        pixels[mode] = GetPostChainPixels( &chain );
+    }
 
-            GuiComboBox((Rectangle){ 130, 200, 200, 32 }, "10;30;60;120;160;220", &FrameRateIndex );
+    TraceLog( LOG_INFO, "POST: %ix%i, bloom, blur and 4 effects: passes with blurs at full %.3f ms, half %.3f ms, quarter %.3f ms, quarter fused %.3f ms (%.1f/%.1f/%.1f/%.1f Mpixels)",
+              width, height, time[0]*1000.0/frames, time[1]*1000.0/frames, time[2]*1000.0/frames, time[3]*1000.0/frames,
+              pixels[0]/1.0e6, pixels[1]/1.0e6, pixels[2]/1.0e6, pixels[3]/1.0e6 );
 
-            GuiToggle( (Rectangle){ 130, 240, 30, 32 }, "W", &Lights[0].enabled );
-            GuiToggle( (Rectangle){ 170, 240, 30, 32 }, "R", &Lights[1].enabled );
-            GuiToggle( (Rectangle){ 210, 240, 30, 32 }, "G", &Lights[2].enabled );
-            GuiToggle( (Rectangle){ 250, 240, 30, 32 }, "B", &Lights[3].enabled );
-            GuiToggle( (Rectangle){ 290, 240, 30, 32 }, "A", &AmbientLight );
-            for ( int i = 0; i < 4; i++ )
-                InstancingLights[i].enabled=Lights[i].enabled;
+    UnloadRenderTexture( image );
+    UnloadPostChain( &chain );
+}
 
-            GuiToggle( (Rectangle){ 130, 280, 200, 32 }, "Lines", &ElementLines );
-            GuiToggle( (Rectangle){ 130, 320, 200, 32 }, "Models", &ElementModels );
-            GuiToggle( (Rectangle){ 130, 360, 200, 32 }, "Text", &ElementText );
-            GuiToggle( (Rectangle){ 130, 400, 200, 32 }, "UI", &ElementUi );
-            GuiToggle( (Rectangle){ 130, 440, 200, 32 }, "Erase", &ElementErase );
+// Antialiasing benchmark scene and post chain, read by the compositor callbacks
+int AntialiasBenchCubes;
+PostChain AntialiasBenchPost;
 
-        EndShaderMode();
+void DrawAntialiasBenchScene(void)
+{
+    Camera camera = { { 0.0f, 30.0f, 40.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, 60.0f, CAMERA_PERSPECTIVE };
+    int side = (int)sqrtf( (float)AntialiasBenchCubes );
+
+    BeginMode3D( camera );
+    for ( int i = 0; i < side*side; i++ ) {
+        Vector3 position = { -side + 2.0f*( i % side ), 0.0f, -side + 2.0f*( i/side ) };
+        DrawCube( position, 1.2f, 1.2f, 1.2f, ColorFromHSV( 360.0f*i/( side*side ), 0.6f, 0.9f ) );
+        DrawCubeWires( position, 1.2f, 1.2f, 1.2f, DARKGRAY );
     }
+    EndMode3D();
 }
 
-// Gameplay Screen Unload logic
-void UnloadGameplayScreen(void)
+Texture2D ApplyAntialiasBenchPost(Texture2D image)
 {
-    // TODO: Unload GAMEPLAY screen variables here!
+    return ApplyPostChain( &AntialiasBenchPost, image );
+}
+
+// Frame time of a redrawn scene layer with each antialiasing mode, at the window size
+void BenchmarkAntialiasing(int cubes, int frames)
+{
+    LayerCompositor compositor = LoadLayerCompositor();
+    int layer = AddCompositorLayer( &compositor, DrawAntialiasBenchScene, COMPOSITOR_LAYER_MSAA, RAYWHITE, 0.0f );
+    AntialiasBenchPost = LoadPostChain( NULL, GLSL_VERSION, "resources/shaders/variants/post_blur.fs",
+                                        "resources/shaders/variants/post_compose.fs" );
+    SetCompositorLayerPost( &compositor, layer, ApplyAntialiasBenchPost );
+    AntialiasBenchCubes = cubes;
+
+    double time[4] = { 0 };
+    for ( int mode = 0; mode < 4; mode++ ) {
+        SetCompositorSamples( &compositor, ( mode == ANTIALIAS_MSAA_2X ) ? 2 : ( mode == ANTIALIAS_MSAA_4X ) ? 4 : 0 );
+        AntialiasBenchPost.effects = ( mode == ANTIALIAS_FXAA ) ? POST_EFFECT_FXAA : 0;
+
+        // First frame loads the targets and the FXAA variant
+        for ( int f = 0; f <= frames; f++ ) {
+            BeginDrawing();
+            double start = GetTime();
+            InvalidateCompositorLayer( &compositor, layer );
+            UpdateLayerCompositor( &compositor );
+            DrawLayerCompositor( &compositor );
+            rlDrawRenderBatchActive();
+            glFinish();
+            if ( f > 0 )
+                time[mode] += GetTime() - start;
+            EndDrawing();
+        }
+    }
+
+    TraceLog( LOG_INFO, "ANTIALIAS: %ix%i, %i cubes redrawn: none %.3f ms, MSAA 2x %.3f ms, MSAA 4x %.3f ms, FXAA %.3f ms",
+              GetRenderWidth(), GetRenderHeight(), cubes, time[0]*1000.0/frames, time[1]*1000.0/frames, time[2]*1000.0/frames, time[3]*1000.0/frames );
+
+    UnloadPostChain( &AntialiasBenchPost );
+    UnloadLayerCompositor( &compositor );
 }
 
 // Gameplay Screen should finish?
@@ -951,9 +2771,25 @@ static Vector3 MeasureText3D(Font font, const char* text, float fontSize, float
 // }
 
 
+// Segments for a cubic bezier on screen, CurveTolerance pixels from the curve at most
+int GetSplineSegments3D(Vector3 p1, Vector3 c2, Vector3 c3, Vector3 p4)
+{
+    if ( !AdaptiveCurves )
+        return SPLINE_FIXED_SEGMENTS;
+
+    return GetCurveSegmentsScreen( SceneViewProj, GetScreenWidth(), GetScreenHeight(), p1, c2, c3, p4, CurveTolerance );
+}
+
 // Draw spline segment: Cubic Bezier, 2 points, 2 control points
+// NOTE: segments <= 0 picks the count from the screen size of the curve
 void DrawSplineSegmentBezierCubic3D(Vector3 p1, Vector3 c2, Vector3 c3, Vector3 p4, int segments, Color color, bool debugIt )
 {
+    if ( segments <= 0 )
+        segments = GetSplineSegments3D( p1, c2, c3, p4 );
+
+    SplineSegmentsDrawn += segments;
+    SplineSegmentsFixed += SPLINE_FIXED_SEGMENTS;
+
     const float step = 1.0f/segments;
 
     Vector3 previous = p1;
@@ -995,19 +2831,12 @@ void DrawSplineBasis3D(Vector3 *points, int pointCount, Color color)
     float a[4] = { 0 };
     float b[4] = { 0 };
     float c[4] = { 0 };
-    // float dy = 0.0f;
-    // float dx = 0.0f;
-    // float dz = 0.0f;
-    // float size = 0.0f;
 
     Vector3 currentPoint = { 0 };
     Vector3 nextPoint = { 0 };
-    // Vector3 vertices[2*SPLINE_SEGMENT_DIVISIONS + 2] = { 0 };
 
     for (int i = 0; i < (pointCount - 3); i++)
     {
-        float t = 0.0f;
-
         Vector3 p1 = points[i], p2 = points[i + 1], p3 = points[i + 2], p4 = points[i + 3];
 
         a[0] = (-p1.x + 3.0f*p2.x - 3.0f*p3.x + p4.x)/6.0f;
@@ -1025,14 +2854,29 @@ void DrawSplineBasis3D(Vector3 *points, int pointCount, Color color)
         c[2] = (-3.0f*p1.z + 3.0f*p3.z)/6.0f;
         c[3] = (p1.z + 4.0f*p2.z + p3.z)/6.0f;
 
-        nextPoint.x = a[3];
-        nextPoint.y = b[3];
-        nextPoint.z = c[3];
+        // Same segment as a bezier, for the segment count
+        Vector3 b1 = Vector3Scale( Vector3Add( Vector3Add( p1, Vector3Scale( p2, 4.0f ) ), p3 ), 1.0f/6.0f );
+        Vector3 b2 = Vector3Scale( Vector3Add( Vector3Scale( p2, 4.0f ), Vector3Scale( p3, 2.0f ) ), 1.0f/6.0f );
+        Vector3 b3 = Vector3Scale( Vector3Add( Vector3Scale( p2, 2.0f ), Vector3Scale( p3, 4.0f ) ), 1.0f/6.0f );
+        Vector3 b4 = Vector3Scale( Vector3Add( Vector3Add( p2, Vector3Scale( p3, 4.0f ) ), p4 ), 1.0f/6.0f );
+        int segments = GetSplineSegments3D( b1, b2, b3, b4 );
+
+        SplineSegmentsDrawn += segments;
+        SplineSegmentsFixed += SPLINE_FIXED_SEGMENTS;
+
+        currentPoint = (Vector3){ a[3], b[3], c[3] };
+
+        for (int j = 1; j <= segments; j++)
+        {
+            float t = (float)j/segments;
+
+            nextPoint.x = ((a[0]*t + a[1])*t + a[2])*t + a[3];
+            nextPoint.y = ((b[0]*t + b[1])*t + b[2])*t + b[3];
+            nextPoint.z = ((c[0]*t + c[1])*t + c[2])*t + c[3];
 
-        if (i > 0){
             DrawLine3D( currentPoint, nextPoint, color );
-        }
 
-        currentPoint = nextPoint;
+            currentPoint = nextPoint;
+        }
     }
 }
@@ -0,0 +1,736 @@
+/**********************************************************************************************
+*
+*   render_queue - Sorted render queue keyed by layer, blend mode, shader, material and depth
+*
+*   Draw calls are recorded as items with a 64 bit sort key and executed in key order, so shader,
+*   blend and material switches happen once per group instead of once per code block. Opaque
+*   items sort by state first and front-to-back inside a state group (cheap early depth reject),
+*   transparent items sort back-to-front first for correct blending, overlay items keep their
+*   submission order.
+*
+*   KEY LAYOUT (most significant first):
+*
+*       opaque:         layer(2) | blend(3) | shader(10) | material(16) | depth(24)
+*       transparent:    layer(2) | inverted depth(24) | blend(3) | shader(10) | material(16)
+*       overlay:        layer(2) | submission order
+*
+*   DEPTH PRE-PASS:
+*
+*   Opaque items given a depth draw (SetRenderItemDepthDraw()) can be drawn twice when the queue
+*   depthPrepass flag is set: first all of them through their depth draw with color writes off,
+*   then shaded with an equal depth test and depth writes off. Expensive fragment shaders then
+*   run once per visible pixel instead of once per covering surface. Depth draws must produce
+*   the same positions as the shaded draw (same vertex shader, gl_Position invariant).
+*
+*   RECORDING:
+*
+*   RecordRenderQueue() executes a queue with a private rlgl batch active and captures what the
+*   callbacks emit (lines, quads, triangles with their texture, shader and blend mode) into one
+*   GPU vertex buffer. Callbacks emitting nothing to the batch (models, drawn directly) are kept
+*   as calls. ReplayRenderRecording() then draws the captured ranges straight from the GPU buffer,
+*   so a static frame costs a handful of draw calls instead of regenerating its geometry.
+*
+*   CONFIGURATION:
+*
+*   #define RENDER_QUEUE_IMPLEMENTATION
+*       Generates the implementation of the library into the included file.
+*       If not defined, the library is in header only mode and can be included in other headers
+*       or source files without problems. But only ONE file should hold the implementation.
+*
+**********************************************************************************************/
+
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include "rlgl.h"               // Required for: rlRenderBatch
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define RENDER_QUEUE_DEPTH_BITS     24
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+
+// Depth test state of a draw
+typedef enum {
+    RENDER_DEPTH_DEFAULT = 0,   // Less or equal, depth writes on
+    RENDER_DEPTH_PREPASS,       // Depth only, color writes off
+    RENDER_DEPTH_EQUAL          // Equal to the pre-pass depth, depth writes off
+} RenderDepthMode;
+
+// Render layers, executed in this order
+typedef enum {
+    RENDER_LAYER_OPAQUE = 0,
+    RENDER_LAYER_TRANSPARENT,
+    RENDER_LAYER_OVERLAY
+} RenderLayer;
+
+// Draw callback, receives the item data value
+typedef void (*RenderDrawFunc)(int data);
+
+// Recorded draw item
+typedef struct {
+    unsigned long long key;     // Sort key
+    int order;                  // Submission order, breaks key ties
+    Shader shader;              // Applied with BeginShaderMode(), id 0 for items binding their own (models)
+    int blendMode;              // BlendMode, BLEND_ALPHA is the default state
+    unsigned int material;      // Material or texture identifier, used for sorting and change counting
+    RenderDrawFunc draw;
+    RenderDrawFunc depthDraw;   // Depth pre-pass draw, NULL when not in the pre-pass
+    int data;
+} RenderItem;
+
+// Render queue
+typedef struct {
+    RenderItem *items;
+    int count;
+    int capacity;
+    Vector3 viewPosition;       // Depth reference
+    float depthRange;           // Distance mapped to the largest depth key
+    bool sorted;                // Execute in key order (false keeps submission order for comparison)
+    bool depthPrepass;          // Draw items with a depth draw in a depth only pass first
+
+    int stateChanges;           // Shader, blend and material switches in the last execution
+    int unsortedStateChanges;   // Switches the same items cost in submission order
+    double sortTime;            // Seconds spent sorting in the last execution
+    int prepassCount;           // Items drawn in the depth pre-pass in the last execution
+} RenderQueue;
+
+// Recorded command, a vertex range of the recording or a direct draw called again
+typedef struct {
+    RenderDrawFunc draw;        // Direct draw, NULL for a recorded vertex range
+    int data;
+    Shader shader;              // Shader mode active when recorded, id 0 for default
+    int blendMode;
+    int mode;                   // RL_LINES or RL_TRIANGLES (quads are split when captured)
+    unsigned int textureId;
+    int first;                  // First vertex of the range
+    int count;                  // Vertex count of the range
+    int depthMode;              // RenderDepthMode
+} RenderCommand;
+
+// Recorded queue execution
+typedef struct {
+    rlRenderBatch batch;        // Capture batch, active while recording
+    float *vertices;            // 3 floats per vertex
+    float *texcoords;           // 2 floats per vertex
+    unsigned char *colors;      // 4 bytes per vertex
+    int vertexCount;
+    int vertexCapacity;
+    RenderCommand *commands;
+    int commandCount;
+    int commandCapacity;
+    unsigned int vaoId;
+    unsigned int vboId[3];      // Positions, texcoords, colors
+    Shader shader;              // State while recording
+    int blendMode;
+    int depthMode;
+    bool valid;                 // Holds a complete recording, clear to invalidate
+} RenderRecording;
+
+#ifdef __cplusplus
+extern "C" {            // Prevents name mangling of functions
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+RenderQueue LoadRenderQueue(int capacity);                                            // Allocate queue (grows on demand)
+void UnloadRenderQueue(RenderQueue *queue);                                           // Free queue memory
+void BeginRenderQueue(RenderQueue *queue, Vector3 viewPosition, float depthRange);   // Drop previous items, set depth reference
+void PushRenderItem(RenderQueue *queue, RenderLayer layer, int blendMode, Shader shader, unsigned int material,
+                    Vector3 position, RenderDrawFunc draw, int data);                 // Record a draw item
+void SetRenderItemDepthDraw(RenderQueue *queue, RenderDrawFunc depthDraw);           // Depth pre-pass draw of the last pushed opaque item
+void ExecuteRenderQueue(RenderQueue *queue);                                          // Sort and draw items, switching state only on change
+
+RenderRecording LoadRenderRecording(int batchElements);                              // Allocate recording (capture batch holds 4*batchElements vertices)
+void UnloadRenderRecording(RenderRecording *recording);                              // Free recording memory and GPU buffers
+void RecordRenderQueue(RenderQueue *queue, RenderRecording *recording);              // Execute queue, capturing geometry and draws
+void ReplayRenderRecording(RenderRecording *recording);                              // Draw a recording without running the queue
+
+void BenchmarkRenderQueue(int itemCount, int frames);                                 // Log sort cost and state changes for random items
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RENDER_QUEUE_H
+
+
+/***********************************************************************************
+*
+*   RENDER_QUEUE IMPLEMENTATION
+*
+************************************************************************************/
+
+#if defined(RENDER_QUEUE_IMPLEMENTATION)
+
+#include "raylib.h"
+#include "raymath.h"
+
+#include <stdlib.h>             // Required for: qsort()
+#include <string.h>             // Required for: memcpy()
+
+#include "gl_loader.h"      // Required for: glDrawArrays(), glDepthFunc(), glDepthMask(), glColorMask()
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Declaration
+//----------------------------------------------------------------------------------
+static int CompareRenderItems(const void *a, const void *b);
+static int CountRenderStateChanges(const RenderItem *items, int count);
+static void ExecuteRenderItems(RenderQueue *queue, RenderRecording *recording);
+static void DrawRenderItem(RenderRecording *recording, RenderItem *item, RenderDrawFunc draw, int depthMode);
+static void SetRenderDepthMode(RenderRecording *recording, int depthMode);
+static int CountBatchVertices(const rlRenderBatch *batch);
+static void CaptureRenderBatch(RenderRecording *recording);
+static void PushRenderCommand(RenderRecording *recording, RenderCommand command);
+static void UploadRenderRecording(RenderRecording *recording);
+static void DrawNothing(int data);
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+
+// Allocate queue (grows on demand)
+RenderQueue LoadRenderQueue(int capacity)
+{
+    RenderQueue queue = { 0 };
+
+    queue.capacity = (capacity > 0)? capacity : 64;
+    queue.items = (RenderItem *)RL_MALLOC(queue.capacity*sizeof(RenderItem));
+    queue.depthRange = 1000.0f;
+    queue.sorted = true;
+
+    return queue;
+}
+
+// Free queue memory
+void UnloadRenderQueue(RenderQueue *queue)
+{
+    RL_FREE(queue->items);
+
+    *queue = (RenderQueue){ 0 };
+}
+
+// Drop previous items, set depth reference
+void BeginRenderQueue(RenderQueue *queue, Vector3 viewPosition, float depthRange)
+{
+    queue->count = 0;
+    queue->viewPosition = viewPosition;
+    queue->depthRange = depthRange;
+}
+
+// Record a draw item
+void PushRenderItem(RenderQueue *queue, RenderLayer layer, int blendMode, Shader shader, unsigned int material,
+                    Vector3 position, RenderDrawFunc draw, int data)
+{
+    if (queue->count == queue->capacity)
+    {
+        queue->capacity *= 2;
+        queue->items = (RenderItem *)RL_REALLOC(queue->items, queue->capacity*sizeof(RenderItem));
+    }
+
+    const unsigned long long depthMax = (1ull << RENDER_QUEUE_DEPTH_BITS) - 1;
+
+    float distance = Vector3Distance(position, queue->viewPosition)/queue->depthRange;
+    if (distance < 0.0f) distance = 0.0f;
+    if (distance > 1.0f) distance = 1.0f;
+
+    unsigned long long depth = (unsigned long long)(distance*depthMax);
+    unsigned long long state = ((unsigned long long)(blendMode & 0x7) << 26) |
+                               ((unsigned long long)(shader.id & 0x3ff) << 16) |
+                               (unsigned long long)(material & 0xffff);
+    unsigned long long key = (unsigned long long)layer << 62;
+
+    switch (layer)
+    {
+        case RENDER_LAYER_OPAQUE: key |= (state << RENDER_QUEUE_DEPTH_BITS) | depth; break;
+        case RENDER_LAYER_TRANSPARENT: key |= ((depthMax - depth) << 29) | state; break;
+        default: key |= (unsigned long long)queue->count; break;
+    }
+
+    RenderItem *item = &queue->items[queue->count];
+    item->key = key;
+    item->order = queue->count;
+    item->shader = shader;
+    item->blendMode = blendMode;
+    item->material = material;
+    item->draw = draw;
+    item->depthDraw = NULL;
+    item->data = data;
+
+    queue->count++;
+}
+
+// Depth pre-pass draw of the last pushed opaque item
+// NOTE: The depth draw must draw directly (models, meshes), not through the rlgl batch
+void SetRenderItemDepthDraw(RenderQueue *queue, RenderDrawFunc depthDraw)
+{
+    if (queue->count == 0) return;
+
+    RenderItem *item = &queue->items[queue->count - 1];
+    if ((item->key >> 62) == RENDER_LAYER_OPAQUE) item->depthDraw = depthDraw;
+}
+
+// Sort and draw items, switching state only on change
+// NOTE: Must be called inside BeginMode3D()/EndMode3D() when items draw in 3d
+void ExecuteRenderQueue(RenderQueue *queue)
+{
+    ExecuteRenderItems(queue, NULL);
+}
+
+// Allocate recording (capture batch holds 4*batchElements vertices)
+RenderRecording LoadRenderRecording(int batchElements)
+{
+    RenderRecording recording = { 0 };
+
+    recording.batch = rlLoadRenderBatch(1, batchElements);
+    recording.vertexCapacity = 4*batchElements;
+    recording.vertices = (float *)RL_MALLOC(recording.vertexCapacity*3*sizeof(float));
+    recording.texcoords = (float *)RL_MALLOC(recording.vertexCapacity*2*sizeof(float));
+    recording.colors = (unsigned char *)RL_MALLOC(recording.vertexCapacity*4*sizeof(unsigned char));
+    recording.commandCapacity = 64;
+    recording.commands = (RenderCommand *)RL_MALLOC(recording.commandCapacity*sizeof(RenderCommand));
+    recording.blendMode = BLEND_ALPHA;
+
+    return recording;
+}
+
+// Free recording memory and GPU buffers
+void UnloadRenderRecording(RenderRecording *recording)
+{
+    if (recording->vaoId != 0)
+    {
+        rlUnloadVertexArray(recording->vaoId);
+        for (int i = 0; i < 3; i++) rlUnloadVertexBuffer(recording->vboId[i]);
+    }
+
+    rlUnloadRenderBatch(recording->batch);
+    RL_FREE(recording->vertices);
+    RL_FREE(recording->texcoords);
+    RL_FREE(recording->colors);
+    RL_FREE(recording->commands);
+
+    *recording = (RenderRecording){ 0 };
+}
+
+// Execute queue, capturing geometry and draws
+// NOTE: An item emitting more than half the capture batch, or both batch geometry and direct
+// draws, is not captured correctly
+void RecordRenderQueue(RenderQueue *queue, RenderRecording *recording)
+{
+    ExecuteRenderItems(queue, recording);
+}
+
+// Draw a recording without running the queue
+// NOTE: Must be called inside BeginMode3D()/EndMode3D() with the camera it was recorded with
+void ReplayRenderRecording(RenderRecording *recording)
+{
+    rlDrawRenderBatchActive();
+
+    Matrix mvp = MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection());
+    float white[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    int slot = 0;
+    int depthMode = RENDER_DEPTH_DEFAULT;
+
+    for (int i = 0; i < recording->commandCount; i++)
+    {
+        RenderCommand *command = &recording->commands[i];
+
+        if (command->depthMode != depthMode)
+        {
+            SetRenderDepthMode(NULL, command->depthMode);
+            depthMode = command->depthMode;
+        }
+
+        if (command->draw != NULL)
+        {
+            command->draw(command->data);
+            continue;
+        }
+
+        unsigned int shaderId = (command->shader.id != 0)? command->shader.id : rlGetShaderIdDefault();
+        int *locs = (command->shader.id != 0)? command->shader.locs : rlGetShaderLocsDefault();
+
+        rlSetBlendMode(command->blendMode);
+        rlEnableShader(shaderId);
+        rlSetUniformMatrix(locs[SHADER_LOC_MATRIX_MVP], mvp);
+        rlSetUniform(locs[SHADER_LOC_COLOR_DIFFUSE], white, SHADER_UNIFORM_VEC4, 1);
+        rlSetUniform(locs[SHADER_LOC_MAP_DIFFUSE], &slot, SHADER_UNIFORM_INT, 1);
+        rlActiveTextureSlot(0);
+        rlEnableTexture(command->textureId);
+        rlEnableVertexArray(recording->vaoId);
+
+        glDrawArrays((command->mode == RL_LINES)? GL_LINES : GL_TRIANGLES, command->first, command->count);
+    }
+
+    rlDisableVertexArray();
+    rlDisableTexture();
+    rlDisableShader();
+    rlSetBlendMode(BLEND_ALPHA);
+
+    if (depthMode != RENDER_DEPTH_DEFAULT) SetRenderDepthMode(NULL, RENDER_DEPTH_DEFAULT);
+}
+
+// Log sort cost and state changes for random items
+void BenchmarkRenderQueue(int itemCount, int frames)
+{
+    RenderQueue queue = LoadRenderQueue(itemCount);
+    double sortTime = 0.0;
+
+    for (int f = 0; f < frames; f++)
+    {
+        BeginRenderQueue(&queue, (Vector3){ 0.0f, 0.0f, 0.0f }, 100.0f);
+
+        for (int i = 0; i < itemCount; i++)
+        {
+            Shader shader = { (unsigned int)GetRandomValue(0, 3), NULL };
+            Vector3 position = { (float)GetRandomValue(-50, 50), 0.0f, (float)GetRandomValue(-50, 50) };
+            RenderLayer layer = (GetRandomValue(0, 9) == 0)? RENDER_LAYER_TRANSPARENT : RENDER_LAYER_OPAQUE;
+
+            PushRenderItem(&queue, layer, BLEND_ALPHA, shader, (unsigned int)GetRandomValue(1, 8), position, DrawNothing, i);
+        }
+
+        // Shader ids are fake, sort and count without executing draws
+        queue.unsortedStateChanges = CountRenderStateChanges(queue.items, queue.count);
+        double start = GetTime();
+        qsort(queue.items, queue.count, sizeof(RenderItem), CompareRenderItems);
+        sortTime += GetTime() - start;
+        queue.stateChanges = CountRenderStateChanges(queue.items, queue.count);
+    }
+
+    TraceLog(LOG_INFO, "RENDER QUEUE: %i items: sort %.3f ms, state changes %i sorted vs %i unsorted",
+             itemCount, sortTime*1000.0/frames, queue.stateChanges, queue.unsortedStateChanges);
+
+    UnloadRenderQueue(&queue);
+}
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Definition
+//----------------------------------------------------------------------------------
+
+// Sort and draw items, capturing them when a recording is given
+static void ExecuteRenderItems(RenderQueue *queue, RenderRecording *recording)
+{
+    queue->unsortedStateChanges = CountRenderStateChanges(queue->items, queue->count);
+
+    double start = GetTime();
+    if (queue->sorted) qsort(queue->items, queue->count, sizeof(RenderItem), CompareRenderItems);
+    queue->sortTime = GetTime() - start;
+
+    queue->stateChanges = CountRenderStateChanges(queue->items, queue->count);
+
+    if (recording != NULL)
+    {
+        rlDrawRenderBatchActive();
+        rlSetRenderBatchActive(&recording->batch);
+
+        recording->vertexCount = 0;
+        recording->commandCount = 0;
+        recording->shader = (Shader){ 0 };
+        recording->blendMode = BLEND_ALPHA;
+        recording->depthMode = RENDER_DEPTH_DEFAULT;
+        recording->valid = false;
+    }
+
+    // Depth of every pre-pass item first, they bind their own (cheap) shader
+    queue->prepassCount = 0;
+    if (queue->depthPrepass)
+    {
+        for (int i = 0; i < queue->count; i++)
+        {
+            RenderItem *item = &queue->items[i];
+            if (item->depthDraw == NULL) continue;
+
+            if (queue->prepassCount == 0) SetRenderDepthMode(recording, RENDER_DEPTH_PREPASS);
+            DrawRenderItem(recording, item, item->depthDraw, RENDER_DEPTH_PREPASS);
+            queue->prepassCount++;
+        }
+    }
+
+    unsigned int shader = 0;
+    int blendMode = BLEND_ALPHA;
+    int depthMode = (queue->prepassCount > 0)? RENDER_DEPTH_PREPASS : RENDER_DEPTH_DEFAULT;
+
+    for (int i = 0; i < queue->count; i++)
+    {
+        RenderItem *item = &queue->items[i];
+        int itemDepthMode = ((queue->prepassCount > 0) && (item->depthDraw != NULL))? RENDER_DEPTH_EQUAL : RENDER_DEPTH_DEFAULT;
+
+        if (itemDepthMode != depthMode)
+        {
+            SetRenderDepthMode(recording, itemDepthMode);
+            depthMode = itemDepthMode;
+        }
+
+        // State changes flush the active batch, capture its geometry first
+        if ((recording != NULL) && ((item->shader.id != shader) || (item->blendMode != blendMode)))
+        {
+            CaptureRenderBatch(recording);
+            recording->shader = item->shader;
+            recording->blendMode = item->blendMode;
+        }
+
+        if (item->shader.id != shader)
+        {
+            if (shader != 0) EndShaderMode();
+            if (item->shader.id != 0) BeginShaderMode(item->shader);
+            shader = item->shader.id;
+        }
+
+        if (item->blendMode != blendMode)
+        {
+            if (blendMode != BLEND_ALPHA) EndBlendMode();
+            if (item->blendMode != BLEND_ALPHA) BeginBlendMode(item->blendMode);
+            blendMode = item->blendMode;
+        }
+
+        DrawRenderItem(recording, item, item->draw, depthMode);
+    }
+
+    if (depthMode != RENDER_DEPTH_DEFAULT) SetRenderDepthMode(recording, RENDER_DEPTH_DEFAULT);
+
+    if (recording != NULL)
+    {
+        CaptureRenderBatch(recording);
+        rlSetRenderBatchActive(NULL);
+        UploadRenderRecording(recording);
+    }
+
+    if (shader != 0) EndShaderMode();
+    if (blendMode != BLEND_ALPHA) EndBlendMode();
+}
+
+// Call one item draw, capturing it when a recording is given
+static void DrawRenderItem(RenderRecording *recording, RenderItem *item, RenderDrawFunc draw, int depthMode)
+{
+    if (recording == NULL)
+    {
+        draw(item->data);
+        return;
+    }
+
+    rlRenderBatch *batch = &recording->batch;
+
+    // Capture early rather than letting rlgl flush a full batch behind our back
+    if ((batch->drawCounter > RL_DEFAULT_BATCH_DRAWCALLS/2) || (CountBatchVertices(batch) > 2*batch->vertexBuffer[0].elementCount))
+    {
+        CaptureRenderBatch(recording);
+    }
+
+    // Every rlEnd() moves the batch depth, an unchanged depth means a direct draw
+    float depth = batch->currentDepth;
+
+    draw(item->data);
+
+    if (batch->currentDepth == depth)
+    {
+        RenderCommand command = { draw, item->data, item->shader, item->blendMode, 0, 0, 0, 0, depthMode };
+        PushRenderCommand(recording, command);
+    }
+}
+
+// Flush pending geometry with the previous state, then switch depth test, depth and color writes
+static void SetRenderDepthMode(RenderRecording *recording, int depthMode)
+{
+    if (recording != NULL)
+    {
+        CaptureRenderBatch(recording);
+        recording->depthMode = depthMode;
+    }
+    else rlDrawRenderBatchActive();
+
+    switch (depthMode)
+    {
+        case RENDER_DEPTH_PREPASS:
+        {
+            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            glDepthMask(GL_TRUE);
+            glDepthFunc(GL_LESS);
+        } break;
+        case RENDER_DEPTH_EQUAL:
+        {
+            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            glDepthMask(GL_FALSE);
+            glDepthFunc(GL_EQUAL);
+        } break;
+        default:
+        {
+            // rlgl defaults
+            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            glDepthMask(GL_TRUE);
+            glDepthFunc(GL_LEQUAL);
+        } break;
+    }
+}
+
+// Vertices stored in a batch, including alignment padding between draws
+static int CountBatchVertices(const rlRenderBatch *batch)
+{
+    int count = 0;
+
+    for (int i = 0; i < batch->drawCounter; i++) count += batch->draws[i].vertexCount + batch->draws[i].vertexAlignment;
+
+    return count;
+}
+
+// Copy the capture batch vertices into the recording, then draw and reset the batch
+static void CaptureRenderBatch(RenderRecording *recording)
+{
+    static const int quadOrder[6] = { 0, 1, 2, 0, 2, 3 };
+
+    rlRenderBatch *batch = &recording->batch;
+    rlVertexBuffer *buffer = &batch->vertexBuffer[batch->currentBuffer];
+    int offset = 0;
+
+    for (int i = 0; i < batch->drawCounter; i++)
+    {
+        rlDrawCall *draw = &batch->draws[i];
+        int count = (draw->mode == RL_QUADS)? draw->vertexCount/4*6 : draw->vertexCount;
+
+        if (recording->vertexCount + count > recording->vertexCapacity)
+        {
+            recording->vertexCapacity = 2*(recording->vertexCount + count);
+            recording->vertices = (float *)RL_REALLOC(recording->vertices, recording->vertexCapacity*3*sizeof(float));
+            recording->texcoords = (float *)RL_REALLOC(recording->texcoords, recording->vertexCapacity*2*sizeof(float));
+            recording->colors = (unsigned char *)RL_REALLOC(recording->colors, recording->vertexCapacity*4*sizeof(unsigned char));
+        }
+
+        if (count > 0)
+        {
+            int first = recording->vertexCount;
+
+            if (draw->mode == RL_QUADS)
+            {
+                // Split quads into the two triangles rlgl draws them with
+                for (int v = 0; v < count; v++)
+                {
+                    int source = offset + (v/6)*4 + quadOrder[v%6];
+                    int target = first + v;
+
+                    memcpy(recording->vertices + 3*target, buffer->vertices + 3*source, 3*sizeof(float));
+                    memcpy(recording->texcoords + 2*target, buffer->texcoords + 2*source, 2*sizeof(float));
+                    memcpy(recording->colors + 4*target, buffer->colors + 4*source, 4);
+                }
+            }
+            else
+            {
+                memcpy(recording->vertices + 3*first, buffer->vertices + 3*offset, count*3*sizeof(float));
+                memcpy(recording->texcoords + 2*first, buffer->texcoords + 2*offset, count*2*sizeof(float));
+                memcpy(recording->colors + 4*first, buffer->colors + 4*offset, count*4);
+            }
+
+            recording->vertexCount += count;
+
+            RenderCommand command = { NULL, 0, recording->shader, recording->blendMode,
+                                      (draw->mode == RL_LINES)? RL_LINES : RL_TRIANGLES, draw->textureId, first, count, recording->depthMode };
+            PushRenderCommand(recording, command);
+        }
+
+        offset += draw->vertexCount + draw->vertexAlignment;
+    }
+
+    rlDrawRenderBatch(batch);
+}
+
+// Append a command, extending the previous vertex range when state matches
+static void PushRenderCommand(RenderRecording *recording, RenderCommand command)
+{
+    if ((command.draw == NULL) && (recording->commandCount > 0))
+    {
+        RenderCommand *last = &recording->commands[recording->commandCount - 1];
+
+        if ((last->draw == NULL) && (last->shader.id == command.shader.id) && (last->blendMode == command.blendMode) &&
+            (last->depthMode == command.depthMode) && (last->mode == command.mode) && (last->textureId == command.textureId) && (last->first + last->count == command.first))
+        {
+            last->count += command.count;
+            return;
+        }
+    }
+
+    if (recording->commandCount == recording->commandCapacity)
+    {
+        recording->commandCapacity *= 2;
+        recording->commands = (RenderCommand *)RL_REALLOC(recording->commands, recording->commandCapacity*sizeof(RenderCommand));
+    }
+
+    recording->commands[recording->commandCount++] = command;
+}
+
+// Upload recorded vertices to a static vertex array, attributes at the default shader locations
+static void UploadRenderRecording(RenderRecording *recording)
+{
+    if (recording->vaoId != 0)
+    {
+        rlUnloadVertexArray(recording->vaoId);
+        for (int i = 0; i < 3; i++) rlUnloadVertexBuffer(recording->vboId[i]);
+        recording->vaoId = 0;
+    }
+
+    if (recording->vertexCount > 0)
+    {
+        recording->vaoId = rlLoadVertexArray();
+        rlEnableVertexArray(recording->vaoId);
+
+        recording->vboId[0] = rlLoadVertexBuffer(recording->vertices, recording->vertexCount*3*sizeof(float), false);
+        rlSetVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION, 3, RL_FLOAT, false, 0, 0);
+        rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION);
+
+        recording->vboId[1] = rlLoadVertexBuffer(recording->texcoords, recording->vertexCount*2*sizeof(float), false);
+        rlSetVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_TEXCOORD, 2, RL_FLOAT, false, 0, 0);
+        rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_TEXCOORD);
+
+        recording->vboId[2] = rlLoadVertexBuffer(recording->colors, recording->vertexCount*4*sizeof(unsigned char), false);
+        rlSetVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_COLOR, 4, RL_UNSIGNED_BYTE, true, 0, 0);
+        rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_COLOR);
+
+        rlDisableVertexArray();
+    }
+
+    recording->valid = true;
+}
+
+// Order by key, then by submission
+static int CompareRenderItems(const void *a, const void *b)
+{
+    const RenderItem *itemA = (const RenderItem *)a;
+    const RenderItem *itemB = (const RenderItem *)b;
+
+    if (itemA->key != itemB->key) return (itemA->key < itemB->key)? -1 : 1;
+
+    return itemA->order - itemB->order;
+}
+
+// Count shader, blend and material switches walking the items in array order
+static int CountRenderStateChanges(const RenderItem *items, int count)
+{
+    int changes = 0;
+    unsigned int shader = 0;
+    unsigned int material = 0;
+    int blendMode = BLEND_ALPHA;
+
+    for (int i = 0; i < count; i++)
+    {
+        const RenderItem *item = &items[i];
+
+        if (item->shader.id != shader) changes++;
+        if (item->blendMode != blendMode) changes++;
+        if (item->material != material) changes++;
+
+        shader = item->shader.id;
+        blendMode = item->blendMode;
+        material = item->material;
+    }
+
+    return changes;
+}
+
+// Benchmark draw callback
+static void DrawNothing(int data)
+{
+    (void)data;
+}
+
+#endif // RENDER_QUEUE_IMPLEMENTATION
@@ -0,0 +1,75 @@
+#version 330
+
+// Input vertex attributes
+in vec2 vertexCurve;            // Curve parameter t, side of the line (-1 or 1) or angle around a tube
+
+// Input instance attributes, one cubic bezier per instance
+in vec3 instanceP1;
+in vec3 instanceC2;
+in vec3 instanceC3;
+in vec3 instanceP4;
+in vec4 instanceColor;
+in float instanceWidth;         // Pixels for lines, world units for ribbons and tubes
+
+// Input uniform values
+uniform mat4 mvp;
+uniform vec2 viewport;          // Render size in pixels
+uniform vec3 viewPos;           // Camera position
+uniform int mode;               // 0 lines, 1 ribbons, 2 tubes
+
+// Output vertex attributes (to fragment shader)
+out vec4 fragColor;
+
+void main()
+{
+    float t = vertexCurve.x;
+    float u = 1.0 - t;
+
+    // Bezier point and derivative
+    vec3 position = u*u*u*instanceP1 + 3.0*u*u*t*instanceC2 + 3.0*u*t*t*instanceC3 + t*t*t*instanceP4;
+    vec3 tangent = 3.0*u*u*(instanceC2 - instanceP1) + 6.0*u*t*(instanceC3 - instanceC2) + 3.0*t*t*(instanceP4 - instanceC3);
+
+    fragColor = instanceColor;
+
+    if (mode == 0)
+    {
+        vec4 clip = mvp*vec4(position, 1.0);
+        vec4 clipTangent = mvp*vec4(tangent, 0.0);
+
+        // Screen space direction of the curve, derivative of the perspective divide
+        vec2 direction = (clipTangent.xy*clip.w - clip.xy*clipTangent.w)*viewport;
+        float size = max(abs(direction.x), abs(direction.y));
+        direction = (size > 0.0)? normalize(direction) : vec2(1.0, 0.0);
+
+        // Extrude across the curve, instanceWidth pixels wide after the divide
+        vec2 normal = vec2(-direction.y, direction.x);
+        clip.xy += normal*vertexCurve.y*instanceWidth/viewport*clip.w;
+
+        gl_Position = clip;
+        return;
+    }
+
+    // Frame around the curve facing the camera, both ends of a segment use the tangent at their t
+    // so neighbour segments share their edge exactly
+    vec3 view = normalize(viewPos - position);
+    vec3 axis = (dot(tangent, tangent) > 1e-12)? normalize(tangent) : vec3(0.0, 1.0, 0.0);
+    vec3 side = cross(axis, view);
+    if (dot(side, side) < 1e-8) side = cross(axis, (abs(axis.y) < 0.9)? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0));
+    side = normalize(side);
+
+    if (mode == 1)
+    {
+        position += side*vertexCurve.y*0.5*instanceWidth;
+    }
+    else
+    {
+        // Ring of the tube, lit from the camera
+        vec3 up = cross(side, axis);
+        vec3 normal = cos(vertexCurve.y)*side + sin(vertexCurve.y)*up;
+
+        position += normal*0.5*instanceWidth;
+        fragColor.rgb *= 0.35 + 0.65*max(dot(normal, view), 0.0);
+    }
+
+    gl_Position = mvp*vec4(position, 1.0);
+}
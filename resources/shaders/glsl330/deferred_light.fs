@@ -0,0 +1,48 @@
+#version 330
+
+// Input vertex attributes (from vertex shader)
+flat in int lightIndex;
+
+// Input uniform values
+uniform sampler2D gPosition;
+uniform sampler2D gNormal;
+uniform sampler2D gAlbedoSpec;
+uniform sampler2D lightData;        // Per light: texel (i, 0) position and radius, texel (i, 1) color
+uniform vec2 viewport;              // G-buffer size, the drawn viewport is its lower left corner
+uniform vec3 viewPos;
+
+// Output fragment color, added to the pixel
+out vec4 finalColor;
+
+void main()
+{
+    vec2 uv = gl_FragCoord.xy/viewport;
+
+    // Pixels without geometry are not lit
+    vec3 normal = texture(gNormal, uv).rgb;
+    if (dot(normal, normal) < 0.25) discard;
+
+    vec3 fragPosition = texture(gPosition, uv).rgb;
+    vec4 light = texelFetch(lightData, ivec2(lightIndex, 0), 0);
+    vec3 color = texelFetch(lightData, ivec2(lightIndex, 1), 0).rgb;
+
+    // Volume pixels outside the light radius
+    vec3 toLight = light.xyz - fragPosition;
+    float lightDistance = length(toLight);
+    if (lightDistance >= light.w) discard;
+
+    vec4 albedoSpec = texture(gAlbedoSpec, uv);
+    vec3 lightDir = toLight/lightDistance;
+    vec3 viewD = normalize(viewPos - fragPosition);
+    normal = normalize(normal);
+
+    // Falls to zero at the radius
+    float attenuation = 1.0 - lightDistance/light.w;
+    attenuation *= attenuation;
+
+    float NdotL = max(dot(normal, lightDir), 0.0);
+    float specCo = 0.0;
+    if (NdotL > 0.0) specCo = pow(max(0.0, dot(viewD, reflect(-lightDir, normal))), 16.0); // 16 refers to shine
+
+    finalColor = vec4((albedoSpec.rgb*NdotL + specCo*albedoSpec.a)*color*attenuation, 1.0);
+}
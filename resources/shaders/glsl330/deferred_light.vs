@@ -0,0 +1,18 @@
+#version 330
+
+// Input vertex attributes: light volume corner, light index in texcoord.x
+in vec3 vertexPosition;
+in vec2 vertexTexCoord;
+
+// Input uniform values
+uniform mat4 mvp;
+
+// Output vertex attributes (to fragment shader)
+flat out int lightIndex;
+
+void main()
+{
+    lightIndex = int(vertexTexCoord.x + 0.5);
+
+    gl_Position = mvp*vec4(vertexPosition, 1.0);
+}
@@ -2,54 +2,78 @@
 out vec4 finalColor;
 
 in vec2 texCoord;
-in vec2 texCoord2;
 
 uniform sampler2D gPosition;
 uniform sampler2D gNormal;
 uniform sampler2D gAlbedoSpec;
+uniform sampler2D gDepth;
+
+// Same lights as lighting.fs (rlights.h), shaded once per pixel instead of once per object fragment
+#define     MAX_LIGHTS              4
+#define     LIGHT_DIRECTIONAL       0
+#define     LIGHT_POINT             1
 
 struct Light {
     int enabled;
-    int type; // Unused in this demo.
+    int type;
     vec3 position;
-    vec3 target; // Unused in this demo.
+    vec3 target;
     vec4 color;
 };
 
-const int NR_LIGHTS = 4;
-uniform Light lights[NR_LIGHTS];
-uniform vec3 viewPosition;
-
-const float QUADRATIC = 0.032;
-const float LINEAR = 0.09;
+// Shared by every lit shader, see light_buffer.h
+layout(std140) uniform LightBlock {
+    Light lights[MAX_LIGHTS];
+    vec4 ambient;
+};
+uniform vec3 viewPos;
 
 void main() {
-    vec3 fragPosition = texture(gPosition, texCoord).rgb;
+    // Pixels without geometry keep what was drawn before
     vec3 normal = texture(gNormal, texCoord).rgb;
-    vec3 albedo = texture(gAlbedoSpec, texCoord).rgb;
-    float specular = texture(gAlbedoSpec, texCoord).a;
+    if (dot(normal, normal) < 0.25) discard;
 
-    vec3 ambient = albedo * vec3(0.1f);
-    vec3 viewDirection = normalize(viewPosition - fragPosition);
+    // retrieve data from gbuffer
+    vec3 fragPosition = texture(gPosition, texCoord).rgb;
+    vec4 albedoSpec = texture(gAlbedoSpec, texCoord);
+    vec4 albedo = vec4(albedoSpec.rgb, 1.0);
+
+    vec3 lightDot = vec3(0.0);
+    vec3 viewD = normalize(viewPos - fragPosition);
+    vec3 specular = vec3(0.0);
 
-    for(int i = 0; i < NR_LIGHTS; ++i)
+    for (int i = 0; i < MAX_LIGHTS; i++)
     {
-        if(lights[i].enabled == 0) continue;
-        vec3 lightDirection = lights[i].position - fragPosition;
-        vec3 diffuse = max(dot(normal, lightDirection), 0.0) * albedo * lights[i].color.xyz;
-
-        vec3 halfwayDirection = normalize(lightDirection + viewDirection);
-        float spec = pow(max(dot(normal, halfwayDirection), 0.0), 32.0);
-        vec3 specular = specular * spec * lights[i].color.xyz;
-
-        // Attenuation
-        float distance = length(lights[i].position - fragPosition);
-        float attenuation = 1.0 / (1.0 + LINEAR * distance + QUADRATIC * distance * distance);
-        diffuse *= attenuation;
-        specular *= attenuation;
-        ambient += diffuse + specular;
+        if (lights[i].enabled == 1)
+        {
+            vec3 light = vec3(0.0);
+
+            if (lights[i].type == LIGHT_DIRECTIONAL)
+            {
+                light = -normalize(lights[i].target - lights[i].position);
+            }
+
+            if (lights[i].type == LIGHT_POINT)
+            {
+                light = normalize(lights[i].position - fragPosition);
+            }
+
+            float NdotL = max(dot(normal, light), 0.0);
+            lightDot += lights[i].color.rgb*NdotL;
+
+            float specCo = 0.0;
+            if (NdotL > 0.0) specCo = pow(max(0.0, dot(viewD, reflect(-(light), normal))), 16.0); // 16 refers to shine
+            specular += specCo*albedoSpec.a;
+        }
     }
 
-    finalColor = vec4(ambient, 1.0);
-}
+    finalColor = albedo*((vec4(1.0) + vec4(specular, 1.0))*vec4(lightDot, 1.0));
+    finalColor += albedo*(ambient/10.0);
+
+    // Gamma correction
+    finalColor = pow(finalColor, vec4(1.0/2.2));
+    finalColor.a = 1.0;
 
+    // Depth of the geometry pass, so forward draws after this pass are hidden behind it
+    gl_FragDepth = texture(gDepth, texCoord).r;
+}
@@ -1,22 +1,23 @@
 #version 330 core
-layout (location = 0) out vec3 gPosition;
-layout (location = 1) out vec3 gNormal;
+layout (location = 0) out vec4 gPosition;
+layout (location = 1) out vec4 gNormal;
 layout (location = 2) out vec4 gAlbedoSpec;
 
 in vec3 fragPosition;
 in vec2 fragTexCoord;
 in vec3 fragNormal;
 
-uniform sampler2D diffuseTexture;
-uniform sampler2D specularTexture;
+// Same material inputs as lighting.fs, so scene models draw with either shader
+uniform sampler2D texture0;
+uniform vec4 colDiffuse;
 
 void main() {
     // store the fragment position vector in the first gbuffer texture
-    gPosition = fragPosition;
-    // also store the per-fragment normals into the gbuffer
-    gNormal = normalize(fragNormal);
+    gPosition = vec4(fragPosition, 1.0);
+    // also store the per-fragment normals into the gbuffer (a zero normal marks pixels without geometry)
+    gNormal = vec4(normalize(fragNormal), 1.0);
     // and the diffuse per-fragment color
-    gAlbedoSpec.rgb = texture(diffuseTexture, fragTexCoord).rgb;
+    gAlbedoSpec.rgb = (texture(texture0, fragTexCoord)*colDiffuse).rgb;
     // store specular intensity in gAlbedoSpec's alpha component
-    gAlbedoSpec.a = texture(specularTexture, fragTexCoord).r;
+    gAlbedoSpec.a = 1.0;
 }
@@ -0,0 +1,25 @@
+#version 330 core
+layout (location = 0) in vec3 vertexPosition;
+layout (location = 1) in vec2 vertexTexCoord;
+layout (location = 2) in vec3 vertexNormal;
+
+in mat4 instanceTransform;
+
+out vec3 fragPosition;
+out vec2 fragTexCoord;
+out vec3 fragNormal;
+
+// View projection, DrawMeshInstanced() leaves the model transform to the instances
+uniform mat4 mvp;
+
+void main()
+{
+    vec4 worldPos = instanceTransform * vec4(vertexPosition, 1.0);
+    fragPosition = worldPos.xyz; 
+    fragTexCoord = vertexTexCoord;
+
+    mat3 normalMatrix = transpose(inverse(mat3(instanceTransform)));
+    fragNormal = normalMatrix * vertexNormal;
+
+    gl_Position = mvp * worldPos;
+}
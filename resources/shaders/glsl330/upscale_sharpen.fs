@@ -0,0 +1,48 @@
+#version 330
+
+// NOTE: Upscale of a layer drawn at reduced resolution (layer_compositor.h). The bilinear sample
+// is sharpened against its 4 neighbours one source texel away, contrast adaptive (as AMD CAS):
+// the weight falls where the neighbourhood is already close to black or white so edges do not
+// ring. Sharpness 0 is a plain bilinear upscale.
+//
+// Only the lower left corner of texture0 (up to sourceExtent) was drawn, every tap is clamped half a
+// texel inside it so the bilinear filter never blends in what lies past it.
+
+// Input vertex attributes (from vertex shader)
+in vec2 fragTexCoord;
+in vec4 fragColor;
+
+// Input uniform values
+uniform sampler2D texture0;
+uniform vec2 sourceTexel;           // Texel size of texture0
+uniform vec2 sourceExtent;          // Texture coordinates of the drawn corner
+uniform float sharpness = 0.5;      // 0..1
+
+// Output fragment color
+out vec4 finalColor;
+
+// Bilinear tap kept inside the drawn corner
+vec4 Tap(vec2 uv)
+{
+    return texture(texture0, clamp(uv, 0.5*sourceTexel, sourceExtent - 0.5*sourceTexel));
+}
+
+void main()
+{
+    vec4 center = Tap(fragTexCoord);
+    vec3 north = Tap(fragTexCoord + vec2(0.0, sourceTexel.y)).rgb;
+    vec3 south = Tap(fragTexCoord - vec2(0.0, sourceTexel.y)).rgb;
+    vec3 east = Tap(fragTexCoord + vec2(sourceTexel.x, 0.0)).rgb;
+    vec3 west = Tap(fragTexCoord - vec2(sourceTexel.x, 0.0)).rgb;
+
+    vec3 minColor = min(center.rgb, min(min(north, south), min(east, west)));
+    vec3 maxColor = max(center.rgb, max(max(north, south), max(east, west)));
+
+    // Room left before clipping, relative to the local maximum
+    vec3 amount = sqrt(clamp(min(minColor, 1.0 - maxColor)/max(maxColor, 0.0001), 0.0, 1.0));
+    vec3 weight = amount*(-1.0/mix(8.0, 5.0, sharpness));
+
+    vec3 color = (center.rgb + (north + south + east + west)*weight)/(1.0 + 4.0*weight);
+
+    finalColor = vec4(mix(center.rgb, clamp(color, 0.0, 1.0), step(0.001, sharpness)), center.a);
+}
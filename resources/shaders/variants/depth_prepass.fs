@@ -0,0 +1,9 @@
+// Single source, see shader_variants.h
+//
+// NOTE: Depth pre-pass, color writes are masked off and only the depth of the fragment is kept.
+// Paired with lighting.vs (and its INSTANCING variant) so positions match the shading pass
+
+void main()
+{
+    FRAG_COLOR = vec4(1.0);
+}
@@ -0,0 +1,138 @@
+// Single source, see shader_variants.h: the version line and feature defines are added when a
+// variant is generated. VARYING, TEXTURE and FRAG_COLOR are GLSL 330's in, texture and finalColor.
+//
+// Features:
+//     LIGHT_0..LIGHT_3    rlights.h lights shaded by this variant, disabled ones are not compiled in
+//     CLUSTERED           point lights of the fragment's cluster (light_clusters.h)
+//     LIGHT_BRANCHES      benchmark baseline only: every light behind a branch on its enabled
+//                         uniform, as the single lighting shader did before variants
+
+#if __VERSION__ < 330
+    #error The lights are a uniform block (light_buffer.h), GLSL 330 only
+#endif
+
+// Input vertex attributes (from vertex shader)
+VARYING vec3 fragPosition;
+VARYING vec2 fragTexCoord;
+VARYING vec3 fragNormal;
+
+// Input uniform values
+uniform sampler2D texture0;
+uniform vec4 colDiffuse;
+
+#define     MAX_LIGHTS              4
+#define     LIGHT_DIRECTIONAL       0
+#define     LIGHT_POINT             1
+
+struct Light {
+    int enabled;
+    int type;
+    vec3 position;
+    vec3 target;
+    vec4 color;
+};
+
+// Input lighting values
+// Shared by every lit shader, see light_buffer.h
+layout(std140) uniform LightBlock {
+    Light lights[MAX_LIGHTS];
+    vec4 ambient;
+};
+uniform vec3 viewPos;
+
+#if defined(CLUSTERED)
+// Clustered point lights (light_clusters.h)
+uniform sampler2D clusterData;      // Per cluster: index offset, light count
+uniform sampler2D clusterIndices;   // Light indices, 1024 per row
+uniform sampler2D clusterLights;    // Per light: texel (i, 0) position and radius, texel (i, 1) color
+uniform ivec3 clusterGrid;
+uniform vec2 clusterDepth;          // Slice of a view depth d: log(d)*x + y
+uniform vec2 clusterViewport;
+uniform mat4 matView;
+#endif
+
+// Diffuse and specular of one light
+void AddLight(Light light, vec3 normal, vec3 viewD, inout vec3 lightDot, inout vec3 specular)
+{
+    vec3 direction = vec3(0.0);
+
+    if (light.type == LIGHT_DIRECTIONAL) direction = -normalize(light.target - light.position);
+    if (light.type == LIGHT_POINT) direction = normalize(light.position - fragPosition);
+
+    float NdotL = max(dot(normal, direction), 0.0);
+    lightDot += light.color.rgb*NdotL;
+
+    float specCo = 0.0;
+    if (NdotL > 0.0) specCo = pow(max(0.0, dot(viewD, reflect(-(direction), normal))), 16.0); // 16 refers to shine
+    specular += specCo;
+}
+
+void main()
+{
+    // Texel color fetching from texture sampler
+    vec4 texelColor = TEXTURE(texture0, fragTexCoord);
+    vec3 lightDot = vec3(0.0);
+    vec3 normal = normalize(fragNormal);
+    vec3 viewD = normalize(viewPos - fragPosition);
+    vec3 specular = vec3(0.0);
+
+    // One call per enabled light, the variant is picked from the enabled mask
+#if defined(LIGHT_BRANCHES)
+    for (int i = 0; i < MAX_LIGHTS; i++)
+    {
+        if (lights[i].enabled == 1) AddLight(lights[i], normal, viewD, lightDot, specular);
+    }
+#endif
+#if defined(LIGHT_0)
+    AddLight(lights[0], normal, viewD, lightDot, specular);
+#endif
+#if defined(LIGHT_1)
+    AddLight(lights[1], normal, viewD, lightDot, specular);
+#endif
+#if defined(LIGHT_2)
+    AddLight(lights[2], normal, viewD, lightDot, specular);
+#endif
+#if defined(LIGHT_3)
+    AddLight(lights[3], normal, viewD, lightDot, specular);
+#endif
+
+#if defined(CLUSTERED)
+    // Only the lights binned in this fragment's cluster
+    float depth = -(matView*vec4(fragPosition, 1.0)).z;
+    vec2 tile = gl_FragCoord.xy/clusterViewport*vec2(clusterGrid.xy);
+    ivec3 cell = clamp(ivec3(int(tile.x), int(tile.y), int(log(max(depth, 0.0001))*clusterDepth.x + clusterDepth.y)), ivec3(0), clusterGrid - 1);
+    vec4 cluster = texelFetch(clusterData, ivec2(cell.x + cell.y*clusterGrid.x, cell.z), 0);
+    int offset = int(cluster.x);
+    int count = int(cluster.y);
+
+    for (int n = 0; n < count; n++)
+    {
+        int index = offset + n;
+        int i = int(texelFetch(clusterIndices, ivec2(index%1024, index/1024), 0).r);
+        vec4 point = texelFetch(clusterLights, ivec2(i, 0), 0);
+        vec3 toLight = point.xyz - fragPosition;
+        float lightDistance = length(toLight);
+        if (lightDistance >= point.w) continue;
+
+        // Falls to zero at the radius
+        vec3 light = toLight/lightDistance;
+        float attenuation = 1.0 - lightDistance/point.w;
+        attenuation *= attenuation;
+
+        float NdotL = max(dot(normal, light), 0.0);
+        lightDot += texelFetch(clusterLights, ivec2(i, 1), 0).rgb*NdotL*attenuation;
+
+        float specCo = 0.0;
+        if (NdotL > 0.0) specCo = pow(max(0.0, dot(viewD, reflect(-(light), normal))), 16.0); // 16 refers to shine
+        specular += specCo*attenuation;
+    }
+#endif
+
+    vec4 color = (texelColor*((colDiffuse + vec4(specular, 1.0))*vec4(lightDot, 1.0)));
+    color += texelColor*(ambient/10.0)*colDiffuse;
+
+    // Gamma correction
+    color = pow(color, vec4(1.0/2.2));
+
+    FRAG_COLOR = color;
+}
@@ -0,0 +1,50 @@
+// Single source, see shader_variants.h: the version line and feature defines are added when a
+// variant is generated. ATTRIBUTE and VARYING are GLSL 330's in and out.
+//
+// Features:
+//     INSTANCING      model transform per instance (DrawMeshInstanced), instead of matModel
+
+// Input vertex attributes
+ATTRIBUTE vec3 vertexPosition;
+ATTRIBUTE vec2 vertexTexCoord;
+ATTRIBUTE vec3 vertexNormal;
+#if defined(INSTANCING)
+ATTRIBUTE mat4 instanceTransform;
+#else
+ATTRIBUTE vec4 vertexColor;
+#endif
+
+// Input uniform values
+uniform mat4 mvp;
+#if !defined(INSTANCING)
+uniform mat4 matModel;
+uniform mat4 matNormal;
+#endif
+
+// Output vertex attributes (to fragment shader)
+VARYING vec3 fragPosition;
+VARYING vec2 fragTexCoord;
+VARYING vec4 fragColor;
+VARYING vec3 fragNormal;
+
+// Depth pre-pass draws use this shader too, positions must match exactly
+invariant gl_Position;
+
+void main()
+{
+    // Position and normal in world space, both ways
+#if defined(INSTANCING)
+    fragPosition = vec3(instanceTransform*vec4(vertexPosition, 1.0));
+    fragColor = vec4(1.0);
+    fragNormal = normalize(vec3(instanceTransform*vec4(vertexNormal, 0.0)));
+
+    gl_Position = (mvp*instanceTransform)*vec4(vertexPosition, 1.0);
+#else
+    fragPosition = vec3(matModel*vec4(vertexPosition, 1.0));
+    fragColor = vertexColor;
+    fragNormal = normalize(vec3(matNormal*vec4(vertexNormal, 1.0)));
+
+    gl_Position = mvp*vec4(vertexPosition, 1.0);
+#endif
+    fragTexCoord = vertexTexCoord;
+}
@@ -0,0 +1,49 @@
+// Single source, see shader_variants.h
+//
+// NOTE: Reduced resolution passes of post_chain.h, drawn with raylib's default vertex shader.
+// Without DOWNSAMPLE it is one direction of a separable 9 tap Gaussian (5 bilinear fetches, the
+// offsets and weights of blur.fs), run back and forth between two targets.
+//
+// Features:
+//     DOWNSAMPLE      average of 4 bilinear taps (4x4 texels) into a target 2 or 4 times smaller
+//     THRESHOLD       with DOWNSAMPLE, keeps the part of the color over the bloom threshold
+
+// Input vertex attributes (from vertex shader)
+VARYING vec2 fragTexCoord;
+VARYING vec4 fragColor;
+
+// Input uniform values
+uniform sampler2D texture0;
+uniform vec2 texelSize;             // Of texture0
+#if defined(THRESHOLD)
+uniform float threshold;
+#endif
+#if !defined(DOWNSAMPLE)
+uniform vec2 blurDirection;         // (1, 0) or (0, 1)
+#endif
+
+void main()
+{
+#if defined(DOWNSAMPLE)
+    vec3 color = TEXTURE(texture0, fragTexCoord + vec2(-1.0, -1.0)*texelSize).rgb;
+    color += TEXTURE(texture0, fragTexCoord + vec2(1.0, -1.0)*texelSize).rgb;
+    color += TEXTURE(texture0, fragTexCoord + vec2(-1.0, 1.0)*texelSize).rgb;
+    color += TEXTURE(texture0, fragTexCoord + vec2(1.0, 1.0)*texelSize).rgb;
+    color *= 0.25;
+
+#if defined(THRESHOLD)
+    float brightness = max(color.r, max(color.g, color.b));
+    color *= max(brightness - threshold, 0.0)/max(brightness, 0.0001);
+#endif
+#else
+    vec2 offset = blurDirection*texelSize;
+
+    vec3 color = TEXTURE(texture0, fragTexCoord).rgb*0.2270270270;
+    color += TEXTURE(texture0, fragTexCoord + offset*1.3846153846).rgb*0.3162162162;
+    color += TEXTURE(texture0, fragTexCoord - offset*1.3846153846).rgb*0.3162162162;
+    color += TEXTURE(texture0, fragTexCoord + offset*3.2307692308).rgb*0.0702702703;
+    color += TEXTURE(texture0, fragTexCoord - offset*3.2307692308).rgb*0.0702702703;
+#endif
+
+    FRAG_COLOR = vec4(color, 1.0);
+}
@@ -0,0 +1,124 @@
+// Single source, see shader_variants.h
+//
+// NOTE: Full resolution pass of post_chain.h, drawn with raylib's default vertex shader. Every
+// enabled effect runs in this one pass, each a few instructions per pixel: the scene is read
+// once and written once whatever the number of effects. Blurs come from reduced resolution
+// targets.
+//
+// Features, in the order they apply:
+//     FXAA            antialiasing of the scene edges (FXAA, console variant), instead of MSAA
+//     EDGES           darkens Sobel edges of the scene luminance (sobel.fs)
+//     BLUR            mixes in the blurred scene by blurAmount
+//     BLOOM           adds the blurred bright parts of the scene by bloomIntensity
+//     GRAYSCALE       NTSC luminance (grayscale.fs)
+//     POSTERIZE       colorLevels levels per channel (posterization.fs)
+//     VIGNETTE        darkens toward the corners
+
+// Input vertex attributes (from vertex shader)
+VARYING vec2 fragTexCoord;
+VARYING vec4 fragColor;
+
+// Input uniform values
+uniform sampler2D texture0;         // Scene
+uniform vec2 texelSize;             // Of texture0
+#if defined(BLUR)
+uniform sampler2D blurTexture;
+uniform float blurAmount;
+#endif
+#if defined(BLOOM)
+uniform sampler2D bloomTexture;
+uniform float bloomIntensity;
+#endif
+#if defined(POSTERIZE)
+uniform float colorLevels;
+#endif
+
+float Luminance(vec2 uv)
+{
+    return dot(TEXTURE(texture0, uv).rgb, vec3(0.299, 0.587, 0.114));
+}
+
+#if defined(FXAA)
+#define FXAA_SPAN_MAX       8.0
+#define FXAA_REDUCE_MUL     (1.0/8.0)
+#define FXAA_REDUCE_MIN     (1.0/128.0)
+
+// Blur along the local edge direction, found from the luminance of the 4 diagonal neighbours
+// NOTE: Relies on bilinear filtering of texture0
+vec3 Fxaa(vec2 uv)
+{
+    float lumaNW = Luminance(uv + vec2(-1.0, -1.0)*texelSize);
+    float lumaNE = Luminance(uv + vec2(1.0, -1.0)*texelSize);
+    float lumaSW = Luminance(uv + vec2(-1.0, 1.0)*texelSize);
+    float lumaSE = Luminance(uv + vec2(1.0, 1.0)*texelSize);
+    vec3 rgbM = TEXTURE(texture0, uv).rgb;
+    float lumaM = dot(rgbM, vec3(0.299, 0.587, 0.114));
+
+    float lumaMin = min(lumaM, min(min(lumaNW, lumaNE), min(lumaSW, lumaSE)));
+    float lumaMax = max(lumaM, max(max(lumaNW, lumaNE), max(lumaSW, lumaSE)));
+
+    vec2 direction = vec2(-((lumaNW + lumaNE) - (lumaSW + lumaSE)), (lumaNW + lumaSW) - (lumaNE + lumaSE));
+    float directionReduce = max((lumaNW + lumaNE + lumaSW + lumaSE)*0.25*FXAA_REDUCE_MUL, FXAA_REDUCE_MIN);
+    float rcpDirectionMin = 1.0/(min(abs(direction.x), abs(direction.y)) + directionReduce);
+    direction = clamp(direction*rcpDirectionMin, vec2(-FXAA_SPAN_MAX), vec2(FXAA_SPAN_MAX))*texelSize;
+
+    vec3 rgbA = 0.5*(TEXTURE(texture0, uv + direction*(1.0/3.0 - 0.5)).rgb + TEXTURE(texture0, uv + direction*(2.0/3.0 - 0.5)).rgb);
+    vec3 rgbB = rgbA*0.5 + 0.25*(TEXTURE(texture0, uv - direction*0.5).rgb + TEXTURE(texture0, uv + direction*0.5).rgb);
+    float lumaB = dot(rgbB, vec3(0.299, 0.587, 0.114));
+
+    // The wide taps crossed another edge, keep the narrow ones
+    if ((lumaB < lumaMin) || (lumaB > lumaMax)) return rgbA;
+
+    return rgbB;
+}
+#endif
+
+void main()
+{
+#if defined(FXAA)
+    vec3 color = Fxaa(fragTexCoord);
+#else
+    vec3 color = TEXTURE(texture0, fragTexCoord).rgb;
+#endif
+
+#if defined(EDGES)
+    float x = texelSize.x;
+    float y = texelSize.y;
+    float topLeft = Luminance(fragTexCoord + vec2(-x, -y));
+    float top = Luminance(fragTexCoord + vec2(0.0, -y));
+    float topRight = Luminance(fragTexCoord + vec2(x, -y));
+    float left = Luminance(fragTexCoord + vec2(-x, 0.0));
+    float right = Luminance(fragTexCoord + vec2(x, 0.0));
+    float bottomLeft = Luminance(fragTexCoord + vec2(-x, y));
+    float bottom = Luminance(fragTexCoord + vec2(0.0, y));
+    float bottomRight = Luminance(fragTexCoord + vec2(x, y));
+
+    float horizEdge = (topRight + 2.0*right + bottomRight) - (topLeft + 2.0*left + bottomLeft);
+    float vertEdge = (bottomLeft + 2.0*bottom + bottomRight) - (topLeft + 2.0*top + topRight);
+    color *= 1.0 - clamp(sqrt(horizEdge*horizEdge + vertEdge*vertEdge), 0.0, 1.0);
+#endif
+
+#if defined(BLUR)
+    color = mix(color, TEXTURE(blurTexture, fragTexCoord).rgb, blurAmount);
+#endif
+
+#if defined(BLOOM)
+    color += TEXTURE(bloomTexture, fragTexCoord).rgb*bloomIntensity;
+#endif
+
+#if defined(GRAYSCALE)
+    color = vec3(dot(color, vec3(0.299, 0.587, 0.114)));
+#endif
+
+#if defined(POSTERIZE)
+    // In a 0.6 gamma, as posterization.fs
+    color = pow(floor(pow(color, vec3(0.6))*colorLevels)/colorLevels, vec3(1.0/0.6));
+#endif
+
+#if defined(VIGNETTE)
+    vec2 centered = fragTexCoord - vec2(0.5);
+    color *= clamp(1.0 - 1.2*dot(centered, centered), 0.0, 1.0);
+#endif
+
+    FRAG_COLOR = vec4(color, 1.0);
+}
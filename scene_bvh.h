@@ -0,0 +1,999 @@
+/**********************************************************************************************
+*
+*   scene_bvh - Dynamic bounding volume hierarchy for scene culling, picking and selection
+*
+*   Leaves hold one object each. Every leaf keeps its tight bounds plus a "fat" box enlarged
+*   by a margin; the hierarchy is built over the fat boxes, so small motions only touch the
+*   leaf. When an object escapes its fat box the leaf is queued and RefitSceneBvh() walks the
+*   ancestors of the queued leaves only. Refitting degrades tree quality over time, so
+*   UpdateSceneBvh() tracks the surface area cost and rebuilds (binned SAH) when it has grown
+*   past SCENE_BVH_REBUILD_RATIO of the cost right after the last rebuild.
+*
+*   CONFIGURATION:
+*
+*   #define SCENE_BVH_IMPLEMENTATION
+*       Generates the implementation of the library into the included file.
+*       If not defined, the library is in header only mode and can be included in other headers
+*       or source files without problems. But only ONE file should hold the implementation.
+*
+**********************************************************************************************/
+
+#ifndef SCENE_BVH_H
+#define SCENE_BVH_H
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define SCENE_BVH_NULL                  -1        // Null node index
+#define SCENE_BVH_MARGIN              0.5f        // Default fat box margin (world units)
+#define SCENE_BVH_REBUILD_RATIO       1.5f        // Rebuild when SAH cost grows past this ratio
+#define SCENE_BVH_QUALITY_INTERVAL      30        // Updates between SAH cost checks
+#define SCENE_BVH_BINS                  12        // SAH bins per rebuild split
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+
+// Hierarchy node
+typedef struct {
+    BoundingBox box;            // Fat box on leaves, union of children on internal nodes
+    BoundingBox bounds;         // Tight object bounds (leaves only)
+    int parent;                 // Parent node, next free node when unused
+    int left;                   // Left child, SCENE_BVH_NULL on leaves
+    int right;                  // Right child, SCENE_BVH_NULL on leaves
+    int height;                 // 0 on leaves, -1 when unused
+    int userData;               // Object index (leaves only)
+    bool moved;                 // Leaf is queued for refit
+} BvhNode;
+
+// Dynamic hierarchy
+typedef struct {
+    BvhNode *nodes;
+    int nodeCount;              // Nodes in use
+    int nodeCapacity;
+    int root;
+    int freeList;
+    int leafCount;
+
+    int *moved;                 // Leaves queued for refit
+    int movedCount;
+    int movedCapacity;
+
+    int *stack;                 // Traversal scratch
+    int stackCapacity;
+
+    float margin;               // Fat box margin
+    float rebuildCost;          // SAH cost right after the last rebuild
+    int updatesSinceCheck;
+
+    int refitCount;             // Leaves refitted since last reset
+    int rebuildCount;           // Rebuilds since creation
+} SceneBvh;
+
+// View frustum as six planes (xyz: normal pointing inside, w: distance)
+typedef struct {
+    Vector4 planes[6];
+} Frustum;
+
+#ifdef __cplusplus
+extern "C" {            // Prevents name mangling of functions
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+SceneBvh CreateSceneBvh(int capacity, float margin);                     // Create an empty hierarchy
+void UnloadSceneBvh(SceneBvh *bvh);                                       // Free hierarchy memory
+int InsertSceneBvh(SceneBvh *bvh, BoundingBox bounds, int userData);      // Insert an object, returns its proxy (leaf index)
+void RemoveSceneBvh(SceneBvh *bvh, int proxy);                            // Remove an object
+bool MoveSceneBvh(SceneBvh *bvh, int proxy, BoundingBox bounds);          // Update object bounds, returns true if the leaf needs a refit
+void RefitSceneBvh(SceneBvh *bvh);                                        // Refit ancestors of moved leaves
+void RebuildSceneBvh(SceneBvh *bvh);                                      // Rebuild all internal nodes (binned SAH)
+bool UpdateSceneBvh(SceneBvh *bvh);                                       // Refit, rebuild when quality degraded; returns true on rebuild
+float GetSceneBvhCost(const SceneBvh *bvh);                               // Sum of internal node surface areas
+
+Frustum GetFrustumFromMatrix(Matrix viewProjection, Rectangle ndc);       // Frustum planes for a NDC sub-rectangle ({ -1, -1, 2, 2 } is the full view)
+Matrix GetCameraViewProjection(Camera camera, int width, int height);     // View-projection matrix used by BeginMode3D() on a width x height target
+Frustum GetCameraFrustum(Camera camera, int width, int height);           // Frustum of a camera rendering to a width x height target
+Frustum GetCameraFrustumRect(Camera camera, Rectangle rect, int width, int height);  // Frustum through a screen rectangle (box selection)
+bool CheckFrustumBox(Frustum frustum, BoundingBox box);                   // Box intersects or is inside frustum
+
+int QuerySceneBvhFrustum(SceneBvh *bvh, Frustum frustum, int *results, int maxResults);   // Objects inside frustum, returns count
+int QuerySceneBvhBox(SceneBvh *bvh, BoundingBox box, int *results, int maxResults);       // Objects overlapping box, returns count
+int RaycastSceneBvh(SceneBvh *bvh, Ray ray, RayCollision *collision);                     // Closest object hit by ray, -1 if none
+
+void BenchmarkSceneBvh(int objectCount, int frames);                      // Log refit vs rebuild cost for a moving scene
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SCENE_BVH_H
+
+
+/***********************************************************************************
+*
+*   SCENE_BVH IMPLEMENTATION
+*
+************************************************************************************/
+
+#if defined(SCENE_BVH_IMPLEMENTATION)
+
+#include "raylib.h"
+#include "raymath.h"
+#include "rlgl.h"               // Required for: RL_CULL_DISTANCE_NEAR, RL_CULL_DISTANCE_FAR
+
+#include <float.h>              // Required for: FLT_MAX
+#include <math.h>               // Required for: sqrtf(), fminf(), fmaxf(), cbrtf()
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+
+// Leaf record used while rebuilding, kept compact so partitioning stays in cache
+typedef struct {
+    BoundingBox box;
+    Vector3 centroid;
+    int leaf;
+} BvhBuildItem;
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Declaration
+//----------------------------------------------------------------------------------
+static int AllocateBvhNode(SceneBvh *bvh);
+static void FreeBvhNode(SceneBvh *bvh, int index);
+static void InsertBvhLeaf(SceneBvh *bvh, int leaf);
+static void RemoveBvhLeaf(SceneBvh *bvh, int leaf);
+static int BuildBvhRange(SceneBvh *bvh, BvhBuildItem *items, int count, int parent);
+static int *GetBvhStack(SceneBvh *bvh, int size);
+
+// NOTE: Plain comparisons instead of fminf()/fmaxf(), those are library calls unless built with fast math.
+// RayBoxDistance() keeps them: they drop the NaN of a ray lying in a slab plane (0*inf)
+static inline BoundingBox BoxUnion(BoundingBox a, BoundingBox b)
+{
+    BoundingBox result = { 0 };
+    result.min.x = (a.min.x < b.min.x)? a.min.x : b.min.x;
+    result.min.y = (a.min.y < b.min.y)? a.min.y : b.min.y;
+    result.min.z = (a.min.z < b.min.z)? a.min.z : b.min.z;
+    result.max.x = (a.max.x > b.max.x)? a.max.x : b.max.x;
+    result.max.y = (a.max.y > b.max.y)? a.max.y : b.max.y;
+    result.max.z = (a.max.z > b.max.z)? a.max.z : b.max.z;
+    return result;
+}
+
+static inline float BoxArea(BoundingBox b)
+{
+    float dx = b.max.x - b.min.x, dy = b.max.y - b.min.y, dz = b.max.z - b.min.z;
+    return 2.0f*(dx*dy + dy*dz + dz*dx);
+}
+
+static inline bool BoxContains(BoundingBox outer, BoundingBox inner)
+{
+    return (outer.min.x <= inner.min.x) && (outer.min.y <= inner.min.y) && (outer.min.z <= inner.min.z) &&
+           (outer.max.x >= inner.max.x) && (outer.max.y >= inner.max.y) && (outer.max.z >= inner.max.z);
+}
+
+static inline bool BoxOverlaps(BoundingBox a, BoundingBox b)
+{
+    return (a.min.x <= b.max.x) && (a.max.x >= b.min.x) &&
+           (a.min.y <= b.max.y) && (a.max.y >= b.min.y) &&
+           (a.min.z <= b.max.z) && (a.max.z >= b.min.z);
+}
+
+static inline bool BoxEquals(BoundingBox a, BoundingBox b)
+{
+    return (a.min.x == b.min.x) && (a.min.y == b.min.y) && (a.min.z == b.min.z) &&
+           (a.max.x == b.max.x) && (a.max.y == b.max.y) && (a.max.z == b.max.z);
+}
+
+static inline bool IsBvhLeaf(const BvhNode *node) { return (node->left == SCENE_BVH_NULL); }
+
+// Classify box against frustum: 0 outside, 1 intersecting, 2 fully inside
+static inline int ClassifyFrustumBox(const Frustum *frustum, BoundingBox box)
+{
+    int result = 2;
+
+    for (int i = 0; i < 6; i++)
+    {
+        Vector4 p = frustum->planes[i];
+
+        // Farthest corner along the plane normal decides rejection, nearest decides containment
+        float far = p.x*((p.x >= 0.0f)? box.max.x : box.min.x) + p.y*((p.y >= 0.0f)? box.max.y : box.min.y) + p.z*((p.z >= 0.0f)? box.max.z : box.min.z) + p.w;
+        if (far < 0.0f) return 0;
+
+        float near = p.x*((p.x >= 0.0f)? box.min.x : box.max.x) + p.y*((p.y >= 0.0f)? box.min.y : box.max.y) + p.z*((p.z >= 0.0f)? box.min.z : box.max.z) + p.w;
+        if (near < 0.0f) result = 1;
+    }
+
+    return result;
+}
+
+// Slab test, returns entry distance or FLT_MAX on miss
+// NOTE: fminf()/fmaxf() return the other operand for a NaN slab distance, comparisons would not
+static inline float RayBoxDistance(Vector3 origin, Vector3 invDir, BoundingBox box, float maxDistance)
+{
+    float t1 = (box.min.x - origin.x)*invDir.x, t2 = (box.max.x - origin.x)*invDir.x;
+    float tmin = fminf(t1, t2), tmax = fmaxf(t1, t2);
+
+    t1 = (box.min.y - origin.y)*invDir.y; t2 = (box.max.y - origin.y)*invDir.y;
+    tmin = fmaxf(tmin, fminf(t1, t2)); tmax = fminf(tmax, fmaxf(t1, t2));
+
+    t1 = (box.min.z - origin.z)*invDir.z; t2 = (box.max.z - origin.z)*invDir.z;
+    tmin = fmaxf(tmin, fminf(t1, t2)); tmax = fminf(tmax, fmaxf(t1, t2));
+
+    if ((tmax < fmaxf(tmin, 0.0f)) || (tmin > maxDistance)) return FLT_MAX;
+
+    return fmaxf(tmin, 0.0f);
+}
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+
+// Create an empty hierarchy
+SceneBvh CreateSceneBvh(int capacity, float margin)
+{
+    SceneBvh bvh = { 0 };
+
+    if (capacity < 16) capacity = 16;
+
+    bvh.nodeCapacity = 2*capacity;
+    bvh.nodes = (BvhNode *)RL_CALLOC(bvh.nodeCapacity, sizeof(BvhNode));
+    bvh.root = SCENE_BVH_NULL;
+    bvh.margin = margin;
+
+    // Chain all nodes into the free list
+    for (int i = 0; i < bvh.nodeCapacity; i++)
+    {
+        bvh.nodes[i].parent = (i < bvh.nodeCapacity - 1)? i + 1 : SCENE_BVH_NULL;
+        bvh.nodes[i].height = -1;
+    }
+    bvh.freeList = 0;
+
+    bvh.movedCapacity = capacity;
+    bvh.moved = (int *)RL_MALLOC(bvh.movedCapacity*sizeof(int));
+
+    bvh.stackCapacity = 64;
+    bvh.stack = (int *)RL_MALLOC(bvh.stackCapacity*sizeof(int));
+
+    return bvh;
+}
+
+// Free hierarchy memory
+void UnloadSceneBvh(SceneBvh *bvh)
+{
+    RL_FREE(bvh->nodes);
+    RL_FREE(bvh->moved);
+    RL_FREE(bvh->stack);
+
+    *bvh = (SceneBvh){ 0 };
+    bvh->root = SCENE_BVH_NULL;
+}
+
+// Insert an object, returns its proxy (leaf index)
+// NOTE: Proxies stay valid across refits and rebuilds until the object is removed
+int InsertSceneBvh(SceneBvh *bvh, BoundingBox bounds, int userData)
+{
+    int leaf = AllocateBvhNode(bvh);
+    BvhNode *node = &bvh->nodes[leaf];
+
+    node->bounds = bounds;
+    node->box = (BoundingBox){ Vector3SubtractValue(bounds.min, bvh->margin), Vector3AddValue(bounds.max, bvh->margin) };
+    node->height = 0;
+    node->userData = userData;
+    node->moved = false;
+
+    InsertBvhLeaf(bvh, leaf);
+    bvh->leafCount++;
+
+    return leaf;
+}
+
+// Remove an object
+void RemoveSceneBvh(SceneBvh *bvh, int proxy)
+{
+    if (bvh->nodes[proxy].moved)
+    {
+        // Drop it from the refit queue
+        for (int i = 0; i < bvh->movedCount; i++)
+        {
+            if (bvh->moved[i] == proxy)
+            {
+                bvh->moved[i] = bvh->moved[--bvh->movedCount];
+                break;
+            }
+        }
+    }
+
+    RemoveBvhLeaf(bvh, proxy);
+    FreeBvhNode(bvh, proxy);
+    bvh->leafCount--;
+}
+
+// Update object bounds, returns true if the leaf escaped its fat box and needs a refit
+bool MoveSceneBvh(SceneBvh *bvh, int proxy, BoundingBox bounds)
+{
+    BvhNode *node = &bvh->nodes[proxy];
+
+    node->bounds = bounds;
+
+    if (BoxContains(node->box, bounds)) return false;
+
+    node->box = (BoundingBox){ Vector3SubtractValue(bounds.min, bvh->margin), Vector3AddValue(bounds.max, bvh->margin) };
+
+    if (!node->moved)
+    {
+        if (bvh->movedCount == bvh->movedCapacity)
+        {
+            bvh->movedCapacity *= 2;
+            bvh->moved = (int *)RL_REALLOC(bvh->moved, bvh->movedCapacity*sizeof(int));
+        }
+
+        bvh->moved[bvh->movedCount++] = proxy;
+        node->moved = true;
+    }
+
+    return true;
+}
+
+// Refit ancestors of moved leaves
+// NOTE: Each walk stops as soon as an ancestor box is unchanged, so leaves moving
+// inside a still valid subtree cost only a few nodes
+void RefitSceneBvh(SceneBvh *bvh)
+{
+    for (int i = 0; i < bvh->movedCount; i++)
+    {
+        int leaf = bvh->moved[i];
+        bvh->nodes[leaf].moved = false;
+
+        int index = bvh->nodes[leaf].parent;
+
+        while (index != SCENE_BVH_NULL)
+        {
+            BvhNode *node = &bvh->nodes[index];
+            BoundingBox box = BoxUnion(bvh->nodes[node->left].box, bvh->nodes[node->right].box);
+
+            if (BoxEquals(box, node->box)) break;
+
+            node->box = box;
+            index = node->parent;
+        }
+    }
+
+    bvh->refitCount += bvh->movedCount;
+    bvh->movedCount = 0;
+}
+
+// Rebuild all internal nodes (binned SAH)
+void RebuildSceneBvh(SceneBvh *bvh)
+{
+    if (bvh->leafCount == 0) return;
+
+    BvhBuildItem *items = (BvhBuildItem *)RL_MALLOC(bvh->leafCount*sizeof(BvhBuildItem));
+    int count = 0;
+
+    // Keep leaves in place (proxies stay valid), release every internal node
+    for (int i = 0; i < bvh->nodeCapacity; i++)
+    {
+        BvhNode *node = &bvh->nodes[i];
+
+        if (node->height < 0) continue;
+
+        if (IsBvhLeaf(node))
+        {
+            node->moved = false;
+            items[count].box = node->box;
+            items[count].centroid = Vector3Scale(Vector3Add(node->box.min, node->box.max), 0.5f);
+            items[count].leaf = i;
+            count++;
+        }
+        else FreeBvhNode(bvh, i);
+    }
+
+    bvh->movedCount = 0;
+    bvh->root = BuildBvhRange(bvh, items, count, SCENE_BVH_NULL);
+
+    RL_FREE(items);
+
+    bvh->rebuildCost = GetSceneBvhCost(bvh);
+    bvh->updatesSinceCheck = 0;
+    bvh->rebuildCount++;
+}
+
+// Refit, rebuild when quality degraded; returns true on rebuild
+bool UpdateSceneBvh(SceneBvh *bvh)
+{
+    RefitSceneBvh(bvh);
+
+    if (++bvh->updatesSinceCheck < SCENE_BVH_QUALITY_INTERVAL) return false;
+
+    bvh->updatesSinceCheck = 0;
+
+    if ((bvh->rebuildCost <= 0.0f) || (GetSceneBvhCost(bvh) > SCENE_BVH_REBUILD_RATIO*bvh->rebuildCost))
+    {
+        RebuildSceneBvh(bvh);
+        return true;
+    }
+
+    return false;
+}
+
+// Sum of internal node surface areas
+float GetSceneBvhCost(const SceneBvh *bvh)
+{
+    float cost = 0.0f;
+
+    for (int i = 0; i < bvh->nodeCapacity; i++)
+    {
+        if (bvh->nodes[i].height > 0) cost += BoxArea(bvh->nodes[i].box);
+    }
+
+    return cost;
+}
+
+// Frustum planes for a NDC sub-rectangle
+// NOTE: Clip space test x >= left*w turns into plane (row0 - left*row3), same for the other sides
+Frustum GetFrustumFromMatrix(Matrix m, Rectangle ndc)
+{
+    Vector4 row0 = { m.m0, m.m4, m.m8, m.m12 };
+    Vector4 row1 = { m.m1, m.m5, m.m9, m.m13 };
+    Vector4 row2 = { m.m2, m.m6, m.m10, m.m14 };
+    Vector4 row3 = { m.m3, m.m7, m.m11, m.m15 };
+
+    float left = ndc.x, right = ndc.x + ndc.width;
+    float bottom = ndc.y, top = ndc.y + ndc.height;
+
+    Frustum frustum = { 0 };
+    frustum.planes[0] = (Vector4){ row0.x - left*row3.x, row0.y - left*row3.y, row0.z - left*row3.z, row0.w - left*row3.w };
+    frustum.planes[1] = (Vector4){ right*row3.x - row0.x, right*row3.y - row0.y, right*row3.z - row0.z, right*row3.w - row0.w };
+    frustum.planes[2] = (Vector4){ row1.x - bottom*row3.x, row1.y - bottom*row3.y, row1.z - bottom*row3.z, row1.w - bottom*row3.w };
+    frustum.planes[3] = (Vector4){ top*row3.x - row1.x, top*row3.y - row1.y, top*row3.z - row1.z, top*row3.w - row1.w };
+    frustum.planes[4] = (Vector4){ row3.x + row2.x, row3.y + row2.y, row3.z + row2.z, row3.w + row2.w };
+    frustum.planes[5] = (Vector4){ row3.x - row2.x, row3.y - row2.y, row3.z - row2.z, row3.w - row2.w };
+
+    for (int i = 0; i < 6; i++)
+    {
+        Vector4 p = frustum.planes[i];
+        float length = sqrtf(p.x*p.x + p.y*p.y + p.z*p.z);
+        if (length > 0.0f) frustum.planes[i] = (Vector4){ p.x/length, p.y/length, p.z/length, p.w/length };
+    }
+
+    return frustum;
+}
+
+// Frustum of a camera rendering to a width x height target
+Frustum GetCameraFrustum(Camera camera, int width, int height)
+{
+    return GetCameraFrustumRect(camera, (Rectangle){ 0.0f, 0.0f, (float)width, (float)height }, width, height);
+}
+
+// View-projection matrix used by BeginMode3D() on a width x height target
+Matrix GetCameraViewProjection(Camera camera, int width, int height)
+{
+    float aspect = (float)width/(float)height;
+    Matrix view = MatrixLookAt(camera.position, camera.target, camera.up);
+    Matrix projection = { 0 };
+
+    if (camera.projection == CAMERA_PERSPECTIVE)
+    {
+        projection = MatrixPerspective(camera.fovy*DEG2RAD, aspect, RL_CULL_DISTANCE_NEAR, RL_CULL_DISTANCE_FAR);
+    }
+    else
+    {
+        double top = camera.fovy/2.0;
+        double right = top*aspect;
+        projection = MatrixOrtho(-right, right, -top, top, RL_CULL_DISTANCE_NEAR, RL_CULL_DISTANCE_FAR);
+    }
+
+    return MatrixMultiply(view, projection);
+}
+
+// Frustum through a screen rectangle (box selection)
+Frustum GetCameraFrustumRect(Camera camera, Rectangle rect, int width, int height)
+{
+    // Screen y grows downwards, NDC y grows upwards
+    Rectangle ndc = { 0 };
+    ndc.x = 2.0f*rect.x/width - 1.0f;
+    ndc.width = 2.0f*rect.width/width;
+    ndc.y = 1.0f - 2.0f*(rect.y + rect.height)/height;
+    ndc.height = 2.0f*rect.height/height;
+
+    return GetFrustumFromMatrix(GetCameraViewProjection(camera, width, height), ndc);
+}
+
+// Box intersects or is inside frustum
+bool CheckFrustumBox(Frustum frustum, BoundingBox box)
+{
+    return (ClassifyFrustumBox(&frustum, box) != 0);
+}
+
+// Objects inside frustum, returns count
+// NOTE: Subtrees fully inside the frustum are collected without further plane tests
+int QuerySceneBvhFrustum(SceneBvh *bvh, Frustum frustum, int *results, int maxResults)
+{
+    if (bvh->root == SCENE_BVH_NULL) return 0;
+
+    int count = 0;
+    int top = 0;
+    int *stack = GetBvhStack(bvh, 1);
+
+    // Stack entries carry the "fully inside" flag in the lowest bit
+    stack[top++] = bvh->root << 1;
+
+    while ((top > 0) && (count < maxResults))
+    {
+        int entry = stack[--top];
+        int index = entry >> 1;
+        bool inside = (entry & 1);
+        const BvhNode *node = &bvh->nodes[index];
+
+        if (!inside)
+        {
+            int result = ClassifyFrustumBox(&frustum, IsBvhLeaf(node)? node->bounds : node->box);
+            if (result == 0) continue;
+            inside = (result == 2);
+        }
+
+        if (IsBvhLeaf(node))
+        {
+            results[count++] = node->userData;
+        }
+        else
+        {
+            stack = GetBvhStack(bvh, top + 2);
+            stack[top++] = (node->left << 1) | (int)inside;
+            stack[top++] = (node->right << 1) | (int)inside;
+        }
+    }
+
+    return count;
+}
+
+// Objects overlapping box, returns count
+int QuerySceneBvhBox(SceneBvh *bvh, BoundingBox box, int *results, int maxResults)
+{
+    if (bvh->root == SCENE_BVH_NULL) return 0;
+
+    int count = 0;
+    int top = 0;
+    int *stack = GetBvhStack(bvh, 1);
+
+    stack[top++] = bvh->root;
+
+    while ((top > 0) && (count < maxResults))
+    {
+        const BvhNode *node = &bvh->nodes[stack[--top]];
+
+        if (IsBvhLeaf(node))
+        {
+            if (BoxOverlaps(node->bounds, box)) results[count++] = node->userData;
+        }
+        else if (BoxOverlaps(node->box, box))
+        {
+            stack = GetBvhStack(bvh, top + 2);
+            stack[top++] = node->left;
+            stack[top++] = node->right;
+        }
+    }
+
+    return count;
+}
+
+// Closest object hit by ray, -1 if none
+int RaycastSceneBvh(SceneBvh *bvh, Ray ray, RayCollision *collision)
+{
+    RayCollision best = { 0 };
+    best.distance = FLT_MAX;
+    int bestData = -1;
+
+    if (bvh->root != SCENE_BVH_NULL)
+    {
+        Vector3 invDir = { 1.0f/ray.direction.x, 1.0f/ray.direction.y, 1.0f/ray.direction.z };
+        int top = 0;
+        int *stack = GetBvhStack(bvh, 1);
+
+        stack[top++] = bvh->root;
+
+        while (top > 0)
+        {
+            const BvhNode *node = &bvh->nodes[stack[--top]];
+
+            if (IsBvhLeaf(node))
+            {
+                RayCollision hit = GetRayCollisionBox(ray, node->bounds);
+
+                if (hit.hit && (hit.distance < best.distance))
+                {
+                    best = hit;
+                    bestData = node->userData;
+                }
+            }
+            else
+            {
+                float dl = RayBoxDistance(ray.position, invDir, bvh->nodes[node->left].box, best.distance);
+                float dr = RayBoxDistance(ray.position, invDir, bvh->nodes[node->right].box, best.distance);
+
+                // Push the farther child first so the nearer one is visited first
+                stack = GetBvhStack(bvh, top + 2);
+                if (dl <= dr)
+                {
+                    if (dr != FLT_MAX) stack[top++] = node->right;
+                    if (dl != FLT_MAX) stack[top++] = node->left;
+                }
+                else
+                {
+                    if (dl != FLT_MAX) stack[top++] = node->left;
+                    if (dr != FLT_MAX) stack[top++] = node->right;
+                }
+            }
+        }
+    }
+
+    if (collision != NULL) *collision = best;
+
+    return bestData;
+}
+
+// Log refit vs rebuild cost for a moving scene
+// NOTE: Every object moves every frame, the worst case for refitting
+void BenchmarkSceneBvh(int objectCount, int frames)
+{
+    float extent = 4.0f*cbrtf((float)objectCount);
+    Vector3 *positions = (Vector3 *)RL_MALLOC(objectCount*sizeof(Vector3));
+    Vector3 *velocities = (Vector3 *)RL_MALLOC(objectCount*sizeof(Vector3));
+    int *proxies = (int *)RL_MALLOC(objectCount*sizeof(int));
+    int *results = (int *)RL_MALLOC(objectCount*sizeof(int));
+
+    for (int i = 0; i < objectCount; i++)
+    {
+        positions[i] = (Vector3){ GetRandomValue(0, 10000)*extent/10000.0f, GetRandomValue(0, 10000)*extent/10000.0f, GetRandomValue(0, 10000)*extent/10000.0f };
+        velocities[i] = (Vector3){ GetRandomValue(-100, 100)/1000.0f, GetRandomValue(-100, 100)/1000.0f, GetRandomValue(-100, 100)/1000.0f };
+    }
+
+    SceneBvh bvh = CreateSceneBvh(objectCount, SCENE_BVH_MARGIN);
+
+    double start = GetTime();
+    for (int i = 0; i < objectCount; i++)
+    {
+        proxies[i] = InsertSceneBvh(&bvh, (BoundingBox){ Vector3SubtractValue(positions[i], 0.5f), Vector3AddValue(positions[i], 0.5f) }, i);
+    }
+    double insertTime = GetTime() - start;
+
+    start = GetTime();
+    RebuildSceneBvh(&bvh);
+    double initialRebuildTime = GetTime() - start;
+    float initialCost = bvh.rebuildCost;
+
+    double moveTime = 0.0, refitTime = 0.0, rebuildTime = 0.0, queryTime = 0.0;
+    int refitted = 0, visible = 0;
+
+    Camera camera = { 0 };
+    camera.position = (Vector3){ extent*0.5f, extent*0.5f, -extent*0.5f };
+    camera.target = (Vector3){ extent*0.5f, extent*0.5f, extent*0.5f };
+    camera.up = (Vector3){ 0.0f, 1.0f, 0.0f };
+    camera.fovy = 45.0f;
+    camera.projection = CAMERA_PERSPECTIVE;
+    Frustum frustum = GetCameraFrustum(camera, 640, 480);
+
+    for (int f = 0; f < frames; f++)
+    {
+        start = GetTime();
+        for (int i = 0; i < objectCount; i++)
+        {
+            positions[i] = Vector3Add(positions[i], velocities[i]);
+            MoveSceneBvh(&bvh, proxies[i], (BoundingBox){ Vector3SubtractValue(positions[i], 0.5f), Vector3AddValue(positions[i], 0.5f) });
+        }
+        moveTime += GetTime() - start;
+
+        refitted += bvh.movedCount;
+        start = GetTime();
+        RefitSceneBvh(&bvh);
+        refitTime += GetTime() - start;
+
+        start = GetTime();
+        visible += QuerySceneBvhFrustum(&bvh, frustum, results, objectCount);
+        queryTime += GetTime() - start;
+    }
+
+    float refitCost = GetSceneBvhCost(&bvh);
+
+    // Same final state, rebuilt from scratch every frame
+    for (int f = 0; f < frames; f++)
+    {
+        start = GetTime();
+        RebuildSceneBvh(&bvh);
+        rebuildTime += GetTime() - start;
+    }
+
+    TraceLog(LOG_INFO, "BVH: %i objects, insert %.2f ms, initial rebuild %.2f ms", objectCount, insertTime*1000.0, initialRebuildTime*1000.0);
+    TraceLog(LOG_INFO, "BVH: per frame: move %.3f ms, refit %.3f ms (%i leaves), rebuild %.3f ms",
+             moveTime*1000.0/frames, refitTime*1000.0/frames, refitted/frames, rebuildTime*1000.0/frames);
+    TraceLog(LOG_INFO, "BVH: frustum query %.3f ms (%i visible), SAH cost after %i refits: %.2fx of rebuilt",
+             queryTime*1000.0/frames, visible/frames, frames, refitCost/initialCost);
+
+    UnloadSceneBvh(&bvh);
+    RL_FREE(positions);
+    RL_FREE(velocities);
+    RL_FREE(proxies);
+    RL_FREE(results);
+}
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Definition
+//----------------------------------------------------------------------------------
+
+// Take a node from the free list, growing the pool if needed
+static int AllocateBvhNode(SceneBvh *bvh)
+{
+    if (bvh->freeList == SCENE_BVH_NULL)
+    {
+        int oldCapacity = bvh->nodeCapacity;
+        bvh->nodeCapacity *= 2;
+        bvh->nodes = (BvhNode *)RL_REALLOC(bvh->nodes, bvh->nodeCapacity*sizeof(BvhNode));
+
+        for (int i = oldCapacity; i < bvh->nodeCapacity; i++)
+        {
+            bvh->nodes[i] = (BvhNode){ 0 };
+            bvh->nodes[i].parent = (i < bvh->nodeCapacity - 1)? i + 1 : SCENE_BVH_NULL;
+            bvh->nodes[i].height = -1;
+        }
+
+        bvh->freeList = oldCapacity;
+    }
+
+    int index = bvh->freeList;
+    BvhNode *node = &bvh->nodes[index];
+
+    bvh->freeList = node->parent;
+    node->parent = SCENE_BVH_NULL;
+    node->left = SCENE_BVH_NULL;
+    node->right = SCENE_BVH_NULL;
+    node->height = 0;
+    node->userData = -1;
+    node->moved = false;
+    bvh->nodeCount++;
+
+    return index;
+}
+
+// Return a node to the free list
+static void FreeBvhNode(SceneBvh *bvh, int index)
+{
+    bvh->nodes[index].parent = bvh->freeList;
+    bvh->nodes[index].height = -1;
+    bvh->freeList = index;
+    bvh->nodeCount--;
+}
+
+// Attach a leaf next to the sibling with the lowest surface area cost increase
+static void InsertBvhLeaf(SceneBvh *bvh, int leaf)
+{
+    if (bvh->root == SCENE_BVH_NULL)
+    {
+        bvh->root = leaf;
+        bvh->nodes[leaf].parent = SCENE_BVH_NULL;
+        return;
+    }
+
+    BoundingBox leafBox = bvh->nodes[leaf].box;
+    int index = bvh->root;
+
+    while (!IsBvhLeaf(&bvh->nodes[index]))
+    {
+        const BvhNode *node = &bvh->nodes[index];
+        float area = BoxArea(node->box);
+        float combinedArea = BoxArea(BoxUnion(node->box, leafBox));
+
+        // Cost of making a new parent here, and the increase every descendant pays
+        float cost = 2.0f*combinedArea;
+        float inheritance = 2.0f*(combinedArea - area);
+
+        const BvhNode *left = &bvh->nodes[node->left];
+        const BvhNode *right = &bvh->nodes[node->right];
+
+        float costLeft = BoxArea(BoxUnion(leafBox, left->box)) + inheritance;
+        if (!IsBvhLeaf(left)) costLeft -= BoxArea(left->box);
+
+        float costRight = BoxArea(BoxUnion(leafBox, right->box)) + inheritance;
+        if (!IsBvhLeaf(right)) costRight -= BoxArea(right->box);
+
+        if ((cost < costLeft) && (cost < costRight)) break;
+
+        index = (costLeft < costRight)? node->left : node->right;
+    }
+
+    int sibling = index;
+    int oldParent = bvh->nodes[sibling].parent;
+    int newParent = AllocateBvhNode(bvh);
+
+    bvh->nodes[newParent].parent = oldParent;
+    bvh->nodes[newParent].box = BoxUnion(leafBox, bvh->nodes[sibling].box);
+    bvh->nodes[newParent].height = bvh->nodes[sibling].height + 1;
+    bvh->nodes[newParent].left = sibling;
+    bvh->nodes[newParent].right = leaf;
+    bvh->nodes[sibling].parent = newParent;
+    bvh->nodes[leaf].parent = newParent;
+
+    if (oldParent == SCENE_BVH_NULL) bvh->root = newParent;
+    else if (bvh->nodes[oldParent].left == sibling) bvh->nodes[oldParent].left = newParent;
+    else bvh->nodes[oldParent].right = newParent;
+
+    // Walk back up fixing boxes and heights
+    index = bvh->nodes[leaf].parent;
+    while (index != SCENE_BVH_NULL)
+    {
+        BvhNode *node = &bvh->nodes[index];
+        const BvhNode *left = &bvh->nodes[node->left];
+        const BvhNode *right = &bvh->nodes[node->right];
+
+        node->box = BoxUnion(left->box, right->box);
+        node->height = 1 + ((left->height > right->height)? left->height : right->height);
+        index = node->parent;
+    }
+}
+
+// Detach a leaf, its sibling takes the place of their parent
+static void RemoveBvhLeaf(SceneBvh *bvh, int leaf)
+{
+    if (leaf == bvh->root)
+    {
+        bvh->root = SCENE_BVH_NULL;
+        return;
+    }
+
+    int parent = bvh->nodes[leaf].parent;
+    int grandParent = bvh->nodes[parent].parent;
+    int sibling = (bvh->nodes[parent].left == leaf)? bvh->nodes[parent].right : bvh->nodes[parent].left;
+
+    if (grandParent == SCENE_BVH_NULL)
+    {
+        bvh->root = sibling;
+        bvh->nodes[sibling].parent = SCENE_BVH_NULL;
+        FreeBvhNode(bvh, parent);
+        return;
+    }
+
+    if (bvh->nodes[grandParent].left == parent) bvh->nodes[grandParent].left = sibling;
+    else bvh->nodes[grandParent].right = sibling;
+    bvh->nodes[sibling].parent = grandParent;
+    FreeBvhNode(bvh, parent);
+
+    int index = grandParent;
+    while (index != SCENE_BVH_NULL)
+    {
+        BvhNode *node = &bvh->nodes[index];
+        const BvhNode *left = &bvh->nodes[node->left];
+        const BvhNode *right = &bvh->nodes[node->right];
+
+        node->box = BoxUnion(left->box, right->box);
+        node->height = 1 + ((left->height > right->height)? left->height : right->height);
+        index = node->parent;
+    }
+}
+
+// Build a subtree over a set of leaves, returns its root
+static int BuildBvhRange(SceneBvh *bvh, BvhBuildItem *items, int count, int parent)
+{
+    if (count == 1)
+    {
+        bvh->nodes[items[0].leaf].parent = parent;
+        return items[0].leaf;
+    }
+
+    // Centroid bounds pick the split axis
+    Vector3 cmin = { FLT_MAX, FLT_MAX, FLT_MAX };
+    Vector3 cmax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+    for (int i = 0; i < count; i++)
+    {
+        BoundingBox c = BoxUnion((BoundingBox){ cmin, cmax }, (BoundingBox){ items[i].centroid, items[i].centroid });
+        cmin = c.min;
+        cmax = c.max;
+    }
+
+    Vector3 extent = Vector3Subtract(cmax, cmin);
+    int axis = 0;
+    if (extent.y > extent.x) axis = 1;
+    if (extent.z > ((axis == 0)? extent.x : extent.y)) axis = 2;
+
+    float axisMin = ((float *)&cmin)[axis];
+    float axisExtent = ((float *)&extent)[axis];
+
+    int mid = count/2;
+
+    if (axisExtent > 1e-6f)
+    {
+        int binCount[SCENE_BVH_BINS] = { 0 };
+        BoundingBox binBox[SCENE_BVH_BINS];
+        for (int b = 0; b < SCENE_BVH_BINS; b++) binBox[b] = (BoundingBox){ { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+
+        float scale = SCENE_BVH_BINS*(1.0f - 1e-4f)/axisExtent;
+
+        for (int i = 0; i < count; i++)
+        {
+            int bin = (int)((((float *)&items[i].centroid)[axis] - axisMin)*scale);
+            binCount[bin]++;
+            binBox[bin] = BoxUnion(binBox[bin], items[i].box);
+        }
+
+        // Sweep from the right to get suffix areas, then from the left evaluating every split
+        float rightArea[SCENE_BVH_BINS] = { 0 };
+        int rightCount[SCENE_BVH_BINS] = { 0 };
+        BoundingBox acc = { { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+        int accCount = 0;
+
+        for (int b = SCENE_BVH_BINS - 1; b > 0; b--)
+        {
+            acc = BoxUnion(acc, binBox[b]);
+            accCount += binCount[b];
+            rightArea[b] = (accCount > 0)? BoxArea(acc) : 0.0f;
+            rightCount[b] = accCount;
+        }
+
+        float bestCost = FLT_MAX;
+        int bestSplit = -1;
+        acc = (BoundingBox){ { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+        accCount = 0;
+
+        for (int b = 1; b < SCENE_BVH_BINS; b++)
+        {
+            acc = BoxUnion(acc, binBox[b - 1]);
+            accCount += binCount[b - 1];
+
+            if ((accCount == 0) || (rightCount[b] == 0)) continue;
+
+            float cost = BoxArea(acc)*accCount + rightArea[b]*rightCount[b];
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestSplit = b;
+            }
+        }
+
+        if (bestSplit > 0)
+        {
+            // Partition items by bin
+            int i = 0, j = count - 1;
+            while (i <= j)
+            {
+                int bin = (int)((((float *)&items[i].centroid)[axis] - axisMin)*scale);
+
+                if (bin < bestSplit) i++;
+                else
+                {
+                    BvhBuildItem t = items[i]; items[i] = items[j]; items[j] = t;
+                    j--;
+                }
+            }
+
+            if ((i > 0) && (i < count)) mid = i;
+        }
+    }
+
+    int index = AllocateBvhNode(bvh);
+    int left = BuildBvhRange(bvh, items, mid, index);
+    int right = BuildBvhRange(bvh, items + mid, count - mid, index);
+
+    BvhNode *node = &bvh->nodes[index];
+    node->parent = parent;
+    node->left = left;
+    node->right = right;
+    node->box = BoxUnion(bvh->nodes[left].box, bvh->nodes[right].box);
+    node->height = 1 + ((bvh->nodes[left].height > bvh->nodes[right].height)? bvh->nodes[left].height : bvh->nodes[right].height);
+
+    return index;
+}
+
+// Traversal stack with room for at least size entries
+static int *GetBvhStack(SceneBvh *bvh, int size)
+{
+    if (size > bvh->stackCapacity)
+    {
+        while (bvh->stackCapacity < size) bvh->stackCapacity *= 2;
+        bvh->stack = (int *)RL_REALLOC(bvh->stack, bvh->stackCapacity*sizeof(int));
+    }
+
+    return bvh->stack;
+}
+
+#endif // SCENE_BVH_IMPLEMENTATION
@@ -0,0 +1,319 @@
+/**********************************************************************************************
+*
+*   shader_cache - Linked program binaries kept on disk, GLSL is only compiled once per driver
+*
+*   LoadShaderCached() works as LoadShader(): the first time a program is seen it is compiled
+*   from source, then its binary (glGetProgramBinary) is written to the cache directory. The
+*   next start loads the binary with glProgramBinary and skips compilation and linking.
+*
+*   A binary is keyed by a hash of the vertex and fragment code, the raylib version (default
+*   vertex shader, attribute bindings) and the GL vendor, renderer and version strings. Defines
+*   are part of the code they are injected into, so each variant gets its own binary. A driver
+*   update changes the key, and a binary the driver still rejects is compiled again and replaced.
+*
+*   Compile and cache hit counts and times are kept in the cache for the startup profile.
+*
+*   NOTE: Program binaries are GL 4.1 (ARB_get_program_binary), the entry points are loaded
+*   through glfwGetProcAddress() from raylib's desktop platform. Without them, or without any
+*   binary format, every shader is compiled as LoadShader() would.
+*
+*   CONFIGURATION:
+*
+*   #define SHADER_CACHE_IMPLEMENTATION
+*       Generates the implementation of the library into the included file.
+*       If not defined, the library is in header only mode and can be included in other headers
+*       or source files without problems. But only ONE file should hold the implementation.
+*
+**********************************************************************************************/
+
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+
+// Cache directory, driver key and load statistics
+typedef struct {
+    char directory[256];
+    bool supported;                 // Driver reports program binary formats
+    unsigned long long driverKey;   // Hash of vendor, renderer and version strings
+    int compiledCount;              // Programs compiled from source
+    int cachedCount;                // Programs loaded from a binary
+    int rejectedCount;              // Binaries the driver refused, compiled again
+    double compileTime;             // Seconds, compiling (and storing) programs
+    double cacheTime;               // Seconds, loading binaries
+} ShaderCache;
+
+#ifdef __cplusplus
+extern "C" {            // Prevents name mangling of functions
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+ShaderCache LoadShaderCache(const char *directory);                                              // Cache in a directory, created if missing
+Shader LoadShaderCached(ShaderCache *cache, const char *vsFileName, const char *fsFileName);    // LoadShader(), from a binary when cached
+Shader LoadShaderCodeCached(ShaderCache *cache, const char *vsCode, const char *fsCode);        // LoadShaderFromMemory(), from a binary when cached
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SHADER_CACHE_H
+
+
+/***********************************************************************************
+*
+*   SHADER_CACHE IMPLEMENTATION
+*
+************************************************************************************/
+
+// NOTE: Modules using the cache include this header too, the implementation is only generated once
+#if defined(SHADER_CACHE_IMPLEMENTATION) && !defined(SHADER_CACHE_IMPLEMENTED)
+#define SHADER_CACHE_IMPLEMENTED
+
+#include "raylib.h"
+#include "rlgl.h"
+
+#include <stdio.h>              // Required for: snprintf()
+#include <string.h>             // Required for: memcmp(), memcpy()
+
+#if defined(_WIN32)
+    #include <direct.h>         // Required for: _mkdir()
+    #define SHADER_CACHE_MKDIR(dir) _mkdir(dir)
+#else
+    #include <sys/stat.h>       // Required for: mkdir()
+    #define SHADER_CACHE_MKDIR(dir) mkdir(dir, 0755)
+#endif
+
+#include "gl_loader.h"      // Required for: glGetString(), glGetIntegerv(), glfwGetProcAddress()
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define SHADER_CACHE_GL_PROGRAM_BINARY_LENGTH       0x8741
+#define SHADER_CACHE_GL_NUM_PROGRAM_BINARY_FORMATS  0x87FE
+#define SHADER_CACHE_GL_LINK_STATUS                 0x8B82
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+
+// Header of a cache file, the binary follows
+typedef struct {
+    char magic[4];                  // "RSPB"
+    unsigned int format;            // Binary format returned by the driver
+    unsigned long long key;         // Program key, guards against file name collisions
+} ShaderCacheHeader;
+
+//----------------------------------------------------------------------------------
+// Global Variables Definition
+//----------------------------------------------------------------------------------
+static GLCreateProgramProc shaderCacheCreateProgram = NULL;
+static GLGetProgramivProc shaderCacheGetProgramiv = NULL;
+static GLGetProgramBinaryProc shaderCacheGetProgramBinary = NULL;
+static GLProgramBinaryProc shaderCacheProgramBinary = NULL;
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Declaration
+//----------------------------------------------------------------------------------
+static unsigned long long HashShaderText(unsigned long long hash, const char *text);
+static unsigned int LoadProgramBinary(ShaderCache *cache, const char *fileName, unsigned long long key);
+static void SaveProgramBinary(const char *fileName, unsigned int program, unsigned long long key);
+static Shader GetProgramShader(unsigned int program);
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+
+// Cache in a directory, created if missing
+ShaderCache LoadShaderCache(const char *directory)
+{
+    ShaderCache cache = { 0 };
+    snprintf(cache.directory, sizeof(cache.directory), "%s", directory);
+
+    shaderCacheCreateProgram = (GLCreateProgramProc)glfwGetProcAddress("glCreateProgram");
+    shaderCacheGetProgramiv = (GLGetProgramivProc)glfwGetProcAddress("glGetProgramiv");
+    shaderCacheGetProgramBinary = (GLGetProgramBinaryProc)glfwGetProcAddress("glGetProgramBinary");
+    shaderCacheProgramBinary = (GLProgramBinaryProc)glfwGetProcAddress("glProgramBinary");
+
+    int formats = 0;
+    if ((shaderCacheGetProgramBinary != NULL) && (shaderCacheProgramBinary != NULL)) glGetIntegerv(SHADER_CACHE_GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    cache.supported = (formats > 0) && (shaderCacheCreateProgram != NULL) && (shaderCacheGetProgramiv != NULL);
+
+    // Binaries of another driver, or another version of it, are never tried
+    unsigned long long key = 14695981039346656037ull;
+    key = HashShaderText(key, (const char *)glGetString(GL_VENDOR));
+    key = HashShaderText(key, (const char *)glGetString(GL_RENDERER));
+    key = HashShaderText(key, (const char *)glGetString(GL_VERSION));
+    key = HashShaderText(key, RAYLIB_VERSION);
+    cache.driverKey = key;
+
+    if (cache.supported && !DirectoryExists(cache.directory)) SHADER_CACHE_MKDIR(cache.directory);
+
+    if (cache.supported) TraceLog(LOG_INFO, "SHADER CACHE: %s, %i binary formats, driver key %016llx", cache.directory, formats, cache.driverKey);
+    else TraceLog(LOG_WARNING, "SHADER CACHE: Program binaries not supported, shaders are compiled every start");
+
+    return cache;
+}
+
+// LoadShader(), from a binary when cached
+Shader LoadShaderCached(ShaderCache *cache, const char *vsFileName, const char *fsFileName)
+{
+    char *vsCode = (vsFileName != NULL)? LoadFileText(vsFileName) : NULL;
+    char *fsCode = (fsFileName != NULL)? LoadFileText(fsFileName) : NULL;
+
+    Shader shader = LoadShaderCodeCached(cache, vsCode, fsCode);
+
+    UnloadFileText(vsCode);
+    UnloadFileText(fsCode);
+
+    return shader;
+}
+
+// LoadShaderFromMemory(), from a binary when cached
+// NOTE: A NULL stage uses raylib's default one, as LoadShaderFromMemory() does
+Shader LoadShaderCodeCached(ShaderCache *cache, const char *vsCode, const char *fsCode)
+{
+    double start = GetTime();
+
+    if (!cache->supported)
+    {
+        Shader shader = LoadShaderFromMemory(vsCode, fsCode);
+        cache->compiledCount++;
+        cache->compileTime += GetTime() - start;
+        return shader;
+    }
+
+    // The stage separator keeps "a" + "bc" and "ab" + "c" apart
+    unsigned long long key = cache->driverKey;
+    key = HashShaderText(key, (vsCode != NULL)? vsCode : "default vs");
+    key = HashShaderText(key, "\n--\n");
+    key = HashShaderText(key, (fsCode != NULL)? fsCode : "default fs");
+
+    char fileName[512] = { 0 };
+    snprintf(fileName, sizeof(fileName), "%s/%016llx.bin", cache->directory, key);
+
+    unsigned int program = LoadProgramBinary(cache, fileName, key);
+    if (program > 0)
+    {
+        cache->cachedCount++;
+        cache->cacheTime += GetTime() - start;
+        return GetProgramShader(program);
+    }
+
+    Shader shader = LoadShaderFromMemory(vsCode, fsCode);
+    if ((shader.id > 0) && (shader.id != rlGetShaderIdDefault())) SaveProgramBinary(fileName, shader.id, key);
+
+    cache->compiledCount++;
+    cache->compileTime += GetTime() - start;
+
+    return shader;
+}
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Definition
+//----------------------------------------------------------------------------------
+
+// FNV-1a over a string, continuing a previous hash
+static unsigned long long HashShaderText(unsigned long long hash, const char *text)
+{
+    if (text == NULL) return hash;
+
+    for (const unsigned char *c = (const unsigned char *)text; *c != '\0'; c++)
+    {
+        hash ^= *c;
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+// Program from a cache file, 0 if missing, stale or rejected by the driver
+static unsigned int LoadProgramBinary(ShaderCache *cache, const char *fileName, unsigned long long key)
+{
+    if (!FileExists(fileName)) return 0;
+
+    int size = 0;
+    unsigned char *data = LoadFileData(fileName, &size);
+    if (data == NULL) return 0;
+
+    ShaderCacheHeader header = { 0 };
+    if (size > (int)sizeof(ShaderCacheHeader)) memcpy(&header, data, sizeof(ShaderCacheHeader));
+
+    unsigned int program = 0;
+    if ((memcmp(header.magic, "RSPB", 4) == 0) && (header.key == key))
+    {
+        program = shaderCacheCreateProgram();
+        shaderCacheProgramBinary(program, header.format, data + sizeof(ShaderCacheHeader), size - (int)sizeof(ShaderCacheHeader));
+
+        int linked = 0;
+        shaderCacheGetProgramiv(program, SHADER_CACHE_GL_LINK_STATUS, &linked);
+        if (!linked)
+        {
+            TraceLog(LOG_WARNING, "SHADER CACHE: %s rejected by the driver, compiling", fileName);
+            rlUnloadShaderProgram(program);
+            program = 0;
+            cache->rejectedCount++;
+        }
+    }
+
+    UnloadFileData(data);
+
+    return program;
+}
+
+// Write the binary of a linked program
+// NOTE: rlgl links without GL_PROGRAM_BINARY_RETRIEVABLE_HINT, a driver needing it reports no binary and nothing is written
+static void SaveProgramBinary(const char *fileName, unsigned int program, unsigned long long key)
+{
+    int length = 0;
+    shaderCacheGetProgramiv(program, SHADER_CACHE_GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    int size = (int)sizeof(ShaderCacheHeader) + length;
+    unsigned char *data = (unsigned char *)RL_MALLOC(size);
+    ShaderCacheHeader header = { { 'R', 'S', 'P', 'B' }, 0, key };
+
+    shaderCacheGetProgramBinary(program, length, &length, &header.format, data + sizeof(ShaderCacheHeader));
+    memcpy(data, &header, sizeof(ShaderCacheHeader));
+
+    if (!SaveFileData(fileName, data, (int)sizeof(ShaderCacheHeader) + length)) TraceLog(LOG_WARNING, "SHADER CACHE: %s could not be written", fileName);
+
+    RL_FREE(data);
+}
+
+// Shader around a linked program, with the locations LoadShaderFromMemory() sets
+// NOTE: Names are raylib's defaults (config.h), attribute bindings come with the binary
+static Shader GetProgramShader(unsigned int program)
+{
+    Shader shader = { 0 };
+    shader.id = program;
+    shader.locs = (int *)RL_MALLOC(RL_MAX_SHADER_LOCATIONS*sizeof(int));
+    for (int i = 0; i < RL_MAX_SHADER_LOCATIONS; i++) shader.locs[i] = -1;
+
+    shader.locs[SHADER_LOC_VERTEX_POSITION] = rlGetLocationAttrib(program, "vertexPosition");
+    shader.locs[SHADER_LOC_VERTEX_TEXCOORD01] = rlGetLocationAttrib(program, "vertexTexCoord");
+    shader.locs[SHADER_LOC_VERTEX_TEXCOORD02] = rlGetLocationAttrib(program, "vertexTexCoord2");
+    shader.locs[SHADER_LOC_VERTEX_NORMAL] = rlGetLocationAttrib(program, "vertexNormal");
+    shader.locs[SHADER_LOC_VERTEX_TANGENT] = rlGetLocationAttrib(program, "vertexTangent");
+    shader.locs[SHADER_LOC_VERTEX_COLOR] = rlGetLocationAttrib(program, "vertexColor");
+
+    shader.locs[SHADER_LOC_MATRIX_MVP] = rlGetLocationUniform(program, "mvp");
+    shader.locs[SHADER_LOC_MATRIX_VIEW] = rlGetLocationUniform(program, "matView");
+    shader.locs[SHADER_LOC_MATRIX_PROJECTION] = rlGetLocationUniform(program, "matProjection");
+    shader.locs[SHADER_LOC_MATRIX_MODEL] = rlGetLocationUniform(program, "matModel");
+    shader.locs[SHADER_LOC_MATRIX_NORMAL] = rlGetLocationUniform(program, "matNormal");
+
+    shader.locs[SHADER_LOC_COLOR_DIFFUSE] = rlGetLocationUniform(program, "colDiffuse");
+    shader.locs[SHADER_LOC_MAP_DIFFUSE] = rlGetLocationUniform(program, "texture0");
+    shader.locs[SHADER_LOC_MAP_SPECULAR] = rlGetLocationUniform(program, "texture1");
+    shader.locs[SHADER_LOC_MAP_NORMAL] = rlGetLocationUniform(program, "texture2");
+
+    TraceLog(LOG_INFO, "SHADER CACHE: [ID %i] Program loaded from binary", program);
+
+    return shader;
+}
+
+#endif // SHADER_CACHE_IMPLEMENTATION
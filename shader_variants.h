@@ -0,0 +1,194 @@
+/**********************************************************************************************
+*
+*   shader_variants - One shader source, variants generated from feature defines
+*
+*   A single source (resources/shaders/variants) is GLSL 330 without the version line, the
+*   generator adds it. Variants are only generated for GLSL 330: the lit shaders read their lights
+*   from a uniform block (light_buffer.h) that older versions do not have. The stage inputs and
+*   outputs are written ATTRIBUTE, VARYING, TEXTURE and FRAG_COLOR, defined by the version line
+*   prelude as in, out/in, texture and finalColor.
+*
+*   Features are the bits of a mask, each bit a define name. GetShaderVariant() generates the
+*   variant of a mask the first time it is asked for (version line, name mapping, one #define
+*   per set bit, then the source) and keeps it. Picking a variant per draw state replaces
+*   runtime branches on uniforms: a feature off is not compiled in.
+*
+*   Variants load through the program binary cache (shader_cache.h), the defines are part of the
+*   hashed code so each variant has its own binary.
+*
+*   CONFIGURATION:
+*
+*   #define SHADER_VARIANTS_IMPLEMENTATION
+*       Generates the implementation of the library into the included file.
+*       If not defined, the library is in header only mode and can be included in other headers
+*       or source files without problems. But only ONE file should hold the implementation.
+*
+**********************************************************************************************/
+
+#ifndef SHADER_VARIANTS_H
+#define SHADER_VARIANTS_H
+
+#include "shader_cache.h"       // Required for: ShaderCache
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define SHADER_VARIANTS_MAX_FEATURES    16      // Bits of a variant mask
+#define SHADER_VARIANTS_MAX             64      // Variants kept, masks past it are compiled and not kept
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+
+// Single source shader and the variants generated from it
+typedef struct {
+    ShaderCache *cache;                                 // Program binaries, NULL to always compile
+    int glslVersion;                                    // 330, the only version generated
+    char *vsCode;                                       // Single sources, without version line
+    char *fsCode;
+    const char *features[SHADER_VARIANTS_MAX_FEATURES]; // Define of each mask bit
+    int featureCount;
+    void (*setup)(Shader *shader, unsigned int mask);  // Locations of a new variant, optional
+    unsigned int masks[SHADER_VARIANTS_MAX];
+    Shader shaders[SHADER_VARIANTS_MAX];
+    int count;
+} ShaderVariants;
+
+#ifdef __cplusplus
+extern "C" {            // Prevents name mangling of functions
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+ShaderVariants LoadShaderVariants(ShaderCache *cache, int glslVersion, const char *vsFileName, const char *fsFileName, const char **features, int featureCount);  // Sources and feature names, no variant compiled yet
+void UnloadShaderVariants(ShaderVariants *variants);                                                 // Unload the sources and every variant
+Shader GetShaderVariant(ShaderVariants *variants, unsigned int mask);                                // Variant of a feature mask, generated on first use
+char *GenShaderVariantCode(const char *code, int glslVersion, bool fragment, const char **features, int featureCount, unsigned int mask);  // Complete stage code of a variant, free with RL_FREE()
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SHADER_VARIANTS_H
+
+
+/***********************************************************************************
+*
+*   SHADER_VARIANTS IMPLEMENTATION
+*
+************************************************************************************/
+
+#if defined(SHADER_VARIANTS_IMPLEMENTATION) && !defined(SHADER_VARIANTS_IMPLEMENTED)
+#define SHADER_VARIANTS_IMPLEMENTED
+
+#include "raylib.h"
+
+#include <stdio.h>              // Required for: snprintf()
+#include <string.h>             // Required for: strlen()
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Declaration
+//----------------------------------------------------------------------------------
+static const char *GetShaderVariantPrelude(int glslVersion, bool fragment);
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+
+// Sources and feature names, no variant compiled yet
+// NOTE: A NULL stage uses raylib's default one, it gets no defines
+ShaderVariants LoadShaderVariants(ShaderCache *cache, int glslVersion, const char *vsFileName, const char *fsFileName, const char **features, int featureCount)
+{
+    ShaderVariants variants = { 0 };
+
+    if (glslVersion < 330) TraceLog(LOG_WARNING, "SHADER VARIANTS: GLSL %i requested, variants are generated for GLSL 330 only", glslVersion);
+
+    variants.cache = cache;
+    variants.glslVersion = glslVersion;
+    variants.vsCode = (vsFileName != NULL)? LoadFileText(vsFileName) : NULL;
+    variants.fsCode = (fsFileName != NULL)? LoadFileText(fsFileName) : NULL;
+    variants.featureCount = (featureCount < SHADER_VARIANTS_MAX_FEATURES)? featureCount : SHADER_VARIANTS_MAX_FEATURES;
+    for (int i = 0; i < variants.featureCount; i++) variants.features[i] = features[i];
+
+    return variants;
+}
+
+// Unload the sources and every variant
+void UnloadShaderVariants(ShaderVariants *variants)
+{
+    for (int i = 0; i < variants->count; i++) UnloadShader(variants->shaders[i]);
+
+    UnloadFileText(variants->vsCode);
+    UnloadFileText(variants->fsCode);
+
+    *variants = (ShaderVariants){ 0 };
+}
+
+// Variant of a feature mask, generated on first use
+Shader GetShaderVariant(ShaderVariants *variants, unsigned int mask)
+{
+    for (int i = 0; i < variants->count; i++)
+    {
+        if (variants->masks[i] == mask) return variants->shaders[i];
+    }
+
+    char *vsCode = (variants->vsCode != NULL)? GenShaderVariantCode(variants->vsCode, variants->glslVersion, false, variants->features, variants->featureCount, mask) : NULL;
+    char *fsCode = (variants->fsCode != NULL)? GenShaderVariantCode(variants->fsCode, variants->glslVersion, true, variants->features, variants->featureCount, mask) : NULL;
+
+    Shader shader = (variants->cache != NULL)? LoadShaderCodeCached(variants->cache, vsCode, fsCode) : LoadShaderFromMemory(vsCode, fsCode);
+
+    RL_FREE(vsCode);
+    RL_FREE(fsCode);
+
+    if (variants->setup != NULL) variants->setup(&shader, mask);
+
+    if (variants->count < SHADER_VARIANTS_MAX)
+    {
+        variants->masks[variants->count] = mask;
+        variants->shaders[variants->count] = shader;
+        variants->count++;
+    }
+    else TraceLog(LOG_WARNING, "SHADER VARIANTS: More than %i variants, mask 0x%x is not kept", SHADER_VARIANTS_MAX, mask);
+
+    return shader;
+}
+
+// Complete stage code of a variant, free with RL_FREE()
+// NOTE: features holds a define name per mask bit, bits past the last name are ignored
+char *GenShaderVariantCode(const char *code, int glslVersion, bool fragment, const char **features, int featureCount, unsigned int mask)
+{
+    const char *prelude = GetShaderVariantPrelude(glslVersion, fragment);
+
+    int size = (int)strlen(prelude) + (int)strlen(code) + 1;
+    for (int i = 0; i < featureCount; i++)
+    {
+        if ((mask & (1u << i)) && (features[i] != NULL)) size += (int)strlen(features[i]) + 9;     // "#define " and new line
+    }
+
+    char *text = (char *)RL_MALLOC(size);
+    int length = snprintf(text, size, "%s", prelude);
+
+    for (int i = 0; i < featureCount; i++)
+    {
+        if ((mask & (1u << i)) && (features[i] != NULL)) length += snprintf(text + length, size - length, "#define %s\n", features[i]);
+    }
+
+    snprintf(text + length, size - length, "%s", code);
+
+    return text;
+}
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Definition
+//----------------------------------------------------------------------------------
+
+// Version line and stage input/output names
+// NOTE: GLSL 330 whatever the version asked for, see LoadShaderVariants()
+static const char *GetShaderVariantPrelude(int glslVersion, bool fragment)
+{
+    if (fragment) return "#version 330\n#define VARYING in\n#define TEXTURE texture\n#define FRAG_COLOR finalColor\nout vec4 finalColor;\n";
+    else return "#version 330\n#define ATTRIBUTE in\n#define VARYING out\n";
+}
+
+#endif // SHADER_VARIANTS_IMPLEMENTATION
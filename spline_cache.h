@@ -0,0 +1,355 @@
+/**********************************************************************************************
+*
+*   spline_cache - Cubic splines with cached spans, re-evaluated only where control points moved
+*
+*   Uniform B-spline, Catmull-Rom and piecewise Bezier splines are all stored the same way: every
+*   span is converted once to its 4 Bezier control points and evaluated into a shared polyline
+*   with the Bernstein tables of curve_eval. Moving a control point marks only the spans that
+*   use it (4 for B-spline/Catmull-Rom, 1 or 2 for Bezier), UpdateSplineCache() redoes those.
+*
+*   The cached polyline goes into a line batch as one strip, the cached spans go into instanced
+*   curves (lines, ribbons or tubes) as one instance each.
+*
+*   DEPENDENCIES:
+*       curve_eval.h, line_batch.h and curve_instancing.h included before this file
+*
+*   CONFIGURATION:
+*
+*   #define SPLINE_CACHE_IMPLEMENTATION
+*       Generates the implementation of the library into the included file.
+*       If not defined, the library is in header only mode and can be included in other headers
+*       or source files without problems. But only ONE file should hold the implementation.
+*
+**********************************************************************************************/
+
+#ifndef SPLINE_CACHE_H
+#define SPLINE_CACHE_H
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+
+// Spline kinds, all cubic
+typedef enum {
+    SPLINE_CACHE_BASIS = 0,     // Uniform B-spline, span i uses points i to i + 3
+    SPLINE_CACHE_CATMULL_ROM,   // Through every point but the first and last, span i uses points i to i + 3
+    SPLINE_CACHE_BEZIER         // Piecewise Bezier, 3n + 1 points, span i uses points 3i to 3i + 3
+} SplineCacheType;
+
+// Spline with cached span coefficients and evaluated points
+typedef struct {
+    int type;                   // SplineCacheType
+    Vector3 *points;            // Control points
+    int pointCount;
+    int pointCapacity;
+
+    Vector3 *spans;             // 4 Bezier control points per span
+    Vector3 *curve;             // Evaluated polyline, spanCount*segments + 1 points
+    bool *dirty;                // Per span, needs evaluation
+    int spanCount;
+    int spanCapacity;
+    int segments;               // Per span
+    int dirtyCount;
+    int evaluatedSpans;         // Spans redone by the last UpdateSplineCache()
+} SplineCache;
+
+#ifdef __cplusplus
+extern "C" {            // Prevents name mangling of functions
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+SplineCache LoadSplineCache(int type, const Vector3 *points, int pointCount, int segments);   // Copy control points, every span dirty
+void UnloadSplineCache(SplineCache *spline);                                                  // Free spline memory
+void SetSplineCachePoint(SplineCache *spline, int index, Vector3 position);                   // Move a control point, marks its spans if it changed
+void AddSplineCachePoint(SplineCache *spline, Vector3 position);                              // Append a control point
+void SetSplineCacheSegments(SplineCache *spline, int segments);                               // Change segments per span, every span dirty
+int UpdateSplineCache(SplineCache *spline);                                                   // Evaluate dirty spans, returns how many
+void AddLineBatchSplineCache(LineBatch *batch, SplineCache *spline, Color color);             // Cached polyline as one strip
+void AddInstancedCurvesSplineCache(InstancedCurves *curves, SplineCache *spline, float width, Color color);  // One instance per span
+
+void BenchmarkSplineCache(int pointCount, int frames);                                        // Log full evaluation vs 1% of the points moving
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SPLINE_CACHE_H
+
+
+/***********************************************************************************
+*
+*   SPLINE_CACHE IMPLEMENTATION
+*
+************************************************************************************/
+
+#if defined(SPLINE_CACHE_IMPLEMENTATION)
+
+#include "raylib.h"
+#include "raymath.h"
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Declaration
+//----------------------------------------------------------------------------------
+static int GetSplineCacheSpanCount(int type, int pointCount);
+static void ResizeSplineCache(SplineCache *spline);
+static void MarkSplineCacheSpan(SplineCache *spline, int span);
+static void EvaluateSplineCacheSpan(SplineCache *spline, int span, const float *weights);
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+
+// Copy control points, every span dirty
+SplineCache LoadSplineCache(int type, const Vector3 *points, int pointCount, int segments)
+{
+    SplineCache spline = { 0 };
+
+    spline.type = type;
+    spline.segments = (int)Clamp((float)segments, 1.0f, (float)CURVE_MAX_SEGMENTS);
+    spline.pointCapacity = (pointCount > 16)? pointCount : 16;
+    spline.points = (Vector3 *)RL_MALLOC(spline.pointCapacity*sizeof(Vector3));
+
+    for (int i = 0; i < pointCount; i++) spline.points[i] = points[i];
+    spline.pointCount = pointCount;
+
+    ResizeSplineCache(&spline);
+
+    return spline;
+}
+
+// Free spline memory
+void UnloadSplineCache(SplineCache *spline)
+{
+    RL_FREE(spline->points);
+    RL_FREE(spline->spans);
+    RL_FREE(spline->curve);
+    RL_FREE(spline->dirty);
+
+    *spline = (SplineCache){ 0 };
+}
+
+// Move a control point, marks its spans if it changed
+void SetSplineCachePoint(SplineCache *spline, int index, Vector3 position)
+{
+    if ((index < 0) || (index >= spline->pointCount)) return;
+    if ((spline->points[index].x == position.x) && (spline->points[index].y == position.y) && (spline->points[index].z == position.z)) return;
+
+    spline->points[index] = position;
+
+    if (spline->type == SPLINE_CACHE_BEZIER)
+    {
+        // Joints belong to two spans, handles to one
+        MarkSplineCacheSpan(spline, index/3);
+        if ((index%3) == 0) MarkSplineCacheSpan(spline, index/3 - 1);
+    }
+    else
+    {
+        for (int span = index - 3; span <= index; span++) MarkSplineCacheSpan(spline, span);
+    }
+}
+
+// Append a control point
+void AddSplineCachePoint(SplineCache *spline, Vector3 position)
+{
+    if (spline->pointCount == spline->pointCapacity)
+    {
+        spline->pointCapacity *= 2;
+        spline->points = (Vector3 *)RL_REALLOC(spline->points, spline->pointCapacity*sizeof(Vector3));
+    }
+
+    spline->points[spline->pointCount++] = position;
+
+    ResizeSplineCache(spline);
+}
+
+// Change segments per span, every span dirty
+void SetSplineCacheSegments(SplineCache *spline, int segments)
+{
+    segments = (int)Clamp((float)segments, 1.0f, (float)CURVE_MAX_SEGMENTS);
+    if (segments == spline->segments) return;
+
+    spline->segments = segments;
+    spline->spanCapacity = 0;       // Polyline size changed, reallocate
+
+    ResizeSplineCache(spline);
+}
+
+// Evaluate dirty spans, returns how many
+int UpdateSplineCache(SplineCache *spline)
+{
+    spline->evaluatedSpans = 0;
+    if (spline->dirtyCount == 0) return 0;
+
+    const float *weights = GetBernsteinWeights(spline->segments);
+
+    for (int span = 0; span < spline->spanCount; span++)
+    {
+        if (!spline->dirty[span]) continue;
+
+        EvaluateSplineCacheSpan(spline, span, weights);
+        spline->dirty[span] = false;
+        spline->evaluatedSpans++;
+    }
+
+    spline->dirtyCount = 0;
+
+    return spline->evaluatedSpans;
+}
+
+// Cached polyline as one strip
+void AddLineBatchSplineCache(LineBatch *batch, SplineCache *spline, Color color)
+{
+    UpdateSplineCache(spline);
+
+    if (spline->spanCount > 0) AddLineBatchStrip(batch, spline->curve, spline->spanCount*spline->segments + 1, color);
+}
+
+// One instance per span, evaluated again by the vertex shader
+void AddInstancedCurvesSplineCache(InstancedCurves *curves, SplineCache *spline, float width, Color color)
+{
+    UpdateSplineCache(spline);
+
+    for (int span = 0; span < spline->spanCount; span++)
+    {
+        const Vector3 *b = spline->spans + 4*span;
+        AddInstancedCurve(curves, b[0], b[1], b[2], b[3], width, color);
+    }
+}
+
+// Log full evaluation vs 1% of the points moving
+void BenchmarkSplineCache(int pointCount, int frames)
+{
+    Vector3 *points = (Vector3 *)RL_MALLOC(pointCount*sizeof(Vector3));
+    for (int i = 0; i < pointCount; i++) points[i] = (Vector3){ (float)i, sinf(0.1f*i), cosf(0.1f*i) };
+
+    const char *names[3] = { "basis", "catmull-rom", "bezier" };
+
+    for (int type = 0; type < 3; type++)
+    {
+        SplineCache spline = LoadSplineCache(type, points, pointCount, 16);
+        double fullTime = 0.0, partialTime = 0.0;
+        int partialSpans = 0;
+
+        for (int f = 0; f < frames; f++)
+        {
+            // Everything moved
+            for (int i = 0; i < pointCount; i++) SetSplineCachePoint(&spline, i, (Vector3){ (float)i, sinf(0.1f*i + 0.01f*f), cosf(0.1f*i) });
+            double start = GetTime();
+            UpdateSplineCache(&spline);
+            fullTime += GetTime() - start;
+
+            // 1% moved
+            for (int i = f%100; i < pointCount; i += 100) SetSplineCachePoint(&spline, i, (Vector3){ (float)i, 1.0f + 0.01f*f, 0.0f });
+            start = GetTime();
+            partialSpans += UpdateSplineCache(&spline);
+            partialTime += GetTime() - start;
+        }
+
+        TraceLog(LOG_INFO, "SPLINE CACHE: %s, %i points x 16 segments: all moved %.3f ms (%i spans), 1%% moved %.3f ms (%i spans)",
+                 names[type], pointCount, fullTime*1000.0/frames, spline.spanCount, partialTime*1000.0/frames, partialSpans/frames);
+
+        UnloadSplineCache(&spline);
+    }
+
+    RL_FREE(points);
+}
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Definition
+//----------------------------------------------------------------------------------
+
+// Spans for a point count, 0 if too few points
+static int GetSplineCacheSpanCount(int type, int pointCount)
+{
+    if (type == SPLINE_CACHE_BEZIER) return (pointCount >= 4)? (pointCount - 1)/3 : 0;
+
+    return (pointCount >= 4)? pointCount - 3 : 0;
+}
+
+// Grow span arrays to the point count, new spans dirty
+static void ResizeSplineCache(SplineCache *spline)
+{
+    int spanCount = GetSplineCacheSpanCount(spline->type, spline->pointCount);
+
+    if (spanCount > spline->spanCapacity)
+    {
+        int capacity = (spline->spanCapacity > 0)? spline->spanCapacity : 16;
+        while (capacity < spanCount) capacity *= 2;
+
+        spline->spans = (Vector3 *)RL_REALLOC(spline->spans, 4*capacity*sizeof(Vector3));
+        spline->curve = (Vector3 *)RL_REALLOC(spline->curve, (capacity*spline->segments + 1)*sizeof(Vector3));
+        spline->dirty = (bool *)RL_REALLOC(spline->dirty, capacity*sizeof(bool));
+
+        // Segment count changes land here too, so everything is evaluated again (rare, capacity doubles)
+        for (int span = 0; span < capacity; span++) spline->dirty[span] = false;
+        spline->dirtyCount = 0;
+        spline->spanCount = spanCount;
+        spline->spanCapacity = capacity;
+        for (int span = 0; span < spanCount; span++) MarkSplineCacheSpan(spline, span);
+        return;
+    }
+
+    int previous = spline->spanCount;
+    spline->spanCount = spanCount;
+
+    // Previous last span wrote the polyline end, the new ones continue from there
+    for (int span = previous; span < spanCount; span++) MarkSplineCacheSpan(spline, span);
+}
+
+// Mark span for evaluation
+static void MarkSplineCacheSpan(SplineCache *spline, int span)
+{
+    if ((span < 0) || (span >= spline->spanCount) || spline->dirty[span]) return;
+
+    spline->dirty[span] = true;
+    spline->dirtyCount++;
+}
+
+// Bezier control points of a span, then its points from the Bernstein table
+// NOTE: Spans write their first segments points, the last span also writes the end point,
+// a point shared by two spans depends on control points used by both so both are dirty
+static void EvaluateSplineCacheSpan(SplineCache *spline, int span, const float *weights)
+{
+    Vector3 *b = spline->spans + 4*span;
+
+    if (spline->type == SPLINE_CACHE_BEZIER)
+    {
+        for (int k = 0; k < 4; k++) b[k] = spline->points[3*span + k];
+    }
+    else
+    {
+        Vector3 p0 = spline->points[span], p1 = spline->points[span + 1];
+        Vector3 p2 = spline->points[span + 2], p3 = spline->points[span + 3];
+
+        if (spline->type == SPLINE_CACHE_BASIS)
+        {
+            b[0] = Vector3Scale(Vector3Add(Vector3Add(p0, Vector3Scale(p1, 4.0f)), p2), 1.0f/6.0f);
+            b[1] = Vector3Scale(Vector3Add(Vector3Scale(p1, 4.0f), Vector3Scale(p2, 2.0f)), 1.0f/6.0f);
+            b[2] = Vector3Scale(Vector3Add(Vector3Scale(p1, 2.0f), Vector3Scale(p2, 4.0f)), 1.0f/6.0f);
+            b[3] = Vector3Scale(Vector3Add(Vector3Add(p1, Vector3Scale(p2, 4.0f)), p3), 1.0f/6.0f);
+        }
+        else
+        {
+            b[0] = p1;
+            b[1] = Vector3Add(p1, Vector3Scale(Vector3Subtract(p2, p0), 1.0f/6.0f));
+            b[2] = Vector3Subtract(p2, Vector3Scale(Vector3Subtract(p3, p1), 1.0f/6.0f));
+            b[3] = p2;
+        }
+    }
+
+    Vector3 *out = spline->curve + span*spline->segments;
+    int last = (span == spline->spanCount - 1)? spline->segments : spline->segments - 1;
+
+    for (int i = 0; i <= last; i++)
+    {
+        const float *w = weights + 4*i;
+
+        out[i] = (Vector3){ w[0]*b[0].x + w[1]*b[1].x + w[2]*b[2].x + w[3]*b[3].x,
+                            w[0]*b[0].y + w[1]*b[1].y + w[2]*b[2].y + w[3]*b[3].y,
+                            w[0]*b[0].z + w[1]*b[1].z + w[2]*b[2].z + w[3]*b[3].z };
+    }
+}
+
+#endif // SPLINE_CACHE_IMPLEMENTATION
@@ -0,0 +1,215 @@
+/**********************************************************************************************
+*
+*   uniform_cache - SetShaderValue() that skips uploads of unchanged values
+*
+*   Every (shader, location) pair set through SetShaderValueCached() keeps a shadow copy of the
+*   last value sent. A call with the same bytes is skipped, anything else is uploaded and copied.
+*   Issued and skipped uploads are counted per frame, EndUniformCacheFrame() closes a frame.
+*
+*   Only values set through the cache are known to it: SetShaderValue() calls around it, and the
+*   matrices and colors raylib sets itself when drawing, bypass the shadow copies. A location has
+*   to go through the cache every time, or its copy has to be cleared.
+*
+*   NOTE: GL reuses program ids, a shader is cleared with ClearShaderValueCache() before it is
+*   unloaded, or its replacement would skip its first uploads.
+*
+*   Textures are not cached: SetShaderValueTexture() picks a texture slot of the current batch.
+*
+*   CONFIGURATION:
+*
+*   #define UNIFORM_CACHE_IMPLEMENTATION
+*       Generates the implementation of the library into the included file.
+*       If not defined, the library is in header only mode and can be included in other headers
+*       or source files without problems. But only ONE file should hold the implementation.
+*
+**********************************************************************************************/
+
+#ifndef UNIFORM_CACHE_H
+#define UNIFORM_CACHE_H
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define UNIFORM_CACHE_CAPACITY      512     // Shadow copies, (shader, location) pairs past it are always uploaded
+#define UNIFORM_CACHE_VALUE_SIZE    64      // Bytes of a shadow copy, larger values are always uploaded
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+
+// Uploads of a frame
+typedef struct {
+    int issued;                 // Values sent to GL
+    int skipped;                // Values equal to the shadow copy
+} UniformCacheStats;
+
+#ifdef __cplusplus
+extern "C" {            // Prevents name mangling of functions
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+void SetShaderValueCached(Shader shader, int locIndex, const void *value, int uniformType);                // SetShaderValue(), skipped if the value did not change
+void SetShaderValueVCached(Shader shader, int locIndex, const void *value, int uniformType, int count);    // SetShaderValueV(), skipped if the values did not change
+void ClearShaderValueCache(Shader shader);                                                                  // Forget the shadow copies of a shader, before unloading it
+void EndUniformCacheFrame(void);                                                                            // Close the frame counters
+UniformCacheStats GetUniformCacheStats(void);                                                               // Uploads of the last closed frame
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // UNIFORM_CACHE_H
+
+
+/***********************************************************************************
+*
+*   UNIFORM_CACHE IMPLEMENTATION
+*
+************************************************************************************/
+
+// NOTE: Modules using the cache include this header too, the implementation is only generated once
+#if defined(UNIFORM_CACHE_IMPLEMENTATION) && !defined(UNIFORM_CACHE_IMPLEMENTED)
+#define UNIFORM_CACHE_IMPLEMENTED
+
+#include "raylib.h"
+
+#include <string.h>             // Required for: memcmp(), memcpy()
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+
+// Last value sent to a (shader, location) pair
+typedef struct {
+    unsigned int shaderId;      // 0 for a free slot
+    int location;
+    int size;                   // Bytes of value in use
+    unsigned char value[UNIFORM_CACHE_VALUE_SIZE];
+} UniformCacheEntry;
+
+//----------------------------------------------------------------------------------
+// Global Variables Definition
+//----------------------------------------------------------------------------------
+static UniformCacheEntry uniformCache[UNIFORM_CACHE_CAPACITY] = { 0 };     // Open addressing, linear probing
+static UniformCacheStats uniformCacheFrame = { 0 };                         // Counting
+static UniformCacheStats uniformCacheLast = { 0 };                          // Last closed frame
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Declaration
+//----------------------------------------------------------------------------------
+static int GetUniformSize(int uniformType);
+static bool UpdateUniformCache(unsigned int shaderId, int location, const void *value, int size);
+
+//----------------------------------------------------------------------------------
+// Module Functions Definition
+//----------------------------------------------------------------------------------
+
+// SetShaderValue(), skipped if the value did not change
+void SetShaderValueCached(Shader shader, int locIndex, const void *value, int uniformType)
+{
+    SetShaderValueVCached(shader, locIndex, value, uniformType, 1);
+}
+
+// SetShaderValueV(), skipped if the values did not change
+void SetShaderValueVCached(Shader shader, int locIndex, const void *value, int uniformType, int count)
+{
+    if (locIndex < 0) return;       // Not in the shader, SetShaderValue() would not send it either
+
+    if (UpdateUniformCache(shader.id, locIndex, value, GetUniformSize(uniformType)*count))
+    {
+        SetShaderValueV(shader, locIndex, value, uniformType, count);
+        uniformCacheFrame.issued++;
+    }
+    else uniformCacheFrame.skipped++;
+}
+
+// Forget the shadow copies of a shader, before unloading it
+// NOTE: Later entries of a probe chain are moved back, so lookups never stop at the hole
+void ClearShaderValueCache(Shader shader)
+{
+    for (int i = 0; i < UNIFORM_CACHE_CAPACITY; i++)
+    {
+        if (uniformCache[i].shaderId != shader.id) continue;
+
+        uniformCache[i].shaderId = 0;
+
+        for (int j = (i + 1)%UNIFORM_CACHE_CAPACITY; uniformCache[j].shaderId != 0; j = (j + 1)%UNIFORM_CACHE_CAPACITY)
+        {
+            UniformCacheEntry entry = uniformCache[j];
+            uniformCache[j].shaderId = 0;
+            if (entry.shaderId == shader.id) continue;
+
+            int slot = (int)((entry.shaderId*31u + (unsigned int)entry.location)%UNIFORM_CACHE_CAPACITY);
+            while (uniformCache[slot].shaderId != 0) slot = (slot + 1)%UNIFORM_CACHE_CAPACITY;
+            uniformCache[slot] = entry;
+        }
+    }
+}
+
+// Close the frame counters
+void EndUniformCacheFrame(void)
+{
+    uniformCacheLast = uniformCacheFrame;
+    uniformCacheFrame = (UniformCacheStats){ 0 };
+}
+
+// Uploads of the last closed frame
+UniformCacheStats GetUniformCacheStats(void)
+{
+    return uniformCacheLast;
+}
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Definition
+//----------------------------------------------------------------------------------
+
+// Bytes of one value of a SHADER_UNIFORM_* type
+static int GetUniformSize(int uniformType)
+{
+    switch (uniformType)
+    {
+        case SHADER_UNIFORM_VEC2: case SHADER_UNIFORM_IVEC2: return 8;
+        case SHADER_UNIFORM_VEC3: case SHADER_UNIFORM_IVEC3: return 12;
+        case SHADER_UNIFORM_VEC4: case SHADER_UNIFORM_IVEC4: return 16;
+        default: return 4;      // FLOAT, INT, SAMPLER2D
+    }
+}
+
+// Compare a value with its shadow copy and keep it, true if it has to be uploaded
+static bool UpdateUniformCache(unsigned int shaderId, int location, const void *value, int size)
+{
+    if (size > UNIFORM_CACHE_VALUE_SIZE) return true;
+
+    int slot = (int)((shaderId*31u + (unsigned int)location)%UNIFORM_CACHE_CAPACITY);
+
+    for (int probe = 0; probe < UNIFORM_CACHE_CAPACITY; probe++)
+    {
+        UniformCacheEntry *entry = &uniformCache[slot];
+
+        if (entry->shaderId == 0)
+        {
+            entry->shaderId = shaderId;
+            entry->location = location;
+            entry->size = size;
+            memcpy(entry->value, value, size);
+            return true;
+        }
+
+        if ((entry->shaderId == shaderId) && (entry->location == location))
+        {
+            if ((entry->size == size) && (memcmp(entry->value, value, size) == 0)) return false;
+
+            entry->size = size;
+            memcpy(entry->value, value, size);
+            return true;
+        }
+
+        slot = (slot + 1)%UNIFORM_CACHE_CAPACITY;
+    }
+
+    return true;        // Full, upload without a copy
+}
+
+#endif // UNIFORM_CACHE_IMPLEMENTATION